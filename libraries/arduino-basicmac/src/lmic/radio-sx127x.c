@@ -4,6 +4,10 @@
 //
 // This file is subject to the terms and conditions defined in file 'LICENSE',
 // which is part of this source code package.
+//
+// Local to this fork: rxfsk() and rxlora() skip the modem setup when
+// state.rxconfig says the registers still hold it. That relies on the
+// SX127x keeping its registers in SLEEP; every TX path clears the cache.
 
 #include "board.h"
 #include "hw.h"
@@ -337,6 +341,9 @@ static struct {
     // one-time receiver chain calibration
     int calibrated;
 #endif
+    // protocol whose receiver setup is in the registers (NULL after TX,
+    // which shares them), so that starting RX again only tunes
+    const rf_proto_desc_t *rxconfig;
 } state;
 
 // ----------------------------------------
@@ -553,6 +560,8 @@ static void power_tcxo (void) {
 
 // continuous wave
 static void txcw (void) {
+    state.rxconfig = NULL;
+
     // select FSK modem (from sleep mode)
     writeReg(RegOpMode, OPMODE_FSK_SLEEP);
     ASSERT(readReg(RegOpMode) == OPMODE_FSK_SLEEP);
@@ -590,6 +599,8 @@ static void txcw (void) {
 #define RF_FIFOTHRESH_TXSTARTCONDITION_FIFONOTEMPTY 0x80
 
 static void txfsk (void) {
+    state.rxconfig = NULL;
+
     // select FSK modem (from sleep mode)
     writeReg(RegOpMode, OPMODE_FSK_SLEEP);
     ASSERT(readReg(RegOpMode) == OPMODE_FSK_SLEEP);
@@ -710,6 +721,8 @@ static void txfsk (void) {
 }
 
 static void txlora (void) {
+    state.rxconfig = NULL;
+
     // select LoRa modem (from sleep mode)
     writeReg(RegOpMode, OPMODE_LORA_SLEEP);
     ASSERT(readReg(RegOpMode) == OPMODE_LORA_SLEEP);
@@ -778,27 +791,11 @@ static void sx127x_radio_starttx (bool txcontinuous) {
     }
 }
 
-static void rxlora (bool rxcontinuous) {
-	
-	debug_printf("running LORA\n");
-
-    ostime_t t0 = os_getTime();
-    // select LoRa modem (from sleep mode)
-    writeReg(RegOpMode, OPMODE_LORA_SLEEP);
-    ASSERT(readReg(RegOpMode) == OPMODE_LORA_SLEEP);
-
-    // power-up tcxo
-    power_tcxo();
-
-    // enter standby mode (warm up)
-    writeReg(RegOpMode, OPMODE_LORA_STANDBY);
-
+// receiver setup of LMIC.protocol, everything but frequency, timeout and IRQs
+static void rxloraconfig (void) {
     // configure LoRa modem (cfg1, cfg2, cfg3)
     configLoraModem();
 
-    // configure frequency
-    configChannel();
-
 #if 1
     // set LNA gain 'gggbbrbb' (LnaGain=001 (max), LnaBoostLf=00 (default), reserved=0, LnaBoostHf=11 (150%))
     writeReg(RegLna, 0b00100011);
@@ -821,11 +818,36 @@ static void rxlora (bool rxcontinuous) {
     writeReg(LORARegPreambleMsb, 0x00);
     writeReg(LORARegPreambleLsb, 0x08);
 
-    // set symbol timeout (for single rx)
-    writeReg(LORARegSymbTimeoutLsb, LMIC.rxsyms);
-
     // set sync word
     writeReg(LORARegSyncWord, LMIC.syncword);
+}
+
+static void rxlora (bool rxcontinuous) {
+	
+	debug_printf("running LORA\n");
+
+    ostime_t t0 = os_getTime();
+    // select LoRa modem (from sleep mode)
+    writeReg(RegOpMode, OPMODE_LORA_SLEEP);
+    ASSERT(readReg(RegOpMode) == OPMODE_LORA_SLEEP);
+
+    // power-up tcxo
+    power_tcxo();
+
+    // enter standby mode (warm up)
+    writeReg(RegOpMode, OPMODE_LORA_STANDBY);
+
+    // configure frequency
+    configChannel();
+
+    // modem setup of this protocol still in the registers (kept in SLEEP)?
+    if (state.rxconfig != LMIC.protocol) {
+    	rxloraconfig();
+    	state.rxconfig = LMIC.protocol;
+    }
+
+    // set symbol timeout (for single rx)
+    writeReg(LORARegSymbTimeoutLsb, LMIC.rxsyms);
 
     // configure DIO mapping DIO0=RxDone DIO1=(Timeout or NOP) DIO2=NOP DIO3=NOP DIO4=NOP DIO5=NOP
     writeReg(RegDioMapping1, (rxcontinuous) ?
@@ -873,23 +895,8 @@ static void rxlora (bool rxcontinuous) {
     hal_enableIRQs();
 }
 
-static void rxfsk (bool rxcontinuous) {
-    // configure radio (needs rampup time)
-    ostime_t t0 = os_getTime();
-
-    // select FSK modem (from sleep mode)
-    writeReg(RegOpMode, OPMODE_FSK_SLEEP);
-    ASSERT( readReg(RegOpMode) == OPMODE_FSK_SLEEP );
-
-    // power-up tcxo
-    power_tcxo();
-
-    // enter standby mode (warm up)
-    writeReg(RegOpMode, OPMODE_FSK_STANDBY);
-
-    // configure frequency
-    configChannel();
-
+// receiver setup of LMIC.protocol, everything but frequency and DIO mapping
+static void rxfskconfig (void) {
     // set bitrate
     switch (LMIC.protocol->bitrate)
     {
@@ -1038,11 +1045,35 @@ static void rxfsk (bool rxcontinuous) {
       break;     
     }
 
-    state.fifolen = -1;
-    state.fifoptr = LMIC.frame;
-
     // I hope that 256 samples will cover full Rx packet
     writeReg(FSKRegRssiConfig, 0x00);
+}
+
+static void rxfsk (bool rxcontinuous) {
+    // configure radio (needs rampup time)
+    ostime_t t0 = os_getTime();
+
+    // select FSK modem (from sleep mode)
+    writeReg(RegOpMode, OPMODE_FSK_SLEEP);
+    ASSERT( readReg(RegOpMode) == OPMODE_FSK_SLEEP );
+
+    // power-up tcxo
+    power_tcxo();
+
+    // enter standby mode (warm up)
+    writeReg(RegOpMode, OPMODE_FSK_STANDBY);
+
+    // configure frequency
+    configChannel();
+
+    // modem setup of this protocol still in the registers (kept in SLEEP)?
+    if (state.rxconfig != LMIC.protocol) {
+    	rxfskconfig();
+    	state.rxconfig = LMIC.protocol;
+    }
+
+    state.fifolen = -1;
+    state.fifoptr = LMIC.frame;
 
     // configure DIO mapping DIO0=PayloadReady DIO1=NOP DIO2=TimeOut
     writeReg(RegDioMapping1, MAP1_FSK_DIO0_RXDONE | MAP1_FSK_DIO1_NOP | MAP1_FSK_DIO2_RXTOUT);
@@ -1156,6 +1187,7 @@ static void sx127x_radio_init (void) {
 #ifdef BRD_sx1276_radio
     state.calibrated = 0;
 #endif
+    state.rxconfig = NULL;
 
     hal_enableIRQs();
 }
@@ -17,7 +17,9 @@
  */
 
 #include "APRS.h"
+#include "APRSQ.h"
 #include "PVALID.h"
+#include "RXSTATS.h"
 #include "SoftRF.h"
 #include "Battery.h"
 #include "Traffic.h"
@@ -56,21 +58,7 @@ static String zeroPadding(String data, int len)
     return tmp;
 }
 
-static String getWW(String data)
-{
-    String tmp = data;
-    int    len = tmp.length();
-    tmp.remove(0, len - 1);
-    return tmp;
-}
-
-static float SnrCalc(float rssi)
-{
-    float noise = -108.0;
-    return rssi - (noise);
-}
-
-static short AprsPasscode(const char* theCall)
+short AprsPasscode(const char* theCall)
 {
     char  rootCall[10];
     char* p1 = rootCall;
@@ -95,25 +83,311 @@ static short AprsPasscode(const char* theCall)
     return hash & 0x7fff;
 }
 
-static bool OGN_APRS_Connect()
+/*
+ * Allocation free formatter for the aircraft beacon. Integer only, it
+ * reproduces what the former String based code sent byte for byte,
+ * including its float rounding:
+ *
+ *   minutes   (float) (LAT - int(LAT)) * 60 rounded to 3 decimals by
+ *             dtostrf(), sent truncated to 2 decimals, the 3rd decimal
+ *             of latitude and longitude goes into !Wxy!. Exact halves
+ *             (x + n/16 minutes) come out of the double digit loop of
+ *             dtostrf() either way, aprs_half_down[] has the outcome.
+ *   altitude  int(altitude * 3.28084) evaluated in double
+ *   others    "0" padded to width in front of the sign, like zeroPadding()
+ */
+
+static const char* const aprs_symbol_table[16] = {"/", "/", "\\", "/", "\\", "\\", "/", "/", "\\", "J", "/", "/", "M", "/", "\\", "\\"}; // 0x79 -> aircraft type 1110 dec 14 & 0x51 -> aircraft type 4
+static const char* const aprs_symbol[16]       = {"z", "^", "^", "X", "", "^", "g", "g", "^", "^", "^", "O", "^", "\'", "", "n", };
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+/* bit n set: dtostrf(min + (2n + 1) / 16, 3) rounds down */
+static const uint8_t aprs_half_down[60] = {
+    0xFF, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00,
+    0x21, 0x84, 0x10, 0x42, 0x08, 0x21, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xF7, 0xDE, 0x7B, 0xEF, 0xBD, 0xF7, 0xDE, 0x7B, 0xEF, 0xBD,
+    0xF7, 0xDE, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x84, 0x10, 0x42, 0x08, 0x21, 0x84, 0x10, 0x42, 0x08, 0x21,
+    0x84, 0x10, 0x42, 0x08, 0x21, 0x84, 0x10, 0x42, 0x08, 0x21,
+};
+
+/* 3.28084 as a double is APRS_FEET_MANT * 2^-51 */
+#define APRS_FEET_MANT  0x1A3F290ABB44E5ULL
+#define APRS_FIX_BITS   40
+
+static char* APRS_put_str(char* p, char* end, const char* s)
 {
-    if (SoC->WiFi_connect_TCP(ogn_server.c_str(), ogn_port))
-        return true;
+    while (*s && p < end)
+        *p++ = *s++;
+    return p;
+}
+
+static char* APRS_put_char(char* p, char* end, char c)
+{
+    if (p < end)
+        *p++ = c;
+    return p;
+}
+
+/* decimal, '0' padded to width in front of the sign */
+static char* APRS_put_int(char* p, char* end, int32_t val, uint8_t width)
+{
+    char     tmp[12];
+    uint8_t  len = 0;
+    uint32_t u   = val < 0 ? 0 - (uint32_t) val : val;
+
+    do {
+        tmp[len++] = '0' + u % 10;
+        u         /= 10;
+    } while (u);
+    if (val < 0)
+        tmp[len++] = '-';
+
+    for (uint8_t i = len; i < width; i++)
+        p = APRS_put_char(p, end, '0');
+    while (len)
+        p = APRS_put_char(p, end, tmp[--len]);
+    return p;
+}
+
+static char* APRS_put_hex(char* p, char* end, uint32_t val, uint8_t width)
+{
+    char    tmp[8];
+    uint8_t len = 0;
+
+    do {
+        tmp[len++] = hex_digits[val & 0x0F];
+        val      >>= 4;
+    } while (val);
+
+    for (uint8_t i = len; i < width; i++)
+        p = APRS_put_char(p, end, '0');
+    while (len)
+        p = APRS_put_char(p, end, tmp[--len]);
+    return p;
+}
+
+static uint8_t APRS_bitlen(uint64_t v)
+{
+    uint8_t n = 0;
+
+    while (v) {
+        n++;
+        v >>= 1;
+    }
+    return n;
+}
+
+/* rounds v to 'bits' significant bits, half to even, like an FPU does */
+static uint64_t APRS_round_bits(uint64_t v, uint8_t bits)
+{
+    uint8_t len = APRS_bitlen(v);
+
+    if (len <= bits)
+        return v;
+
+    uint8_t  s    = len - bits;
+    uint64_t keep = v >> s;
+    uint64_t rem  = v & ((1ULL << s) - 1);
+    uint64_t half = 1ULL << (s - 1);
+
+    if (rem > half || (rem == half && (keep & 1)))
+        keep++;
+    return keep << s;
+}
+
+/*
+ * |v| = deg + min / 60, min in thousandths of a minute, the way
+ * String((LAT - int(LAT)) * 60, 3) rounds it
+ */
+static void APRS_degmin(float v, uint32_t* deg, uint32_t* min)
+{
+    uint32_t bits;
+
+    memcpy(&bits, &v, sizeof(bits));
+
+    uint32_t exp  = (bits >> 23) & 0xFF;
+    uint64_t mant = (bits & 0x7FFFFF) | 0x800000;
+    int      ea   = (int) exp - 150; /* |v| = mant * 2^ea */
+    uint64_t fix;                    /* |v| * 2^APRS_FIX_BITS */
+
+    *deg = 0;
+    *min = 0;
+
+    if (exp == 0 || exp == 0xFF)
+        return;                      /* zero, subnormal, inf or NaN */
+
+    if (ea > 0)
+    {
+        *deg = mant << ea;           /* no fraction left */
+        return;
+    }
+
+    if (ea + APRS_FIX_BITS >= 0)
+        fix = mant << (ea + APRS_FIX_BITS);
+    else if (ea + APRS_FIX_BITS > -64)
+        fix = mant >> -(ea + APRS_FIX_BITS); /* < 0.0005 min, rounds to 0 anyway */
     else
-        return false;
+        fix = 0;
+
+    *deg = fix >> APRS_FIX_BITS;
+
+    /* float multiply by 60, then dtostrf() rounding to 3 decimals */
+    uint64_t m60 = APRS_round_bits((fix & ((1ULL << APRS_FIX_BITS) - 1)) * 60, 24);
+
+    *min = (m60 * 1000 + (1ULL << (APRS_FIX_BITS - 1))) >> APRS_FIX_BITS;
+
+    if (((m60 * 1000) & ((1ULL << APRS_FIX_BITS) - 1)) == (1ULL << (APRS_FIX_BITS - 1)) &&
+        (m60 >> APRS_FIX_BITS) < 60 &&
+        (aprs_half_down[m60 >> APRS_FIX_BITS] >> ((m60 >> (APRS_FIX_BITS - 3)) & 0x07) & 1))
+        (*min)--;
 }
 
-static bool OGN_APRS_DisConnect()
+/* int(v * 3.28084) with the product rounded to double precision */
+static int32_t APRS_feet(float v)
 {
-    if (!SoC->WiFi_disconnect_TCP())
-        return true;
-    return false;
+    uint32_t bits;
+
+    memcpy(&bits, &v, sizeof(bits));
+
+    uint32_t exp  = (bits >> 23) & 0xFF;
+    uint64_t mant = (bits & 0x7FFFFF) | 0x800000;
+    int      ea   = (int) exp - 150;
+
+    if (exp == 0 || exp == 0xFF)
+        return 0;
+
+    /* mant * APRS_FEET_MANT is up to 77 bits, as hi * 2^32 + lo */
+    uint64_t x  = mant * (APRS_FEET_MANT & 0xFFFFFFFF);
+    uint64_t hi = mant * (APRS_FEET_MANT >> 32) + (x >> 32);
+    uint32_t lo = (uint32_t) x;
+
+    uint8_t  len  = 32 + APRS_bitlen(hi);
+    uint8_t  s    = len > 53 ? len - 53 : 0;
+    uint64_t keep = (hi << (32 - s)) | (lo >> s);
+
+    if (s)
+    {
+        uint32_t rem  = lo & ((1UL << s) - 1);
+        uint32_t half = 1UL << (s - 1);
+
+        if (rem > half || (rem == half && (keep & 1)))
+            keep++;
+    }
+
+    /* |v| * 3.28084 = keep * 2^(s + ea - 51) */
+    int     t  = 51 - ea - (int) s;
+    int32_t ft;
+
+    if (t >= 64)
+        ft = 0;
+    else if (t > 0)
+        ft = (int32_t) (keep >> t);
+    else
+        ft = (int32_t) (keep << -t);
+
+    return bits & 0x80000000 ? -ft : ft;
 }
 
-static int OGN_APRS_check_reg(String* msg) // 0 = unverified // 1 = verified // -1 = wrong message
+size_t OGN_APRS_Position(char* buf, size_t size, ufo_t* fop, const char* rec_callsign)
 {
-    int len = msg->length();
+    char*        p   = buf;
+    char*        end = buf + size;
+    tmElements_t tm;
+    uint32_t     lat_deg, lat_min, lon_deg, lon_min;
 
+    if (size == 0)
+        return 0;
+
+    switch (fop->addr_type)
+    {
+        case 1:
+            p = APRS_put_str(p, end, "ICA");
+            break;
+        case 2:
+            p = APRS_put_str(p, end, "FLR");
+            break;
+        case 3:
+            p = APRS_put_str(p, end, "OGN");
+            break;
+        case 4:
+            p = APRS_put_str(p, end, "P3I");
+            break;
+        case 5:
+            p = APRS_put_str(p, end, "FNT");
+            break;
+        default:
+            p = APRS_put_str(p, end, "RANDOM");
+            break;
+    }
+
+    p = APRS_put_hex(p, end, fop->addr, 6);
+    p = APRS_put_str(p, end, ">APRS,qAS,");
+    p = APRS_put_str(p, end, rec_callsign);
+    p = APRS_put_str(p, end, ":/");
+
+    breakTime(fop->timestamp, tm);
+    p = APRS_put_int(p, end, tm.Hour, 2);
+    p = APRS_put_int(p, end, tm.Minute, 2);
+    p = APRS_put_int(p, end, tm.Second, 2);
+    p = APRS_put_char(p, end, 'h');
+
+    APRS_degmin(fop->latitude, &lat_deg, &lat_min);
+    APRS_degmin(fop->longitude, &lon_deg, &lon_min);
+
+    p = APRS_put_int(p, end, lat_deg, 0);
+    p = APRS_put_int(p, end, lat_min / 1000, 2);
+    p = APRS_put_char(p, end, '.');
+    p = APRS_put_int(p, end, lat_min % 1000 / 10, 2);
+    p = APRS_put_char(p, end, fop->latitude < 0 ? 'S' : 'N');
+    p = APRS_put_str(p, end, aprs_symbol_table[fop->aircraft_type & 0x0F]);
+
+    p = APRS_put_int(p, end, lon_deg, 3);
+    p = APRS_put_int(p, end, lon_min / 1000, 2);
+    p = APRS_put_char(p, end, '.');
+    p = APRS_put_int(p, end, lon_min % 1000 / 10, 2);
+    p = APRS_put_char(p, end, fop->longitude < 0 ? 'W' : 'E');
+    p = APRS_put_str(p, end, aprs_symbol[fop->aircraft_type & 0x0F]);
+
+    p = APRS_put_int(p, end, (int32_t) fop->course, 3);
+    p = APRS_put_char(p, end, '/');
+    p = APRS_put_int(p, end, (int32_t) fop->speed, 3);
+    p = APRS_put_str(p, end, "/A=");
+    p = APRS_put_int(p, end, APRS_feet(fop->altitude), 6);
+
+    p = APRS_put_str(p, end, " !W");
+    p = APRS_put_char(p, end, '0' + lat_min % 10);
+    p = APRS_put_char(p, end, '0' + lon_min % 10);
+    p = APRS_put_str(p, end, "! id");
+    p = APRS_put_hex(p, end, fop->aircraft_type << 2 | (fop->stealth << 7) | (fop->no_track << 6) | fop->addr_type, 2);
+    p = APRS_put_hex(p, end, fop->addr, 6);
+    p = APRS_put_char(p, end, ' ');
+
+    if (fop->vs >= 0)
+        p = APRS_put_char(p, end, '+');
+    p = APRS_put_int(p, end, (int32_t) fop->vs, 3);
+    p = APRS_put_str(p, end, "fpm +0.0rot ");
+
+    /* SNR against a -108 dBm noise floor, one (always 0) decimal */
+    p = APRS_put_int(p, end, fop->rssi + 108, 0);
+    p = APRS_put_str(p, end, ".0dB 0e -0.0kHz\r\n");
+
+    if (p >= end)
+        return 0;  /* no room left for the terminator */
+
+    *p = 0;
+    return p - buf;
+}
+
+/* never waits: 1 connected, 0 failed, -1 still connecting */
+static int OGN_APRS_Connect()
+{
+    return SoC->WiFi_connect_TCP(ogn_server.c_str(), ogn_port);
+}
+
+static int OGN_APRS_check_reg(String* msg) // 0 = unverified // 1 = verified // -1 = wrong message
+{
     if (msg->indexOf("verified") > -1)
         return 1;
     if (msg->indexOf("unverified") > -1)
@@ -124,23 +398,29 @@ static int OGN_APRS_check_reg(String* msg) // 0 = unverified // 1 = verified //
     return -1;
 }
 
-bool OGN_APRS_check_Wifi()
+/*
+ * Never waits: true if connected. Otherwise restarts the station
+ * interface, which needs a while to connect again, so the caller looks
+ * a second time later with reset set and the board is reset if it is
+ * still not connected.
+ */
+bool OGN_APRS_check_Wifi(bool reset)
 {
-    if (WiFi.status() != WL_CONNECTED && WiFi.getMode() == WIFI_STA)
-    {
-        WiFi.disconnect();
-        WiFi.mode(WIFI_OFF);
-        WiFi.mode(WIFI_STA);
-        //WiFi.begin(ogn_ssid_1.c_str(), ogn_wpass_1.c_str());
-        delay(100);
-    }
     if (WiFi.status() == WL_CONNECTED)
         return true;
-    else
+
+    if (reset)
     {
         Serial.println("more then 10 minutes in AP mode reset");
         SoC->reset();
     }
+    else if (WiFi.getMode() == WIFI_STA)
+    {
+        WiFi.disconnect();
+        WiFi.mode(WIFI_OFF);
+        WiFi.mode(WIFI_STA);
+        //WiFi.begin(ogn_ssid_1.c_str(), ogn_wpass_1.c_str());
+    }
     return false;
 }
 
@@ -172,6 +452,7 @@ int OGN_APRS_check_messages()
         msg = "no packet since > 60 seconds...reconnecting";
         Logger_send_udp(&msg);
         SoC->WiFi_disconnect_TCP();
+        APRSQ_Reset();
         aprs_registred = 0;
     }
 
@@ -180,143 +461,89 @@ int OGN_APRS_check_messages()
     return aprs_registred;
 }
 
+/* validates and queues the newest fix of Container[i], false if nothing was queued */
+static bool OGN_APRS_Send(int i, time_t this_moment)
+{
+    char   AircraftPacket[APRS_PACKET_SIZE];
+    size_t len;
+
+    if (!Container[i].addr || (this_moment - Container[i].timestamp) > EXPORT_EXPIRATION_TIME || Container[i].distance >= ogn_range * 1000)
+        return false;
+
+    switch (isPacketValid(&Traffic_history[i]))
+    {
+        case PVALID_OK:
+            break;
+        case PVALID_REJECT:
+            RXSTATS_Implausible(Container[i].protocol);
+            return false;
+        default:
+            return false;   /* not enough history yet, not a reject */
+    }
+
+    RXSTATS_Fix(Container[i].distance, Container[i].bearing);
+
+    if (Container[i].distance / 1000 > largest_range)
+        largest_range = Container[i].distance / 1000;
+
+    // TBD need to make sure Container[i].timestamp is based on SlotTime not current time due slot-2 time extension
+    len = OGN_APRS_Position(AircraftPacket, sizeof(AircraftPacket), &Container[i], ogn_callsign.c_str());
+    if (!len)
+        return false;
+
+    Log_write(AircraftPacket, len);
+
+    if ((!Container[i].stealth && !Container[i].no_track) || (ogn_itrackbit && ogn_istealthbit))
+        APRSQ_Position(Container[i].addr, AircraftPacket, len);
+
+    Traffic_Sent(i);
+    return true;
+}
+
 void OGN_APRS_Export()
 {
-    struct aprs_airc_packet APRS_AIRC;
-    time_t                  this_moment = now();
+    time_t this_moment = now();
 
-    String symbol_table[16] = {"/", "/", "\\", "/", "\\", "\\", "/", "/", "\\", "J", "/", "/", "M", "/", "\\", "\\"}; // 0x79 -> aircraft type 1110 dec 14 & 0x51 -> aircraft type 4
-    String symbol[16]       = {"z", "^", "^", "X", "", "^", "g", "g", "^", "^", "^", "O", "^", "\'", "", "n", };
+    for (int i = Traffic_First(); i != TRAFFIC_NONE; i = Traffic_Next(i))
+    {
+        /*
+         * streaming: what OGN_APRS_Forward() held back, once the per
+         * aircraft interval is over, however long ago it came in
+         */
+        if (ogn_aprs_stream ? !Traffic_Pending(i) || Traffic_Since_Sent(i) < ogn_aprs_interval :
+                              !Traffic_Fresh(i) || !Traffic_Pending(i))
+            continue;
+
+        OGN_APRS_Send(i, this_moment);
+    }
 
+    Traffic_Exported(); // keep the history, export each reception once
+    APRSQ_Flush();
+}
 
-    for (int i = 0; i < MAX_TRACKING_OBJECTS; i++)
-        if (Container[i].addr && (this_moment - Container[i].timestamp) <= EXPORT_EXPIRATION_TIME && Container[i].distance < ogn_range * 1000)
-        {
+/*
+ * Streaming mode, called by ParseData() with the slot of every accepted
+ * fix: goes out right away unless this aircraft was forwarded less than
+ * ogn_aprs_interval ms ago.
+ */
+void OGN_APRS_Forward(int i)
+{
+    if (i == TRAFFIC_NONE || !Traffic_Pending(i) || Traffic_Since_Sent(i) < ogn_aprs_interval)
+        return;
 
-            if(!isPacketValid(Container[i].addr, Container[i].latitude, Container[i].longitude, Container[i].speed, Container[i].timestamp)){
-              break;
-            }
-            
-            if (Container[i].distance / 1000 > largest_range)
-                largest_range = Container[i].distance / 1000;
-
-            float LAT = fabs(Container[i].latitude);
-            float LON = fabs(Container[i].longitude);
-
-
-            APRS_AIRC.callsign = zeroPadding(String(Container[i].addr, HEX), 6);
-            APRS_AIRC.callsign.toUpperCase();
-            APRS_AIRC.rec_callsign = ogn_callsign;
-
-
-            // TBD need to use Container[i].timestamp instead of hour(), minute(), second()
-            // actually, need to make sure Container[i].timestamp is based on SlotTime not current time due slot-2 time extension
-            //converting Container[i].timestamp to hour minutes seconds
-
-            time_t receive_time = Container[i].timestamp;
-            APRS_AIRC.timestamp = zeroPadding(String(hour(receive_time)), 2) + zeroPadding(String(minute(receive_time)), 2) + zeroPadding(String(second(receive_time)), 2) + "h";
-
-            /*Latitude*/
-            APRS_AIRC.lat_deg = String(int(LAT));
-            APRS_AIRC.lat_min = zeroPadding(String((LAT - int(LAT)) * 60, 3), 5);
-
-            /*Longitude*/
-            APRS_AIRC.lon_deg = zeroPadding(String(int(LON)), 3);
-            APRS_AIRC.lon_min = zeroPadding(String((LON - int(LON)) * 60, 3), 5);
-
-            /*Altitude*/
-            APRS_AIRC.alt = zeroPadding(String(int(Container[i].altitude * 3.28084)), 6);
-
-            APRS_AIRC.heading      = zeroPadding(String(int(Container[i].course)), 3);
-            APRS_AIRC.ground_speed = zeroPadding(String(int(Container[i].speed)), 3);
-
-
-            APRS_AIRC.sender_details = zeroPadding(String(Container[i].aircraft_type << 2 | (Container[i].stealth << 7) | (Container[i].no_track << 6) | Container[i].addr_type, HEX), 2);
-
-            APRS_AIRC.symbol_table = symbol_table[Container[i].aircraft_type];
-            APRS_AIRC.symbol       = symbol[Container[i].aircraft_type];
-
-            APRS_AIRC.snr = String(SnrCalc(Container[i].rssi), 1);
-
-
-            String W_lat = String((LAT - int(LAT)) * 60, 3);
-            String W_lon = String((LON - int(LON)) * 60, 3);
-
-
-            APRS_AIRC.pos_precision = getWW(W_lat) + getWW(W_lon);
-
-            if (Container[i].vs >= 0)
-                APRS_AIRC.climbrate = "+" + zeroPadding(String(int(Container[i].vs)), 3);
-            else
-                APRS_AIRC.climbrate = zeroPadding(String(int(Container[i].vs)), 3);
-
-            String AircraftPacket = "";
-
-            if (Container[i].addr_type == 1)
-                AircraftPacket = "ICA";
-            if (Container[i].addr_type == 2)
-                AircraftPacket += "FLR";
-            if (Container[i].addr_type == 3)
-                AircraftPacket += "OGN";
-            if (Container[i].addr_type == 4)
-                AircraftPacket += "P3I";
-            if (Container[i].addr_type == 5)
-                AircraftPacket += "FNT";
-            if (Container[i].addr_type == 0 || Container[i].addr_type > 5)
-                AircraftPacket += "RANDOM";
-
-            AircraftPacket += APRS_AIRC.callsign;
-            APRS_AIRC.sender_details.toUpperCase();
-
-            AircraftPacket += ">APRS,qAS,";
-            AircraftPacket += APRS_AIRC.rec_callsign;
-            AircraftPacket += ":/";
-            AircraftPacket += APRS_AIRC.timestamp;
-            AircraftPacket += APRS_AIRC.lat_deg;
-            AircraftPacket += APRS_AIRC.lat_min;
-            if (Container[i].latitude < 0)
-                AircraftPacket += "S";
-            else
-                AircraftPacket += "N";
-            AircraftPacket += APRS_AIRC.symbol_table;
-            AircraftPacket += APRS_AIRC.lon_deg;
-            AircraftPacket += APRS_AIRC.lon_min;
-            if (Container[i].longitude < 0)
-                AircraftPacket += "W";
-            else
-                AircraftPacket += "E";
-            AircraftPacket += APRS_AIRC.symbol;
-            AircraftPacket += APRS_AIRC.heading;
-            AircraftPacket += "/";
-            AircraftPacket += APRS_AIRC.ground_speed;
-            AircraftPacket += "/A=";
-            AircraftPacket += APRS_AIRC.alt;
-            AircraftPacket += " !W";
-            AircraftPacket += APRS_AIRC.pos_precision;
-            AircraftPacket += "! id";
-            AircraftPacket += APRS_AIRC.sender_details;
-            AircraftPacket += APRS_AIRC.callsign;
-            AircraftPacket += " ";
-            AircraftPacket += APRS_AIRC.climbrate;
-            AircraftPacket += "fpm +0.0rot ";
-            AircraftPacket += APRS_AIRC.snr;
-            AircraftPacket += "dB 0e -0.0kHz";
-            AircraftPacket += "\r\n";
-
-            Logger_send_udp(&AircraftPacket);
-            Logger_send_udp(&APRS_AIRC.pos_precision);
-
-            if (!Container[i].stealth && !Container[i].no_track || ogn_itrackbit && ogn_istealthbit)
-                SoC->WiFi_transmit_TCP(AircraftPacket);
-        }
-
-    for (int i = 0; i < MAX_TRACKING_OBJECTS; i++) // cleaning up containers
-        Container[i] = EmptyFO;
+    if (OGN_APRS_Send(i, now()))
+        APRSQ_Flush();
 }
 
+/* never waits: 1 logged in, 0 still connecting, ask again, -1 failed */
 int OGN_APRS_Register(ufo_t* this_aircraft)
 {
-    if (OGN_APRS_Connect())
+    int connected = OGN_APRS_Connect();
+
+    if (connected < 0)
+        return 0;
+
+    if (connected)
     {
         struct aprs_login_packet APRS_LOGIN;
 
@@ -339,7 +566,8 @@ int OGN_APRS_Register(ufo_t* this_aircraft)
         LoginPacket += "\n";
 
         Logger_send_udp(&LoginPacket);
-        SoC->WiFi_transmit_TCP(LoginPacket);
+        APRSQ_Reset(); // nothing from the old connection goes before the login
+        APRSQ_Control(LoginPacket.c_str(), LoginPacket.length());
 
         aprs_registred = 1;
     }
@@ -393,7 +621,8 @@ int OGN_APRS_Register(ufo_t* this_aircraft)
         RegisterPacket += APRS_REG.alt;
         RegisterPacket += "\r\n";
 
-        SoC->WiFi_transmit_TCP(RegisterPacket);
+        APRSQ_Control(RegisterPacket.c_str(), RegisterPacket.length());
+        APRSQ_Flush();
         Logger_send_udp(&RegisterPacket);
     }
     return aprs_registred;
@@ -401,45 +630,44 @@ int OGN_APRS_Register(ufo_t* this_aircraft)
 
 void OGN_APRS_KeepAlive()
 {
-    String KeepAlivePacket = "#keepalive\n";
-    Logger_send_udp(&KeepAlivePacket);
-    SoC->WiFi_transmit_TCP(KeepAlivePacket);
+    static const char KeepAlivePacket[] = "#keepalive\n";
+
+    Log_write(KeepAlivePacket, sizeof(KeepAlivePacket) - 1);
+    APRSQ_Control(KeepAlivePacket, sizeof(KeepAlivePacket) - 1);
+    APRSQ_Flush();
 }
 
 // LKHS>APRS,TCPIP*,qAC,GLIDERN2:>211635h v0.2.6.ARM CPU:0.2 RAM:777.7/972.2MB NTP:3.1ms/-3.8ppm 4.902V 0.583A +33.6C
 
 void OGN_APRS_Status(ufo_t* this_aircraft)
 {
-    struct aprs_stat_packet APRS_STAT;
-    APRS_STAT.origin   = ogn_callsign;
-    APRS_STAT.callsign = String(this_aircraft->addr, HEX);
-    APRS_STAT.callsign.toUpperCase();
-    APRS_STAT.timestamp      = zeroPadding(String(hour()), 2) + zeroPadding(String(minute()), 2) + zeroPadding(String(second()), 2) + "h";
+    char    StatusPacket[APRS_PACKET_SIZE];
+    char*   end = StatusPacket + sizeof(StatusPacket);
+    char*   p   = StatusPacket;
+    int32_t cv  = (int32_t) lroundf(Battery_voltage() * 100);    /* String(float) has 2 decimals */
+
+    p = APRS_put_str(p, end, ogn_callsign.c_str());
+    p = APRS_put_str(p, end, ">APRS,TCPIP*,qAC,");
+    p = APRS_put_hex(p, end, this_aircraft->addr, 0);
+    p = APRS_put_str(p, end, ":>");
+    p = APRS_put_int(p, end, hour(), 2);
+    p = APRS_put_int(p, end, minute(), 2);
+    p = APRS_put_int(p, end, second(), 2);
 
     /*issue17*/ /*v0.1.0.20-ESP32*/
-    APRS_STAT.platform      = "v";
-    APRS_STAT.platform      += SOFTRF_FIRMWARE_VERSION;
-    APRS_STAT.platform      += "-ESP32";
-    
-    APRS_STAT.realtime_clock = String(0.0);
-    APRS_STAT.board_voltage  = String(Battery_voltage()) + "V";
+    p = APRS_put_str(p, end, "h v" SOFTRF_FIRMWARE_VERSION "-ESP32 ");
+    p = APRS_put_int(p, end, cv / 100, 0);
+    p = APRS_put_char(p, end, '.');
+    p = APRS_put_int(p, end, cv % 100, 2);
 
     // 14/16Acfts[1h]
 
-    String StatusPacket = "";
-    StatusPacket += APRS_STAT.origin;
-    StatusPacket += ">APRS,TCPIP*,qAC,";
-    StatusPacket += APRS_STAT.callsign;
-    StatusPacket += ":>";
-    StatusPacket += APRS_STAT.timestamp;
-    StatusPacket += " ";
-    StatusPacket += APRS_STAT.platform;
-    StatusPacket += " ";
-    StatusPacket += APRS_STAT.board_voltage;
-    //StatusPacket += " ";
-    //StatusPacket += ThisAircraft.timestamp;
-    StatusPacket += "\r\n";
-    SoC->WiFi_transmit_TCP(StatusPacket);
-    Logger_send_udp(&StatusPacket);
-    return;
+    p = APRS_put_str(p, end, "V\r\n");
+    if (p >= end)
+        return;  /* no room left for the terminator */
+    *p = 0;
+
+    APRSQ_Control(StatusPacket, p - StatusPacket);
+    APRSQ_Flush();
+    Log_write(StatusPacket, p - StatusPacket);
 }
@@ -62,25 +62,7 @@ struct aprs_stat_packet
 };
 
 // FLRDF0A52>APRS,qAS,LSTB:/220132h4658.70N/00707.72Ez090/054/A=001424 !W37! id06DF0A52 +020fpm +0.0rot 55.2dB 0e -6.2kHz gps4x6 s6.01 h03 rDDACC4 +5.0dBm hearD7EA hearDA95
-struct aprs_airc_packet
-{
-    String callsign;
-    String rec_callsign;
-    String timestamp;
-    String lat_deg;
-    String lat_min;
-    String lon_deg;
-    String lon_min;
-    String alt;
-    String heading;
-    String ground_speed;
-    String pos_precision;
-    String symbol_table;
-    String symbol;
-    String climbrate;
-    String sender_details;
-    String snr;
-};
+#define APRS_PACKET_SIZE 192
 
 enum
 {
@@ -88,25 +70,23 @@ enum
     OGN_ON,
 };
 
-static bool OGN_APRS_Connect();
-
-static bool OGN_APRS_DisConnect();
-
+size_t OGN_APRS_Position(char* buf, size_t size, ufo_t* fop, const char* rec_callsign);
+short AprsPasscode(const char* theCall);
 
 void OGN_APRS_Export();
 
+void OGN_APRS_Forward(int);
+
 void OGN_APRS_Weather();
 
 int OGN_APRS_Register(ufo_t* this_aircraft);
 
 void OGN_APRS_KeepAlive();
 
-bool OGN_APRS_check_Wifi();
+bool OGN_APRS_check_Wifi(bool reset);
 
 void OGN_APRS_Status(ufo_t* this_aircraft);
 
-static int OGN_APRS_check_reg(String *);
-
 int OGN_APRS_check_messages();
 
 #endif /* OGNHELPER_H */
@@ -0,0 +1,215 @@
+/*
+ * APRSQ.cpp
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * Outbound APRS-IS queue. Lines are queued by the exporters and written
+ * by APRSQ_Flush() from loop() in MSS sized chunks, without ever waiting
+ * for the socket: what does not fit into the lwIP send buffer stays here
+ * for the next round. When the server is too slow the queue sheds
+ * positions, a newer position of an aircraft replaces its queued one
+ * and on overflow the oldest position goes. Login, keepalive and status
+ * lines are never dropped for a position.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "APRSQ.h"
+
+#define APRSQ_CONTROL_ADDR  0xFFFFFFFF  /* not a valid 24 bit address */
+
+typedef struct aprsq_line
+{
+    uint32_t addr;      /* aircraft, APRSQ_CONTROL_ADDR for everything else */
+    uint8_t  len;
+    char     text[APRSQ_LINE_SIZE];
+} aprsq_line_t;
+
+aprsq_stats_t APRSQ_stats;
+
+static aprsq_line_t lines[APRSQ_SLOTS];
+static uint8_t      order[APRSQ_SLOTS];    /* slot numbers, oldest first */
+static uint8_t      free_slots[APRSQ_SLOTS];
+static uint8_t      count     = 0;
+static uint8_t      free_cnt  = 0;
+static uint8_t      positions = 0;
+
+static char     tx_buf[APRSQ_MSS];
+static uint16_t tx_len = 0;
+static uint16_t tx_off = 0;
+
+void APRSQ_Reset()
+{
+    APRSQ_stats.flushed += count;
+
+    for (uint8_t i = 0; i < APRSQ_SLOTS; i++)
+        free_slots[i] = i;
+    free_cnt  = APRSQ_SLOTS;
+    count     = 0;
+    positions = 0;
+    tx_len    = tx_off = 0;
+
+    APRSQ_stats.depth = 0;
+}
+
+/* takes entry n out of order[], its slot goes back to the free list */
+static void APRSQ_Remove(uint8_t n)
+{
+    uint8_t slot = order[n];
+
+    if (lines[slot].addr != APRSQ_CONTROL_ADDR)
+        positions--;
+
+    memmove(&order[n], &order[n + 1], count - n - 1);
+    count--;
+    free_slots[free_cnt++] = slot;
+}
+
+static int APRSQ_Oldest_Position()
+{
+    for (uint8_t n = 0; n < count; n++)
+        if (lines[order[n]].addr != APRSQ_CONTROL_ADDR)
+            return n;
+    return -1;
+}
+
+static bool APRSQ_Push(uint32_t addr, const char* text, size_t len)
+{
+    if (len == 0 || len >= APRSQ_LINE_SIZE || free_cnt == 0)
+        return false;
+
+    uint8_t slot = free_slots[--free_cnt];
+
+    lines[slot].addr = addr;
+    lines[slot].len  = len;
+    memcpy(lines[slot].text, text, len);
+
+    order[count++] = slot;
+    if (addr != APRSQ_CONTROL_ADDR)
+        positions++;
+
+    APRSQ_stats.queued++;
+    APRSQ_stats.depth = count;
+    if (count > APRSQ_stats.max_depth)
+        APRSQ_stats.max_depth = count;
+    return true;
+}
+
+bool APRSQ_Position(uint32_t addr, const char* line, size_t len)
+{
+    if (free_cnt + count != APRSQ_SLOTS)
+        APRSQ_Reset();  /* first use */
+
+    for (uint8_t n = 0; n < count; n++)
+        if (lines[order[n]].addr == addr)
+        {
+            APRSQ_Remove(n);
+            APRSQ_stats.superseded++;
+            break;
+        }
+
+    /* full: make room on the socket first, shed the oldest position if it is backed up */
+    if (positions >= APRSQ_SLOTS - APRSQ_RESERVED)
+        APRSQ_Flush();
+
+    if (positions >= APRSQ_SLOTS - APRSQ_RESERVED)
+    {
+        APRSQ_Remove(APRSQ_Oldest_Position());
+        APRSQ_stats.dropped++;
+    }
+
+    return APRSQ_Push(addr, line, len);
+}
+
+bool APRSQ_Control(const char* line, size_t len)
+{
+    if (free_cnt + count != APRSQ_SLOTS)
+        APRSQ_Reset();
+
+    if (free_cnt == 0)
+        APRSQ_Flush();
+
+    if (free_cnt == 0)
+    {
+        int n = APRSQ_Oldest_Position();
+
+        if (n < 0)
+        {
+            APRSQ_stats.dropped_control++;
+            return false;
+        }
+        APRSQ_Remove(n);
+        APRSQ_stats.dropped++;
+    }
+
+    if (!APRSQ_Push(APRSQ_CONTROL_ADDR, line, len))
+    {
+        APRSQ_stats.dropped_control++;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Writes as much as the socket takes right now. Returns the bytes
+ * written, -1 (and an empty queue) when the connection is gone.
+ */
+int APRSQ_Flush()
+{
+    int total = 0;
+
+    for (;;)
+    {
+        if (tx_off == tx_len)
+        {
+            /* refill with whole lines, oldest first */
+            tx_len = tx_off = 0;
+            while (count > 0 && tx_len + lines[order[0]].len <= APRSQ_MSS)
+            {
+                aprsq_line_t* line = &lines[order[0]];
+
+                memcpy(&tx_buf[tx_len], line->text, line->len);
+                tx_len += line->len;
+                APRSQ_Remove(0);
+                APRSQ_stats.sent++;
+            }
+            APRSQ_stats.depth = count;
+
+            if (tx_len == 0)
+                break;
+        }
+
+        int rval = SoC->WiFi_send_TCP(&tx_buf[tx_off], tx_len - tx_off);
+
+        if (rval < 0)
+        {
+            APRSQ_Reset();
+            return -1;
+        }
+
+        if (rval > 0)
+            APRSQ_stats.writes++;
+
+        tx_off            += rval;
+        total             += rval;
+        APRSQ_stats.bytes += rval;
+
+        if (tx_off < tx_len)
+        {
+            APRSQ_stats.blocked++;
+            break;  /* socket buffer full, retry on the next loop() */
+        }
+    }
+
+    return total;
+}
@@ -0,0 +1,52 @@
+/*
+ * APRSQ.h
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "SoC.h"
+
+#ifndef APRSQHELPER_H
+#define APRSQHELPER_H
+
+#define APRSQ_SLOTS         32      /* queued lines */
+#define APRSQ_RESERVED      4       /* slots positions can not take, kept for login/keepalive/status */
+#define APRSQ_LINE_SIZE     192     /* = APRS_PACKET_SIZE */
+#define APRSQ_MSS           1436    /* lwIP TCP_MSS on the ESP32, bytes per write */
+
+typedef struct aprsq_stats
+{
+    uint16_t depth;             /* lines waiting */
+    uint16_t max_depth;
+    uint32_t queued;
+    uint32_t sent;              /* lines handed to the socket */
+    uint32_t bytes;
+    uint32_t writes;            /* socket writes, several lines each */
+    uint32_t blocked;           /* writes cut short by a full socket buffer */
+    uint32_t superseded;        /* older position of the same aircraft dropped */
+    uint32_t dropped;           /* oldest position dropped, queue full */
+    uint32_t dropped_control;   /* keepalive/status not queued, should stay 0 */
+    uint32_t flushed;           /* lines discarded on (re)connect or socket error */
+} aprsq_stats_t;
+
+extern aprsq_stats_t APRSQ_stats;
+
+void APRSQ_Reset();
+bool APRSQ_Position(uint32_t addr, const char* line, size_t len);
+bool APRSQ_Control(const char* line, size_t len);
+int  APRSQ_Flush();
+
+#endif /* APRSQHELPER_H */
@@ -0,0 +1,373 @@
+/*
+ * CAPTURE.cpp
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * Raw frame capture for decode problems. The RF task appends every
+ * frame the radio hands over, before the CRC/FEC check, with millis(),
+ * GNSS time, protocol, channel and RSSI; `ognbase-host replay` reads
+ * the file like its text format and sends the frames through the same
+ * receive path again.
+ *
+ * Frames go into one of two RAM buffers, loop() writes the other one
+ * in whole sectors. A record never spans two buffers, the end of a
+ * buffer is padded. The RF task never waits: if loop() has not written
+ * the other buffer yet, or is sealing the current one for a periodic
+ * flush, the frame is counted as dropped.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CAPTURE.h"
+
+#define CAPTURE_REF_SIZE    13      /* type and fields */
+#define CAPTURE_RX_SIZE     12      /* type and fields, without the frame */
+
+capture_stats_t CAPTURE_stats;
+
+static uint8_t*        buffers = NULL;     /* 2 x CAPTURE_BUFFER */
+static capture_write_t writer  = NULL;
+static bool            active  = false;
+static uint8_t         lock    = 0;        /* buffer being filled is in use */
+static uint8_t         fill    = 0;        /* buffer being filled */
+static uint16_t        fill_len = 0;
+static uint32_t        fill_ms  = 0;       /* first record in it */
+static bool            fill_records = false;
+static uint16_t        sealed[2];          /* bytes for CAPTURE_Loop() to write, 0 = free */
+static uint8_t         ref_record[1 + CAPTURE_REF_SIZE];
+static uint8_t         ref_pending = 0;    /* goes in front of the next frame */
+
+static void CAPTURE_Put16(uint8_t* p, uint16_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void CAPTURE_Put32(uint8_t* p, uint32_t v)
+{
+    CAPTURE_Put16(p, v);
+    CAPTURE_Put16(p + 2, v >> 16);
+}
+
+static uint16_t CAPTURE_Get16(const uint8_t* p)
+{
+    return p[0] | p[1] << 8;
+}
+
+static uint32_t CAPTURE_Get32(const uint8_t* p)
+{
+    return CAPTURE_Get16(p) | (uint32_t) CAPTURE_Get16(p + 2) << 16;
+}
+
+static bool CAPTURE_Lock()
+{
+    uint8_t idle = 0;
+
+    return __atomic_compare_exchange_n(&lock, &idle, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static void CAPTURE_Unlock()
+{
+    __atomic_store_n(&lock, 0, __ATOMIC_RELEASE);
+}
+
+/* lock held: hands the buffer being filled to CAPTURE_Loop(), padded to a sector */
+static bool CAPTURE_Seal()
+{
+    uint8_t* buf  = buffers + fill * CAPTURE_BUFFER;
+    uint16_t size = (fill_len + CAPTURE_SECTOR - 1) / CAPTURE_SECTOR * CAPTURE_SECTOR;
+
+    if (fill_len == 0)
+        return true;
+    if (__atomic_load_n(&sealed[fill ^ 1], __ATOMIC_ACQUIRE))
+        return false;
+
+    /* a length byte of 0 starts the padding */
+    memset(buf + fill_len, 0, size - fill_len);
+    __atomic_store_n(&sealed[fill], size, __ATOMIC_RELEASE);
+    fill        ^= 1;
+    fill_len     = 0;
+    fill_records = false;
+    return true;
+}
+
+/* lock held */
+static bool CAPTURE_Append(const uint8_t* record, size_t size, uint32_t ms)
+{
+    if (fill_len + size > CAPTURE_BUFFER && !CAPTURE_Seal())
+        return false;
+
+    if (!fill_records)
+    {
+        fill_ms      = ms;
+        fill_records = true;
+    }
+    memcpy(buffers + fill * CAPTURE_BUFFER + fill_len, record, size);
+    fill_len += size;
+    return true;
+}
+
+/* loop(): writes what CAPTURE_Seal() has handed over */
+static void CAPTURE_Write()
+{
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        uint16_t size = __atomic_load_n(&sealed[i], __ATOMIC_ACQUIRE);
+
+        if (size == 0)
+            continue;
+
+        /* after a short write the buffers are only recycled */
+        if (CAPTURE_stats.errors == 0)
+        {
+            size_t n = (*writer)(buffers + i * CAPTURE_BUFFER, size);
+
+            CAPTURE_stats.bytes += n;
+            if (n != size)
+            {
+                CAPTURE_stats.errors++;
+                __atomic_store_n(&active, false, __ATOMIC_RELEASE);    /* storage full or gone */
+            }
+        }
+        __atomic_store_n(&sealed[i], 0, __ATOMIC_RELEASE);
+    }
+}
+
+bool CAPTURE_Start(capture_write_t write, bool magic)
+{
+    if (buffers)
+        CAPTURE_Stop();
+
+    buffers = (uint8_t *) malloc(2 * CAPTURE_BUFFER);
+    if (buffers == NULL)
+        return false;
+
+    memset(&CAPTURE_stats, 0, sizeof(CAPTURE_stats));
+    writer       = write;
+    fill         = 0;
+    fill_len     = 0;
+    fill_records = false;
+    sealed[0]    = sealed[1] = 0;
+    ref_pending  = 0;
+
+    /* an existing file ends on a sector, see CAPTURE_Open() */
+    if (magic)
+    {
+        memcpy(buffers, CAPTURE_MAGIC, CAPTURE_MAGIC_SIZE);
+        fill_len = CAPTURE_MAGIC_SIZE;
+    }
+
+    __atomic_store_n(&active, true, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* loop(), writes the rest */
+void CAPTURE_Stop()
+{
+    if (buffers == NULL)
+        return;
+
+    __atomic_store_n(&active, false, __ATOMIC_RELEASE);
+    CAPTURE_Write();
+    while (!CAPTURE_Lock())
+        ;
+    CAPTURE_Seal();
+    CAPTURE_Write();
+
+    /* held until the buffers are gone, CAPTURE_Frame() sees inactive after it */
+    free(buffers);
+    buffers = NULL;
+    writer  = NULL;
+    CAPTURE_Unlock();
+}
+
+bool CAPTURE_Active()
+{
+    return __atomic_load_n(&active, __ATOMIC_ACQUIRE);
+}
+
+/* RF task, raw frame as the radio delivered it */
+void CAPTURE_Frame(uint32_t ms, uint32_t time, uint8_t protocol, uint8_t channel, int8_t rssi,
+                   const uint8_t* frame, size_t size)
+{
+    uint8_t record[1 + CAPTURE_RX_SIZE + CAPTURE_FRAME_MAX];
+
+    if (!CAPTURE_Active() || size == 0)
+        return;
+    if (size > CAPTURE_FRAME_MAX)
+        size = CAPTURE_FRAME_MAX;
+
+    record[0] = CAPTURE_RX_SIZE + size;
+    record[1] = CAPTURE_RX;
+    CAPTURE_Put32(&record[2], ms);
+    CAPTURE_Put32(&record[6], time);
+    record[10] = protocol;
+    record[11] = channel;
+    record[12] = (uint8_t) rssi;
+    memcpy(&record[13], frame, size);
+
+    if (!CAPTURE_Lock())
+    {
+        CAPTURE_stats.dropped++;
+        return;
+    }
+
+    /* CAPTURE_Stop() came in between, the buffers may be gone */
+    if (!CAPTURE_Active())
+    {
+        CAPTURE_Unlock();
+        return;
+    }
+
+    if (__atomic_load_n(&ref_pending, __ATOMIC_ACQUIRE) &&
+        CAPTURE_Append(ref_record, sizeof(ref_record), ms))
+        __atomic_store_n(&ref_pending, 0, __ATOMIC_RELEASE);
+
+    if (CAPTURE_Append(record, 1 + record[0], ms))
+        CAPTURE_stats.frames++;
+    else
+        CAPTURE_stats.dropped++;
+
+    CAPTURE_Unlock();
+}
+
+/* station position for the decoder, written in front of the next frame */
+bool CAPTURE_Ref(float lat, float lon, int alt, int geoid)
+{
+    if (!CAPTURE_Active() || __atomic_load_n(&ref_pending, __ATOMIC_ACQUIRE))
+        return false;
+
+    ref_record[0] = CAPTURE_REF_SIZE;
+    ref_record[1] = CAPTURE_REF;
+    CAPTURE_Put32(&ref_record[2], (uint32_t) (int32_t) lround(lat * 1e7));
+    CAPTURE_Put32(&ref_record[6], (uint32_t) (int32_t) lround(lon * 1e7));
+    CAPTURE_Put16(&ref_record[10], (uint16_t) (int16_t) alt);
+    CAPTURE_Put16(&ref_record[12], (uint16_t) (int16_t) geoid);
+
+    __atomic_store_n(&ref_pending, 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* loop(): writes full buffers, and the one being filled after CAPTURE_FLUSH_MS */
+void CAPTURE_Loop(uint32_t ms)
+{
+    if (buffers == NULL)
+        return;
+
+    if (fill_records && ms - fill_ms >= CAPTURE_FLUSH_MS && CAPTURE_Lock())
+    {
+        CAPTURE_Seal();
+        CAPTURE_Unlock();
+    }
+    CAPTURE_Write();
+}
+
+/* record without its length byte */
+bool CAPTURE_Decode(const uint8_t* record, size_t size, capture_record_t* rec)
+{
+    if (size == 0)
+        return false;
+
+    rec->type = record[0];
+    switch (rec->type)
+    {
+        case CAPTURE_REF:
+            if (size != CAPTURE_REF_SIZE)
+                return false;
+            rec->lat   = (int32_t) CAPTURE_Get32(&record[1]) / 1e7;
+            rec->lon   = (int32_t) CAPTURE_Get32(&record[5]) / 1e7;
+            rec->alt   = (int16_t) CAPTURE_Get16(&record[9]);
+            rec->geoid = (int16_t) CAPTURE_Get16(&record[11]);
+            return true;
+        case CAPTURE_RX:
+            if (size <= CAPTURE_RX_SIZE)
+                return false;
+            rec->ms       = CAPTURE_Get32(&record[1]);
+            rec->time     = CAPTURE_Get32(&record[5]);
+            rec->protocol = record[9];
+            rec->channel  = record[10];
+            rec->rssi     = (int8_t) record[11];
+            rec->size     = size - CAPTURE_RX_SIZE;
+            memcpy(rec->frame, &record[CAPTURE_RX_SIZE], rec->size);
+            return true;
+        default:
+            return false;
+    }
+}
+
+#if defined(ESP32)
+
+#include <FS.h>
+#include <SPIFFS.h>
+#if defined(TTGO)
+#include <SD.h>
+#include <SPI.h>
+
+#include "config.h"
+#endif
+
+static File     capture_file;
+#if defined(TTGO)
+static SPIClass capture_spi(HSPI);  /* the radio is on VSPI */
+#endif
+
+static size_t CAPTURE_File_write(const uint8_t* buf, size_t size)
+{
+    size_t n = capture_file.write(buf, size);
+
+    capture_file.flush();
+    return n;
+}
+
+/*
+ * appends to CAPTURE_PATH on the SD card (TTGO), or on SPIFFS. Other
+ * boards have no SD slot on these pins, the T-Beam uses 14, 2, 15 and 13
+ * itself, so sd is ignored there.
+ */
+bool CAPTURE_Open(bool sd)
+{
+    fs::FS* fs = &SPIFFS;
+
+#if defined(TTGO)
+    if (sd)
+    {
+        /* SD.begin() keeps a card mounted on another bus */
+        SD.end();
+        capture_spi.begin(SD_SCK, SD_MISO, SD_MOSI, SD_CS);
+        if (SD.begin(SD_CS, capture_spi) && SD.cardType() != CARD_NONE)
+            fs = &SD;
+        else
+            Serial.println(F("capture: no SD card, using SPIFFS"));
+    }
+#endif
+
+    capture_file = fs->open(CAPTURE_PATH, FILE_APPEND);
+    if (!capture_file)
+        return false;
+
+    /* a write cut short by a reset, pad up to the next sector */
+    size_t size = capture_file.size();
+    while (size % CAPTURE_SECTOR)
+    {
+        capture_file.write((uint8_t) 0);
+        size++;
+    }
+
+    return CAPTURE_Start(CAPTURE_File_write, size == 0);
+}
+
+#endif /* ESP32 */
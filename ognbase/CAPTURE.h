@@ -0,0 +1,86 @@
+/*
+ * CAPTURE.h
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef CAPTUREHELPER_H
+#define CAPTUREHELPER_H
+
+#define CAPTURE_SECTOR      512
+#define CAPTURE_BUFFER      (8 * CAPTURE_SECTOR)    /* two of them, written whole sectors at a time */
+#define CAPTURE_FLUSH_MS    10000                   /* a buffer is written at the latest after that */
+#define CAPTURE_MAGIC       "OGNCAP1\n"             /* first bytes of the file */
+#define CAPTURE_MAGIC_SIZE  8
+#define CAPTURE_PATH        "/capture.bin"
+#define CAPTURE_FRAME_MAX   (255 - 12)              /* record length is a byte */
+
+/*
+ * Record types. A record is a length byte (bytes that follow it), the
+ * type and the fields, little endian. A length of 0 pads the rest of
+ * the sector.
+ */
+enum
+{
+    CAPTURE_REF = 'R',      /* int32 lat, int32 lon (1e-7 deg), int16 alt, int16 geoid separation (m) */
+    CAPTURE_RX  = 'F'       /* uint32 millis, uint32 GNSS time, protocol, channel, int8 rssi, raw frame */
+};
+
+typedef struct capture_record
+{
+    uint8_t  type;
+    uint32_t ms;
+    uint32_t time;
+    uint8_t  protocol;
+    uint8_t  channel;
+    int8_t   rssi;
+    uint8_t  size;
+    uint8_t  frame[CAPTURE_FRAME_MAX];
+    float    lat;
+    float    lon;
+    int16_t  alt;
+    int16_t  geoid;
+} capture_record_t;
+
+typedef struct capture_stats
+{
+    uint32_t frames;
+    uint32_t dropped;       /* both buffers full, or a flush in progress */
+    uint32_t bytes;         /* written to the file */
+    uint32_t errors;        /* short writes, capture stops */
+} capture_stats_t;
+
+/* writes size bytes, a multiple of CAPTURE_SECTOR, returns what it wrote */
+typedef size_t (*capture_write_t)(const uint8_t* buf, size_t size);
+
+bool CAPTURE_Start(capture_write_t write, bool magic);
+void CAPTURE_Stop();
+bool CAPTURE_Active();
+void CAPTURE_Frame(uint32_t ms, uint32_t time, uint8_t protocol, uint8_t channel, int8_t rssi,
+                   const uint8_t* frame, size_t size);
+bool CAPTURE_Ref(float lat, float lon, int alt, int geoid);
+void CAPTURE_Loop(uint32_t ms);
+bool CAPTURE_Decode(const uint8_t* record, size_t size, capture_record_t* rec);
+
+#if defined(ESP32)
+bool CAPTURE_Open(bool sd);
+#endif /* ESP32 */
+
+extern capture_stats_t CAPTURE_stats;
+
+#endif /* CAPTUREHELPER_H */
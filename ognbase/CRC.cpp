@@ -0,0 +1,74 @@
+/*
+ * CRC.cpp
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * CRC-CCITT (poly 0x1021, MSB first), the same as update_crc_ccitt() of
+ * lib_crc, but slice-by-8: table k holds the CRC of a byte followed by k
+ * zero bytes, so eight bytes are folded in with eight lookups and no
+ * dependency between them.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CRC.h"
+
+#define CRC_CCITT_POLY  0x1021
+
+static uint16_t crc_ccitt_tab[CRC_CCITT_SLICES][256];  /* 4 kB, in RAM for the RF task */
+static bool     crc_ccitt_init = false;
+
+void CRC_setup()
+{
+    if (crc_ccitt_init)
+        return;
+
+    for (int b = 0; b < 256; b++)
+    {
+        uint16_t crc = b << 8;
+
+        for (int bit = 0; bit < 8; bit++)
+            crc = crc & 0x8000 ? (crc << 1) ^ CRC_CCITT_POLY : crc << 1;
+        crc_ccitt_tab[0][b] = crc;
+    }
+
+    for (int k = 1; k < CRC_CCITT_SLICES; k++)
+        for (int b = 0; b < 256; b++)
+        {
+            uint16_t crc = crc_ccitt_tab[k - 1][b];
+            crc_ccitt_tab[k][b] = (crc << 8) ^ crc_ccitt_tab[0][crc >> 8];
+        }
+
+    crc_ccitt_init = true;
+}
+
+uint16_t CRC_ccitt(uint16_t crc, const uint8_t* buf, size_t len)
+{
+    if (!crc_ccitt_init)
+        CRC_setup();
+
+    for ( ; len >= CRC_CCITT_SLICES; len -= CRC_CCITT_SLICES, buf += CRC_CCITT_SLICES)
+        crc = crc_ccitt_tab[7][(crc >> 8) ^ buf[0]] ^
+              crc_ccitt_tab[6][(crc & 0xFF) ^ buf[1]] ^
+              crc_ccitt_tab[5][buf[2]] ^
+              crc_ccitt_tab[4][buf[3]] ^
+              crc_ccitt_tab[3][buf[4]] ^
+              crc_ccitt_tab[2][buf[5]] ^
+              crc_ccitt_tab[1][buf[6]] ^
+              crc_ccitt_tab[0][buf[7]];
+
+    while (len--)
+        crc = (crc << 8) ^ crc_ccitt_tab[0][(crc >> 8) ^ *buf++];
+
+    return crc;
+}
@@ -0,0 +1,34 @@
+/*
+ * CRC.h
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef CRCHELPER_H
+#define CRCHELPER_H
+
+#define CRC_CCITT_SLICES        8       /* bytes per step, tables of 256 entries each */
+
+/* CRC-CCITT state after the NRF905/FLARM address bytes 31 FA B6 */
+#define CRC_CCITT_LEGACY_FFFF   0x051E
+#define CRC_CCITT_LEGACY_0000   0xC982
+
+void     CRC_setup();
+uint16_t CRC_ccitt(uint16_t crc, const uint8_t* buf, size_t len);
+
+#endif /* CRCHELPER_H */
@@ -0,0 +1,150 @@
+/*
+ * DEDUP.cpp
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * Duplicate frames in front of the protocol decoders. With an ognrelay
+ * about, the base hears an aircraft directly and once more on
+ * RF_RELAY_CHANNEL, and Legacy sends the same frame in both slots of a
+ * second. Each copy would go through decryption, FEC and decoding only
+ * to overwrite the Container[] entry of the first.
+ *
+ * A fingerprint is the address of the frame (plain in every protocol,
+ * see DEDUP_Address()) and a FNV-1a hash of the raw payload, kept for
+ * DEDUP_WINDOW_MS. Hash and window keep it cheap: a frame that really
+ * differs only in bits the hash misses would have to come within the
+ * window, and the next one of that aircraft gets through anyway.
+ * Fingerprints live in a small table probed DEDUP_WAYS slots from the
+ * hash; expired slots are reused, when all are live the oldest goes.
+ *
+ * Duplicates are counted by the source they came on and the source of
+ * the first copy, so the relay coverage that only adds duplicates shows.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "DEDUP.h"
+#include "RELAY.h"
+
+#include <protocol.h>
+
+#define DEDUP_MASK          (DEDUP_SLOTS - 1)
+#define DEDUP_FNV_BASIS     2166136261UL
+#define DEDUP_FNV_PRIME     16777619UL
+
+typedef struct dedup_slot
+{
+    uint32_t hash;
+    uint32_t addr;
+    uint32_t ms;
+    uint8_t  source;
+    bool     used;
+} dedup_slot_t;
+
+dedup_stats_t DEDUP_stats;
+
+static dedup_slot_t slots[DEDUP_SLOTS];
+
+void DEDUP_Reset()
+{
+    memset(&DEDUP_stats, 0, sizeof(DEDUP_stats));
+    memset(slots, 0, sizeof(slots));
+}
+
+/* 24 bit address, in the clear ahead of anything encrypted or FEC coded */
+uint32_t DEDUP_Address(uint8_t protocol, const uint8_t* payload)
+{
+    const uint8_t* p = payload;
+
+    switch (protocol)
+    {
+        case RF_PROTOCOL_P3I:   /* after the sync byte */
+        case RF_PROTOCOL_FANET: /* after the header byte */
+            p++;
+            break;
+        case RF_PROTOCOL_LEGACY:
+        case RF_PROTOCOL_OGNTP:
+        default:
+            break;
+    }
+
+    return p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16;
+}
+
+/* true: a copy of a frame seen in the last DEDUP_WINDOW_MS, drop it */
+bool DEDUP_Check(uint8_t protocol, const uint8_t* payload, size_t size, uint8_t source, uint32_t ms)
+{
+    uint32_t      hash   = DEDUP_FNV_BASIS ^ protocol;
+    uint32_t      addr   = size >= 4 ? DEDUP_Address(protocol, payload) : 0;
+    dedup_slot_t* victim = NULL;
+
+    if (source >= DEDUP_SOURCES)
+        source = DEDUP_DIRECT;
+    DEDUP_stats.frames[source]++;
+
+    /* the hop count differs between the copies of a relay chain */
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ (i == 3 ? payload[i] & ~RELAY_HopMask(protocol) : payload[i])) * DEDUP_FNV_PRIME;
+
+    for (uint8_t w = 0; w < DEDUP_WAYS; w++)
+    {
+        dedup_slot_t* s = &slots[(hash + w) & DEDUP_MASK];
+
+        if (!s->used || ms - s->ms >= DEDUP_WINDOW_MS)
+        {
+            if (victim == NULL || victim->used)
+                victim = s;
+            continue;
+        }
+
+        if (s->hash == hash && s->addr == addr)
+        {
+            DEDUP_stats.duplicates[source][s->source]++;
+            return true;
+        }
+
+        if (victim == NULL || (victim->used && (int32_t) (s->ms - victim->ms) < 0))
+            victim = s;
+    }
+
+    if (victim->used && ms - victim->ms < DEDUP_WINDOW_MS)
+        DEDUP_stats.evicted++;
+
+    victim->hash   = hash;
+    victim->addr   = addr;
+    victim->ms     = ms;
+    victim->source = source;
+    victim->used   = true;
+    return false;
+}
+
+size_t DEDUP_Report(char* buf, size_t size)
+{
+    size_t len;
+
+    len = snprintf(buf, size,
+                   "{\"t\":\"dedup\",\"dedup\":{\"window\":%u,\"direct\":[%lu,%lu,%lu],\"relay\":[%lu,%lu,%lu],\"evicted\":%lu}}",
+                   DEDUP_WINDOW_MS,
+                   (unsigned long) DEDUP_stats.frames[DEDUP_DIRECT],
+                   (unsigned long) DEDUP_stats.duplicates[DEDUP_DIRECT][DEDUP_DIRECT],
+                   (unsigned long) DEDUP_stats.duplicates[DEDUP_DIRECT][DEDUP_RELAY],
+                   (unsigned long) DEDUP_stats.frames[DEDUP_RELAY],
+                   (unsigned long) DEDUP_stats.duplicates[DEDUP_RELAY][DEDUP_DIRECT],
+                   (unsigned long) DEDUP_stats.duplicates[DEDUP_RELAY][DEDUP_RELAY],
+                   (unsigned long) DEDUP_stats.evicted);
+
+    return len < size ? len : 0;
+}
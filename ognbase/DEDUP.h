@@ -0,0 +1,51 @@
+/*
+ * DEDUP.h
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef DEDUPHELPER_H
+#define DEDUPHELPER_H
+
+#define DEDUP_SLOTS         512     /* fingerprints, power of 2 */
+#define DEDUP_WAYS          8       /* slots probed per fingerprint */
+#define DEDUP_WINDOW_MS     1500    /* both slots of a second and the relay hop */
+#define DEDUP_REPORT_SIZE   256
+
+enum
+{
+    DEDUP_DIRECT,                   /* heard from the aircraft */
+    DEDUP_RELAY,                    /* retransmitted by an ognrelay on RF_RELAY_CHANNEL */
+    DEDUP_SOURCES
+};
+
+typedef struct dedup_stats
+{
+    uint32_t frames[DEDUP_SOURCES];
+    uint32_t duplicates[DEDUP_SOURCES][DEDUP_SOURCES];  /* [heard on][first heard on] */
+    uint32_t evicted;               /* live fingerprints pushed out, cache too small */
+} dedup_stats_t;
+
+void     DEDUP_Reset();
+bool     DEDUP_Check(uint8_t protocol, const uint8_t* payload, size_t size, uint8_t source, uint32_t ms);
+uint32_t DEDUP_Address(uint8_t protocol, const uint8_t* payload);
+size_t   DEDUP_Report(char* buf, size_t size);
+
+extern dedup_stats_t DEDUP_stats;
+
+#endif /* DEDUPHELPER_H */
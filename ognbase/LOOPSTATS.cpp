@@ -0,0 +1,83 @@
+/*
+ * LOOPSTATS.cpp
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * How long one loop() takes, from its start to where it would sleep
+ * until the next timer event, as a histogram with bins doubling from
+ * LOOPSTATS_FIRST_US. Whatever keeps loop() from coming round (a
+ * delay(), a blocking connect) keeps the frame queue of the RF task,
+ * APRSQ and the web server waiting as long; the sleep itself does not.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "LOOPSTATS.h"
+
+loopstats_t LOOPSTATS_stats;
+
+static uint32_t loop_start_us = 0;
+static bool     loop_started  = false;
+
+void LOOPSTATS_Reset()
+{
+    memset(&LOOPSTATS_stats, 0, sizeof(LOOPSTATS_stats));
+    loop_started = false;
+}
+
+/* top of loop(), micros() */
+void LOOPSTATS_Start(uint32_t us)
+{
+    loop_start_us = us;
+    loop_started  = true;
+}
+
+/* loop() is done and goes idle, micros() */
+void LOOPSTATS_Iteration(uint32_t us)
+{
+    uint32_t took = us - loop_start_us;
+    uint8_t  bin  = 0;
+
+    if (!loop_started)
+        return;
+    loop_started = false;
+
+    while (bin < LOOPSTATS_BINS - 1 && took >= (uint32_t) LOOPSTATS_FIRST_US << bin)
+        bin++;
+
+    LOOPSTATS_stats.iterations++;
+    LOOPSTATS_stats.bins[bin]++;
+    if (took > LOOPSTATS_stats.max_us)
+        LOOPSTATS_stats.max_us = took;
+}
+
+size_t LOOPSTATS_Report(char* buf, size_t size)
+{
+    size_t len;
+
+    len = snprintf(buf, size, "{\"t\":\"loop\",\"loop\":{\"iterations\":%lu,\"max_us\":%lu,\"first_us\":%u,\"bins\":[",
+                   (unsigned long) LOOPSTATS_stats.iterations, (unsigned long) LOOPSTATS_stats.max_us,
+                   LOOPSTATS_FIRST_US);
+
+    for (uint8_t b = 0; b < LOOPSTATS_BINS && len < size; b++)
+        len += snprintf(buf + len, size - len, "%s%lu", b ? "," : "",
+                        (unsigned long) LOOPSTATS_stats.bins[b]);
+
+    if (len < size)
+        len += snprintf(buf + len, size - len, "]}}");
+
+    return len < size ? len : 0;
+}
@@ -0,0 +1,43 @@
+/*
+ * LOOPSTATS.h
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LOOPSTATSHELPER_H
+#define LOOPSTATSHELPER_H
+
+#define LOOPSTATS_BINS          16
+#define LOOPSTATS_FIRST_US      128     /* upper edge of the first bin, doubling per bin */
+#define LOOPSTATS_REPORT_SIZE   256
+
+typedef struct loopstats
+{
+    uint32_t iterations;
+    uint32_t bins[LOOPSTATS_BINS];      /* the last one takes all above */
+    uint32_t max_us;
+} loopstats_t;
+
+void   LOOPSTATS_Reset();
+void   LOOPSTATS_Start(uint32_t us);
+void   LOOPSTATS_Iteration(uint32_t us);
+size_t LOOPSTATS_Report(char* buf, size_t size);
+
+extern loopstats_t LOOPSTATS_stats;
+
+#endif /* LOOPSTATSHELPER_H */
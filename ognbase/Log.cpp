@@ -2,6 +2,13 @@
  * Log.cpp
  * Copyright (C) 2019-2020 Linar Yusupov
  *
+ * The LOG_*() macros claim a record in a bounded ring (Vyukov's MPSC
+ * queue: a sequence number per slot, a CAS on the head), copy the
+ * arguments into it and publish it. That is safe from the RF task and
+ * loop() alike and never blocks or allocates; a full ring drops the
+ * record and counts it. Log_loop() in loop() is the only reader, it
+ * does the printf work and packs the lines into datagrams.
+ *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
  * the Free Software Foundation, either version 3 of the License, or
@@ -22,19 +29,280 @@
 #include "PNET.h"
 #include "global.h"
 
+#include <stdio.h>
+#include <string.h>
+
+#define LOG_MASK    (LOG_RING - 1)
+
+log_stats_t Log_stats;
+
+static log_record_t ring[LOG_RING];
+static uint32_t     ring_head = 0;              /* next to claim, all writers */
+static uint32_t     ring_tail = 0;              /* next to format, Log_loop() */
+static char         batch[LOG_DATAGRAM];
+static size_t       batch_len = 0;
+static uint32_t     batch_ms  = 0;              /* first line in it */
+
+static void Log_count(uint32_t* counter)
+{
+    __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+}
+
+log_record_t* Log_claim(uint8_t level, const char* fmt)
+{
+    uint32_t      pos = __atomic_load_n(&ring_head, __ATOMIC_RELAXED);
+    log_record_t* r;
+
+    for (;;)
+    {
+        r = &ring[pos & LOG_MASK];
+
+        /* seq counts from 0 in each slot, not from its index: no setup */
+        int32_t dif = (int32_t) (__atomic_load_n(&r->seq, __ATOMIC_ACQUIRE) - (pos & ~LOG_MASK));
+
+        if (dif == 0)
+        {
+            if (__atomic_compare_exchange_n(&ring_head, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if (dif < 0)
+        {
+            Log_count(&Log_stats.dropped);          /* Log_loop() has not caught up */
+            return NULL;
+        }
+        else
+            pos = __atomic_load_n(&ring_head, __ATOMIC_RELAXED);
+    }
+
+    r->ms       = millis();
+    r->fmt      = fmt;
+    r->level    = level;
+    r->argc     = 0;
+    r->text_len = 0;
+    r->text[LOG_TEXT - 1] = '\0';
+    return r;
+}
+
+void Log_commit(log_record_t* r)
+{
+    Log_count(&Log_stats.records);
+    __atomic_store_n(&r->seq, r->seq + 1, __ATOMIC_RELEASE);
+}
+
+int Log_arg(log_record_t* r, uint8_t type)
+{
+    if (r->argc >= LOG_ARGS)
+    {
+        Log_count(&Log_stats.truncated);
+        return -1;
+    }
+    r->type[r->argc] = type;
+    return r->argc++;
+}
+
+/* copied, what does not fit is cut */
+void Log_put(log_record_t* r, const char* s)
+{
+    int n = Log_arg(r, LOG_ARG_STR);
+
+    if (n < 0)
+        return;
+
+    if (s == NULL)
+        s = "(null)";
+
+    size_t room = r->text_len < LOG_TEXT - 1 ? LOG_TEXT - 1 - r->text_len : 0;
+    size_t len  = strlen(s);
+
+    if (len > room)
+    {
+        len = room;
+        Log_count(&Log_stats.truncated);
+    }
+    if (room == 0)
+    {
+        r->arg[n].i = LOG_TEXT - 1;                 /* the '\0' Log_claim() left there */
+        return;
+    }
+
+    r->arg[n].i = r->text_len;
+    memcpy(&r->text[r->text_len], s, len);
+    r->text[r->text_len + len] = '\0';
+    r->text_len += len + 1;
+}
+
+/* one line, printf() with the stored arguments; no '*' width or precision */
+static size_t Log_format(const log_record_t* r, char* line, size_t size)
+{
+    const char* p   = r->fmt;
+    uint8_t     n   = 0;
+    size_t      len = snprintf(line, size, "%lu %c ", (unsigned long) r->ms,
+                          r->level <= LOG_LEVEL_DEBUG ? "-EWID"[r->level] : '?');
+
+    while (*p && len < size - 1)
+    {
+        if (*p != '%')
+        {
+            line[len++] = *p++;
+            continue;
+        }
+        if (p[1] == '%')
+        {
+            line[len++] = '%';
+            p += 2;
+            continue;
+        }
+
+        /* flags, width, precision; the length modifier is ours to choose */
+        char   spec[16];
+        size_t s = 0;
+
+        spec[s++] = *p++;
+        while (*p && strchr("-+ #0123456789.", *p) && s < sizeof(spec) - 3)
+            spec[s++] = *p++;
+        while (*p && strchr("hlLqjzt", *p))
+            p++;
+        if (*p == '\0')
+            break;
+
+        char c = *p++;
+        int  w = -1;
+
+        if (n < r->argc)
+            w = n++;
+
+        if (strchr("diouxXc", c) && w >= 0 && r->type[w] == LOG_ARG_INT)
+        {
+            if (c != 'c')
+                spec[s++] = 'l';
+            spec[s++] = c;
+            spec[s]   = '\0';
+            len      += snprintf(line + len, size - len, spec, r->arg[w].i);
+        }
+        else if (strchr("fFeEgGaA", c) && w >= 0 &&
+                 (r->type[w] == LOG_ARG_DOUBLE || r->type[w] == LOG_ARG_INT))
+        {
+            spec[s++] = c;
+            spec[s]   = '\0';
+            len      += snprintf(line + len, size - len, spec,
+                                 r->type[w] == LOG_ARG_DOUBLE ? r->arg[w].d : (double) r->arg[w].i);
+        }
+        else if (c == 's' && w >= 0 && r->type[w] == LOG_ARG_STR)
+        {
+            spec[s++] = c;
+            spec[s]   = '\0';
+            len      += snprintf(line + len, size - len, spec, &r->text[r->arg[w].i]);
+        }
+        else if (c == 'p' && w >= 0 && r->type[w] == LOG_ARG_PTR)
+            len += snprintf(line + len, size - len, "%p", r->arg[w].p);
+        else
+            len += snprintf(line + len, size - len, "%%%c?", c);    /* missing or mismatched argument */
+    }
+
+    if (len > size - 1)
+        len = size - 1;
+    return len;
+}
+
+static void Log_send()
+{
+    if (batch_len == 0)
+        return;
+    SoC->WiFi_transmit_UDP_debug(ogn_debugport, (byte *) batch, batch_len);
+    Log_stats.datagrams++;
+    Log_stats.bytes += batch_len;
+    batch_len = 0;
+}
+
+/* a line without its '\n', into the datagram being packed */
+static void Log_append(const char* line, size_t len, uint32_t ms)
+{
+    if (len > LOG_DATAGRAM - 1)
+    {
+        len = LOG_DATAGRAM - 1;
+        Log_stats.truncated++;
+    }
+    if (batch_len + len + 1 > LOG_DATAGRAM)
+        Log_send();
+    if (batch_len == 0)
+        batch_ms = ms;
+
+    memcpy(&batch[batch_len], line, len);
+    batch_len += len;
+    batch[batch_len++] = '\n';
+}
+
+static void Log_drain(uint32_t ms)
+{
+    char line[LOG_LINE];
+
+    for (;;)
+    {
+        log_record_t* r = &ring[ring_tail & LOG_MASK];
+
+        if (__atomic_load_n(&r->seq, __ATOMIC_ACQUIRE) != (ring_tail & ~LOG_MASK) + 1)
+            break;
+
+        if (Log_enabled())
+            Log_append(line, Log_format(r, line, sizeof(line)), ms);
+
+        __atomic_store_n(&r->seq, (ring_tail & ~LOG_MASK) + LOG_RING, __ATOMIC_RELEASE);
+        ring_tail++;
+    }
+}
+
+/* loop(): formats what the ring holds, sends a datagram when full or LOG_FLUSH_MS old */
+void Log_loop(uint32_t ms)
+{
+    Log_drain(ms);
+    if (!Log_enabled())
+        batch_len = 0;
+    else if (batch_len && ms - batch_ms >= LOG_FLUSH_MS)
+        Log_send();
+}
+
+void Log_flush()
+{
+    Log_drain(millis());
+    Log_send();
+}
+
+/* loop(): text formatted already, after what the ring holds */
+void Log_write(const char* s, size_t len)
+{
+    char     line[LOG_DATAGRAM];
+    uint32_t ms = millis();
+    size_t   n;
+
+    if (!Log_enabled())
+        return;
+    Log_drain(ms);
+
+    /* one line each, as the LOG_*() lines */
+    while (len && (s[len - 1] == '\n' || s[len - 1] == '\r'))
+        len--;
+    if (len == 0)
+        return;
+
+    Log_count(&Log_stats.records);
+    n = snprintf(line, sizeof(line), "%lu I ", (unsigned long) ms);
+    if (n + len > sizeof(line) - 1)
+    {
+        len = sizeof(line) - 1 - n;
+        Log_stats.truncated++;
+    }
+    memcpy(line + n, s, len);
+    Log_append(line, n + len, ms);
+}
 
 void Logger_send_udp(String* buf)
 {
-    if (ogn_debug && !ognrelay_enable)
+    if (Log_enabled())
     {
-        int  debug_len = buf->length() + 1;
-        byte debug_msg[debug_len];
-        buf->getBytes(debug_msg, debug_len);
-        SoC->WiFi_transmit_UDP_debug(ogn_debugport, debug_msg, debug_len);
-        
+        Log_write(buf->c_str(), buf->length());
+
         if(remotelogs_enable){
-          char *encrypted;
-          size_t encrypted_len;       
           //PNETencrypt(debug_msg, debug_len, &encrypted, &encrypted_len);
           //SoC->WiFi_transmit_UDP(remotelogs_server.c_str(), remotelogs_port, (byte*)encrypted, encrypted_len);
           //free(encrypted);
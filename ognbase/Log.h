@@ -21,6 +21,170 @@
 
 #include "SoftRF.h"
 
+#include <type_traits>
+
+/*
+ * Debug log to the UDP debug port. LOG_ERROR() .. LOG_DEBUG() take a
+ * printf format, which has to be a literal, and up to LOG_ARGS
+ * arguments. Sites above LOG_LEVEL compile to nothing, the others cost
+ * a test of ogn_debug while it is off. The arguments are stored in a
+ * ring, strings copied; Log_loop() formats them in loop() and sends
+ * as many lines per datagram as fit.
+ */
+#define LOG_LEVEL_NONE      0
+#define LOG_LEVEL_ERROR     1
+#define LOG_LEVEL_WARN      2
+#define LOG_LEVEL_INFO      3
+#define LOG_LEVEL_DEBUG     4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL           LOG_LEVEL_INFO
+#endif
+
+#define LOG_RING            32      /* records, power of 2 */
+#define LOG_ARGS            6
+#define LOG_TEXT            48      /* bytes of %s arguments per record */
+#define LOG_LINE            256
+#define LOG_DATAGRAM        1024
+#define LOG_FLUSH_MS        500     /* a datagram waits at most that long for more lines */
+
+enum
+{
+    LOG_ARG_INT,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_STR,                    /* offset into text */
+    LOG_ARG_PTR
+};
+
+typedef struct log_record
+{
+    uint32_t    seq;                /* round of the ring and state, see Log_claim() */
+    uint32_t    ms;
+    const char* fmt;
+    uint8_t     level;
+    uint8_t     argc;
+    uint8_t     text_len;
+    uint8_t     type[LOG_ARGS];
+    union
+    {
+        long        i;
+        double      d;
+        const void* p;
+    } arg[LOG_ARGS];
+    char        text[LOG_TEXT];
+} log_record_t;
+
+typedef struct log_stats
+{
+    uint32_t records;
+    uint32_t dropped;               /* ring full */
+    uint32_t truncated;             /* more arguments or string bytes than a record holds */
+    uint32_t datagrams;
+    uint32_t bytes;
+} log_stats_t;
+
+extern bool        ogn_debug;
+extern bool        ognrelay_enable;
+extern log_stats_t Log_stats;
+
+static inline bool Log_enabled()
+{
+    return ogn_debug && !ognrelay_enable;
+}
+
+log_record_t* Log_claim(uint8_t level, const char* fmt);
+void          Log_commit(log_record_t* r);
+int           Log_arg(log_record_t* r, uint8_t type);
+void          Log_put(log_record_t* r, const char* s);
+void          Log_write(const char* s, size_t len);
+void          Log_loop(uint32_t ms);
+void          Log_flush();
+
+static inline void Log_put(log_record_t* r, char* s)
+{
+    Log_put(r, (const char *) s);
+}
+
+static inline void Log_put(log_record_t* r, const String& s)
+{
+    Log_put(r, s.c_str());
+}
+
+static inline void Log_put(log_record_t* r, double v)
+{
+    int n = Log_arg(r, LOG_ARG_DOUBLE);
+
+    if (n >= 0)
+        r->arg[n].d = v;
+}
+
+template <typename T>
+static inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+Log_put(log_record_t* r, T v)
+{
+    int n = Log_arg(r, LOG_ARG_INT);
+
+    if (n >= 0)
+        r->arg[n].i = (long) v;
+}
+
+template <typename T>
+static inline void Log_put(log_record_t* r, T* p)
+{
+    int n = Log_arg(r, LOG_ARG_PTR);
+
+    if (n >= 0)
+        r->arg[n].p = p;
+}
+
+static inline void Log_pack(log_record_t* r)
+{ }
+
+template <typename T, typename ... Rest>
+static inline void Log_pack(log_record_t* r, const T& first, const Rest&... rest)
+{
+    Log_put(r, first);
+    Log_pack(r, rest...);
+}
+
+template <typename ... Args>
+void Log_record(uint8_t level, const char* fmt, const Args&... args)
+{
+    log_record_t* r = Log_claim(level, fmt);
+
+    if (r == NULL)
+        return;
+    Log_pack(r, args...);
+    Log_commit(r);
+}
+
+#define LOG_AT(level, ...)  do { if (Log_enabled()) Log_record(level, __VA_ARGS__); } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...)      LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...)      do { } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...)       LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...)       do { } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...)       LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...)       do { } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...)      LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...)      do { } while (0)
+#endif
+
+/* loop() only, the text as it is */
 void Logger_send_udp(String *);
 void Logger_send_enc_udp(String *);
 
@@ -0,0 +1,460 @@
+/*
+ * NBP.cpp
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * Batching of the new binary protocol. All aircraft of an export cycle
+ * go into one OneMessage: a StationHeader with the sequence number and
+ * a vector of AircraftPos structs, one datagram instead of one per
+ * aircraft. A cycle with more than NBP_BATCH_MAX aircraft is split, the
+ * caller sends what NBP_Finish() returns and keeps adding.
+ *
+ * The builder is allocated once with room for a full datagram and
+ * cleared before every batch, so an export does not touch the heap.
+ *
+ * Stream mode (newprot stream) is for metered uplinks. Instead of the
+ * 32 byte structs, airc_stream carries one record per aircraft:
+ *
+ *   keyframe  0x80 | slot, address (3 bytes LE), info, then time, lat
+ *             and lon relative to the StationHeader, altitude, course
+ *             and speed
+ *   delta     slot, then time, lat, lon, altitude, course and speed
+ *             relative to the previous record of the slot
+ *
+ * Unsigned values are LEB128 varints, signed ones zigzag coded first.
+ * Positions are in 1/1000 arc minute, what APRS carries anyway. An
+ * aircraft gets a keyframe when it is new, its info changes or its last
+ * one is NBP_STREAM_KEYFRAME s old. A receiver that misses a sequence
+ * number forgets all slots of the station and waits for keyframes.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "NBP.h"
+
+#include "ogn_service_generated.h"
+
+using namespace ogn;
+
+nbp_stats_t NBP_stats;
+
+static flatbuffers::FlatBufferBuilder nbp_builder(NBP_DATAGRAM_SIZE);
+static AircraftPos                    nbp_batch[NBP_BATCH_MAX];
+static uint8_t                        nbp_stream[NBP_STREAM_SIZE];
+static size_t                         nbp_stream_len = 0;
+static nbp_slot_t                     nbp_tx[NBP_STREAM_SLOTS];
+static size_t                         nbp_count = 0;
+static uint32_t                       nbp_sequence = 0;
+static uint8_t                        nbp_mode = NBP_MODE_BATCH;
+
+static struct
+{
+    char     callsign[NBP_CALLSIGN_SIZE];
+    uint32_t timestamp;
+    float    lat;
+    float    lon;
+    int32_t  alt;
+    int32_t  lat_units;
+    int32_t  lon_units;
+} nbp_station;
+
+int32_t NBP_Units(float deg)
+{
+    return (int32_t) floor((double) deg * NBP_STREAM_UNITS + 0.5);
+}
+
+static uint32_t NBP_zigzag(int32_t v)
+{
+    return ((uint32_t) v << 1) ^ (uint32_t) (v >> 31);
+}
+
+static int32_t NBP_unzigzag(uint32_t v)
+{
+    return (int32_t) (v >> 1) ^ -(int32_t) (v & 1);
+}
+
+static uint8_t* NBP_put_varint(uint8_t* p, uint32_t v)
+{
+    while (v >= 0x80)
+    {
+        *p++ = (uint8_t) v | 0x80;
+        v  >>= 7;
+    }
+    *p++ = (uint8_t) v;
+    return p;
+}
+
+/* NULL when the record runs past end */
+static const uint8_t* NBP_get_varint(const uint8_t* p, const uint8_t* end, uint32_t* v)
+{
+    *v = 0;
+    for (uint8_t shift = 0; p && p < end && shift < 35; shift += 7)
+    {
+        *v |= (uint32_t) (*p & 0x7F) << shift;
+        if (!(*p++ & 0x80))
+            return p;
+    }
+    return NULL;
+}
+
+/* course difference in -180 .. 179, so a turn through north stays short */
+static int32_t NBP_course_delta(uint16_t to, uint16_t from)
+{
+    return ((int32_t) to - from + 540) % 360 - 180;
+}
+
+void NBP_Reset()
+{
+    memset(&NBP_stats, 0, sizeof(NBP_stats));
+    memset(nbp_tx, 0, sizeof(nbp_tx));
+    nbp_sequence = 0;
+    nbp_count    = 0;
+}
+
+void NBP_Begin(const char* callsign, uint32_t timestamp, float lat, float lon, int32_t alt, uint8_t mode)
+{
+    strncpy(nbp_station.callsign, callsign, sizeof(nbp_station.callsign) - 1);
+    nbp_station.callsign[sizeof(nbp_station.callsign) - 1] = 0;
+    nbp_station.timestamp = timestamp;
+    nbp_station.lat       = lat;
+    nbp_station.lon       = lon;
+    nbp_station.alt       = alt;
+    nbp_station.lat_units = NBP_Units(lat);
+    nbp_station.lon_units = NBP_Units(lon);
+
+    nbp_mode       = mode;
+    nbp_count      = 0;
+    nbp_stream_len = 0;
+    NBP_stats.cycles++;
+}
+
+/* the slot of addr, or the one it takes over */
+static nbp_slot_t* NBP_slot(uint32_t addr, int32_t now, uint8_t* index)
+{
+    uint8_t oldest = 0;
+
+    addr &= 0xFFFFFF;
+    for (uint8_t n = 0; n < NBP_STREAM_SLOTS; n++)
+    {
+        if (nbp_tx[n].addr == addr)
+        {
+            *index = n;
+            return &nbp_tx[n];
+        }
+        if (nbp_tx[n].timestamp < nbp_tx[oldest].timestamp || !nbp_tx[n].addr)
+            oldest = n;
+    }
+
+    /* a free slot, an expired one or, with all of them busy, the oldest */
+    if (nbp_tx[oldest].addr && now - nbp_tx[oldest].timestamp < NBP_STREAM_EXPIRE)
+        NBP_stats.evicted++;
+
+    memset(&nbp_tx[oldest], 0, sizeof(nbp_tx[oldest]));
+    *index = oldest;
+    return &nbp_tx[oldest];
+}
+
+static void NBP_Add_stream(const ufo_t* fop)
+{
+    uint8_t     index;
+    nbp_slot_t* slot = NBP_slot(fop->addr, nbp_station.timestamp, &index);
+    uint8_t*    p    = nbp_stream + nbp_stream_len;
+    nbp_slot_t  now;
+
+    now.addr      = fop->addr & 0xFFFFFF;
+    now.info      = (fop->aircraft_type & 0x0F) << 5 | fop->stealth << 4 | fop->no_track << 3 |
+                    (fop->addr_type & 0x07);
+    now.timestamp = fop->timestamp;
+    now.lat       = NBP_Units(fop->latitude);
+    now.lon       = NBP_Units(fop->longitude);
+    now.alt       = (int32_t) fop->altitude;
+    now.course    = ((int32_t) fop->course % 360 + 360) % 360;
+    now.speed     = fop->speed < 0 ? 0 : fop->speed > 0xFFFF ? 0xFFFF : (uint16_t) fop->speed;
+    now.keyframe  = slot->keyframe;
+
+    if (!slot->addr || slot->info != now.info || now.timestamp - slot->keyframe >= NBP_STREAM_KEYFRAME)
+    {
+        *p++ = NBP_STREAM_KEY | index;
+        *p++ = now.addr;
+        *p++ = now.addr >> 8;
+        *p++ = now.addr >> 16;
+        p    = NBP_put_varint(p, now.info);
+        p    = NBP_put_varint(p, NBP_zigzag(now.timestamp - (int32_t) nbp_station.timestamp));
+        p    = NBP_put_varint(p, NBP_zigzag(now.lat - nbp_station.lat_units));
+        p    = NBP_put_varint(p, NBP_zigzag(now.lon - nbp_station.lon_units));
+        p    = NBP_put_varint(p, NBP_zigzag(now.alt));
+        p    = NBP_put_varint(p, now.course);
+        p    = NBP_put_varint(p, now.speed);
+
+        now.keyframe = now.timestamp;
+        NBP_stats.keyframes++;
+    }
+    else
+    {
+        *p++ = index;
+        p    = NBP_put_varint(p, NBP_zigzag(now.timestamp - slot->timestamp));
+        p    = NBP_put_varint(p, NBP_zigzag(now.lat - slot->lat));
+        p    = NBP_put_varint(p, NBP_zigzag(now.lon - slot->lon));
+        p    = NBP_put_varint(p, NBP_zigzag(now.alt - slot->alt));
+        p    = NBP_put_varint(p, NBP_zigzag(NBP_course_delta(now.course, slot->course)));
+        p    = NBP_put_varint(p, NBP_zigzag((int32_t) now.speed - slot->speed));
+    }
+
+    *slot          = now;
+    nbp_stream_len = p - nbp_stream;
+}
+
+/* false when the batch is full, send it with NBP_Finish() and add again */
+bool NBP_Add(const ufo_t* fop)
+{
+    if (nbp_mode == NBP_MODE_STREAM)
+    {
+        if (nbp_stream_len + NBP_STREAM_RECORD > NBP_STREAM_SIZE)
+            return false;
+
+        NBP_Add_stream(fop);
+        nbp_count++;
+        return true;
+    }
+
+    if (nbp_count >= NBP_BATCH_MAX)
+        return false;
+
+    nbp_batch[nbp_count++] = AircraftPos(fop->addr,
+                                         fop->timestamp,
+                                         fop->aircraft_type,
+                                         fop->stealth,
+                                         fop->no_track,
+                                         fop->course,
+                                         fop->speed,
+                                         fop->latitude,
+                                         fop->longitude,
+                                         fop->altitude);
+    return true;
+}
+
+size_t NBP_Count()
+{
+    return nbp_count;
+}
+
+/* the datagram for the aircraft added since the last call */
+size_t NBP_Finish(const uint8_t** buf)
+{
+    nbp_builder.Clear();
+
+    flatbuffers::Offset<flatbuffers::Vector<const AircraftPos *>> list   = 0;
+    flatbuffers::Offset<flatbuffers::Vector<uint8_t>>             stream = 0;
+
+    auto callsign = nbp_builder.CreateString(nbp_station.callsign);
+    if (nbp_mode == NBP_MODE_STREAM)
+        stream = nbp_builder.CreateVector(nbp_stream, nbp_stream_len);
+    else
+        list = nbp_builder.CreateVectorOfStructs(nbp_batch, nbp_count);
+    auto station = CreateStationHeader(nbp_builder, callsign, nbp_station.timestamp, nbp_sequence++,
+                                       nbp_station.lat, nbp_station.lon, nbp_station.alt);
+
+    nbp_builder.Finish(CreateOneMessage(nbp_builder, 0, 0, 0, station, list, stream));
+
+    NBP_stats.datagrams++;
+    NBP_stats.aircraft += nbp_count;
+    NBP_stats.bytes    += nbp_builder.GetSize();
+    nbp_count           = 0;
+    nbp_stream_len      = 0;
+
+    *buf = nbp_builder.GetBufferPointer();
+    return nbp_builder.GetSize();
+}
+
+void NBP_Receiver_Reset(nbp_receiver_t* rx)
+{
+    memset(rx, 0, sizeof(*rx));
+}
+
+static void NBP_out(ufo_t* fop, const nbp_slot_t* slot, float vs)
+{
+    memset(fop, 0, sizeof(*fop));
+    fop->addr          = slot->addr;
+    fop->addr_type     = slot->info & 0x07;
+    fop->no_track      = slot->info >> 3 & 1;
+    fop->stealth       = slot->info >> 4 & 1;
+    fop->aircraft_type = slot->info >> 5 & 0x0F;
+    fop->timestamp     = slot->timestamp;
+    fop->latitude      = (float) ((double) slot->lat / NBP_STREAM_UNITS);
+    fop->longitude     = (float) ((double) slot->lon / NBP_STREAM_UNITS);
+    fop->altitude      = slot->alt;
+    fop->course        = slot->course;
+    fop->speed         = slot->speed;
+    fop->vs            = vs;
+}
+
+/* feet per minute between two reports of a slot */
+static float NBP_vs(const nbp_slot_t* from, int32_t alt, int32_t timestamp)
+{
+    if (!from->addr || timestamp <= from->timestamp)
+        return 0;
+    return (float) (alt - from->alt) * 3.28084f * 60 / (timestamp - from->timestamp);
+}
+
+static int NBP_Parse_stream(nbp_receiver_t* rx, const uint8_t* p, const uint8_t* end,
+                            int32_t timestamp, int32_t lat, int32_t lon, ufo_t* out, int max)
+{
+    int n = 0;
+
+    while (p && p < end && n < max)
+    {
+        uint8_t     tag  = *p++;
+        nbp_slot_t* slot = &rx->slot[tag & ~NBP_STREAM_KEY];
+        nbp_slot_t  now;
+        uint32_t    v[7];
+
+        if (tag & NBP_STREAM_KEY)
+        {
+            if (end - p < 3)
+                break;
+            now.addr = p[0] | p[1] << 8 | (uint32_t) p[2] << 16;
+            p       += 3;
+
+            for (int i = 0; i < 7; i++)
+                p = NBP_get_varint(p, end, &v[i]);
+            if (!p)
+                break;
+
+            now.info      = v[0];
+            now.timestamp = timestamp + NBP_unzigzag(v[1]);
+            now.lat       = lat + NBP_unzigzag(v[2]);
+            now.lon       = lon + NBP_unzigzag(v[3]);
+            now.alt       = NBP_unzigzag(v[4]);
+            now.course    = v[5];
+            now.speed     = v[6];
+            now.keyframe  = now.timestamp;
+
+            if (slot->addr != now.addr)
+                slot->addr = 0;    /* another aircraft, no vertical speed */
+        }
+        else
+        {
+            for (int i = 0; i < 6; i++)
+                p = NBP_get_varint(p, end, &v[i]);
+            if (!p)
+                break;
+
+            if (!slot->addr)
+            {
+                rx->dropped++;
+                continue;
+            }
+
+            now           = *slot;
+            now.timestamp = slot->timestamp + NBP_unzigzag(v[0]);
+            now.lat       = slot->lat + NBP_unzigzag(v[1]);
+            now.lon       = slot->lon + NBP_unzigzag(v[2]);
+            now.alt       = slot->alt + NBP_unzigzag(v[3]);
+            now.course    = (slot->course + NBP_unzigzag(v[4]) + 360) % 360;
+            now.speed     = slot->speed + NBP_unzigzag(v[5]);
+        }
+
+        NBP_out(&out[n++], &now, NBP_vs(slot, now.alt, now.timestamp));
+        *slot = now;
+    }
+
+    return n;
+}
+
+/*
+ * Aircraft of one datagram, any of the three layouts: airc_pos, airc_list
+ * or airc_stream. -1 if it is not a OneMessage.
+ */
+int NBP_Parse(nbp_receiver_t* rx, const uint8_t* buf, size_t size, ufo_t* out, int max,
+              char* callsign, size_t callsign_size)
+{
+    flatbuffers::Verifier verifier(buf, size);
+    int                   n = 0;
+
+    if (!VerifyOneMessageBuffer(verifier))
+        return -1;
+
+    const OneMessage*    msg     = GetOneMessage(buf);
+    const StationHeader* station = msg->station();
+
+    rx->datagrams++;
+
+    if (callsign && callsign_size)
+    {
+        callsign[0] = 0;
+        if (station && station->callsign())
+        {
+            strncpy(callsign, station->callsign()->c_str(), callsign_size - 1);
+            callsign[callsign_size - 1] = 0;
+        }
+    }
+
+    if (station)
+    {
+        /* a gap, a restart or a reordered datagram: the deltas are off */
+        if (!rx->synced || station->sequence() != rx->sequence)
+        {
+            if (rx->synced && station->sequence() - rx->sequence < 0x10000)
+                rx->lost += station->sequence() - rx->sequence;
+            for (int i = 0; i < NBP_STREAM_SLOTS; i++)
+                rx->slot[i].addr = 0;
+        }
+        rx->sequence = station->sequence() + 1;
+        rx->synced   = true;
+    }
+
+    if (msg->airc_stream() && station)
+        n = NBP_Parse_stream(rx, msg->airc_stream()->data(), msg->airc_stream()->data() + msg->airc_stream()->size(),
+                             station->timestamp(), NBP_Units(station->lat()), NBP_Units(station->lon()), out, max);
+
+    if (msg->airc_list())
+        for (flatbuffers::uoffset_t i = 0; i < msg->airc_list()->size() && n < max; i++, n++)
+        {
+            const AircraftPos* pos = msg->airc_list()->Get(i);
+
+            memset(&out[n], 0, sizeof(out[n]));
+            out[n].addr          = pos->callsign();
+            out[n].timestamp     = pos->timestamp();
+            out[n].aircraft_type = pos->type();
+            out[n].stealth       = pos->stealth();
+            out[n].no_track      = pos->notrack();
+            out[n].course        = pos->heading();
+            out[n].speed         = pos->speed();
+            out[n].latitude      = pos->lat();
+            out[n].longitude     = pos->lon();
+            out[n].altitude      = pos->alt();
+        }
+
+    if (msg->airc_pos() && n < max)
+    {
+        const AircraftPos* pos = msg->airc_pos();
+
+        memset(&out[n], 0, sizeof(out[n]));
+        out[n].addr          = pos->callsign();
+        out[n].timestamp     = pos->timestamp();
+        out[n].aircraft_type = pos->type();
+        out[n].stealth       = pos->stealth();
+        out[n].no_track      = pos->notrack();
+        out[n].course        = pos->heading();
+        out[n].speed         = pos->speed();
+        out[n].latitude      = pos->lat();
+        out[n].longitude     = pos->lon();
+        out[n].altitude      = pos->alt();
+        n++;
+    }
+
+    return n;
+}
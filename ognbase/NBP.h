@@ -0,0 +1,96 @@
+/*
+ * NBP.h
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "SoftRF.h"
+
+#ifndef NBPHELPER_H
+#define NBPHELPER_H
+
+#define NBP_DATAGRAM_SIZE   1400    /* below the path MTU, no IP fragments */
+#define NBP_HEADER_SIZE     120     /* OneMessage, StationHeader, callsign, vector length */
+#define NBP_AIRCRAFT_SIZE   32      /* sizeof(ogn::AircraftPos) */
+#define NBP_BATCH_MAX       ((NBP_DATAGRAM_SIZE - NBP_HEADER_SIZE) / NBP_AIRCRAFT_SIZE)
+#define NBP_CALLSIGN_SIZE   16
+
+/* stream mode */
+#define NBP_STREAM_SIZE     (NBP_DATAGRAM_SIZE - NBP_HEADER_SIZE)
+#define NBP_STREAM_RECORD   40      /* longest record, a keyframe */
+#define NBP_STREAM_SLOTS    128     /* aircraft a station streams at a time */
+#define NBP_STREAM_KEYFRAME 30      /* s, at most between two keyframes of an aircraft */
+#define NBP_STREAM_EXPIRE   60      /* s without a report until a slot is reused */
+#define NBP_STREAM_UNITS    60000   /* per degree, 1/1000 arc minute as in APRS */
+#define NBP_STREAM_KEY      0x80    /* record tag: keyframe, low 7 bits are the slot */
+
+enum
+{
+    NBP_MODE_BATCH,                 /* airc_list, 32 bytes per aircraft */
+    NBP_MODE_STREAM                 /* airc_stream, keyframes and deltas */
+};
+
+typedef struct nbp_stats
+{
+    uint32_t cycles;
+    uint32_t datagrams;
+    uint32_t aircraft;
+    uint32_t bytes;
+    uint32_t keyframes;
+    uint32_t evicted;               /* slots taken over before they expired */
+} nbp_stats_t;
+
+/* an aircraft as last sent, in stream units */
+typedef struct nbp_slot
+{
+    uint32_t addr;                  /* 0 = free */
+    uint16_t info;                  /* aircraft type, stealth, no track, address type */
+    int32_t  timestamp;
+    int32_t  lat;
+    int32_t  lon;
+    int32_t  alt;
+    uint16_t course;
+    uint16_t speed;
+    int32_t  keyframe;              /* timestamp of the last keyframe */
+} nbp_slot_t;
+
+/* receiver side, one per station */
+typedef struct nbp_receiver
+{
+    uint32_t   sequence;            /* expected next */
+    bool       synced;
+    uint32_t   datagrams;
+    uint32_t   lost;                /* datagrams missing in the sequence */
+    uint32_t   dropped;             /* deltas without a keyframe to go on */
+    nbp_slot_t slot[NBP_STREAM_SLOTS];
+} nbp_receiver_t;
+
+void   NBP_Reset();
+void   NBP_Begin(const char* callsign, uint32_t timestamp, float lat, float lon, int32_t alt, uint8_t mode);
+bool   NBP_Add(const ufo_t* fop);
+size_t NBP_Count();
+size_t NBP_Finish(const uint8_t** buf);
+
+void   NBP_Receiver_Reset(nbp_receiver_t* rx);
+int    NBP_Parse(nbp_receiver_t* rx, const uint8_t* buf, size_t size, ufo_t* out, int max,
+                 char* callsign, size_t callsign_size);
+int32_t NBP_Units(float deg);
+
+extern nbp_stats_t NBP_stats;
+
+#endif /* NBPHELPER_H */
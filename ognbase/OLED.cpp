@@ -20,6 +20,10 @@
 
 #include <Wire.h>
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
 #include "OLED.h"
 #include "EEPROM.h"
 #include "RF.h"
@@ -31,7 +35,31 @@
 #include "version.h"
 #include "logos.h"
 
-SSD1306Wire display(SSD1306_OLED_I2C_ADDR, SDA, SCL, GEOMETRY_128_64, I2C_TWO, 400000);  // ADDRESS, SDA, SCL
+/*
+ * Drawing only changes the frame buffer of the library. OLED_commit()
+ * copies it for the OLED task, which compares it with what the panel
+ * shows and writes the changed columns of the changed pages. loop()
+ * never waits for the I2C bus; if it commits faster than the task
+ * writes, the task skips to the newest frame.
+ */
+class OLED_Display : public SSD1306Wire
+{
+  public:
+    using SSD1306Wire::SSD1306Wire;
+
+    const uint8_t* frame() { return buffer; }
+};
+
+OLED_Display display(SSD1306_OLED_I2C_ADDR, SDA, SCL, GEOMETRY_128_64, I2C_TWO, 400000);  // ADDRESS, SDA, SCL
+
+static TaskHandle_t      OLED_task_handle = NULL;
+static SemaphoreHandle_t OLED_mutex       = NULL;
+static uint8_t           oled_next[OLED_PAGES * OLED_WIDTH];    /* last commit */
+static bool              oled_next_on   = true;
+static uint32_t          oled_committed = 0;
+static uint8_t           oled_shown[OLED_PAGES * OLED_WIDTH];   /* on the panel, OLED task only */
+static bool              oled_shown_on  = true;                 /* display.init() clears it and turns it on */
+static uint32_t          oled_written   = 0;                    /* commit the panel shows */
 
 bool display_init = false;
 bool display_enabled = true;
@@ -67,21 +95,140 @@ const char* ISO3166_CC[] = {
     [RF_BAND_IN]   = "IN"
 };
 
+/* Co = 0, D/C = 0: the rest of the transfer are commands */
+static void OLED_Send_commands(const uint8_t* cmd, size_t size)
+{
+    ESP32_Wire1_lock();
+    Wire1.beginTransmission(SSD1306_OLED_I2C_ADDR);
+    Wire1.write(0x00);
+    Wire1.write(cmd, size);
+    Wire1.endTransmission();
+    ESP32_Wire1_unlock();
+}
+
+/* columns first .. last of one page, horizontal addressing as display.init() set it */
+static void OLED_Send_page(uint8_t page, uint8_t first, uint8_t last, const uint8_t* data)
+{
+    const uint8_t window[] = {0x21, first, last, 0x22, page, page};    /* COLUMNADDR, PAGEADDR */
+    size_t        size     = last - first + 1;
+
+    /* the PMU shares the bus, it waits at most for one page */
+    ESP32_Wire1_lock();
+    OLED_Send_commands(window, sizeof(window));
+    for (size_t i = 0; i < size; i += OLED_I2C_CHUNK)
+    {
+        Wire1.beginTransmission(SSD1306_OLED_I2C_ADDR);
+        Wire1.write(0x40);                                              /* data follows */
+        Wire1.write(data + i, size - i < OLED_I2C_CHUNK ? size - i : OLED_I2C_CHUNK);
+        Wire1.endTransmission();
+    }
+    ESP32_Wire1_unlock();
+}
+
+static void OLED_Task(void* param)
+{
+    static uint8_t frame[OLED_PAGES * OLED_WIDTH];
+    bool           on;
+    uint32_t       committed;
+
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        xSemaphoreTake(OLED_mutex, portMAX_DELAY);
+        memcpy(frame, oled_next, sizeof(frame));
+        on        = oled_next_on;
+        committed = oled_committed;
+        xSemaphoreGive(OLED_mutex);
+
+        for (uint8_t page = 0; page < OLED_PAGES; page++)
+        {
+            const uint8_t* next  = &frame[page * OLED_WIDTH];
+            uint8_t*       shown = &oled_shown[page * OLED_WIDTH];
+            int            first = 0, last = OLED_WIDTH - 1;
+
+            while (first < OLED_WIDTH && next[first] == shown[first])
+                first++;
+            if (first == OLED_WIDTH)
+                continue;
+            while (next[last] == shown[last])
+                last--;
+
+            OLED_Send_page(page, first, last, next + first);
+            memcpy(shown + first, next + first, last - first + 1);
+        }
+
+        if (on != oled_shown_on)
+        {
+            const uint8_t cmd = on ? 0xAF : 0xAE;                       /* DISPLAYON, DISPLAYOFF */
+
+            OLED_Send_commands(&cmd, 1);
+            oled_shown_on = on;
+        }
+
+        __atomic_store_n(&oled_written, committed, __ATOMIC_RELEASE);
+    }
+}
+
+/* loop(): hands what was drawn to the OLED task, a memcpy() */
+static void OLED_commit(bool on)
+{
+    if (OLED_task_handle == NULL)
+    {
+        display.display();
+        if (on)
+            display.displayOn();
+        else
+            display.displayOff();
+        return;
+    }
+
+    xSemaphoreTake(OLED_mutex, portMAX_DELAY);
+    memcpy(oled_next, display.frame(), sizeof(oled_next));
+    oled_next_on = on;
+    oled_committed++;
+    xSemaphoreGive(OLED_mutex);
+
+    xTaskNotifyGive(OLED_task_handle);
+}
+
+/* waits until the panel shows the last commit, at most timeout_ms */
+static void OLED_sync(uint32_t timeout_ms)
+{
+    uint32_t start = millis();
+
+    while (OLED_task_handle && __atomic_load_n(&oled_written, __ATOMIC_ACQUIRE) != oled_committed &&
+           millis() - start < timeout_ms)
+        vTaskDelay(1);
+}
+
 byte OLED_setup()
 {
     display_init = display.init();
     display.flipScreenVertically();
+
+    if (!display_init)
+        return display_init;
+
+    OLED_mutex = xSemaphoreCreateMutex();
+    if (OLED_mutex == NULL ||
+        xTaskCreatePinnedToCore(OLED_Task, "OLED", OLED_TASK_STACK, NULL,
+                                OLED_TASK_PRIORITY, &OLED_task_handle, OLED_TASK_CORE) != pdPASS)
+    {
+        OLED_task_handle = NULL;
+        Serial.println(F("WARNING! OLED task not started, display updates from loop()"));
+    }
+    return display_init;
 }
 
 void OLED_write(char* text, short x, short y, bool clear)
 {
     if (!display_enabled){return;}
       
-    display.displayOn();
     if (clear)
         display.clear();
     display.drawString(x, y, text);
-    display.display();
+    OLED_commit(true);
 }
 
 void OLED_disable()
@@ -89,7 +236,8 @@ void OLED_disable()
   if (!display_enabled){return;}
   
   display.clear();
-  display.displayOff();
+  OLED_commit(false);
+  OLED_sync(OLED_SYNC_MS);   /* deep sleep may follow */
   display_enabled = false;
 }
 
@@ -102,7 +250,6 @@ void OLED_draw_Bitmap(int16_t x, int16_t y, uint8_t bm, bool clear)
 {
     if (!display_enabled){return;}
     
-    display.displayOn();
     if (clear)
         display.clear();
     if (bm == 1)
@@ -115,7 +262,7 @@ void OLED_draw_Bitmap(int16_t x, int16_t y, uint8_t bm, bool clear)
     if (bm == 100)
         // supporter_50_64
         display.drawXbm(x, y, 50, 64, supporter_50_64);
-    display.display();
+    OLED_commit(true);
 }
 
 void OLED_info(bool ntp)
@@ -146,7 +293,6 @@ void OLED_info(bool ntp)
 
     if (display_init)
     {
-        display.displayOff();
         display.clear();
 
 
@@ -201,8 +347,7 @@ void OLED_info(bool ntp)
                display.drawString(0, 63, buf);
              */
             oled_site = 1;
-            display.display();
-            display.displayOn();
+            OLED_commit(true);
             return;
         }
         if (oled_site == 1)
@@ -243,12 +388,11 @@ void OLED_info(bool ntp)
             display.drawString(0, 54, buf);
 
 
-            display.display();
+            OLED_commit(true);
             if(!ognrelay_enable )
               oled_site = 2;
             else
               oled_site = 3;
-            display.displayOn();
             return;
         }
 
@@ -271,8 +415,7 @@ void OLED_info(bool ntp)
             snprintf(buf, sizeof(buf), "connected to %s", WiFi.SSID().c_str());
             display.drawString(0, 54, buf);
 
-            display.display();
-            display.displayOn();
+            OLED_commit(true);
             oled_site = 3;
             return;
         }
@@ -304,12 +447,11 @@ void OLED_info(bool ntp)
               snprintf(buf, sizeof(buf), "RELAY: %s", ognrelay_enable ? "true" : "false");              
             display.drawString(0, 54, buf);                                                                           
 
-            display.display();
+            OLED_commit(true);
             if (beers_show)
                 oled_site = 4;
             else
                 oled_site = 0;
-            display.displayOn();
             return;
         }  
 
@@ -327,10 +469,8 @@ void OLED_info(bool ntp)
             snprintf(buf, sizeof(buf), "many thanks !!");
             display.drawString(0, 52, buf);
 
-            OLED_draw_Bitmap(75, 0, 100, false);
-            display.display();
+            OLED_draw_Bitmap(75, 0, 100, false);    /* commits the page */
             oled_site = 0;
-            display.displayOn();
             return;
         }
     }
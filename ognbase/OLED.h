@@ -23,6 +23,15 @@
 
 #define SSD1306_OLED_I2C_ADDR   0x3C
 
+#define OLED_WIDTH              128
+#define OLED_PAGES              8       /* of 8 rows each, GEOMETRY_128_64 */
+#define OLED_I2C_CHUNK          32      /* data bytes per I2C transfer, Wire buffers 128 */
+#define OLED_SYNC_MS            100     /* OLED_disable() waits that long for the panel */
+
+#define OLED_TASK_STACK         2048
+#define OLED_TASK_PRIORITY      1       /* below the RF task */
+#define OLED_TASK_CORE          0       /* off the loop() core */
+
 byte OLED_setup(void);
 
 void OLED_write(char *, short, short, bool);
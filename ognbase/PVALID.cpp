@@ -9,129 +9,7 @@
 
 #include <math.h>
 
-#define pi 3.14159265358979323846
-#define PACKET_EXPIRY_TIME 10
-
-//time_t timestamp;
-//uint32_t addr;
-//float latitude;
-//float longitude;
-//float altitude;
-//float course;
-//float speed;
-
-
-//aircrafts_t ac, ai[MAX_TRACKING_OBJECTS], EmptyFO;
-
-aircrafts_t ac[MAX_TRACKING_OBJECTS];
-
-
-bool isPacketValid(uint32_t addr, double lat1, double lon1, double speed, time_t timestamp) {
-  double theta, dist;
-  String msg;
-
-  speed = speed * 1.852;
-
-  /*V0.1.0-24*/
-
-  for (uint8_t i = 0; i < MAX_TRACKING_OBJECTS; i++) {
-    msg = "checking database: ";
-    msg += String(ac[i].addr, HEX);
-    msg += " CNT: ";
-    msg += String(ac[i].pkt_counter);
-    Logger_send_udp(&msg);
-  }
-  for (uint8_t i = 0; i < MAX_TRACKING_OBJECTS; i++) {
-
-    if (addr == ac[i].addr) {
-
-      msg = "ADDR: ";
-      msg += String(addr, HEX);
-      msg += " found in database..";
-      Logger_send_udp(&msg);
-
-      int dist = distance(lat1, lon1, ac[i].latitude, ac[i].longitude);
-
-      msg = "Transmitted distance: ";
-      msg += dist;
-      msg = "Transmitted speed: ";
-      msg += speed / 3.6;
-      msg += " m/s";      
-      Logger_send_udp(&msg);
-
-      int calcdist = calcMaxDistance(speed, timestamp - ac[i].timestamp);
-      if (dist > calcdist) {
-
-        msg = "Max calculated distance: ";
-        msg += calcdist;
-        msg += "m Distance: ";
-        msg += dist;
-        msg += " m";
-        msg += " timediff: ";
-        msg += timestamp - ac[i].timestamp;
-        Logger_send_udp(&msg);
-
-        msg = "Packet seems to be invalid";
-        Logger_send_udp(&msg);
-
-        cleanUpPacket(i);
-        shiftPackets();
-        return false;
-      }
-      else {
-
-        msg = "Max calculated distance: ";
-        msg += calcdist;
-        msg += "m Distance: ";
-        msg += dist;
-        msg += "m";
-        Logger_send_udp(&msg);
-
-
-        uint8_t cnt = ac[i].pkt_counter + 1;
-
-        msg = "Packet seems to be valid - counter: ";
-        msg += cnt;
-        Logger_send_udp(&msg);
-
-        cleanUpPacket(i);
-        shiftPackets();
-        appendPacket(addr, lat1, lon1, timestamp, cnt);
-        return true;
-      }
-    }
-  }
-  msg = "Address not found, appending";
-  Logger_send_udp(&msg);
-  shiftPackets();
-  appendPacket(addr, lat1, lon1, timestamp, 0);
-  return (false);
-}
-
-/*
-static int distance(double lat1, double lon1, double lat2, double lon2) {
-  double theta, dist;
-  double r = 6378137.0;
-
-  if ((lat1 == lat2) && (lon1 == lon2)) {
-    return 0;
-  }
-  else {
-
-    lat1 = deg2rad(lat1);
-    lon1 = deg2rad(lon1);
-    lat2 = deg2rad(lat2);
-    lon2 = deg2rad(lon2);
-
-    double dlat = lat2 - lat1;
-    double dlon = lon2 - lon1;
-
-    double dist = 2 * r * asin(sqrt(pow(sin(dlat / 2), 2) + cos(lat1) * cos(lat2) * pow(sin(dlon / 2), 2)));
-
-    return (int)(dist); //distance in km
-  }
-}
-*/
+#define PVALID_MASK (PVALID_HISTORY - 1)
 
 static int distance(double lat1, double lon1, double lat2, double lon2) {
   double p = 0.017453292519943295;    // Math.PI / 180
@@ -139,49 +17,81 @@ static int distance(double lat1, double lon1, double lat2, double lon2) {
   return (int)(12742 * asin(sqrt(a)) * 1000);
 }
 
-static int calcMaxDistance(double speed, time_t time_diff) {
-  int speed_ms = speed;
-  
-  if(speed == 0){
-    // GPS precision ...
-    return (int)(10);
-  }
-  else{
-    // 20% more than calculated
-    return (int)((speed * time_diff / 3.6) * 1.2 );
-  }
+static int calcMaxDistance(float speed, time_t time_diff) {
+  // speed in m/s, 20% more than calculated plus GPS precision
+  return (int)(speed * time_diff * 1.2) + PVALID_GPS_SLACK;
 }
 
-static bool appendPacket(uint32_t addr, double lat, double lon, time_t timestamp, uint8_t cnt) {
-  ac[MAX_TRACKING_OBJECTS - 1].timestamp = timestamp;
-  ac[MAX_TRACKING_OBJECTS - 1].addr = addr;
-  ac[MAX_TRACKING_OBJECTS - 1].latitude = lat;
-  ac[MAX_TRACKING_OBJECTS - 1].longitude = lon;
-  ac[MAX_TRACKING_OBJECTS - 1].pkt_counter = cnt;
+void PVALID_Reset(pvalid_history_t* history) {
+  history->head = 0;
+  history->len = 0;
+  history->pkt_counter = 0;
 }
 
-static void shiftPackets(void) {
-  for (uint8_t i = 0; i < MAX_TRACKING_OBJECTS - 1; i++) {
-    ac[i].timestamp = ac[i + 1].timestamp;
-    ac[i].addr = ac[i + 1].addr;
-    ac[i].latitude = ac[i + 1].latitude;
-    ac[i].longitude = ac[i + 1].longitude;
-    ac[i].pkt_counter = ac[i + 1].pkt_counter;
-  }
+void PVALID_Append(pvalid_history_t* history, ufo_t* fop) {
+  history->head = (history->head + 1) & PVALID_MASK;
+  if (history->len < PVALID_HISTORY)
+    history->len++;
+
+  pvalid_fix_t* fix = &history->fix[history->head];
+  fix->timestamp = fop->timestamp;
+  fix->latitude = fop->latitude;
+  fix->longitude = fop->longitude;
+  fix->altitude = fop->altitude;
+  fix->speed = fop->speed;
 }
 
-static void cleanUpPacket(uint8_t index) {
-  ac[index].addr = 0x00000000;
-}
+/*
+ * Newest fix against the one before (distance, speed change, climb) and
+ * against the oldest one in the ring with the fastest speed seen since.
+ * A rejected fix restarts the history from itself, so asking again
+ * about it gives PVALID_SHORT.
+ */
+uint8_t isPacketValid(pvalid_history_t* history) {
+  if (history->len < 2)
+    return PVALID_SHORT;
+
+  const pvalid_fix_t* cur = &history->fix[history->head];
+  const pvalid_fix_t* prev = &history->fix[(history->head - 1) & PVALID_MASK];
+  const pvalid_fix_t* oldest = &history->fix[(history->head - history->len + 1) & PVALID_MASK];
+
+  time_t dt = cur->timestamp - prev->timestamp;
+  if (dt < 1)
+    dt = 1; // both slots of the same second
+
+  float speed = cur->speed * _GPS_MPS_PER_KNOT;
+  float vmax = speed;
+  for (uint8_t n = 1; n < history->len; n++) {
+    float v = history->fix[(history->head - n) & PVALID_MASK].speed * _GPS_MPS_PER_KNOT;
+    if (v > vmax)
+      vmax = v;
+  }
 
-static void cleanUpArray() {
+  time_t span = cur->timestamp - oldest->timestamp;
+  if (span < 1)
+    span = 1;
 
-}
+  int dist = distance(cur->latitude, cur->longitude, prev->latitude, prev->longitude);
+  int calcdist = calcMaxDistance(speed, dt);
+  int span_dist = distance(cur->latitude, cur->longitude, oldest->latitude, oldest->longitude);
+  int span_calcdist = calcMaxDistance(vmax, span);
+  float accel = fabs(cur->speed - prev->speed) * _GPS_MPS_PER_KNOT / dt;
+  float climb = fabs(cur->altitude - prev->altitude);
 
-static double deg2rad(double deg) {
-  return (deg * pi / 180);
-}
+  if (dist > calcdist || span_dist > span_calcdist || accel > PVALID_MAX_ACCEL ||
+      climb > PVALID_MAX_CLIMB * dt + PVALID_GPS_SLACK) {
+
+    LOG_INFO("Packet seems to be invalid - distance: %dm max: %dm accel: %.2f climb: %.2fm timediff: %ld",
+             dist, calcdist, accel, climb, (long) dt);
+
+    history->fix[0] = *cur;
+    history->head = 0;
+    history->len = 1;
+    history->pkt_counter = 0;
+    return PVALID_REJECT;
+  }
 
-static double rad2deg(double rad) {
-  return (rad * 180 / pi);
+  if (history->pkt_counter < 0xFF)
+    history->pkt_counter++;
+  return PVALID_OK;
 }
@@ -23,25 +23,39 @@
 #ifndef PVALIDHELPER_H
 #define PVALIDHELPER_H
 
-bool isPacketValid(uint32_t, double, double, double, time_t);
+#define PVALID_HISTORY      4   /* fixes kept per aircraft, power of 2 */
+#define PVALID_GPS_SLACK    10  /* metres */
+#define PVALID_MAX_ACCEL    15  /* m/s^2, change of ground speed */
+#define PVALID_MAX_CLIMB    50  /* m/s */
 
-static int distance(double, double, double, double);
-static double deg2rad(double);
-static double rad2deg(double);
-static void cleanUpPacket(uint8_t);
-static void shiftPackets(void);
-static bool appendPacket(uint32_t, double, double, time_t, uint8_t cnt);
-static int calcMaxDistance(double, time_t);
-
-typedef struct aircrafts
+typedef struct pvalid_fix
 {
     time_t timestamp;
-    uint32_t addr;
     float latitude;
     float longitude;
     float altitude;
-    float course;
+    float speed;        /* knots */
+} pvalid_fix_t;
+
+/* ring of the most recent fixes of one aircraft, lives next to its Container[] slot */
+typedef struct pvalid_history
+{
+    pvalid_fix_t fix[PVALID_HISTORY];
+    uint8_t head;       /* newest fix */
+    uint8_t len;
     uint8_t pkt_counter;
-} aircrafts_t;
+} pvalid_history_t;
+
+void PVALID_Reset(pvalid_history_t *);
+void PVALID_Append(pvalid_history_t *, ufo_t *);
+
+enum
+{
+    PVALID_OK,
+    PVALID_SHORT,       /* first sighting, nothing to compare with yet */
+    PVALID_REJECT       /* implausible against the fixes before */
+};
+
+uint8_t isPacketValid(pvalid_history_t *);
 
 #endif /* PVALIDHELPER_H */
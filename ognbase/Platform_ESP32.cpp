@@ -20,11 +20,15 @@
 #include <SPI.h>
 #include <esp_err.h>
 #include <esp_wifi.h>
+#include <lwip/sockets.h>
+#include <errno.h>
 #include <esp_bt.h>
 #include <soc/rtc_cntl_reg.h>
 #include <soc/efuse_reg.h>
 #include <rom/rtc.h>
 #include <rom/spi_flash.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #include <flashchips.h>
 #include <axp20x.h>
 #include <TFT_eSPI.h>
@@ -75,6 +79,22 @@ volatile bool       PMU_Irq        = false;
 
 static bool GPIO_21_22_are_busy = false;
 
+static SemaphoreHandle_t Wire1_mutex = NULL;
+
+/* APRS-IS connect, see ESP32_WiFi_connect_TCP() */
+enum
+{
+    TCP_IDLE,
+    TCP_CONNECTING,
+    TCP_CONNECTED,
+    TCP_FAILED
+};
+
+static TaskHandle_t TCP_task_handle = NULL;
+static char         tcp_host[64];
+static int          tcp_port;
+static int          tcp_state = TCP_IDLE;
+
 static union
 {
     uint8_t efuse_mac[6];
@@ -115,8 +135,22 @@ static uint32_t ESP32_getFlashId()
     return g_rom_flashchip.device_id;
 }
 
+void ESP32_Wire1_lock()
+{
+    if (Wire1_mutex)
+        xSemaphoreTakeRecursive(Wire1_mutex, portMAX_DELAY);
+}
+
+void ESP32_Wire1_unlock()
+{
+    if (Wire1_mutex)
+        xSemaphoreGiveRecursive(Wire1_mutex);
+}
+
 static void ESP32_setup()
 {
+    Wire1_mutex = xSemaphoreCreateRecursiveMutex();
+
 #if !defined(SOFTRF_ADDRESS)
 
     esp_err_t ret         = ESP_OK;
@@ -278,6 +312,7 @@ static void ESP32_loop()
 
         if (is_irq)
         {
+            ESP32_Wire1_lock();
             if (axp.readIRQ() == AXP_PASS)
             {
                 if (axp.isPEKLongtPressIRQ())
@@ -298,6 +333,7 @@ static void ESP32_loop()
 
                 axp.clearIRQ();
             }
+            ESP32_Wire1_unlock();
 
             portENTER_CRITICAL_ISR(&PMU_mutex);
             PMU_Irq = false;
@@ -309,10 +345,11 @@ static void ESP32_loop()
 
         if (isTimeToBattery())
         {
-            if (Battery_voltage() > Battery_threshold())
-                axp.setChgLEDMode(AXP20X_LED_LOW_LEVEL);
-            else
-                axp.setChgLEDMode(AXP20X_LED_BLINK_1HZ);
+            bool low = Battery_voltage() <= Battery_threshold();
+
+            ESP32_Wire1_lock();
+            axp.setChgLEDMode(low ? AXP20X_LED_BLINK_1HZ : AXP20X_LED_LOW_LEVEL);
+            ESP32_Wire1_unlock();
         }
     }
 }
@@ -326,11 +363,13 @@ static void ESP32_fini()
 
     if (hw_info.model == SOFTRF_MODEL_SKYWATCH)
     {
+        ESP32_Wire1_lock();
         axp.setChgLEDMode(AXP20X_LED_OFF);
 
         axp.setPowerOutPut(AXP202_LDO2, AXP202_OFF); // BL
         axp.setPowerOutPut(AXP202_LDO4, AXP202_OFF); // S76G (Sony GNSS)
         axp.setPowerOutPut(AXP202_LDO3, AXP202_OFF); // S76G (MCU + LoRa)
+        ESP32_Wire1_unlock();
 
         delay(20);
 
@@ -339,15 +378,19 @@ static void ESP32_fini()
     else if (hw_info.model == SOFTRF_MODEL_PRIME_MK2 &&
              hw_info.revision == 8)
     {
+        ESP32_Wire1_lock();
         axp.setChgLEDMode(AXP20X_LED_OFF);
+        ESP32_Wire1_unlock();
 
         delay(2000); /* Keep 'OFF' message on OLED for 2 seconds */
 
+        ESP32_Wire1_lock();
         axp.setPowerOutPut(AXP192_LDO2, AXP202_OFF);
         axp.setPowerOutPut(AXP192_LDO3, AXP202_OFF);
         axp.setPowerOutPut(AXP192_DCDC2, AXP202_OFF);
         axp.setPowerOutPut(AXP192_DCDC1, AXP202_OFF);
         axp.setPowerOutPut(AXP192_EXTEN, AXP202_OFF);
+        ESP32_Wire1_unlock();
 
         delay(20);
 
@@ -668,22 +711,74 @@ static void ESP32_WiFi_transmit_UDP(const char* host, int port, byte* buf, size_
     }
 }
 
-static int ESP32_WiFi_connect_TCP(const char* host, int port)
+static bool ESP32_TCP_connect()
 {
-    bool ret = Ping.ping(host, 2);
+    return Ping.ping(tcp_host, 2) && client.connect(tcp_host, tcp_port, 5000);
+}
 
-    if (ret)
+static void ESP32_TCP_Task(void* param)
+{
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        bool ok = ESP32_TCP_connect();
+
+        __atomic_store_n(&tcp_state, ok ? TCP_CONNECTED : TCP_FAILED, __ATOMIC_RELEASE);
+    }
+}
+
+/*
+ * Never waits: the ping and the connect, up to seconds, run in the TCP
+ * task. 1 connected, 0 failed, -1 while it still connects; the caller
+ * asks again until it is not -1 and leaves client alone meanwhile, or
+ * gives the attempt up with ESP32_WiFi_disconnect_TCP().
+ */
+static int ESP32_WiFi_connect_TCP(const char* host, int port)
+{
+    switch (__atomic_load_n(&tcp_state, __ATOMIC_ACQUIRE))
     {
-        if (!client.connect(host, port, 5000))
+        case TCP_CONNECTING:
+            return -1;
+        case TCP_CONNECTED:
+            __atomic_store_n(&tcp_state, TCP_IDLE, __ATOMIC_RELEASE);
+            return 1;
+        case TCP_FAILED:
+            __atomic_store_n(&tcp_state, TCP_IDLE, __ATOMIC_RELEASE);
             return 0;
-        return 1;
+        default:
+            break;
     }
-    return 0;
+
+    strncpy(tcp_host, host, sizeof(tcp_host) - 1);
+    tcp_port = port;
+
+    if (TCP_task_handle == NULL &&
+        xTaskCreatePinnedToCore(ESP32_TCP_Task, "TCP", TCP_TASK_STACK, NULL,
+                                TCP_TASK_PRIORITY, &TCP_task_handle, TCP_TASK_CORE) != pdPASS)
+    {
+        TCP_task_handle = NULL;
+        Serial.println(F("WARNING! TCP task not started, connecting from loop()"));
+        return ESP32_TCP_connect() ? 1 : 0;
+    }
+
+    __atomic_store_n(&tcp_state, TCP_CONNECTING, __ATOMIC_RELEASE);
+    xTaskNotifyGive(TCP_task_handle);
+    return -1;
 }
 
+/*
+ * Waits for an attempt the TCP task still runs, it owns client until
+ * then, and drops its result: the next ESP32_WiFi_connect_TCP() starts
+ * a new one instead of taking a stale connect for a fresh login.
+ */
 static int ESP32_WiFi_disconnect_TCP()
 {
+    while (__atomic_load_n(&tcp_state, __ATOMIC_ACQUIRE) == TCP_CONNECTING)
+        delay(10);
     client.stop();
+    __atomic_store_n(&tcp_state, TCP_IDLE, __ATOMIC_RELEASE);
+    return 0;
 }
 
 static int ESP32_WiFi_transmit_TCP(String message)
@@ -696,6 +791,19 @@ static int ESP32_WiFi_transmit_TCP(String message)
     return 0;
 }
 
+/* never waits: bytes the send buffer took, 0 if it is full, -1 if not connected */
+static int ESP32_WiFi_send_TCP(const char* buf, size_t size)
+{
+    if (!client.connected())
+        return -1;
+
+    int rval = send(client.fd(), buf, size, MSG_DONTWAIT);
+
+    if (rval < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+    return rval;
+}
+
 static int ESP32_WiFi_receive_TCP(char* RXbuffer, int RXbuffer_size)
 {
     int i = 0;
@@ -881,8 +989,10 @@ static float ESP32_Battery_voltage()
         hw_info.model == SOFTRF_MODEL_SKYWATCH)
     {
         /* T-Beam v08 and T-Watch have PMU */
+        ESP32_Wire1_lock();
         if (axp.isBatteryConnect())
             voltage = axp.getBattVoltage();
+        ESP32_Wire1_unlock();
     }
     else
     {
@@ -983,6 +1093,7 @@ const SoC_ops_t ESP32_ops = {
     ESP32_WiFi_connect_TCP,
     ESP32_WiFi_disconnect_TCP,
     ESP32_WiFi_transmit_TCP,
+    ESP32_WiFi_send_TCP,
     ESP32_WiFi_receive_TCP,
     ESP32_WiFi_isconnected_TCP,
     ESP32_WiFi_connect_TCP2,
@@ -40,6 +40,10 @@
 
 #define isValidFix()            isValidGNSSFix()
 
+/* CPU cycles, to time the radio code */
+#define CycleCount()            ESP.getCycleCount()
+#define CyclesPerMicro()        getCpuFrequencyMhz()
+
 /* Adafruit_NeoPixel still has "flickering" issue of ESP32 caused by 1 ms scheduler */
 //#define USE_ADAFRUIT_NEO_LIBRARY
 
@@ -189,6 +193,15 @@ extern Adafruit_NeoPixel strip;
 
 extern WebServer server;
 
+/* Wire1 is shared by the OLED task (core 0) and the AXP PMU (loop()) */
+void ESP32_Wire1_lock(void);
+void ESP32_Wire1_unlock(void);
+
+/* the APRS-IS ping and connect, off loop(), see ESP32_WiFi_connect_TCP() */
+#define TCP_TASK_STACK          4096
+#define TCP_TASK_PRIORITY       1       /* as loop(), runs while it sleeps */
+#define TCP_TASK_CORE           1       /* APP CPU, next to loop() */
+
 enum rst_reason
 {
     REASON_DEFAULT_RST = 0,      /* normal startup by power on */
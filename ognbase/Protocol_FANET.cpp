@@ -95,10 +95,10 @@ const uint8_t aircraft_type_from_fanet[] PROGMEM = {
 };
 
 #define AT_TO_FANET(x)  (x > 15 ? \
-                         FANET_AIRCRAFT_TYPE_OTHER : pgm_read_byte(&aircraft_type_to_fanet[x]))
+                         (uint8_t) FANET_AIRCRAFT_TYPE_OTHER : pgm_read_byte(&aircraft_type_to_fanet[x]))
 
 #define AT_FROM_FANET(x)  (x > 7 ? \
-                           AIRCRAFT_TYPE_UNKNOWN : pgm_read_byte(&aircraft_type_from_fanet[x]))
+                           (uint8_t) AIRCRAFT_TYPE_UNKNOWN : pgm_read_byte(&aircraft_type_from_fanet[x]))
 
 #if defined(FANET_DEPRECATED)
 /* ------------------------------------------------------------------------- */
@@ -212,8 +212,8 @@ bool fanet_decode(void* fanet_pkt, ufo_t* this_aircraft, ufo_t* fop)
 {
     fanet_packet_t* pkt = (fanet_packet_t *) fanet_pkt;
     unsigned int    altitude;
-    uint8_t         speed_byte, climb_byte, offset_byte;
-    int             speed_int, climb_int, offset_int;
+    uint8_t         speed_byte, climb_byte;
+    int             speed_int, climb_int;
     bool            rval = false;
 
     if (pkt->ext_header == 0 && pkt->type == 1)   /* Tracking  */
@@ -259,8 +259,8 @@ bool fanet_decode(void* fanet_pkt, ufo_t* this_aircraft, ufo_t* fop)
         fop->vs = ((float)climb_int) * (_GPS_FEET_PER_METER * 6.0);
 
 #if defined(FANET_NEXT)
-        offset_byte = pkt->qne_offset;
-        offset_int  = (int) (offset_byte | (offset_byte & (1 << 6) ? 0xFFFFFF80U : 0));
+        uint8_t offset_byte = pkt->qne_offset;
+        int     offset_int  = (int) (offset_byte | (offset_byte & (1 << 6) ? 0xFFFFFF80U : 0));
 
         if (pkt->qne_scale)
             offset_int *= 4;
@@ -304,8 +304,7 @@ bool fanet_decode(void* fanet_pkt, ufo_t* this_aircraft, ufo_t* fop)
 
     if (pkt->ext_header == 0 && (pkt->type == 2 || pkt->type == 3 || pkt->type == 4))    /* Service  */
     {
-        String logf = "found FANET service data";
-        Logger_send_udp(&logf);
+        LOG_INFO("found FANET service data");
     }
 
     return rval;
@@ -322,8 +321,6 @@ size_t fanet_encode(void* fanet_pkt, ufo_t* this_aircraft)
     float        climb         = this_aircraft->vs / (_GPS_FEET_PER_METER * 60.0);
     float        heading       = this_aircraft->course;
     float        turnrate      = 0;
-    int16_t      alt_diff      = this_aircraft->pressure_altitude == 0 ? 0 :
-                                 (int16_t) (this_aircraft->pressure_altitude - this_aircraft->altitude);
 
     fanet_packet_t* pkt = (fanet_packet_t *) fanet_pkt;
 
@@ -388,7 +385,9 @@ size_t fanet_encode(void* fanet_pkt, ufo_t* this_aircraft)
     }
 
 #if defined(FANET_NEXT)
-    int16_t offset = constrain(alt_diff, -254, 254);
+    int16_t alt_diff = this_aircraft->pressure_altitude == 0 ? 0 :
+                       (int16_t) (this_aircraft->pressure_altitude - this_aircraft->altitude);
+    int16_t offset   = constrain(alt_diff, -254, 254);
     if (abs(offset) > 63)
     {
         pkt->qne_scale  = 1;
@@ -411,7 +410,6 @@ size_t fanet_encode_sp(void* fanet_pkt_s, ufo_t* this_aircraft)
     uint32_t id  = this_aircraft->addr;
     float    lat = this_aircraft->latitude;
     float    lon = this_aircraft->longitude;
-    int16_t  alt = (int16_t) this_aircraft->altitude;
 
     fanet_packet_s* spkt = (fanet_packet_s *) fanet_pkt_s;
 
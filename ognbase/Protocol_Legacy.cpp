@@ -75,7 +75,7 @@ void btea(uint32_t* v, int8_t n, const uint32_t key[4])
         do {
             sum += DELTA;
             e    = (sum >> 2) & 3;
-            for (p = 0; p < n - 1; p++) {
+            for (p = 0; p < (uint32_t) n - 1; p++) {
                 y = v[p + 1];
                 z = v[p] += MX;
             }
@@ -122,10 +122,45 @@ void make_key(uint32_t key[4], uint32_t timestamp, uint32_t address)
     }
 }
 
-bool legacy_decode(void* legacy_pkt, ufo_t* this_aircraft, ufo_t* fop)
+/*
+ * The key only changes with timestamp >> 6 (bit 23 included) and the
+ * address, so every aircraft needs a new one once per 64 s. Direct
+ * mapped on the address; loop() is the only user.
+ */
+typedef struct
+{
+    bool     valid;
+    uint32_t epoch;
+    uint32_t address;
+    uint32_t key[4];
+} legacy_key_t;
+
+static legacy_key_t legacy_keys[LEGACY_KEY_CACHE];
+
+static const uint32_t* legacy_key(uint32_t timestamp, uint32_t address)
 {
-    String msg;
+    legacy_key_t* k = &legacy_keys[((address >> 8) ^ (address >> 16)) & (LEGACY_KEY_CACHE - 1)];
+
+    if (!k->valid || k->epoch != (timestamp >> 6) || k->address != address)
+    {
+        make_key(k->key, timestamp, address);
+        k->valid   = true;
+        k->epoch   = timestamp >> 6;
+        k->address = address;
+    }
+    return k->key;
+}
 
+/* even/odd number of 1s in the whole packet, 6 words */
+static uint8_t legacy_parity(const legacy_packet_t* pkt)
+{
+    const uint32_t* w = (const uint32_t *) pkt;
+
+    return parity(w[0] ^ w[1] ^ w[2] ^ w[3] ^ w[4] ^ w[5]);
+}
+
+bool legacy_decode(void* legacy_pkt, ufo_t* this_aircraft, ufo_t* fop)
+{
     legacy_packet_t* pkt = (legacy_packet_t *) legacy_pkt;
 
     float    ref_lat   = this_aircraft->latitude;
@@ -133,23 +168,11 @@ bool legacy_decode(void* legacy_pkt, ufo_t* this_aircraft, ufo_t* fop)
     float    geo_separ = this_aircraft->geoid_separation;
     uint32_t timestamp = (uint32_t) this_aircraft->timestamp;
 
+    btea((uint32_t *) pkt + 1, -5, legacy_key(timestamp, (pkt->addr << 8) & 0xffffff));
 
-    uint32_t key[4];
-    int      ndx;
-    uint8_t  pkt_parity=0;
-
-    make_key(key, timestamp, (pkt->addr << 8) & 0xffffff);
-    btea((uint32_t *) pkt + 1, -5, key);
-    
-
-    for (ndx = 0; ndx < sizeof (legacy_packet_t); ndx++)
-        pkt_parity += parity(*(((unsigned char *) pkt) + ndx));
-    if (pkt_parity % 2)
+    if (legacy_parity(pkt))
     {
-        msg = "bad parity of decoded legacy packet";
-        Logger_send_udp(&msg);
-        msg = "decoding failed";
-        Logger_send_udp(&msg);
+        LOG_DEBUG("bad parity of decoded legacy packet %06X", pkt->addr);
         return false;
     }
 
@@ -212,10 +235,6 @@ size_t legacy_encode(void* legacy_pkt, ufo_t* this_aircraft)
 {
     legacy_packet_t* pkt = (legacy_packet_t *) legacy_pkt;
 
-    int      ndx;
-    uint8_t  pkt_parity=0;
-    uint32_t key[4];
-
     uint32_t id        = this_aircraft->addr;
     float    lat       = this_aircraft->latitude;
     float    lon       = this_aircraft->longitude;
@@ -311,12 +330,9 @@ size_t legacy_encode(void* legacy_pkt, ufo_t* this_aircraft)
     pkt->_unk3 = 0;
 //    pkt->_unk4 = 0;
 
-    for (ndx = 0; ndx < sizeof (legacy_packet_t); ndx++)
-        pkt_parity += parity(*(((unsigned char *) pkt) + ndx));
-
-    pkt->parity = (pkt_parity % 2);
+    pkt->parity = legacy_parity(pkt);
 
-    make_key(key, timestamp, (pkt->addr << 8) & 0xffffff);
+    const uint32_t* key = legacy_key(timestamp, (pkt->addr << 8) & 0xffffff);
 
 #if 0
     Serial.print(key[0]);
@@ -67,7 +67,7 @@ bool p3i_decode(void* p3i_pkt, ufo_t* this_aircraft, ufo_t* fop)
     uint8_t  cs = 0;
     uint8_t* p  = (uint8_t *)pkt;
 
-    for (int i=0; i < sizeof(p3i_packet_t); i++)
+    for (size_t i=0; i < sizeof(p3i_packet_t); i++)
         cs ^= *p++;
     if (cs)
         return false;
@@ -129,7 +129,7 @@ size_t p3i_encode(void* p3i_pkt, ufo_t* this_aircraft)
 
     pkt->aircraft = aircraft_type;
 
-    for (int i=0; i < (sizeof(p3i_packet_t) - 1); i++)
+    for (size_t i=0; i < (sizeof(p3i_packet_t) - 1); i++)
         cs ^= *p++;
 
     pkt->crc = cs;
@@ -0,0 +1,333 @@
+/*
+ * RELAY.cpp
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * Store and forward for ognrelay stations. ParseData() queues the raw
+ * frames, RELAY_Loop() sends them on RF_RELAY_CHANNEL, where the base
+ * (and the next relay of a chain) listens.
+ *
+ * The queue works like OGN_PrioQueue in libraries/OGN/ogn.h: a newer
+ * frame of an aircraft replaces the older one, a new frame takes the
+ * slot of the lowest rank when the queue is full, and the frame to send
+ * is drawn with a probability proportional to its rank. Weak frames
+ * rank higher, the base is less likely to hear them itself, and every
+ * hop a frame has made halves its rank, so a relay near the base does
+ * not spend its airtime on the far end of the chain alone.
+ *
+ * The number of hops travels in the frame: OGNTP has RelayCount in the
+ * header (the FEC is encoded again), Legacy uses the reserved nibble of
+ * the plain header word, the count written twice so that the packet
+ * parity holds. Other protocols, and Legacy frames with that nibble in
+ * use, are forwarded only when heard directly.
+ *
+ * Airtime is a token bucket: it fills at the duty cycle of the region
+ * (at most RELAY_RX_SHARE) and holds RELAY_BURST_MS. Frames are only
+ * sent between slot 2 and slot 1 while slot timing is running.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "RELAY.h"
+#include "DEDUP.h"
+#include "SoC.h"
+#include "global.h"
+
+#include <ldpc.h>
+
+#define RELAY_LEGACY_NIBBLE 0x0F    /* byte 3, _unk0 of legacy_packet_t */
+#define RELAY_OGNTP_COUNT   0x30    /* byte 3, Header.RelayCount */
+#define RELAY_OGNTP_FEC     6
+
+typedef struct relay_frame
+{
+    uint32_t addr;
+    uint32_t ms;
+    uint8_t  protocol;
+    uint8_t  hops;                  /* after this relay */
+    uint8_t  rank;                  /* 0 = free */
+    uint8_t  size;
+    uint8_t  payload[MAX_PKT_SIZE];
+} relay_frame_t;
+
+relay_stats_t RELAY_stats;
+
+static relay_frame_t queue[RELAY_QUEUE];
+static uint16_t      rank_sum  = 0;
+static uint8_t       low       = 0;
+static uint8_t       low_idx   = 0;
+static uint32_t      budget_us = 0;
+static uint32_t      budget_ms = 0;
+
+/* permille of airtime per band, ETSI g1 1%, g3 10% */
+static uint16_t RELAY_Duty()
+{
+    uint16_t duty;
+
+    switch (RF_FreqPlan.Plan)
+    {
+        case RF_BAND_UK:
+            duty = 100;
+            break;
+        case RF_BAND_US:
+        case RF_BAND_AU:
+            duty = 1000;            /* frequency hopping, no duty cycle */
+            break;
+        case RF_BAND_EU:
+        case RF_BAND_RU:
+        case RF_BAND_NZ:
+        case RF_BAND_CN:
+        case RF_BAND_IN:
+        default:
+            duty = 10;
+            break;
+    }
+
+    return duty < RELAY_RX_SHARE ? duty : RELAY_RX_SHARE;
+}
+
+void RELAY_Reset()
+{
+    memset(&RELAY_stats, 0, sizeof(RELAY_stats));
+    memset(queue, 0, sizeof(queue));
+    rank_sum  = 0;
+    low       = 0;
+    low_idx   = 0;
+    budget_us = RELAY_BURST_MS * 1000UL;
+    budget_ms = 0;
+}
+
+size_t RELAY_Depth()
+{
+    size_t n = 0;
+
+    for (uint8_t i = 0; i < RELAY_QUEUE; i++)
+        n += queue[i].rank != 0;
+    return n;
+}
+
+uint8_t RELAY_HopMask(uint8_t protocol)
+{
+    switch (protocol)
+    {
+        case RF_PROTOCOL_LEGACY:
+            return RELAY_LEGACY_NIBBLE;
+        case RF_PROTOCOL_OGNTP:
+            return RELAY_OGNTP_COUNT;
+        default:
+            return 0;
+    }
+}
+
+/* hops the frame has made, 0xFF if it can not tell */
+uint8_t RELAY_Hops(uint8_t protocol, const uint8_t* payload)
+{
+    uint8_t nibble;
+
+    switch (protocol)
+    {
+        case RF_PROTOCOL_LEGACY:
+            nibble = payload[3] & RELAY_LEGACY_NIBBLE;
+            return (nibble >> 2) == (nibble & 0x03) ? nibble & 0x03 : 0xFF;
+        case RF_PROTOCOL_OGNTP:
+            return (payload[3] & RELAY_OGNTP_COUNT) >> 4;
+        default:
+            return 0xFF;
+    }
+}
+
+/* writes the hop count, size grows by the FEC where the radio does not add it */
+bool RELAY_SetHops(uint8_t protocol, uint8_t* payload, size_t* size, uint8_t hops)
+{
+    if (hops > 3 || RELAY_Hops(protocol, payload) == 0xFF)
+        return false;
+
+    switch (protocol)
+    {
+        case RF_PROTOCOL_LEGACY:
+            payload[3] = (payload[3] & ~RELAY_LEGACY_NIBBLE) | hops | hops << 2;
+            return true;
+        case RF_PROTOCOL_OGNTP:
+            if (*size + RELAY_OGNTP_FEC > MAX_PKT_SIZE)
+                return false;
+            payload[3] = (payload[3] & ~RELAY_OGNTP_COUNT) | hops << 4;
+            LDPC_Encode(payload);
+            *size = OGNTP_PAYLOAD_SIZE + RELAY_OGNTP_FEC;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* OGN_PrioQueue::reCalc() */
+static void RELAY_Recalc()
+{
+    rank_sum = low = queue[0].rank;
+    low_idx  = 0;
+    for (uint8_t i = 1; i < RELAY_QUEUE; i++)
+    {
+        rank_sum += queue[i].rank;
+        if (queue[i].rank < low)
+        {
+            low     = queue[i].rank;
+            low_idx = i;
+        }
+    }
+}
+
+static void RELAY_Clean(uint8_t i)
+{
+    rank_sum     -= queue[i].rank;
+    queue[i].rank = 0;
+    low           = 0;
+    low_idx       = i;
+}
+
+/* OGN_PrioQueue::getRand(), by rank */
+static uint8_t RELAY_Pick()
+{
+    uint16_t pick = SoC->random(0, rank_sum);
+    uint16_t sum  = 0;
+
+    for (uint8_t i = 0; i < RELAY_QUEUE; i++)
+    {
+        if (queue[i].rank == 0)
+            continue;
+        sum += queue[i].rank;
+        if (sum > pick)
+            return i;
+    }
+    return low_idx;
+}
+
+static uint8_t RELAY_Rank(int8_t rssi, uint8_t hops)
+{
+    int rank = 16;
+
+    if (rssi < RELAY_RSSI_WEAK)
+        rank += (RELAY_RSSI_WEAK - rssi) / 2;   /* a point per 2 dB */
+    if (rank > 0xFF)
+        rank = 0xFF;
+    return (rank >> hops) | 1;
+}
+
+bool RELAY_Enqueue(uint8_t protocol, const uint8_t* payload, size_t size, int8_t rssi,
+                   uint8_t channel, uint32_t ms)
+{
+    uint8_t hops = 0;
+
+    /* sent on the protocol the radio is on, see RF_Transmit() */
+    if (protocol != ogn_protocol_1 || size == 0 || size > MAX_PKT_SIZE)
+        return false;
+
+    if (channel == RF_RELAY_CHANNEL)
+    {
+        hops = RELAY_Hops(protocol, payload);
+        if (hops >= RELAY_MAX_HOPS)
+        {
+            RELAY_stats.hop_limit++;
+            return false;
+        }
+    }
+    hops++;
+
+    uint32_t addr = DEDUP_Address(protocol, payload);
+
+    for (uint8_t i = 0; i < RELAY_QUEUE; i++)
+        if (queue[i].rank && queue[i].addr == addr && queue[i].protocol == protocol)
+        {
+            RELAY_Clean(i);
+            RELAY_stats.superseded++;
+        }
+
+    /* OGN_PrioQueue::getNew(), a free slot has rank 0 */
+    if (low != 0 || queue[low_idx].rank != 0)
+        RELAY_Recalc();
+    uint8_t i = low_idx;
+    if (queue[i].rank)
+    {
+        RELAY_stats.dropped++;
+        RELAY_Clean(i);
+    }
+
+    relay_frame_t* f = &queue[i];
+
+    f->addr     = addr;
+    f->ms       = ms;
+    f->protocol = protocol;
+    f->hops     = hops;
+    f->size     = size;
+    memcpy(f->payload, payload, size);
+    f->rank     = RELAY_Rank(rssi, hops - 1);
+    rank_sum   += f->rank;
+    RELAY_Recalc();
+
+    RELAY_stats.queued++;
+    return true;
+}
+
+/* at most one frame per call, true if one went out */
+bool RELAY_Loop(uint32_t ms)
+{
+    uint16_t duty = RELAY_Duty();
+
+    if (budget_ms == 0)
+        budget_ms = ms;
+    budget_us += (ms - budget_ms) * duty;  /* us of airtime per ms at duty permille */
+    budget_ms  = ms;
+    if (budget_us > RELAY_BURST_MS * 1000UL)
+        budget_us = RELAY_BURST_MS * 1000UL;
+    RELAY_stats.duty = duty;
+
+    for (uint8_t i = 0; i < RELAY_QUEUE; i++)
+        if (queue[i].rank && ms - queue[i].ms > RELAY_MAX_AGE_MS)
+        {
+            RELAY_Clean(i);
+            RELAY_stats.expired++;
+        }
+
+    if (rank_sum == 0 || !RF_Quiet())
+        return false;
+
+    uint8_t        i = RELAY_Pick();
+    relay_frame_t* f = &queue[i];
+    size_t         size = f->size;
+    uint32_t       airtime;
+
+    memcpy(TxBuffer, f->payload, size);
+    if (!RELAY_SetHops(f->protocol, TxBuffer, &size, f->hops) && f->hops > 1)
+    {
+        RELAY_Clean(i);
+        RELAY_stats.hop_limit++;
+        return false;
+    }
+
+    /* RF_Airtime() adds the FEC RELAY_SetHops() has put into size */
+    airtime = RF_Airtime(f->protocol, f->size);
+    if (budget_us < airtime)
+    {
+        RELAY_stats.deferred++;
+        return false;
+    }
+
+    if (!RF_Transmit(size, false))
+        return false;
+
+    budget_us              -= airtime;
+    RELAY_stats.sent++;
+    RELAY_stats.airtime_ms += (airtime + 500) / 1000;
+    RELAY_Clean(i);
+    return true;
+}
@@ -0,0 +1,59 @@
+/*
+ * RELAY.h
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RF.h"
+
+#ifndef RELAYHELPER_H
+#define RELAYHELPER_H
+
+#define RELAY_QUEUE         8       /* frames waiting, OGN_PrioQueue<8> */
+#define RELAY_MAX_HOPS      2       /* relays a frame may pass, 3 at most (OGNTP RelayCount) */
+#define RELAY_MAX_AGE_MS    3000    /* older frames are of no use downstream */
+#define RELAY_BURST_MS      500     /* airtime that can be saved up */
+#define RELAY_RX_SHARE      100     /* permille, airtime cap to keep the receiver listening */
+#define RELAY_RSSI_WEAK     -80     /* dBm, below that a frame ranks higher, the base hardly hears it */
+
+typedef struct relay_stats
+{
+    uint32_t queued;
+    uint32_t superseded;            /* a newer frame of the same aircraft came in */
+    uint32_t dropped;               /* pushed out by a frame of higher rank */
+    uint32_t expired;               /* older than RELAY_MAX_AGE_MS */
+    uint32_t hop_limit;             /* relayed RELAY_MAX_HOPS times, or no hop count to go by */
+    uint32_t deferred;              /* passes without airtime budget */
+    uint32_t sent;
+    uint32_t airtime_ms;
+    uint16_t duty;                  /* permille allowed in this region */
+} relay_stats_t;
+
+void    RELAY_Reset();
+bool    RELAY_Enqueue(uint8_t protocol, const uint8_t* payload, size_t size, int8_t rssi,
+                      uint8_t channel, uint32_t ms);
+bool    RELAY_Loop(uint32_t ms);
+size_t  RELAY_Depth();
+
+uint8_t RELAY_Hops(uint8_t protocol, const uint8_t* payload);
+bool    RELAY_SetHops(uint8_t protocol, uint8_t* payload, size_t* size, uint8_t hops);
+uint8_t RELAY_HopMask(uint8_t protocol);
+
+extern relay_stats_t RELAY_stats;
+
+#endif /* RELAYHELPER_H */
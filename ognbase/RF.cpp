@@ -32,12 +32,36 @@
 #include "Log.h"
 #include "GNSS.h"
 #include "PNET.h"
+#include "CRC.h"
+#include "RFSCHED.h"
+#include "RXSTATS.h"
+#include "CAPTURE.h"
 #include <fec.h>
+#include <ldpc.h>
 
 #if LOGGER_IS_ENABLED
 #include "LogHelper.h"
 #endif /* LOGGER_IS_ENABLED */
 
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+static TaskHandle_t      RF_task_handle = NULL;
+static SemaphoreHandle_t RF_mutex       = NULL;
+static TaskHandle_t      RF_waiter      = NULL;     /* loop() in RF_Wait() */
+
+/* the radio belongs to the RF task once it runs, everybody else borrows it */
+#define RF_LOCK()   do { if (RF_mutex) xSemaphoreTakeRecursive(RF_mutex, portMAX_DELAY); } while (0)
+#define RF_UNLOCK() do { if (RF_mutex) xSemaphoreGiveRecursive(RF_mutex); } while (0)
+#define RF_TASK_RUNNING() (RF_task_handle != NULL)
+#else
+#define RF_LOCK()   do { } while (0)
+#define RF_UNLOCK() do { } while (0)
+#define RF_TASK_RUNNING() false
+#endif /* ESP32 */
+
 byte RxBuffer[MAX_PKT_SIZE];
 
 unsigned long TxTimeMarker = 0;
@@ -46,7 +70,87 @@ byte          TxBuffer[MAX_PKT_SIZE];
 uint32_t tx_packets_counter = 0;
 uint32_t rx_packets_counter = 0;
 
-int8_t RF_last_rssi = 0;
+int8_t        RF_last_rssi     = 0;
+unsigned long RF_last_rx_ms    = 0;
+time_t        RF_last_rx_time  = 0;
+uint8_t       RF_last_protocol = RF_PROTOCOL_LEGACY;
+uint8_t       RF_last_channel  = 0;
+
+/*
+ * Validated frames, RF task -> loop(). Single producer, single consumer:
+ * only the producer moves rx_head, only the consumer moves rx_tail.
+ */
+static byte   rx_payload[MAX_PKT_SIZE];   /* radio side, RxBuffer is loop()'s */
+static size_t rx_size = 0;
+static int8_t rx_rssi = 0;
+
+static rf_frame_t        rx_ring[RF_RX_QUEUE];
+static volatile uint16_t rx_head = 0;
+static volatile uint16_t rx_tail = 0;
+
+rf_queue_stats_t RF_queue_stats;
+rf_fec_stats_t   RF_fec_stats;
+rf_tx_stats_t    RF_tx_stats;
+rf_rearm_stats_t RF_rearm_stats;
+rf_proto_stats_t RF_proto_stats[RF_DUAL_PROTOCOLS];
+
+/*
+ * ogn_protocol_2 shares the receiver with ogn_protocol_1. Slotted
+ * protocols (Legacy, OGNTP) keep the RF_SetChannel() slot timing and
+ * RFSCHED hands out the slots by yield; a slotted one next to an
+ * unslotted one leaves it the dead time between slot 2 and slot 1 on
+ * top. Without slot timing (no fix, or none is slotted) RFSCHED hands
+ * out windows of RF_DUAL_WINDOW ms.
+ */
+enum
+{
+    RF_DUAL_OFF,
+    RF_DUAL_SLOTS,
+    RF_DUAL_DEADTIME,
+    RF_DUAL_SPLIT
+};
+
+static uint8_t       rf_dual   = RF_DUAL_OFF;
+static uint8_t       rf_timing = 0;     /* index of the protocol the slot timing follows */
+static uint8_t       rf_active = 0;     /* index of the protocol the receiver is on */
+static unsigned long rf_hop_ms = 0;
+
+static unsigned long rf_window       = 0;   /* current slot or window, RFSCHED picked its owner */
+static uint8_t       rf_window_owner = 0;
+static uint8_t       rf_window_kind  = RFSCHED_FREE;
+static uint8_t       rf_bucket       = 0;   /* RF task */
+static uint8_t       rf_last_bucket  = 0;   /* loop(), of RxBuffer */
+static uint8_t       rf_channel      = 0;   /* RF task, the receiver is tuned to */
+
+/*
+ * TinyGPSPlus and TimeLib belong to loop(). RF_Clock() copies what the
+ * slot timing needs under RF_LOCK, the RF task reads only this copy.
+ */
+typedef struct rf_clock_struct
+{
+    bool          fix;          /* isValidFix() */
+    time_t        gnss_time;    /* GNSS date and time of the last NMEA commit */
+    unsigned long gnss_ms;      /* millis() of that commit */
+    time_t        time;         /* now() */
+    unsigned long time_ms;      /* millis() of time */
+} rf_clock_t;
+
+static rf_clock_t rf_clock;
+
+typedef struct rf_proto_bind_struct
+{
+    uint8_t                type;
+    const rf_proto_desc_t* desc;
+    size_t                 (* encode)(void *, ufo_t *);
+    bool                   (* decode)(void *, ufo_t *, ufo_t *);
+} rf_proto_bind_t;
+
+static const rf_proto_bind_t rf_protocols[] = {
+    { RF_PROTOCOL_LEGACY, &legacy_proto_desc, &legacy_encode, &legacy_decode },
+    { RF_PROTOCOL_OGNTP,  &ogntp_proto_desc,  &ogntp_encode,  &ogntp_decode  },
+    { RF_PROTOCOL_P3I,    &p3i_proto_desc,    &p3i_encode,    &p3i_decode    },
+    { RF_PROTOCOL_FANET,  &fanet_proto_desc,  &fanet_encode,  &fanet_decode  },
+};
 
 FreqPlan    RF_FreqPlan;
 static bool RF_ready = false;
@@ -67,6 +171,7 @@ static bool sx1262_probe(void);
 static void sx12xx_setup(void);
 
 static void sx12xx_channel(uint8_t);
+static void sx12xx_protocol(uint8_t);
 static bool sx12xx_receive(void);
 
 static void sx12xx_transmit(void);
@@ -80,6 +185,7 @@ const rfchip_ops_t sx1276_ops = {
     sx1276_probe,
     sx12xx_setup,
     sx12xx_channel,
+    sx12xx_protocol,
     sx12xx_receive,
     sx12xx_transmit,
     sx12xx_shutdown
@@ -91,6 +197,7 @@ const rfchip_ops_t sx1262_ops = {
     sx1262_probe,
     sx12xx_setup,
     sx12xx_channel,
+    sx12xx_protocol,
     sx12xx_receive,
     sx12xx_transmit,
     sx12xx_shutdown
@@ -100,7 +207,7 @@ const rfchip_ops_t sx1262_ops = {
 String Bin2Hex(byte* buffer, size_t size)
 {
     String str = "";
-    for (int i=0; i < size; i++) {
+    for (size_t i=0; i < size; i++) {
         byte c = buffer[i];
         str += (c < 0x10 ? "0" : "") + String(c, HEX);
     }
@@ -109,13 +216,93 @@ String Bin2Hex(byte* buffer, size_t size)
 
 uint8_t parity(uint32_t x)
 {
-    uint8_t parity=0;
-    while (x > 0) {
-        if (x & 0x1)
-            parity++;
-        x >>= 1;
+    x ^= x >> 16;
+    x ^= x >> 8;
+    x ^= x >> 4;
+    return (0x6996 >> (x & 0xF)) & 1;
+}
+
+static const rf_proto_bind_t* RF_Bind(uint8_t protocol)
+{
+    for (size_t i = 0; i < sizeof(rf_protocols) / sizeof(rf_protocols[0]); i++)
+        if (rf_protocols[i].type == protocol)
+            return &rf_protocols[i];
+    return NULL;
+}
+
+static bool RF_Slotted(uint8_t protocol)
+{
+    return protocol == RF_PROTOCOL_LEGACY || protocol == RF_PROTOCOL_OGNTP;
+}
+
+static void RF_Dual_setup(void)
+{
+    const uint8_t protocol[RF_DUAL_PROTOCOLS] = { ogn_protocol_1, ogn_protocol_2 };
+
+    for (int i = 0; i < RF_DUAL_PROTOCOLS; i++)
+        if (RF_proto_stats[i].protocol != protocol[i])
+        {
+            memset(&RF_proto_stats[i], 0, sizeof(RF_proto_stats[i]));
+            RF_proto_stats[i].protocol = protocol[i];
+        }
+
+    rf_timing = rf_active = 0;
+    rf_hop_ms = millis();
+
+    if (ogn_protocol_2 == ogn_protocol_1 || RF_Bind(ogn_protocol_2) == NULL ||
+        ognrelay_enable || ognrelay_base)
+        rf_dual = RF_DUAL_OFF;
+    else if (RF_Slotted(ogn_protocol_1) && RF_Slotted(ogn_protocol_2))
+        rf_dual = RF_DUAL_SLOTS;
+    else if (RF_Slotted(ogn_protocol_1) || RF_Slotted(ogn_protocol_2))
+    {
+        rf_dual   = RF_DUAL_DEADTIME;
+        rf_timing = RF_Slotted(ogn_protocol_1) ? 0 : 1;
+    }
+    else
+        rf_dual = RF_DUAL_SPLIT;
+
+    /* shares while nothing is heard, and what each keeps at least */
+    uint8_t share[RF_DUAL_PROTOCOLS] = { 100, 0 };
+    uint8_t floor[RF_DUAL_PROTOCOLS] = { 0, 0 };
+
+    switch (rf_dual)
+    {
+        case RF_DUAL_SLOTS:
+            share[0] = share[1] = 50;
+            floor[0] = floor[1] = RFSCHED_MIN_SHARE;
+            break;
+        case RF_DUAL_DEADTIME:
+            /* the unslotted one has the dead time anyway */
+            share[rf_timing]     = 100;
+            share[1 - rf_timing] = 0;
+            floor[rf_timing]     = RFSCHED_MIN_SHARE;
+            break;
+        case RF_DUAL_SPLIT:
+            share[1] = RF_DUAL_WINDOW / 10;
+            share[0] = 100 - share[1];
+            floor[0] = floor[1] = RFSCHED_MIN_SHARE;
+            break;
+        default:
+            break;
+    }
+
+    RFSCHED_Reset(protocol, share, floor);
+    if (memcmp(RXSTATS_stats.protocol, protocol, sizeof(RXSTATS_stats.protocol)))
+        RXSTATS_Reset(protocol);
+    rf_window = 0;
+    rf_window_owner = rf_bucket = rf_last_bucket = 0;
+
+    if (rf_dual != RF_DUAL_OFF)
+    {
+        Serial.print(F("Second protocol: "));
+        Serial.println(RF_Bind(ogn_protocol_2)->desc->name);
     }
-    return parity % 2;
+}
+
+bool RF_Dual(void)
+{
+    return rf_dual != RF_DUAL_OFF;
 }
 
 byte RF_setup(void)
@@ -133,7 +320,7 @@ byte RF_setup(void)
             SX12XX_LL = &sx126x_ll_ops;
         }
 
-        if (rf_chip && rf_chip->name)
+        if (rf_chip)
         {
             Serial.print(rf_chip->name);
             Serial.println(F(" RFIC is detected."));
@@ -143,10 +330,12 @@ byte RF_setup(void)
     }
 
     RF_FreqPlan.setPlan(ogn_band);
+    CRC_setup();
 
     if (rf_chip)
     {
         rf_chip->setup();
+        RF_Dual_setup();
         return rf_chip->type;
     }
     else
@@ -170,14 +359,118 @@ static long prev_TimeCommit = 0;
 uint8_t     Slot            = 0;
 time_t      slotTime        = 0;
 
+/* loop(): a new copy for the RF task when the GNSS or the clock moved on */
+static void RF_Clock()
+{
+    rf_clock_t   clock = rf_clock;
+    tmElements_t tm;
+
+    clock.fix = isValidFix();
+
+    if (gnss.date.isValid() && gnss.time.isValid())
+    {
+        int yr = gnss.date.year();
+        if (yr > 99)
+            yr = yr - 1970;
+        else
+            yr += 30;
+        tm.Year   = yr;
+        tm.Month  = gnss.date.month();
+        tm.Day    = gnss.date.day();
+        tm.Hour   = gnss.time.hour();
+        tm.Minute = gnss.time.minute();
+        tm.Second = gnss.time.second();
+
+        /* GGA and RMC carry the same time, the first commit of it counts */
+        time_t gnss_time = makeTime(tm);
+        if (gnss_time != clock.gnss_time)
+        {
+            clock.gnss_time = gnss_time;
+            clock.gnss_ms   = millis() - gnss.time.age();
+        }
+    }
+
+    time_t time = now();
+    if (time != clock.time)
+    {
+        clock.time    = time;
+        clock.time_ms = millis();
+    }
+
+    if (clock.fix == rf_clock.fix && clock.gnss_time == rf_clock.gnss_time &&
+        clock.time == rf_clock.time)
+        return;
+
+    RF_LOCK();
+    rf_clock = clock;
+    RF_UNLOCK();
+}
+
+/* RF task: wall time at ms, from the copy of RF_Clock() */
+static time_t RF_Time(unsigned long ms)
+{
+    return rf_clock.time + (long) (ms - rf_clock.time_ms) / 1000;
+}
+
+/* index of the protocol to listen to, phase is ms since slot 0 began, -1 without slot timing */
+static uint8_t RF_Dual_Select(long phase)
+{
+    bool          slotted = phase >= 0 && phase < 1000;
+    unsigned long window;
+
+    switch (rf_dual)
+    {
+        case RF_DUAL_OFF:
+            rf_window_kind = slotted && RF_Slotted(ogn_protocol_1) ? Slot : (uint8_t) RFSCHED_FREE;
+            return 0;
+        case RF_DUAL_DEADTIME:
+            /* nothing slotted is on the air from 1200 to 400 ms after the PPS */
+            if (slotted && (phase < SLOT1_ADVANCE || phase >= SLOT1_ADVANCE + 2 * SLOT_DURATION))
+            {
+                rf_window_kind = RFSCHED_FREE;
+                return 1 - rf_timing;
+            }
+            /* fall through */
+        case RF_DUAL_SLOTS:
+            if (slotted)
+            {
+                window         = 2 * (unsigned long) TimeReference + Slot;
+                rf_window_kind = Slot;
+                break;
+            }
+            /* fall through */
+        default:
+            window         = millis() / RF_DUAL_WINDOW;
+            rf_window_kind = RFSCHED_FREE;
+            break;
+    }
+
+    if (window != rf_window)
+    {
+        rf_window       = window;
+        rf_window_owner = RFSCHED_Pick();
+    }
+    return rf_window_owner;
+}
+
+static void RF_Dual_Switch(uint8_t active)
+{
+    if (active == rf_active)
+        return;
+
+    rf_active = active;
+    RF_proto_stats[active].windows++;
+    if (rf_chip && rf_chip->protocol)
+        rf_chip->protocol(RF_proto_stats[active].protocol);
+}
+
 
 void RF_SetChannel(void)
    {
-    tmElements_t tm;
-    time_t       Time;
+    time_t       Time = slotTime;   /* no fix: the last one */
 
     if (RF_ready && rf_chip && ognrelay_base){
-      rf_chip->channel(4);
+      rf_chip->channel(RF_RELAY_CHANNEL);
       return;
     }
 
@@ -188,7 +481,10 @@ void RF_SetChannel(void)
             unsigned long pps_btime_ms = SoC->get_PPS_TimeMarker();
             unsigned long time_corr_neg  = 0;
             unsigned long timeAge        = 0;
-            unsigned long lastCommitTime = (Now_millis = millis()) - (timeAge = gnss.time.age());
+            unsigned long lastCommitTime = rf_clock.gnss_ms;
+
+            Now_millis = millis();
+            timeAge    = Now_millis - lastCommitTime;
 
             // HOP Testing - NMEA sentence time commit
             //Serial.printf("Commit: %d, %d, %d\r\n", lastCommitTime, prev_TimeCommit, pps_btime_ms);
@@ -217,8 +513,8 @@ void RF_SetChannel(void)
                 time_corr_neg = DELAY_PPS_GPSTIME;
 
             // only frequency hop with legacy and OGN protocols and gps fix
-            if (isValidFix()){
-              switch (ogn_protocol_1)
+            if (rf_clock.fix){
+              switch (rf_dual ? RF_proto_stats[rf_timing].protocol : ogn_protocol_1)
               {
                   case RF_PROTOCOL_LEGACY:
                   case RF_PROTOCOL_OGNTP:
@@ -249,7 +545,7 @@ void RF_SetChannel(void)
                               TxTimeMarker    = TimeReference_2;
                               TxRandomValue   = SoC->random(10, SLOT_DURATION - 0); //  allow some margin
                           }
-                          else
+                          else if (!rf_dual) // the second protocol may be due within the slot
                               return;
                       }
                       break;
@@ -264,34 +560,25 @@ void RF_SetChannel(void)
             //Serial.printf("Timing: %d, %d, %d, %d, %d, %d, %d\r\n", Now_millis, pps_btime_ms, timeAge, time_corr_neg, TimeReference, TxRandomValue, Slot);
 
             // latest time from GPS
-            if (isValidFix()){
-              int yr = gnss.date.year();
-              if (yr > 99)
-                  yr = yr - 1970;
-              else
-                  yr += 30;
-              tm.Year   = yr;
-              tm.Month  = gnss.date.month();
-              tm.Day    = gnss.date.day();
-              tm.Hour   = gnss.time.hour();
-              tm.Minute = gnss.time.minute();
-              tm.Second = gnss.time.second();
-  
+            if (rf_clock.fix){
               // time right now is:
-              slotTime = Time = makeTime(tm) + (timeAge + time_corr_neg) / 1000;
+              slotTime = Time = rf_clock.gnss_time + (timeAge + time_corr_neg) / 1000;
               break;
             }
     }
 
-    uint8_t OGN = (ogn_protocol_1 == RF_PROTOCOL_OGNTP ? 1 : 0);
+    uint8_t active   = RF_Dual_Select(rf_clock.fix ? Now_millis - TimeReference : -1);
+    uint8_t protocol = rf_dual ? RF_proto_stats[active].protocol : ogn_protocol_1;
+
+    uint8_t OGN = (protocol == RF_PROTOCOL_OGNTP ? 1 : 0);
 
-    uint8_t chan = RF_FreqPlan.getChannel(Time, Slot, OGN);
+    uint8_t chan = RF_FreqPlan.getChannel(Time, rf_dual && !RF_Slotted(protocol) ? 0 : Slot, OGN);
 
     // HOP Testing - time and channel
     //Serial.printf("Time: %d, %d\r\n", Time,chan);
 #if DEBUG
     Serial.print("GSP Fix: ");
-    Serial.println(isValidFix());
+    Serial.println(rf_clock.fix);
     Serial.print("Plan: ");
     Serial.println(RF_FreqPlan.Plan);
     Serial.print("Slot: ");
@@ -303,10 +590,14 @@ void RF_SetChannel(void)
 #endif
  
     if (RF_ready && rf_chip)
+    {
+        RF_Dual_Switch(active);
         rf_chip->channel(chan);
+        rf_bucket = RFSCHED_Bucket(active, rf_window_kind, chan);
+    }
    }
 
-void RF_loop()
+static void RF_Hop()
 {
     if (!RF_ready)
     {
@@ -324,10 +615,33 @@ void RF_loop()
     }
 
     if (RF_ready){
+        unsigned long ms = millis();
+
+        /* on air: not listening, and the radio keeps its settings until TX done */
+        if (RF_Transmit_busy())
+        {
+            rf_hop_ms = ms;
+            return;
+        }
+
+        /* the receiver was on rf_active and rf_bucket since the last hop */
+        RF_proto_stats[rf_active].listen_ms += ms - rf_hop_ms;
+        RFSCHED_Listen(rf_bucket, ms - rf_hop_ms);
+        rf_hop_ms = ms;
+
         RF_SetChannel();
     }
 }
 
+void RF_loop()
+{
+    RF_Clock();
+
+    /* the RF task hops on its own */
+    if (!RF_TASK_RUNNING())
+        RF_Hop();
+}
+
 size_t RF_Encode(ufo_t* fop)
 {
     size_t size = 0;
@@ -336,7 +650,12 @@ size_t RF_Encode(ufo_t* fop)
         if (settings->txpower == RF_TX_POWER_OFF)
             return size;
 
-        if ((millis() - TxTimeMarker) > TxRandomValue)
+        /* RF_SetChannel() moves the TX window in the RF task */
+        RF_LOCK();
+        bool due = (millis() - TxTimeMarker) > (unsigned long) TxRandomValue;
+        RF_UNLOCK();
+
+        if (due)
             size = (*protocol_encode)((void *) &TxBuffer[0], fop);
     }
     return size;
@@ -351,10 +670,21 @@ bool RF_Transmit(size_t size, bool wait)
         if (settings->txpower == RF_TX_POWER_OFF)
             return true;
 
-        if (!wait || (millis() - TxTimeMarker) > TxRandomValue)
+        /* the RF task hops under the lock, so the checks hold until the frame is out */
+        RF_LOCK();
+        bool due = !wait || (millis() - TxTimeMarker) > (unsigned long) TxRandomValue;
+
+        /* the radio is on ogn_protocol_2, wait for a window of protocol 1 */
+        if (rf_active != 0)
+            due = false;
+        else if (RF_Transmit_busy())
         {
-            time_t timestamp = now();
+            RF_tx_stats.busy++;
+            due = false;
+        }
 
+        if (due)
+        {
             rf_chip->transmit();
 
             tx_packets_counter++;
@@ -368,9 +698,10 @@ bool RF_Transmit(size_t size, bool wait)
                 SoC->random(LEGACY_TX_INTERVAL_MIN, LEGACY_TX_INTERVAL_MAX));
 
             TxTimeMarker = millis();
-
-            return true;
         }
+        RF_UNLOCK();
+
+        return due;
     }
     return false;
 }
@@ -384,37 +715,246 @@ bool RF_Transmit_raw(size_t size, bool wait)
         if (settings->txpower == RF_TX_POWER_OFF)
             settings->txpower = RF_TX_POWER_FULL;
 
-        if (!wait || (millis() - TxTimeMarker) > TxRandomValue)
+        RF_LOCK();
+        bool due = !wait || (millis() - TxTimeMarker) > (unsigned long) TxRandomValue;
+
+        if (RF_Transmit_busy())
         {
-            time_t timestamp = now();
+            RF_tx_stats.busy++;
+            due = false;
+        }
 
+        if (due)
+        {
             rf_chip->transmit();
 
             tx_packets_counter++;
             RF_tx_size = 0;
 
-             TxTimeMarker = millis();
-
-            return true;
+            TxTimeMarker = millis();
         }
+        RF_UNLOCK();
+
+        return due;
     }
     return false;
 }
 
+/* producer side, RF task (or RF_Receive() when there is none) */
+static void RF_Service(void)
+{
+    if (!RF_ready || !rf_chip || !rf_chip->receive())
+        return;
+
+    uint16_t head = rx_head;
+
+    if ((uint16_t) (head - __atomic_load_n(&rx_tail, __ATOMIC_ACQUIRE)) >= RF_RX_QUEUE)
+    {
+        RF_queue_stats.dropped++;   /* loop() is behind, keep the older frames */
+        return;
+    }
+
+    rf_frame_t* frame = &rx_ring[head & (RF_RX_QUEUE - 1)];
+
+    frame->ms        = millis();
+    frame->rssi      = rx_rssi;
+    frame->protocol  = LMIC.protocol ? LMIC.protocol->type : ogn_protocol_1;
+    frame->bucket    = rf_bucket;
+    frame->channel   = rf_channel;
+    RF_proto_stats[rf_active].frames++;
+    RFSCHED_Frame(rf_bucket);
+    RXSTATS_Frame(rf_active, rf_channel, rf_window_kind, rx_rssi);
+    frame->size      = rx_size;
+    memcpy(frame->payload, rx_payload, rx_size);
+
+    __atomic_store_n(&rx_head, (uint16_t) (head + 1), __ATOMIC_RELEASE);
+
+#if defined(ESP32)
+    TaskHandle_t waiter = __atomic_load_n(&RF_waiter, __ATOMIC_ACQUIRE);
+    if (waiter)
+        xTaskNotifyGive(waiter);
+#endif /* ESP32 */
+
+    uint16_t depth = head + 1 - rx_tail;
+    if (depth > RF_queue_stats.max_depth)
+        RF_queue_stats.max_depth = depth;
+    RF_queue_stats.frames++;
+}
+
+/* consumer side: next validated frame into RxBuffer, false if none is waiting */
 bool RF_Receive(void)
 {
-    bool rval = false;
+    if (!RF_TASK_RUNNING())
+        RF_Service();
 
-    if (RF_ready && rf_chip)
-        rval = rf_chip->receive();
+    uint16_t tail = rx_tail;
+
+    if (tail == __atomic_load_n(&rx_head, __ATOMIC_ACQUIRE))
+        return false;
+
+    rf_frame_t* frame = &rx_ring[tail & (RF_RX_QUEUE - 1)];
+
+    memset(RxBuffer, 0, sizeof(RxBuffer));
+    memcpy(RxBuffer, frame->payload, frame->size);
+    RF_last_rssi     = frame->rssi;
+    RF_last_rx_ms    = frame->ms;
+    RF_last_rx_time  = now() - (millis() - frame->ms) / 1000;
+    RF_last_protocol = frame->protocol;
+    rf_last_bucket   = frame->bucket;
+    RF_last_channel  = frame->channel;
+
+    __atomic_store_n(&rx_tail, (uint16_t) (tail + 1), __ATOMIC_RELEASE);
+    return true;
+}
+
+/*
+ * loop() with nothing to do: sleeps until the RF task queues a frame, at
+ * most timeout_ms. Without the task the radio is polled from loop(),
+ * which then must not sleep.
+ */
+void RF_Wait(uint32_t timeout_ms)
+{
+#if defined(ESP32)
+    if (!RF_TASK_RUNNING() || timeout_ms == 0)
+        return;
+
+    __atomic_store_n(&RF_waiter, xTaskGetCurrentTaskHandle(), __ATOMIC_RELEASE);
+
+    /* a frame queued before the store above gives no notification */
+    if (rx_tail == __atomic_load_n(&rx_head, __ATOMIC_ACQUIRE))
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms));
+
+    __atomic_store_n(&RF_waiter, (TaskHandle_t) NULL, __ATOMIC_RELEASE);
+#endif /* ESP32 */
+}
+
+/* decodes RxBuffer with the protocol it was received on */
+bool RF_Decode(void* buffer, ufo_t* this_aircraft, ufo_t* fop)
+{
+    const rf_proto_bind_t* bind  = RF_Bind(RF_last_protocol);
+    uint8_t                index = rf_dual && RF_last_protocol == ogn_protocol_2 ? 1 : 0;
 
-    return rval;
+    if (bind == NULL || !(*bind->decode)(buffer, this_aircraft, fop))
+    {
+        RXSTATS_Undecoded(index);
+        return false;
+    }
+
+    RF_proto_stats[index].decoded++;
+
+    /* the RF task moves the buckets and ends the epochs */
+    RF_LOCK();
+    RFSCHED_Fix(rf_last_bucket, fop->addr);
+    RF_UNLOCK();
+    return true;
+}
+
+#if defined(ESP32)
+static void RF_Task(void* param)
+{
+    for (;;)
+    {
+        uint16_t head = rx_head;
+
+        RF_LOCK();
+        RF_Hop();
+        RF_Service();
+        RF_UNLOCK();
+
+        /* nothing came in: let IDLE0 (task watchdog) and lwIP have the core */
+        if (head == rx_head)
+            vTaskDelay(1);
+    }
+}
+#endif /* ESP32 */
+
+void RF_Task_start(void)
+{
+#if defined(ESP32)
+    if (RF_task_handle || !rf_chip)
+        return;
+
+    RF_mutex = xSemaphoreCreateRecursiveMutex();
+    if (RF_mutex == NULL ||
+        xTaskCreatePinnedToCore(RF_Task, "RF", RF_TASK_STACK, NULL,
+                                RF_TASK_PRIORITY, &RF_task_handle, RF_TASK_CORE) != pdPASS)
+    {
+        RF_task_handle = NULL;
+        Serial.println(F("WARNING! RF task not started, receiving from loop()"));
+        return;
+    }
+
+    Serial.println(F("RF task started."));
+#endif /* ESP32 */
 }
 
 void RF_Shutdown(void)
 {
+    RF_LOCK();
+#if defined(ESP32)
+    /* it is waiting for the lock or sleeping, never inside the radio code */
+    if (RF_task_handle)
+    {
+        vTaskDelete(RF_task_handle);
+        RF_task_handle = NULL;
+    }
+#endif /* ESP32 */
     if (rf_chip)
         rf_chip->shutdown();
+    RF_UNLOCK();
+}
+
+/* microseconds on air for size payload bytes, preamble, sync word and CRC/FEC included */
+uint32_t RF_Airtime(uint8_t protocol, size_t size)
+{
+    const rf_proto_bind_t* bind = RF_Bind(protocol);
+    const rf_proto_desc_t* desc;
+
+    if (bind == NULL)
+        return 0;
+    desc = bind->desc;
+
+    /* a Gallager coded frame may have its FEC in size already */
+    if (desc->crc_type == RF_CHECKSUM_TYPE_GALLAGER && size > desc->payload_size)
+        size = desc->payload_size;
+
+    if (desc->modulation_type == RF_MODULATION_TYPE_LORA)
+    {
+        /* explicit header, CRC on, CR 4/5, 8 symbols preamble */
+        uint32_t sf      = desc->bitrate < DR_SF7B ? 12 - desc->bitrate : 7;
+        uint32_t bw      = desc->bitrate == DR_SF7B ? 250 : 125;        /* kHz */
+        uint32_t t_sym   = (1000UL << sf) / bw;                         /* us */
+        int32_t  bits    = 8 * size - 4 * sf + 28 + 16;
+        uint32_t symbols = 8 + (bits > 0 ? (bits + 4 * sf - 1) / (4 * sf) * 5 : 0);
+
+        return t_sym * symbols + t_sym * 49 / 4;
+    }
+
+    uint32_t bits = 8 * (desc->preamble_size + desc->syncword_size + desc->payload_offset +
+                         size + desc->crc_size);
+    if (desc->whitening == RF_WHITENING_MANCHESTER)
+        bits *= 2;
+
+    switch (desc->bitrate)
+    {
+        case RF_BITRATE_38400:
+            return bits * 1000000UL / 38400;
+        case RF_BITRATE_1042KBPS:
+            return bits * 1000UL / 1042;
+        case RF_BITRATE_100KBPS:
+        default:
+            return bits * 10;
+    }
+}
+
+/* the dead time between slot 2 and slot 1, or no slot timing at all */
+bool RF_Quiet(void)
+{
+    long phase = millis() - TimeReference;
+
+    if (!isValidFix() || !RF_Slotted(ogn_protocol_1) || phase < 0 || phase >= 1000)
+        return true;
+    return phase < SLOT1_ADVANCE || phase >= SLOT1_ADVANCE + 2 * SLOT_DURATION;
 }
 
 uint8_t RF_Payload_Size(uint8_t protocol)
@@ -446,12 +986,42 @@ static void sx12xx_rx_func(osjob_t* job);
 
 static void sx12xx_rx(osjobcb_t func);
 
+static void sx12xx_rearm(void);
+
 static bool sx12xx_receive_complete  = false;
 bool        sx12xx_receive_active    = false;
-static bool sx12xx_transmit_complete = false;
+static bool sx12xx_transmit_complete = true;    /* false while a frame is on air, atomic */
+
+static unsigned long sx12xx_tx_start_us = 0;
+static uint32_t      sx12xx_airtime_us  = 0;    /* below a ms, not in RF_tx_stats yet */
 
 static uint8_t sx12xx_channel_prev = (uint8_t) -1;
 
+/* why the receiver is off, and since when (CycleCount()) */
+enum
+{
+    SX12XX_LISTENING,
+    SX12XX_BLIND_FRAME,
+    SX12XX_BLIND_HOP
+};
+
+/* the last frame, copied out of LMIC.frame as RX starts again */
+static u1_t rx_frame[MAX_LEN_FRAME];
+static u1_t rx_frame_len  = 0;
+static s1_t rx_frame_rssi = 0;
+
+static uint8_t  sx12xx_blind        = SX12XX_LISTENING;
+static uint32_t sx12xx_blind_cycles = 0;
+
+static void sx12xx_deaf(uint8_t why)
+{
+    if (sx12xx_blind == SX12XX_LISTENING)
+    {
+        sx12xx_blind        = why;
+        sx12xx_blind_cycles = CycleCount();
+    }
+}
+
 #if defined(USE_BASICMAC)
 void os_getDevEui(u1_t* buf)
 { }
@@ -587,14 +1157,12 @@ static void sx12xx_channel(uint8_t channel)
     {
         uint32_t frequency = RF_FreqPlan.getChanFrequency(channel);
         int8_t   fc        = settings->freq_corr;
+        bool     listening = sx12xx_receive_active;
 
         //Serial.print("frequency: "); Serial.println(frequency);
 
-        if (sx12xx_receive_active)
-        {
-            os_radio(RADIO_RST);
-            sx12xx_receive_active = false;
-        }
+        if (listening)
+            sx12xx_deaf(SX12XX_BLIND_HOP);
 
         if (rf_chip->type == RF_IC_SX1276)
         {
@@ -614,9 +1182,32 @@ static void sx12xx_channel(uint8_t channel)
         //LMIC.freq = 868200000UL;
 
         sx12xx_channel_prev = channel;
+        rf_channel          = channel;
+
+        /* os_radio() stops RX itself, the modem setup stays in the radio */
+        if (listening)
+            sx12xx_rearm();
     }
 }
 
+static void sx12xx_protocol(uint8_t protocol)
+{
+    const rf_proto_bind_t* bind = RF_Bind(protocol);
+
+    if (bind == NULL || LMIC.protocol == bind->desc)
+        return;
+
+    /* re-armed with the new modem settings by sx12xx_receive() */
+    if (sx12xx_receive_active)
+    {
+        sx12xx_deaf(SX12XX_BLIND_HOP);
+        os_radio(RADIO_RST);
+        sx12xx_receive_active = false;
+    }
+
+    LMIC.protocol = bind->desc;
+}
+
 static void sx12xx_setup()
 {
     SoC->SPI_begin();
@@ -631,36 +1222,23 @@ static void sx12xx_setup()
     // range test.
     LMIC.agcref = 0x00;
 
-    switch (ogn_protocol_1)
+    const rf_proto_bind_t* bind = RF_Bind(ogn_protocol_1);
+
+    if (bind == NULL)
     {
-        case RF_PROTOCOL_OGNTP:
-            LMIC.protocol   = &ogntp_proto_desc;
-            protocol_encode = &ogntp_encode;
-            protocol_decode = &ogntp_decode;
-            break;
-        case RF_PROTOCOL_P3I:
-            LMIC.protocol   = &p3i_proto_desc;
-            protocol_encode = &p3i_encode;
-            protocol_decode = &p3i_decode;
-            break;
-        case RF_PROTOCOL_FANET:
-            LMIC.protocol   = &fanet_proto_desc;
-            protocol_encode = &fanet_encode;
-            protocol_decode = &fanet_decode;
-            break;
-        case RF_PROTOCOL_LEGACY:
-        default:
-            LMIC.protocol   = &legacy_proto_desc;
-            protocol_encode = &legacy_encode;
-            protocol_decode = &legacy_decode;
-            /*
-             * Enforce legacy protocol setting for SX1276
-             * if other value (UAT) left in EEPROM from other (UATM) radio
-             */
-            ogn_protocol_1 = RF_PROTOCOL_LEGACY;
-            break;
+        /*
+         * Enforce legacy protocol setting for SX1276
+         * if other value (UAT) left in EEPROM from other (UATM) radio
+         */
+        bind           = RF_Bind(RF_PROTOCOL_LEGACY);
+        ogn_protocol_1 = RF_PROTOCOL_LEGACY;
     }
 
+    /* transmitting is ogn_protocol_1 only, ogn_protocol_2 is bound by sx12xx_protocol() */
+    LMIC.protocol   = bind->desc;
+    protocol_encode = bind->encode;
+    protocol_decode = bind->decode;
+
     switch (settings->txpower)
     {
         case RF_TX_POWER_FULL:
@@ -740,17 +1318,20 @@ static void sx12xx_setvars()
 static bool sx12xx_receive()
 {
     bool success = false;
-    String msg;
 
     sx12xx_receive_complete = false;
 
+    /* a frame is on air, TX done comes in through os_runstep() */
+    if (!__atomic_load_n(&sx12xx_transmit_complete, __ATOMIC_ACQUIRE))
+    {
+        os_runstep();
+        return false;
+    }
+
     if (!sx12xx_receive_active)
     {
-        msg = "activating receive...";
-        Logger_send_udp(&msg);    
-        sx12xx_setvars();
-        sx12xx_rx(sx12xx_rx_func);
-        sx12xx_receive_active = true;
+        LOG_DEBUG("activating receive...");
+        sx12xx_rearm();
     }
 
     if (sx12xx_receive_complete == false){
@@ -760,16 +1341,16 @@ static bool sx12xx_receive()
 
     if (sx12xx_receive_complete == true)
     {
-        msg = "Receive complete...";
-        Logger_send_udp(&msg);    
-        u1_t size = LMIC.dataLen - LMIC.protocol->payload_offset - LMIC.protocol->crc_size;
+        LOG_DEBUG("Receive complete...");
+        u1_t size = rx_frame_len - LMIC.protocol->payload_offset - LMIC.protocol->crc_size;
 
-        if (size > sizeof(RxBuffer))
-            size = sizeof(RxBuffer);
+        if (size > sizeof(rx_payload))
+            size = sizeof(rx_payload);
 
         for (u1_t i=0; i < size; i++){
-            RxBuffer[i] = LMIC.frame[i + LMIC.protocol->payload_offset];
+            rx_payload[i] = rx_frame[i + LMIC.protocol->payload_offset];
         }
+        rx_size = size;
 
         /*decrypt payload for private network*/
         /*if packet is bigger , maybe its encryptedr*/
@@ -781,10 +1362,10 @@ static bool sx12xx_receive()
             switch (ogn_protocol_1)
               {
                case RF_PROTOCOL_FANET:
-                    PNETdecrypt(RxBuffer, size, &decrypted, &decrypted_len);
+                    PNETdecrypt(rx_payload, size, &decrypted, &decrypted_len);
                     if(decrypted_len == RF_Payload_Size(ogn_protocol_1)){      
                       for(size_t i=0; i<decrypted_len;i++){
-                        RxBuffer[i] = decrypted[i];
+                        rx_payload[i] = decrypted[i];
                           }
                         }
                     break;
@@ -796,27 +1377,37 @@ static bool sx12xx_receive()
             free(decrypted);        
           }
         
-        RF_last_rssi = LMIC.rssi;
+        rx_rssi = rx_frame_rssi;
         rx_packets_counter++;
         success = true;
     }
     return success;
 }
 
+/*
+ * Starts TX of TxBuffer and returns, the radio has its own copy of the
+ * frame. sx12xx_txdone_func() arms RX again as soon as it is out, until
+ * then sx12xx_receive() only runs the LMIC jobs and RF_Transmit() refuses.
+ */
 static void sx12xx_transmit()
 {
-    sx12xx_transmit_complete = false;
+    __atomic_store_n(&sx12xx_transmit_complete, false, __ATOMIC_RELEASE);
     sx12xx_receive_active    = false;
+    sx12xx_tx_start_us       = micros();
+    sx12xx_blind             = SX12XX_LISTENING;   /* on air, counted in RF_tx_stats */
 
-    sx12xx_setvars();
-    os_setCallback(&sx12xx_txjob, sx12xx_tx_func);
+    RF_tx_stats.frames++;
+    sx12xx_airtime_us      += RF_Airtime(LMIC.protocol->type, RF_tx_size);
+    RF_tx_stats.airtime_ms += sx12xx_airtime_us / 1000;
+    sx12xx_airtime_us      %= 1000;
 
-    while (sx12xx_transmit_complete == false) {
-        // execute scheduled jobs and events
-        os_runstep();
+    sx12xx_setvars();
+    sx12xx_tx_func(&sx12xx_txjob);
+}
 
-        yield();
-    };
+bool RF_Transmit_busy(void)
+{
+    return !__atomic_load_n(&sx12xx_transmit_complete, __ATOMIC_ACQUIRE);
 }
 
 static void sx12xx_shutdown()
@@ -838,88 +1429,144 @@ static void sx12xx_rx(osjobcb_t func)
     //Serial.println("RX");
 }
 
-static void sx12xx_rx_func(osjob_t* job)
+static void sx12xx_rearm()
 {
-    u1_t crc8, pkt_crc8;
-    u2_t crc16, pkt_crc16;
-    u1_t i;
+    sx12xx_setvars();
+    sx12xx_rx(sx12xx_rx_func);
+    sx12xx_receive_active = true;
 
-    // SX1276 is in SLEEP after IRQ handler, Force it to enter RX mode
-    sx12xx_receive_active = false;
+    if (sx12xx_blind != SX12XX_LISTENING)
+    {
+        uint32_t us = (CycleCount() - sx12xx_blind_cycles) / CyclesPerMicro();
 
-    /* FANET (LoRa) LMIC IRQ handler may deliver empty packets here when CRC is invalid. */
-    if (LMIC.dataLen == 0)
-        return;
+        if (sx12xx_blind == SX12XX_BLIND_FRAME)
+            RF_rearm_stats.frames++;
+        else
+            RF_rearm_stats.hops++;
+        RF_rearm_stats.blind_us += us;
+        if (us > RF_rearm_stats.blind_max_us)
+            RF_rearm_stats.blind_max_us = us;
+        sx12xx_blind = SX12XX_LISTENING;
+    }
+}
+
+static LDPC_Decoder rf_ldpc;    /* RF task only */
+
+/*
+ * Min-sum belief propagation over the OGNTP Gallager code for a frame
+ * that failed LDPC_Check(). err marks bits the demodulator could not
+ * decide (Manchester violations) and gives them no weight; NULL when the
+ * radio hands over hard bits only, as the SX127x/SX126x decode Manchester
+ * themselves. The frame is rewritten only if all checks pass within
+ * RF_FEC_ITERATIONS rounds and no more than RF_FEC_MAX_FLIPS decided bits
+ * had to change.
+ */
+bool RF_FEC_Correct(uint8_t* frame, const uint8_t* err)
+{
+    static const uint8_t no_err[LDPC_Decoder::CodeBytes] = { 0 };
+    uint8_t out[LDPC_Decoder::CodeBytes];
+    int8_t  check = 1;
+    uint8_t flips = 0;
+
+    if (!err)
+        err = no_err;
+
+    rf_ldpc.Input(frame, (uint8_t *) err);
+    for (uint8_t n = 0; n < RF_FEC_ITERATIONS && check; n++)
+        check = rf_ldpc.ProcessChecks();
+    if (check)
+    {
+        RF_fec_stats.rejected++;
+        return false;
+    }
+
+    rf_ldpc.Output(out);
+    for (uint8_t i = 0; i < LDPC_Decoder::CodeBytes; i++)
+        flips += Count1s((uint8_t) ((out[i] ^ frame[i]) & ~err[i]));
+
+    if (flips > RF_FEC_MAX_FLIPS)
+    {
+        RF_fec_stats.rejected++;
+        return false;
+    }
+
+    memcpy(frame, out, sizeof(out));
+    RF_fec_stats.corrected++;
+    RF_fec_stats.bits += flips;
+    return true;
+}
+
+/*
+ * Checksum of len frame bytes as the protocol defines it: seed, and for
+ * legacy frames the NRF905/FLARM address bytes, which are not sent.
+ */
+static u2_t sx12xx_checksum(const u1_t* buf, size_t len)
+{
+    bool legacy = LMIC.protocol->type == RF_PROTOCOL_LEGACY;
+    u1_t crc8   = 0x71; /* seed value */
 
     switch (LMIC.protocol->crc_type)
     {
         case RF_CHECKSUM_TYPE_GALLAGER:
         case RF_CHECKSUM_TYPE_NONE:
-            /* crc16 left not initialized */
-            break;
+            return 0;
         case RF_CHECKSUM_TYPE_CRC8_107:
-            crc8 = 0x71; /* seed value */
-            break;
+            while (len--)
+                update_crc8(&crc8, *buf++);
+            return crc8;
         case RF_CHECKSUM_TYPE_CCITT_0000:
-            crc16 = 0x0000; /* seed value */
-            break;
+            return CRC_ccitt(legacy ? CRC_CCITT_LEGACY_0000 : 0x0000, buf, len);
         case RF_CHECKSUM_TYPE_CCITT_FFFF:
         default:
-            crc16 = 0xffff; /* seed value */
-            break;
+            return CRC_ccitt(legacy ? CRC_CCITT_LEGACY_FFFF : 0xFFFF, buf, len);
     }
+}
 
-    //Serial.print("Got ");
-    //Serial.print(LMIC.dataLen);
-    //Serial.println(" bytes");
+static void sx12xx_rx_func(osjob_t* job)
+{
+    u1_t pkt_crc8;
+    u2_t crc, pkt_crc16;
+    u1_t i;
 
-    switch (LMIC.protocol->type)
+    // SX1276 is in SLEEP after IRQ handler, Force it to enter RX mode
+    sx12xx_receive_active = false;
+    sx12xx_deaf(SX12XX_BLIND_FRAME);
+
+    /* take the frame out of LMIC.frame and listen again before checking it */
+    rx_frame_len  = LMIC.dataLen < sizeof(rx_frame) ? LMIC.dataLen : sizeof(rx_frame);
+    rx_frame_rssi = LMIC.rssi;
+    memcpy(rx_frame, LMIC.frame, rx_frame_len);
+    sx12xx_rearm();
+
+    /* as received, bad frames too, the replay checks them again */
+    CAPTURE_Frame(millis(), RF_Time(millis()), LMIC.protocol->type, rf_channel, rx_frame_rssi, rx_frame, rx_frame_len);
+
+    /* FANET (LoRa) LMIC IRQ handler may deliver empty packets here when CRC is invalid,
+     * a frame shorter than its header and checksum is no better. */
+    if (rx_frame_len == 0 ||
+        rx_frame_len < LMIC.protocol->payload_offset + LMIC.protocol->crc_size)
     {
-        case RF_PROTOCOL_LEGACY:
-            /* take in account NRF905/FLARM "address" bytes */
-            crc16 = update_crc_ccitt(crc16, 0x31);
-            crc16 = update_crc_ccitt(crc16, 0xFA);
-            crc16 = update_crc_ccitt(crc16, 0xB6);
-            break;
-        case RF_PROTOCOL_P3I:
-        case RF_PROTOCOL_OGNTP:
-        default:
-            break;
+        RXSTATS_Error(rf_active, rf_channel, rf_window_kind);
+        return;
     }
 
-    for (i = LMIC.protocol->payload_offset;
-         i < (LMIC.dataLen - LMIC.protocol->crc_size);
-         i++)
-    {
-        switch (LMIC.protocol->crc_type)
-        {
-            case RF_CHECKSUM_TYPE_GALLAGER:
-            case RF_CHECKSUM_TYPE_NONE:
-                break;
-            case RF_CHECKSUM_TYPE_CRC8_107:
-                update_crc8(&crc8, (u1_t)(LMIC.frame[i]));
-                break;
-            case RF_CHECKSUM_TYPE_CCITT_FFFF:
-            case RF_CHECKSUM_TYPE_CCITT_0000:
-            default:
-                crc16 = update_crc_ccitt(crc16, (u1_t)(LMIC.frame[i]));
-                break;
-        }
+    //Serial.print("Got ");
+    //Serial.print(rx_frame_len);
+    //Serial.println(" bytes");
+
+    u1_t first = LMIC.protocol->payload_offset;
+
+    i   = rx_frame_len - LMIC.protocol->crc_size; /* checksum follows the payload */
+    crc = sx12xx_checksum(&rx_frame[first], i - first);
+
+    if (LMIC.protocol->whitening == RF_WHITENING_NICERF)
+        for (u1_t k = first; k < i; k++)
+            rx_frame[k] ^= pgm_read_byte(&whitening_pattern[k - first]);
 
-        switch (LMIC.protocol->whitening)
-        {
-            case RF_WHITENING_NICERF:
-                LMIC.frame[i] ^= pgm_read_byte(&whitening_pattern[i - LMIC.protocol->payload_offset]);
-                break;
-            case RF_WHITENING_MANCHESTER:
-            case RF_WHITENING_NONE:
-            default:
-                break;
-        }
 #if DEBUG
-        Serial.printf("%02x", (u1_t)(LMIC.frame[i]));
+    for (u1_t k = first; k < i; k++)
+        Serial.printf("%02x", (u1_t)(rx_frame[k]));
 #endif
-    }
 
     switch (LMIC.protocol->crc_type)
     {
@@ -927,28 +1574,31 @@ static void sx12xx_rx_func(osjob_t* job)
             sx12xx_receive_complete = true;
             break;
         case RF_CHECKSUM_TYPE_GALLAGER:
-            if (LDPC_Check((uint8_t *) &LMIC.frame[0]))
+            RF_fec_stats.frames++;
+            if (LDPC_Check((uint8_t *) &rx_frame[0]) == 0)
+                sx12xx_receive_complete = true;
+            else
             {
+                RF_fec_stats.errored++;
+                sx12xx_receive_complete = RF_FEC_Correct((uint8_t *) &rx_frame[0], NULL);
 #if DEBUG
-                Serial.printf(" %02x%02x%02x%02x%02x%02x is wrong FEC",
-                              LMIC.frame[i], LMIC.frame[i + 1], LMIC.frame[i + 2],
-                              LMIC.frame[i + 3], LMIC.frame[i + 4], LMIC.frame[i + 5]);
+                Serial.printf(" %02x%02x%02x%02x%02x%02x is wrong FEC%s",
+                              rx_frame[i], rx_frame[i + 1], rx_frame[i + 2],
+                              rx_frame[i + 3], rx_frame[i + 4], rx_frame[i + 5],
+                              sx12xx_receive_complete ? ", corrected" : "");
 #endif
-                sx12xx_receive_complete = false;
             }
-            else
-                sx12xx_receive_complete = true;
             break;
         case RF_CHECKSUM_TYPE_CRC8_107:
-            pkt_crc8 = LMIC.frame[i];
+            pkt_crc8 = rx_frame[i];
 #if DEBUG
-            if (crc8 == pkt_crc8)
+            if (crc == pkt_crc8)
                 Serial.printf(" %02x is valid crc", pkt_crc8);
             else
                 Serial.printf(" %02x is wrong crc", pkt_crc8);
 
 #endif
-            if (crc8 == pkt_crc8)
+            if (crc == pkt_crc8)
                 sx12xx_receive_complete = true;
             else
                 sx12xx_receive_complete = false;
@@ -956,21 +1606,24 @@ static void sx12xx_rx_func(osjob_t* job)
         case RF_CHECKSUM_TYPE_CCITT_FFFF:
         case RF_CHECKSUM_TYPE_CCITT_0000:
         default:
-            pkt_crc16 = (LMIC.frame[i] << 8 | LMIC.frame[i + 1]);
+            pkt_crc16 = (rx_frame[i] << 8 | rx_frame[i + 1]);
 #if DEBUG
-            if (crc16 == pkt_crc16)
+            if (crc == pkt_crc16)
                 Serial.printf(" %04x is valid crc", pkt_crc16);
             else
                 Serial.printf(" %04x is wrong crc", pkt_crc16);
 
 #endif
-            if (crc16 == pkt_crc16)
+            if (crc == pkt_crc16)
                 sx12xx_receive_complete = true;
             else
                 sx12xx_receive_complete = false;
             break;
     }
 
+    if (!sx12xx_receive_complete)
+        RXSTATS_Error(rf_active, rf_channel, rf_window_kind);
+
 #if DEBUG
     Serial.println();
 #endif
@@ -979,27 +1632,8 @@ static void sx12xx_rx_func(osjob_t* job)
 // Transmit the given string and call the given function afterwards
 static void sx12xx_tx(unsigned char* buf, size_t size, osjobcb_t func)
 {
-    u1_t crc8;
-    u2_t crc16;
-
-
-    switch (LMIC.protocol->crc_type)
-    {
-        case RF_CHECKSUM_TYPE_GALLAGER:
-        case RF_CHECKSUM_TYPE_NONE:
-            /* crc16 left not initialized */
-            break;
-        case RF_CHECKSUM_TYPE_CRC8_107:
-            crc8 = 0x71; /* seed value */
-            break;
-        case RF_CHECKSUM_TYPE_CCITT_0000:
-            crc16 = 0x0000; /* seed value */
-            break;
-        case RF_CHECKSUM_TYPE_CCITT_FFFF:
-        default:
-            crc16 = 0xffff; /* seed value */
-            break;
-    }
+    u1_t crc8 = 0x71; /* seed value, P3I sends it in the header */
+    u2_t crc;
 
     os_radio(RADIO_RST); // Stop RX first
     delay(1);            // Wait a bit, without this os_radio below asserts, apparently because the state hasn't changed yet
@@ -1008,12 +1642,6 @@ static void sx12xx_tx(unsigned char* buf, size_t size, osjobcb_t func)
 
     switch (LMIC.protocol->type)
     {
-        case RF_PROTOCOL_LEGACY:
-            /* take in account NRF905/FLARM "address" bytes */
-            crc16 = update_crc_ccitt(crc16, 0x31);
-            crc16 = update_crc_ccitt(crc16, 0xFA);
-            crc16 = update_crc_ccitt(crc16, 0xB6);
-            break;
         case RF_PROTOCOL_P3I:
             /* insert Net ID */
             LMIC.frame[LMIC.dataLen++] = (u1_t) ((LMIC.protocol->net_id >> 24) & 0x000000FF);
@@ -1028,55 +1656,38 @@ static void sx12xx_tx(unsigned char* buf, size_t size, osjobcb_t func)
                 LMIC.frame[LMIC.dataLen++] = crc8;
 
             break;
+        case RF_PROTOCOL_LEGACY:
         case RF_PROTOCOL_OGNTP:
         default:
             break;
     }
 
-    for (u1_t i=0; i < size; i++) {
-        switch (LMIC.protocol->whitening)
-        {
-            case RF_WHITENING_NICERF:
-                LMIC.frame[LMIC.dataLen] = buf[i] ^ pgm_read_byte(&whitening_pattern[i]);
-                break;
-            case RF_WHITENING_MANCHESTER:
-            case RF_WHITENING_NONE:
-            default:
-                LMIC.frame[LMIC.dataLen] = buf[i];
-                break;
-        }
-
-        switch (LMIC.protocol->crc_type)
-        {
-            case RF_CHECKSUM_TYPE_GALLAGER:
-            case RF_CHECKSUM_TYPE_NONE:
-                break;
-            case RF_CHECKSUM_TYPE_CRC8_107:
-                update_crc8(&crc8, (u1_t)(LMIC.frame[LMIC.dataLen]));
-                break;
-            case RF_CHECKSUM_TYPE_CCITT_FFFF:
-            case RF_CHECKSUM_TYPE_CCITT_0000:
-            default:
-                crc16 = update_crc_ccitt(crc16, (u1_t)(LMIC.frame[LMIC.dataLen]));
-                break;
-        }
+    u1_t first = LMIC.dataLen;
 
-        LMIC.dataLen++;
+    if (LMIC.protocol->whitening == RF_WHITENING_NICERF)
+        for (u1_t i = 0; i < size; i++)
+            LMIC.frame[LMIC.dataLen++] = buf[i] ^ pgm_read_byte(&whitening_pattern[i]);
+    else
+    {
+        memcpy(&LMIC.frame[LMIC.dataLen], buf, size);
+        LMIC.dataLen += size;
     }
 
+    crc = sx12xx_checksum(&LMIC.frame[first], size);
+
     switch (LMIC.protocol->crc_type)
     {
         case RF_CHECKSUM_TYPE_GALLAGER:
         case RF_CHECKSUM_TYPE_NONE:
             break;
         case RF_CHECKSUM_TYPE_CRC8_107:
-            LMIC.frame[LMIC.dataLen++] = crc8;
+            LMIC.frame[LMIC.dataLen++] = crc & 0xFF;
             break;
         case RF_CHECKSUM_TYPE_CCITT_FFFF:
         case RF_CHECKSUM_TYPE_CCITT_0000:
         default:
-            LMIC.frame[LMIC.dataLen++] = (crc16 >>  8) & 0xFF;
-            LMIC.frame[LMIC.dataLen++] = (crc16) & 0xFF;
+            LMIC.frame[LMIC.dataLen++] = (crc >>  8) & 0xFF;
+            LMIC.frame[LMIC.dataLen++] = (crc) & 0xFF;
             break;
     }
 
@@ -1086,17 +1697,29 @@ static void sx12xx_tx(unsigned char* buf, size_t size, osjobcb_t func)
 
 static void sx12xx_txdone_func(osjob_t* job)
 {
-    sx12xx_transmit_complete = true;
+    uint32_t latency = micros() - sx12xx_tx_start_us;
+
+    RF_tx_stats.latency_us = latency;
+    if (latency > RF_tx_stats.latency_max_us)
+        RF_tx_stats.latency_max_us = latency;
+
+    /* listen again right away, not on the next RF_Service() */
+    __atomic_store_n(&sx12xx_transmit_complete, true, __ATOMIC_RELEASE);
+    sx12xx_rearm();
 }
 
 static void sx12xx_tx_func(osjob_t* job)
 {
+    uint8_t channel = rf_channel;
+
     if (RF_tx_size > 0){
       if(ognrelay_enable){
-        rf_chip->channel(4);        
+        rf_chip->channel(RF_RELAY_CHANNEL);
       }
       sx12xx_tx((unsigned char *) &TxBuffer[0], RF_tx_size, sx12xx_txdone_func);
-      rf_chip->channel(0);
+      /* back to the receive channel, the radio has taken the TX frequency */
+      rf_chip->channel(channel);
     }
-        
+    else
+      __atomic_store_n(&sx12xx_transmit_complete, true, __ATOMIC_RELEASE);
 }
@@ -51,6 +51,19 @@
                              P3I_PAYLOAD_SIZE, FANET_PAYLOAD_SIZE, \
                              UAT978_PAYLOAD_SIZE)
 
+#define RF_RX_QUEUE       16    /* frames, power of 2 */
+#define RF_TASK_STACK     4096
+#define RF_TASK_PRIORITY  2     /* above loop() */
+#define RF_TASK_CORE      0     /* PRO CPU, loop() runs on APP CPU */
+
+#define RF_FEC_ITERATIONS 32    /* LDPC belief propagation rounds */
+#define RF_FEC_MAX_FLIPS  4     /* past that, wrong codewords become likely */
+
+#define RF_DUAL_PROTOCOLS 2     /* ogn_protocol_1, ogn_protocol_2 */
+#define RF_DUAL_WINDOW    200   /* ms of every second for ogn_protocol_2 without slot timing */
+
+#define RF_RELAY_CHANNEL  4     /* ognrelay retransmits here, an ognrelay base listens here */
+
 #define RXADDR {0x31, 0xfa, 0xb6}  // Address of this device (4 bytes)
 #define TXADDR {0x31, 0xfa, 0xb6}  // Address of device to send to (4 bytes)
 
@@ -75,11 +88,69 @@ typedef struct rfchip_ops_struct
   bool (* probe)();
   void (* setup)();
   void (* channel)(uint8_t);
+  void (* protocol)(uint8_t);
   bool (* receive)();
   void (* transmit)();
   void (* shutdown)();
 } rfchip_ops_t;
 
+/* one validated frame on its way from the RF task to loop() */
+typedef struct rf_frame_struct
+{
+  unsigned long ms;     /* millis(), loop() makes it wall time */
+  int8_t rssi;
+  uint8_t protocol;
+  uint8_t bucket;       /* RFSCHED bucket it came in on */
+  uint8_t channel;
+  uint8_t size;
+  byte payload[MAX_PKT_SIZE];
+} rf_frame_t;
+
+typedef struct rf_queue_stats_struct
+{
+  uint32_t frames;
+  uint32_t dropped;     /* queue full, loop() fell behind */
+  uint16_t max_depth;
+} rf_queue_stats_t;
+
+typedef struct rf_fec_stats_struct
+{
+  uint32_t frames;      /* Gallager coded frames received */
+  uint32_t errored;     /* failed LDPC_Check() */
+  uint32_t corrected;   /* recovered by RF_FEC_Correct() */
+  uint32_t rejected;    /* did not converge, or on too many flipped bits */
+  uint32_t bits;        /* bits flipped in corrected frames */
+} rf_fec_stats_t;
+
+/* frames handed to the radio, which sends them while loop() goes on */
+typedef struct rf_tx_stats_struct
+{
+  uint32_t frames;
+  uint32_t busy;        /* refused, the frame before was still on air */
+  uint32_t airtime_ms;  /* RF_Airtime() of the frames sent */
+  uint32_t latency_us;  /* RF_Transmit() to TX done, last frame */
+  uint32_t latency_max_us;
+} rf_tx_stats_t;
+
+/* receiver off after a frame or a hop, until RX is started again */
+typedef struct rf_rearm_stats_struct
+{
+  uint32_t frames;      /* RX started again after a frame */
+  uint32_t hops;        /* after a channel or protocol change */
+  uint32_t blind_us;    /* summed over both */
+  uint32_t blind_max_us;
+} rf_rearm_stats_t;
+
+/* receiver time and yield of each protocol, index 0 is ogn_protocol_1 */
+typedef struct rf_proto_stats_struct
+{
+  uint8_t protocol;
+  uint32_t listen_ms;   /* receiver armed on this protocol */
+  uint32_t windows;     /* times the receiver was switched to it */
+  uint32_t frames;      /* passed the CRC */
+  uint32_t decoded;     /* accepted by the protocol decoder */
+} rf_proto_stats_t;
+
 String Bin2Hex(byte *, size_t);
 
 uint8_t parity(uint32_t);
@@ -100,14 +171,31 @@ bool RF_Transmit(size_t, bool);
 
 bool RF_Transmit_raw(size_t, bool);
 
+bool RF_Transmit_busy(void);
+
 bool RF_Receive(void);
 
+void RF_Wait(uint32_t);
+
+bool RF_Decode(void *, ufo_t *, ufo_t *);
+
+bool RF_Dual(void);
+
+void RF_Task_start(void);
+
 void RF_Shutdown(void);
 
+bool RF_FEC_Correct(uint8_t *, const uint8_t *);
+
 uint8_t RF_Payload_Size(uint8_t);
 
+uint32_t RF_Airtime(uint8_t, size_t);
+
+bool RF_Quiet(void);
+
 extern byte          TxBuffer[MAX_PKT_SIZE], RxBuffer[MAX_PKT_SIZE];
 extern unsigned long TxTimeMarker;
+extern FreqPlan      RF_FreqPlan;
 
 extern const rfchip_ops_t* rf_chip;
 extern bool                RF_SX12XX_RST_is_connected;
@@ -115,5 +203,14 @@ extern size_t              (* protocol_encode)(void *, ufo_t *);
 extern bool                (* protocol_decode)(void *, ufo_t *, ufo_t *);
 
 extern int8_t RF_last_rssi;
+extern unsigned long RF_last_rx_ms;
+extern time_t        RF_last_rx_time;
+extern uint8_t RF_last_protocol;
+extern uint8_t RF_last_channel;
+extern rf_queue_stats_t RF_queue_stats;
+extern rf_fec_stats_t RF_fec_stats;
+extern rf_tx_stats_t RF_tx_stats;
+extern rf_rearm_stats_t RF_rearm_stats;
+extern rf_proto_stats_t RF_proto_stats[RF_DUAL_PROTOCOLS];
 
 #endif /* RFHELPER_H */
@@ -0,0 +1,229 @@
+/*
+ * RFSCHED.cpp
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * Listening time of the dual protocol receiver, weighted by yield. The
+ * RF task asks RFSCHED_Pick() which protocol gets the next window (a
+ * slot, or RF_DUAL_WINDOW ms without slot timing); windows are handed
+ * out by smooth weighted round robin on the current shares.
+ *
+ * Yield is kept per bucket, a protocol/window/channel combination: time
+ * listened, frames, fixes and aircraft heard for the first time in the
+ * epoch. Every RFSCHED_EPOCH seconds the shares follow the smoothed
+ * number of distinct aircraft each protocol brought in, so a site with
+ * paragliders about gives FANET more time and gives it back when they
+ * land. A protocol never goes below its floor, or it could not notice
+ * traffic coming back. Channels follow the hopping sequence of the
+ * transmitters and can not be chosen, they are only a statistics key.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "RFSCHED.h"
+
+#define RFSCHED_UNUSED  0xFF
+
+rfsched_stats_t  RFSCHED_stats;
+rfsched_bucket_t RFSCHED_buckets[RFSCHED_BUCKETS];
+
+static uint8_t  protocols[RFSCHED_PROTOCOLS];
+static uint8_t  share_idle[RFSCHED_PROTOCOLS];     /* shares while nothing is heard */
+static int16_t  credit[RFSCHED_PROTOCOLS];
+static uint32_t seen[RFSCHED_PROTOCOLS][RFSCHED_SEEN_BITS / 32];
+static uint16_t seen_cnt[RFSCHED_PROTOCOLS];
+static uint32_t epoch_ms    = 0;
+static uint8_t  last_bucket = 0;
+
+void RFSCHED_Reset(const uint8_t protocol[RFSCHED_PROTOCOLS], const uint8_t share[RFSCHED_PROTOCOLS],
+                   const uint8_t floor[RFSCHED_PROTOCOLS])
+{
+    memset(&RFSCHED_stats, 0, sizeof(RFSCHED_stats));
+    memset(credit, 0, sizeof(credit));
+    memset(seen, 0, sizeof(seen));
+    memset(seen_cnt, 0, sizeof(seen_cnt));
+
+    for (int i = 0; i < RFSCHED_PROTOCOLS; i++)
+    {
+        protocols[i]           = protocol[i];
+        share_idle[i]          = share[i];
+        RFSCHED_stats.share[i] = share[i];
+        RFSCHED_stats.floor[i] = floor[i];
+    }
+
+    for (int b = 0; b < RFSCHED_BUCKETS; b++)
+    {
+        memset(&RFSCHED_buckets[b], 0, sizeof(RFSCHED_buckets[b]));
+        RFSCHED_buckets[b].window = RFSCHED_UNUSED;
+    }
+
+    epoch_ms    = 0;
+    last_bucket = 0;
+}
+
+/* new shares from the aircraft each protocol brought in */
+static void RFSCHED_Epoch()
+{
+    uint32_t total = 0;
+
+    for (int i = 0; i < RFSCHED_PROTOCOLS; i++)
+    {
+        int32_t avg = RFSCHED_stats.aircraft[i];
+
+        avg += ((int32_t) seen_cnt[i] * 16 - avg) / 4;
+        RFSCHED_stats.aircraft[i] = avg;
+        total += avg;
+
+        seen_cnt[i] = 0;
+    }
+    memset(seen, 0, sizeof(seen));
+
+    if (total == 0)
+        memcpy(RFSCHED_stats.share, share_idle, sizeof(share_idle));
+    else
+    {
+        uint8_t share = (uint8_t) (100 * RFSCHED_stats.aircraft[1] / total);
+
+        if (share < RFSCHED_stats.floor[1])
+            share = RFSCHED_stats.floor[1];
+        if (share > 100 - RFSCHED_stats.floor[0])
+            share = 100 - RFSCHED_stats.floor[0];
+
+        RFSCHED_stats.share[0] = 100 - share;
+        RFSCHED_stats.share[1] = share;
+    }
+
+    RFSCHED_stats.epochs++;
+}
+
+/* protocol index for the next window */
+uint8_t RFSCHED_Pick()
+{
+    uint8_t pick = 0;
+
+    for (int i = 0; i < RFSCHED_PROTOCOLS; i++)
+        credit[i] += RFSCHED_stats.share[i];
+
+    if (credit[1] > credit[0])
+        pick = 1;
+    credit[pick] -= 100;
+
+    RFSCHED_stats.windows[pick]++;
+    return pick;
+}
+
+uint8_t RFSCHED_Bucket(uint8_t index, uint8_t window, uint8_t channel)
+{
+    rfsched_bucket_t* b = &RFSCHED_buckets[last_bucket];
+    uint8_t           oldest = 0;
+
+    if (b->index == index && b->window == window && b->channel == channel)
+        return last_bucket;
+
+    for (uint8_t n = 0; n < RFSCHED_BUCKETS; n++)
+    {
+        b = &RFSCHED_buckets[n];
+
+        if (b->window == RFSCHED_UNUSED)
+        {
+            oldest = n;
+            break;
+        }
+        if (b->index == index && b->window == window && b->channel == channel)
+            return last_bucket = n;
+        if (b->epoch < RFSCHED_buckets[oldest].epoch)
+            oldest = n;
+    }
+
+    /* a new combination (US band hopping), the least recently used goes */
+    b = &RFSCHED_buckets[oldest];
+    memset(b, 0, sizeof(*b));
+    b->index   = index;
+    b->window  = window;
+    b->channel = channel;
+    b->epoch   = RFSCHED_stats.epochs;
+
+    return last_bucket = oldest;
+}
+
+void RFSCHED_Listen(uint8_t bucket, uint32_t ms)
+{
+    RFSCHED_buckets[bucket].listen_ms += ms;
+    RFSCHED_buckets[bucket].epoch      = RFSCHED_stats.epochs;
+
+    epoch_ms += ms;
+    if (epoch_ms >= RFSCHED_EPOCH * 1000UL)
+    {
+        RFSCHED_Epoch();
+        epoch_ms = 0;
+    }
+}
+
+void RFSCHED_Frame(uint8_t bucket)
+{
+    RFSCHED_buckets[bucket].frames++;
+}
+
+/* loop() side; a bucket reused in between only misattributes one fix */
+void RFSCHED_Fix(uint8_t bucket, uint32_t addr)
+{
+    rfsched_bucket_t* b   = &RFSCHED_buckets[bucket];
+    uint8_t           i   = b->index < RFSCHED_PROTOCOLS ? b->index : 0;
+    uint32_t          bit = (uint32_t) (addr * 2654435761UL) >> 23 & (RFSCHED_SEEN_BITS - 1);
+
+    b->fixes++;
+
+    if (seen[i][bit >> 5] & (1UL << (bit & 31)))
+        return;
+
+    seen[i][bit >> 5] |= 1UL << (bit & 31);
+    seen_cnt[i]++;
+    b->aircraft++;
+}
+
+/* one JSON object for the web socket */
+size_t RFSCHED_Report(char* buf, size_t size)
+{
+    size_t len;
+
+    len = snprintf(buf, size,
+                   "{\"t\":\"rfsched\",\"protocol\":[%u,%u],\"share\":[%u,%u],\"aircraft\":[%u,%u],"
+                   "\"windows\":[%lu,%lu],\"epochs\":%lu,\"buckets\":[",
+                   protocols[0], protocols[1],
+                   RFSCHED_stats.share[0], RFSCHED_stats.share[1],
+                   (unsigned) RFSCHED_stats.aircraft[0] / 16, (unsigned) RFSCHED_stats.aircraft[1] / 16,
+                   (unsigned long) RFSCHED_stats.windows[0], (unsigned long) RFSCHED_stats.windows[1],
+                   (unsigned long) RFSCHED_stats.epochs);
+
+    for (uint8_t n = 0; n < RFSCHED_BUCKETS && len < size; n++)
+    {
+        const rfsched_bucket_t* b = &RFSCHED_buckets[n];
+
+        if (b->window == RFSCHED_UNUSED)
+            continue;
+
+        len += snprintf(buf + len, size - len, "%s[%u,%u,%u,%lu,%lu,%lu,%lu]",
+                        buf[len - 1] == '[' ? "" : ",",
+                        protocols[b->index < RFSCHED_PROTOCOLS ? b->index : 0], b->window, b->channel,
+                        (unsigned long) (b->listen_ms / 1000), (unsigned long) b->frames,
+                        (unsigned long) b->fixes, (unsigned long) b->aircraft);
+    }
+
+    if (len < size)
+        len += snprintf(buf + len, size - len, "]}");
+
+    return len < size ? len : 0;
+}
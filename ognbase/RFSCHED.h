@@ -0,0 +1,72 @@
+/*
+ * RFSCHED.h
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef RFSCHEDHELPER_H
+#define RFSCHEDHELPER_H
+
+#define RFSCHED_PROTOCOLS   2       /* = RF_DUAL_PROTOCOLS */
+#define RFSCHED_BUCKETS     16      /* protocol/window/channel combinations tracked */
+#define RFSCHED_EPOCH       60      /* s between share updates */
+#define RFSCHED_MIN_SHARE   10      /* % of the scheduled windows a protocol keeps to notice new traffic */
+#define RFSCHED_SEEN_BITS   512     /* per protocol, aircraft heard in this epoch, power of 2 */
+#define RFSCHED_REPORT_SIZE 1024
+
+enum
+{
+    RFSCHED_SLOT_0,
+    RFSCHED_SLOT_1,
+    RFSCHED_FREE            /* dead time between the slots or no slot timing */
+};
+
+typedef struct rfsched_bucket
+{
+    uint8_t  index;         /* 0 = ogn_protocol_1, 1 = ogn_protocol_2 */
+    uint8_t  window;        /* RFSCHED_SLOT_0 .. RFSCHED_FREE */
+    uint8_t  channel;
+    uint32_t listen_ms;
+    uint32_t frames;        /* passed the CRC */
+    uint32_t fixes;         /* decoded */
+    uint32_t aircraft;      /* first fix of an aircraft in its epoch */
+    uint32_t epoch;         /* last epoch with listen time, for reuse */
+} rfsched_bucket_t;
+
+typedef struct rfsched_stats
+{
+    uint8_t  share[RFSCHED_PROTOCOLS];      /* % of the scheduled windows, target */
+    uint8_t  floor[RFSCHED_PROTOCOLS];      /* % the share never goes below */
+    uint16_t aircraft[RFSCHED_PROTOCOLS];   /* per epoch, smoothed, 1/16 */
+    uint32_t windows[RFSCHED_PROTOCOLS];    /* scheduled windows given to each */
+    uint32_t epochs;
+} rfsched_stats_t;
+
+void    RFSCHED_Reset(const uint8_t protocol[RFSCHED_PROTOCOLS], const uint8_t share[RFSCHED_PROTOCOLS],
+                      const uint8_t floor[RFSCHED_PROTOCOLS]);
+uint8_t RFSCHED_Pick();
+uint8_t RFSCHED_Bucket(uint8_t index, uint8_t window, uint8_t channel);
+void    RFSCHED_Listen(uint8_t bucket, uint32_t ms);
+void    RFSCHED_Frame(uint8_t bucket);
+void    RFSCHED_Fix(uint8_t bucket, uint32_t addr);
+size_t  RFSCHED_Report(char* buf, size_t size);
+
+extern rfsched_stats_t  RFSCHED_stats;
+extern rfsched_bucket_t RFSCHED_buckets[RFSCHED_BUCKETS];
+
+#endif /* RFSCHEDHELPER_H */
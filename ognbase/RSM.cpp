@@ -26,14 +26,10 @@
 #include "Web.h"
 #include "Log.h"
 #include "PNET.h"
-
-
-#include "ogn_service_generated.h"
+#include "NBP.h"
 
 WiFiUDP udp;
 
-using namespace ogn;
-
 
 bool RSM_Setup(int port)
 {
@@ -48,49 +44,55 @@ bool RSM_Setup(int port)
     return false;
 }
 
-// AircraftPos(int32_t _callsign, int32_t _timestamp, int8_t _type, bool _stealth, bool _notrack, int32_t _heading, int32_t _speed, int32_t _lat, int32_t _lon, int32_t _alt)
-
-void RSM_ExportAircraftPosition() {
-  
-    flatbuffers::FlatBufferBuilder builder;
-
-     time_t this_moment = now();
-    
-    for (int i = 0; i < MAX_TRACKING_OBJECTS; i++)
-        if (Container[i].addr && (this_moment - Container[i].timestamp) <= EXPORT_EXPIRATION_TIME && Container[i].distance < ogn_range * 1000)
-        {    
-          auto AircPosition = AircraftPos( Container[i].addr,
-                                           Container[i].timestamp,
-                                           Container[i].aircraft_type,
-                                           Container[i].stealth,
-                                           Container[i].no_track,
-                                           Container[i].course,
-                                           Container[i].speed,
-                                           Container[i].latitude,
-                                           Container[i].longitude,
-                                           Container[i].altitude);
-                                           
-          auto message = CreateOneMessage(builder, &AircPosition);                                                                                                                                                                 
-          builder.Finish(message);
-          
-          auto ptr = builder.GetBufferPointer();
-          auto size = builder.GetSize();
-
-          //next release
-          if(false){
-            
-            char *encrypted;
-            size_t encrypted_len;
-            
-            PNETencrypt(ptr, size, &encrypted, &encrypted_len);
-            SoC->WiFi_transmit_UDP(new_protocol_server.c_str(), new_protocol_port, (byte*)encrypted, encrypted_len); 
-        
+static void RSM_Send(const uint8_t* ptr, size_t size)
+{
+    //next release
+    if(false){
+
+      char *encrypted;
+      size_t encrypted_len;
+
+      PNETencrypt((unsigned char*)ptr, size, &encrypted, &encrypted_len);
+      SoC->WiFi_transmit_UDP(new_protocol_server.c_str(), new_protocol_port, (byte*)encrypted, encrypted_len);
+
+    }
+
+    else{
+     SoC->WiFi_transmit_UDP(new_protocol_server.c_str(), new_protocol_port, (byte*)ptr, size);
+    }
+}
+
+/* one datagram per export cycle, split only above NBP_BATCH_MAX aircraft */
+bool RSM_ExportAircraftPosition() {
+
+    const uint8_t* ptr;
+    bool           sent = false;
+
+    time_t this_moment = now();
+
+    NBP_Begin(ogn_callsign.c_str(), this_moment, ogn_lat, ogn_lon, ogn_alt,
+              new_protocol_stream ? NBP_MODE_STREAM : NBP_MODE_BATCH);
+
+    for (int i = Traffic_First(); i != TRAFFIC_NONE; i = Traffic_Next(i))
+        if (Container[i].addr && Traffic_Fresh(i) && (this_moment - Container[i].timestamp) <= EXPORT_EXPIRATION_TIME && Container[i].distance < ogn_range * 1000)
+        {
+          if (!NBP_Add(&Container[i]))
+          {
+            size_t size = NBP_Finish(&ptr);
+            RSM_Send(ptr, size);
+            sent = true;
+            NBP_Add(&Container[i]);
           }
-      
-          else{
-           SoC->WiFi_transmit_UDP(new_protocol_server.c_str(), new_protocol_port, ptr, size);  
-          }                   
         }
+
+    if (NBP_Count())
+    {
+      size_t size = NBP_Finish(&ptr);
+      RSM_Send(ptr, size);
+      sent = true;
+    }
+
+    return sent;
 }
 
 void RSM_receiver()
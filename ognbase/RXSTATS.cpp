@@ -0,0 +1,161 @@
+/*
+ * RXSTATS.cpp
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * Reception statistics in fixed memory, for antenna placement and the
+ * receiver schedule. The RF task counts the frames that passed or
+ * failed the CRC (or the FEC) per protocol, channel and window (slot 0,
+ * slot 1 or free) and the RSSI of the good ones. loop() counts frames
+ * the protocol decoder refused, fixes PVALID held back and, per bearing
+ * sector and range ring, the fixes sent to APRS-IS.
+ *
+ * The counters only grow, a reader takes differences. RXSTATS_Report()
+ * writes all of it as one JSON object, cells that never saw a frame are
+ * left out.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "RXSTATS.h"
+
+rxstats_t RXSTATS_stats;
+
+void RXSTATS_Reset(const uint8_t protocol[RXSTATS_PROTOCOLS])
+{
+    memset(&RXSTATS_stats, 0, sizeof(RXSTATS_stats));
+    memcpy(RXSTATS_stats.protocol, protocol, sizeof(RXSTATS_stats.protocol));
+}
+
+uint8_t RXSTATS_Index(uint8_t protocol)
+{
+    return protocol == RXSTATS_stats.protocol[1] && protocol != RXSTATS_stats.protocol[0] ? 1 : 0;
+}
+
+static uint8_t RXSTATS_Channel(uint8_t channel)
+{
+    return channel < RXSTATS_CHANNELS ? channel : RXSTATS_CHANNELS - 1;
+}
+
+void RXSTATS_Frame(uint8_t index, uint8_t channel, uint8_t window, int8_t rssi)
+{
+    int bin = (rssi - RXSTATS_RSSI_MIN) / RXSTATS_RSSI_STEP;
+
+    if (index >= RXSTATS_PROTOCOLS || window >= RXSTATS_WINDOWS)
+        return;
+
+    if (bin < 0)
+        bin = 0;
+    if (bin >= RXSTATS_RSSI_BINS)
+        bin = RXSTATS_RSSI_BINS - 1;
+
+    RXSTATS_stats.frames[index][RXSTATS_Channel(channel)][window]++;
+    RXSTATS_stats.rssi[index][bin]++;
+}
+
+void RXSTATS_Error(uint8_t index, uint8_t channel, uint8_t window)
+{
+    if (index < RXSTATS_PROTOCOLS && window < RXSTATS_WINDOWS)
+        RXSTATS_stats.errors[index][RXSTATS_Channel(channel)][window]++;
+}
+
+void RXSTATS_Undecoded(uint8_t index)
+{
+    if (index < RXSTATS_PROTOCOLS)
+        RXSTATS_stats.undecoded[index]++;
+}
+
+void RXSTATS_Implausible(uint8_t protocol)
+{
+    RXSTATS_stats.implausible[RXSTATS_Index(protocol)]++;
+}
+
+/* distance in m, bearing in degrees from the station */
+void RXSTATS_Fix(float distance, float bearing)
+{
+    uint32_t range  = distance > 0 ? (uint32_t) distance : 0;
+    uint32_t ring   = range / (RXSTATS_RING_KM * 1000UL);
+    int      sector = (int) ((bearing + 360.0f / RXSTATS_SECTORS / 2) * RXSTATS_SECTORS / 360.0f);
+
+    /* north is the middle of sector 0 */
+    sector %= RXSTATS_SECTORS;
+    if (sector < 0)
+        sector += RXSTATS_SECTORS;
+    if (ring >= RXSTATS_RINGS)
+        ring = RXSTATS_RINGS - 1;
+
+    RXSTATS_stats.coverage[sector][ring]++;
+    if (range > RXSTATS_stats.range_m[sector])
+        RXSTATS_stats.range_m[sector] = range;
+}
+
+size_t RXSTATS_Report(char* buf, size_t size)
+{
+    size_t len;
+
+    len = snprintf(buf, size,
+                   "{\"t\":\"rx\",\"rx\":{\"protocol\":[%u,%u],\"undecoded\":[%lu,%lu],\"implausible\":[%lu,%lu],"
+                   "\"frames\":[",
+                   RXSTATS_stats.protocol[0], RXSTATS_stats.protocol[1],
+                   (unsigned long) RXSTATS_stats.undecoded[0], (unsigned long) RXSTATS_stats.undecoded[1],
+                   (unsigned long) RXSTATS_stats.implausible[0], (unsigned long) RXSTATS_stats.implausible[1]);
+
+    /* [protocol,channel,window,frames,errors] */
+    for (uint8_t p = 0; p < RXSTATS_PROTOCOLS; p++)
+        for (uint8_t c = 0; c < RXSTATS_CHANNELS; c++)
+            for (uint8_t w = 0; w < RXSTATS_WINDOWS && len < size; w++)
+            {
+                if (!RXSTATS_stats.frames[p][c][w] && !RXSTATS_stats.errors[p][c][w])
+                    continue;
+                len += snprintf(buf + len, size - len, "%s[%u,%u,%u,%lu,%lu]",
+                                buf[len - 1] == '[' ? "" : ",",
+                                RXSTATS_stats.protocol[p], c, w,
+                                (unsigned long) RXSTATS_stats.frames[p][c][w],
+                                (unsigned long) RXSTATS_stats.errors[p][c][w]);
+            }
+
+    if (len < size)
+        len += snprintf(buf + len, size - len, "],\"rssi\":{\"min\":%d,\"step\":%u,\"bins\":[",
+                        RXSTATS_RSSI_MIN, RXSTATS_RSSI_STEP);
+    for (uint8_t p = 0; p < RXSTATS_PROTOCOLS && len < size; p++)
+    {
+        len += snprintf(buf + len, size - len, "%s[", p ? "," : "");
+        for (uint8_t b = 0; b < RXSTATS_RSSI_BINS && len < size; b++)
+            len += snprintf(buf + len, size - len, "%s%lu", b ? "," : "",
+                            (unsigned long) RXSTATS_stats.rssi[p][b]);
+        if (len < size)
+            len += snprintf(buf + len, size - len, "]");
+    }
+
+    /* per sector clockwise from north: farthest fix in m, then fixes per ring */
+    if (len < size)
+        len += snprintf(buf + len, size - len, "]},\"coverage\":{\"ring_km\":%u,\"sectors\":[",
+                        RXSTATS_RING_KM);
+    for (uint8_t s = 0; s < RXSTATS_SECTORS && len < size; s++)
+    {
+        len += snprintf(buf + len, size - len, "%s[%lu", s ? "," : "",
+                        (unsigned long) RXSTATS_stats.range_m[s]);
+        for (uint8_t r = 0; r < RXSTATS_RINGS && len < size; r++)
+            len += snprintf(buf + len, size - len, ",%lu", (unsigned long) RXSTATS_stats.coverage[s][r]);
+        if (len < size)
+            len += snprintf(buf + len, size - len, "]");
+    }
+
+    if (len < size)
+        len += snprintf(buf + len, size - len, "]}}}");
+
+    return len < size ? len : 0;
+}
@@ -0,0 +1,61 @@
+/*
+ * RXSTATS.h
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RFSCHED.h"
+
+#ifndef RXSTATSHELPER_H
+#define RXSTATSHELPER_H
+
+#define RXSTATS_PROTOCOLS   2       /* = RF_DUAL_PROTOCOLS */
+#define RXSTATS_CHANNELS    8       /* the last one counts all channels above */
+#define RXSTATS_WINDOWS     (RFSCHED_FREE + 1)
+#define RXSTATS_RSSI_BINS   16
+#define RXSTATS_RSSI_MIN    -124    /* dBm, lower edge of the first bin, weaker goes there too */
+#define RXSTATS_RSSI_STEP   6       /* dB per bin, the last one takes all above */
+#define RXSTATS_SECTORS     16      /* bearing from the station, 22.5 deg each */
+#define RXSTATS_RINGS       8       /* range, the last one takes all beyond */
+#define RXSTATS_RING_KM     10
+#define RXSTATS_REPORT_SIZE 2048
+
+typedef struct rxstats
+{
+    uint8_t  protocol[RXSTATS_PROTOCOLS];
+    uint32_t frames[RXSTATS_PROTOCOLS][RXSTATS_CHANNELS][RXSTATS_WINDOWS];     /* passed the CRC/FEC */
+    uint32_t errors[RXSTATS_PROTOCOLS][RXSTATS_CHANNELS][RXSTATS_WINDOWS];     /* failed it */
+    uint32_t undecoded[RXSTATS_PROTOCOLS];      /* refused by the protocol decoder */
+    uint32_t implausible[RXSTATS_PROTOCOLS];    /* fixes PVALID would not send */
+    uint32_t rssi[RXSTATS_PROTOCOLS][RXSTATS_RSSI_BINS];
+    uint32_t coverage[RXSTATS_SECTORS][RXSTATS_RINGS];  /* fixes sent to APRS-IS */
+    uint32_t range_m[RXSTATS_SECTORS];                  /* farthest of them */
+} rxstats_t;
+
+void    RXSTATS_Reset(const uint8_t protocol[RXSTATS_PROTOCOLS]);
+uint8_t RXSTATS_Index(uint8_t protocol);
+void    RXSTATS_Frame(uint8_t index, uint8_t channel, uint8_t window, int8_t rssi);
+void    RXSTATS_Error(uint8_t index, uint8_t channel, uint8_t window);
+void    RXSTATS_Undecoded(uint8_t index);
+void    RXSTATS_Implausible(uint8_t protocol);
+void    RXSTATS_Fix(float distance, float bearing);
+size_t  RXSTATS_Report(char* buf, size_t size);
+
+extern rxstats_t RXSTATS_stats;
+
+#endif /* RXSTATSHELPER_H */
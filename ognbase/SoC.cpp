@@ -34,6 +34,9 @@ byte SoC_setup()
     SoC = &STM32_ops;
 #elif defined(__ASR6501__)
     SoC = &PSoC4_ops;
+#elif defined(HOST_BUILD)
+    SoC = &Host_ops;
+
 #else
 #error "This hardware platform is not supported!"
 #endif
@@ -23,6 +23,9 @@
 
 #include "SoftRF.h"
 #include "Platform_ESP32.h"
+#if defined(HOST_BUILD)
+#include "host/Platform_Host.h"
+#endif /* HOST_BUILD */
 
 typedef struct SoC_ops_struct
 {
@@ -45,6 +48,7 @@ typedef struct SoC_ops_struct
     int (* WiFi_connect_TCP)(const char *, int);
     int (* WiFi_disconnect_TCP)();
     int (* WiFi_transmit_TCP)(String);
+    int (* WiFi_send_TCP)(const char *, size_t);
     int (* WiFi_receive_TCP)(char *, int);
     int (* WiFi_isconnected_TCP)();
     int (* WiFi_connect_TCP2)(const char *, int);
@@ -102,6 +106,9 @@ extern const SoC_ops_t STM32_ops;
 #if defined(__ASR6501__)
 extern const SoC_ops_t PSoC4_ops;
 #endif
+#if defined(HOST_BUILD)
+extern const SoC_ops_t Host_ops;
+#endif
 
 byte SoC_setup(void);
 
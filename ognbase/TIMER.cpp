@@ -0,0 +1,214 @@
+/*
+ * TIMER.cpp
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * Hierarchical timer wheel for what loop() does now and then: APRS-IS
+ * export, keepalive and status, the message check and Zabbix trap, web
+ * refresh, OLED and sleep. An event sits in one slot of one level, by
+ * how far off it is; scheduling and cancelling unlink and link it, and
+ * TIMER_Loop() only looks at the slot of each tick that passed. When
+ * the lowest level comes round, the next slot of the level above is
+ * spread over it.
+ *
+ * The wheel counts its own ticks from TIMER_Setup(), so millis()
+ * wrapping does not matter. Events run from TIMER_Loop(), in loop(),
+ * never early and at most a tick late while loop() keeps up. A
+ * periodic event is scheduled again, a period after it was due, before
+ * its function runs, which may cancel or reschedule it.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "TIMER.h"
+
+#define TIMER_MASK  (TIMER_SLOTS - 1)
+
+timer_stats_t TIMER_stats;
+
+static timer_event_t* wheel[TIMER_LEVELS][TIMER_SLOTS];
+static uint32_t       wheel_tick = 0;       /* last tick TIMER_Loop() ran */
+static uint32_t       wheel_ms   = 0;       /* millis() of wheel_tick */
+static uint32_t       wheel_rand = 1;
+
+/* xorshift32, for the jitter */
+static uint32_t TIMER_Random()
+{
+    wheel_rand ^= wheel_rand << 13;
+    wheel_rand ^= wheel_rand >> 17;
+    wheel_rand ^= wheel_rand << 5;
+    return wheel_rand;
+}
+
+static void TIMER_Link(timer_event_t* t)
+{
+    uint32_t delta = t->expires - wheel_tick;
+    uint8_t  level = 0;
+
+    if ((int32_t) delta < 0)
+    {
+        t->expires = wheel_tick;                /* due, runs with this tick */
+        delta      = 0;
+    }
+    while (level < TIMER_LEVELS - 1 && delta >= 1UL << (TIMER_BITS * (level + 1)))
+        level++;
+
+    t->slot = &wheel[level][(t->expires >> (TIMER_BITS * level)) & TIMER_MASK];
+    t->prev = NULL;
+    t->next = *t->slot;
+    if (t->next)
+        t->next->prev = t;
+    *t->slot = t;
+}
+
+void TIMER_Setup(uint32_t ms, uint32_t seed)
+{
+    memset(wheel, 0, sizeof(wheel));
+    memset(&TIMER_stats, 0, sizeof(TIMER_stats));
+    wheel_tick = 0;
+    wheel_ms   = ms;
+    wheel_rand = seed ? seed : 1;
+}
+
+bool TIMER_Pending(const timer_event_t* t)
+{
+    return t->slot != NULL;
+}
+
+void TIMER_Cancel(timer_event_t* t)
+{
+    if (!TIMER_Pending(t))
+        return;
+
+    if (t->prev)
+        t->prev->next = t->next;
+    else
+        *t->slot = t->next;
+    if (t->next)
+        t->next->prev = t->prev;
+    t->slot = NULL;
+}
+
+/* not pending: links t for due_ms, plus up to jitter_ms */
+static void TIMER_Arm(timer_event_t* t, uint32_t due_ms)
+{
+    int32_t after;
+
+    t->due_ms = due_ms;
+    if (t->jitter_ms)
+        due_ms += TIMER_Random() % (t->jitter_ms + 1);
+
+    /* ticks after the one TIMER_Loop() ran last, rounded up, at least one */
+    after = (int32_t) (due_ms - wheel_ms);
+    after = after > 0 ? (after + TIMER_TICK_MS - 1) / TIMER_TICK_MS : 1;
+    if ((uint32_t) after > TIMER_MAX_TICKS)
+        after = TIMER_MAX_TICKS;
+
+    t->expires = wheel_tick + after;
+    TIMER_Link(t);
+}
+
+/* (re)schedules t for delay_ms after ms, plus up to jitter_ms */
+void TIMER_Schedule(timer_event_t* t, uint32_t ms, uint32_t delay_ms)
+{
+    TIMER_Cancel(t);
+    TIMER_Arm(t, ms + delay_ms);
+}
+
+/* (re)schedules a periodic t one period after ms */
+void TIMER_Start(timer_event_t* t, uint32_t ms)
+{
+    TIMER_Schedule(t, ms, t->period_ms);
+}
+
+/* moves the events of one slot down a level, or into the slot of this tick */
+static void TIMER_Cascade(uint8_t level)
+{
+    timer_event_t** slot = &wheel[level][(wheel_tick >> (TIMER_BITS * level)) & TIMER_MASK];
+    timer_event_t*  t    = *slot;
+
+    *slot = NULL;
+    while (t)
+    {
+        timer_event_t* next = t->next;
+
+        TIMER_Link(t);
+        t = next;
+    }
+}
+
+static void TIMER_Run(uint32_t ms)
+{
+    timer_event_t** slot = &wheel[0][wheel_tick & TIMER_MASK];
+    timer_event_t*  t;
+
+    /* what a function schedules goes into later ticks, never this slot */
+    while ((t = *slot) != NULL)
+    {
+        TIMER_Cancel(t);
+
+        uint32_t late = ms - wheel_ms;
+        if (late > TIMER_stats.late_max_ms)
+            TIMER_stats.late_max_ms = late;
+        TIMER_stats.fired++;
+
+        /* a period after it was due, not after it ran: no drift, what loop() missed is skipped */
+        if (t->period_ms)
+        {
+            uint32_t due = t->due_ms + t->period_ms;
+
+            if ((int32_t) (ms - due) > 0)
+                due += ((ms - due) / t->period_ms + 1) * t->period_ms;
+            TIMER_Arm(t, due);
+        }
+        (*t->fn)();
+    }
+}
+
+/* loop(): runs what is due */
+void TIMER_Loop(uint32_t ms)
+{
+    while ((int32_t) (ms - wheel_ms) >= TIMER_TICK_MS)
+    {
+        wheel_tick++;
+        wheel_ms += TIMER_TICK_MS;
+
+        for (uint8_t level = 1; level < TIMER_LEVELS; level++)
+        {
+            if ((wheel_tick >> (TIMER_BITS * (level - 1))) & TIMER_MASK)
+                break;
+            TIMER_Cascade(level);
+        }
+
+        TIMER_Run(ms);
+    }
+}
+
+/* ms loop() may sleep before an event is due, at most max_ms */
+uint32_t TIMER_Idle(uint32_t ms, uint32_t max_ms)
+{
+    uint32_t ticks = 1;
+
+    /* the lowest level, up to where the next slot above comes down */
+    while (ticks < TIMER_SLOTS && !wheel[0][(wheel_tick + ticks) & TIMER_MASK] &&
+           ((wheel_tick + ticks) & TIMER_MASK))
+        ticks++;
+
+    int32_t idle = (int32_t) (wheel_ms + ticks * TIMER_TICK_MS - ms);
+
+    if (idle <= 0)
+        return 0;
+    return (uint32_t) idle < max_ms ? idle : max_ms;
+}
@@ -0,0 +1,63 @@
+/*
+ * TIMER.h
+ * Copyright (C) 2020 Manuel Rösel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef TIMERHELPER_H
+#define TIMERHELPER_H
+
+#define TIMER_TICK_MS       10
+#define TIMER_BITS          6                       /* slots per level = 1 << TIMER_BITS */
+#define TIMER_SLOTS         (1 << TIMER_BITS)
+#define TIMER_LEVELS        5                       /* 640 ms, 41 s, 44 min, 46 h, 124 d */
+#define TIMER_MAX_TICKS     ((1UL << (TIMER_BITS * TIMER_LEVELS)) - 1)
+
+typedef void (*timer_fn_t)(void);
+
+typedef struct timer_event
+{
+    struct timer_event** slot;      /* the list it is in, NULL if not pending */
+    struct timer_event*  next;
+    struct timer_event*  prev;
+    uint32_t             expires;   /* in ticks of the wheel */
+    uint32_t             due_ms;    /* millis() it is due, without the jitter */
+    uint32_t             period_ms; /* scheduled again when it ran, 0 = once */
+    uint32_t             jitter_ms; /* up to that much later, drawn every time */
+    timer_fn_t           fn;
+} timer_event_t;
+
+#define TIMER_EVENT(fn, period_ms, jitter_ms)   { NULL, NULL, NULL, 0, 0, period_ms, jitter_ms, fn }
+
+typedef struct timer_stats
+{
+    uint32_t fired;
+    uint32_t late_max_ms;           /* how long loop() kept a due event waiting */
+} timer_stats_t;
+
+void     TIMER_Setup(uint32_t ms, uint32_t seed);
+void     TIMER_Schedule(timer_event_t* t, uint32_t ms, uint32_t delay_ms);
+void     TIMER_Start(timer_event_t* t, uint32_t ms);
+void     TIMER_Cancel(timer_event_t* t);
+bool     TIMER_Pending(const timer_event_t* t);
+void     TIMER_Loop(uint32_t ms);
+uint32_t TIMER_Idle(uint32_t ms, uint32_t max_ms);
+
+extern timer_stats_t TIMER_stats;
+
+#endif /* TIMERHELPER_H */
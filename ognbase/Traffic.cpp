@@ -25,11 +25,40 @@
 #include "OLED.h"
 #include "global.h"
 #include "Log.h"
+#include "DEDUP.h"
+#include "RELAY.h"
 
 
 unsigned long UpdateTrafficTimeMarker = 0;
 
-ufo_t fo, Container[MAX_TRACKING_OBJECTS], EmptyFO;
+ufo_t fo, EmptyFO;
+
+/*
+ * Tracking table: Container[] slots, an open addressed index from addr to
+ * slot (linear probing, backward shift deletion, load factor <= 1/2) and a
+ * doubly linked LRU list through the slots. Free slots are chained through
+ * lru_next. An address can only ever be in one slot. Traffic_history[]
+ * keeps the recent fixes of the aircraft in the same slot for PVALID.
+ */
+ufo_t*            Container       = NULL;
+pvalid_history_t* Traffic_history = NULL;
+uint16_t Traffic_capacity = 0;
+uint16_t Traffic_count    = 0;
+
+static int16_t* bucket      = NULL;
+static uint16_t bucket_mask = 0;
+static uint8_t  bucket_bits = 0;
+static int16_t* lru_prev    = NULL;
+static int16_t* lru_next    = NULL;
+static int16_t  lru_head    = TRAFFIC_NONE;
+static int16_t  lru_tail    = TRAFFIC_NONE;
+static int16_t  free_head   = TRAFFIC_NONE;
+static uint8_t* fresh       = NULL;  /* TRAFFIC_FLAG_* */
+static uint32_t* sent_ms    = NULL;
+
+#define TRAFFIC_FLAG_FRESH      0x01    /* received since the last export cycle */
+#define TRAFFIC_FLAG_PENDING    0x02    /* received since last forwarded */
+#define TRAFFIC_FLAG_SENT       0x04    /* sent_ms is valid */
 
 static int8_t (* Alarm_Level)(ufo_t *, ufo_t *);
 
@@ -120,6 +149,227 @@ static int8_t Alarm_Legacy(ufo_t* this_aircraft, ufo_t* fop)
     return rval;
 }
 
+static inline uint16_t Traffic_Hash(uint32_t addr)
+{
+    /* Fibonacci hashing, top bits of the product are the best mixed */
+    return (uint16_t) ((uint32_t) (addr * 2654435761U) >> (32 - bucket_bits));
+}
+
+static void Traffic_Index(int ndx)
+{
+    uint16_t b = Traffic_Hash(Container[ndx].addr);
+
+    while (bucket[b] != TRAFFIC_NONE)
+        b = (b + 1) & bucket_mask;
+    bucket[b] = ndx;
+}
+
+static void Traffic_Unindex(int ndx)
+{
+    uint16_t b = Traffic_Hash(Container[ndx].addr);
+    uint16_t hole;
+
+    while (bucket[b] != ndx)
+        b = (b + 1) & bucket_mask;
+
+    /* pull back every following entry whose home bucket is at or before the hole */
+    hole = b;
+    for (b = (b + 1) & bucket_mask; bucket[b] != TRAFFIC_NONE; b = (b + 1) & bucket_mask)
+    {
+        uint16_t home = Traffic_Hash(Container[bucket[b]].addr);
+
+        if (((b - home) & bucket_mask) >= ((b - hole) & bucket_mask))
+        {
+            bucket[hole] = bucket[b];
+            hole         = b;
+        }
+    }
+    bucket[hole] = TRAFFIC_NONE;
+}
+
+static void Traffic_Unlink(int ndx)
+{
+    if (lru_prev[ndx] != TRAFFIC_NONE)
+        lru_next[lru_prev[ndx]] = lru_next[ndx];
+    else
+        lru_head = lru_next[ndx];
+
+    if (lru_next[ndx] != TRAFFIC_NONE)
+        lru_prev[lru_next[ndx]] = lru_prev[ndx];
+    else
+        lru_tail = lru_prev[ndx];
+}
+
+static void Traffic_LinkFront(int ndx)
+{
+    lru_prev[ndx] = TRAFFIC_NONE;
+    lru_next[ndx] = lru_head;
+
+    if (lru_head != TRAFFIC_NONE)
+        lru_prev[lru_head] = ndx;
+    else
+        lru_tail = ndx;
+    lru_head = ndx;
+}
+
+/* entries are refreshed in time order, so the expired ones are at the LRU tail */
+static void Traffic_Expire(time_t reference)
+{
+    while (lru_tail != TRAFFIC_NONE &&
+           reference - Container[lru_tail].timestamp > ENTRY_EXPIRATION_TIME)
+        Traffic_Remove(lru_tail);
+}
+
+int Traffic_Find(uint32_t addr)
+{
+    if (bucket == NULL)
+        return TRAFFIC_NONE;
+
+    for (uint16_t b = Traffic_Hash(addr); bucket[b] != TRAFFIC_NONE; b = (b + 1) & bucket_mask)
+        if (Container[bucket[b]].addr == addr)
+            return bucket[b];
+
+    return TRAFFIC_NONE;
+}
+
+int Traffic_Insert(ufo_t* fop)
+{
+    int ndx;
+
+    if (Container == NULL)
+        return TRAFFIC_NONE;
+
+    ndx = Traffic_Find(fop->addr);
+    if (ndx != TRAFFIC_NONE)
+    {
+        Traffic_Unlink(ndx);
+        Container[ndx] = *fop;
+    }
+    else
+    {
+        Traffic_Expire(now());
+
+        /* table is full, drop the aircraft we have not heard from for the longest time */
+        if (free_head == TRAFFIC_NONE)
+            Traffic_Remove(lru_tail);
+
+        ndx            = free_head;
+        free_head      = lru_next[ndx];
+        Container[ndx] = *fop;
+        Traffic_Index(ndx);
+        PVALID_Reset(&Traffic_history[ndx]);
+        fresh[ndx] = 0;
+        Traffic_count++;
+    }
+
+    PVALID_Append(&Traffic_history[ndx], fop);
+    fresh[ndx] |= TRAFFIC_FLAG_FRESH | TRAFFIC_FLAG_PENDING;
+
+    Traffic_LinkFront(ndx);
+    return ndx;
+}
+
+void Traffic_Remove(int ndx)
+{
+    Traffic_Unindex(ndx);
+    Traffic_Unlink(ndx);
+
+    Container[ndx] = EmptyFO;
+    fresh[ndx]     = 0;
+    lru_next[ndx]  = free_head;
+    free_head      = ndx;
+    Traffic_count--;
+}
+
+void Traffic_Clear(void)
+{
+    if (Container == NULL)
+        return;
+
+    for (uint16_t b = 0; b <= bucket_mask; b++)
+        bucket[b] = TRAFFIC_NONE;
+
+    for (int i = Traffic_capacity - 1; i >= 0; i--) {
+        Container[i] = EmptyFO;
+        fresh[i]     = 0;
+        lru_next[i]  = i + 1 < Traffic_capacity ? i + 1 : TRAFFIC_NONE;
+    }
+
+    free_head     = 0;
+    lru_head      = TRAFFIC_NONE;
+    lru_tail      = TRAFFIC_NONE;
+    Traffic_count = 0;
+}
+
+bool Traffic_Fresh(int ndx)
+{
+    return fresh[ndx] & TRAFFIC_FLAG_FRESH;
+}
+
+void Traffic_Exported(void)
+{
+    for (int i = lru_head; i != TRAFFIC_NONE; i = lru_next[i])
+        fresh[i] &= ~TRAFFIC_FLAG_FRESH;
+}
+
+bool Traffic_Pending(int ndx)
+{
+    return fresh[ndx] & TRAFFIC_FLAG_PENDING;
+}
+
+void Traffic_Sent(int ndx)
+{
+    fresh[ndx]   = (fresh[ndx] & ~TRAFFIC_FLAG_PENDING) | TRAFFIC_FLAG_SENT;
+    sent_ms[ndx] = millis();
+}
+
+uint32_t Traffic_Since_Sent(int ndx)
+{
+    return fresh[ndx] & TRAFFIC_FLAG_SENT ? millis() - sent_ms[ndx] : 0xFFFFFFFF;
+}
+
+int Traffic_First(void)
+{
+    return lru_head;
+}
+
+int Traffic_Next(int ndx)
+{
+    return lru_next[ndx];
+}
+
+static bool Traffic_Alloc(uint16_t capacity)
+{
+    uint8_t bits = 1;
+
+    while ((1U << bits) < 2U * capacity)
+        bits++;
+
+    size_t size = capacity * (sizeof(ufo_t) + sizeof(pvalid_history_t) + sizeof(uint32_t) +
+                              2 * sizeof(int16_t) + sizeof(uint8_t)) +
+                  (1U << bits) * sizeof(int16_t);
+    uint8_t* block = (uint8_t *) malloc(size);
+
+    if (block == NULL)
+        return false;
+
+    free(Container);
+
+    Container        = (ufo_t *) block;
+    Traffic_history  = (pvalid_history_t *) (Container + capacity);
+    sent_ms          = (uint32_t *) (Traffic_history + capacity);
+    lru_prev         = (int16_t *) (sent_ms + capacity);
+    lru_next         = lru_prev + capacity;
+    bucket           = lru_next + capacity;
+    fresh            = (uint8_t *) (bucket + (1U << bits));
+    bucket_bits      = bits;
+    bucket_mask      = (1U << bits) - 1;
+    Traffic_capacity = capacity;
+
+    Traffic_Clear();
+    return true;
+}
+
 void Traffic_Update(int ndx)
 {
     Container[ndx].distance = gnss.distanceBetween(ThisAircraft.latitude,
@@ -136,16 +386,11 @@ void Traffic_Update(int ndx)
         Container[ndx].alarm_level = (*Alarm_Level)(&ThisAircraft, &Container[ndx]);
 }
 
-void ParseData()
+int ParseData()
 {
-    size_t rx_size = RF_Payload_Size(ogn_protocol_1);
+    size_t rx_size = RF_Payload_Size(RF_last_protocol);
     rx_size = rx_size > sizeof(fo.raw) ? sizeof(fo.raw) : rx_size;
 
-    char buf[16];
-    String msg;
-
-    msg = "RXBuffer: ";
-
     memset(fo.raw, 0, sizeof(fo.raw));
     memcpy(fo.raw, RxBuffer, rx_size);
     memcpy(TxBuffer, RxBuffer, rx_size);
@@ -162,40 +407,34 @@ void ParseData()
     Logger_send_udp(&msg);
 
     */
-    
+
+    /* a copy heard on another slot or via the relay, before any decoding */
+    if (DEDUP_Check(RF_last_protocol, RxBuffer, rx_size,
+                    RF_last_channel == RF_RELAY_CHANNEL ? DEDUP_RELAY : DEDUP_DIRECT, RF_last_rx_ms))
+        return TRAFFIC_NONE;
+
     if(ognrelay_enable){
-      RF_Transmit(rx_size, true);
-      return;
+      RELAY_Enqueue(RF_last_protocol, RxBuffer, rx_size, RF_last_rssi, RF_last_channel, RF_last_rx_ms);
+      return TRAFFIC_NONE;
     }
 
     
 
-    if (protocol_decode && (*protocol_decode)((void *) RxBuffer, &ThisAircraft, &fo))
+    /* Legacy keys go by the second the frame came in */
+    ThisAircraft.timestamp = RF_last_rx_time;
+
+    if (RF_Decode((void *) RxBuffer, &ThisAircraft, &fo))
     {
         int i;
 
         fo.rssi = RF_last_rssi;
 
-        for (i=0; i < MAX_TRACKING_OBJECTS; i++) {
-            if (Container[i].addr == fo.addr)
-            {
-                Container[i] = fo;
-                Traffic_Update(i);
-                break;
-            }
-            else if (now() - Container[i].timestamp > ENTRY_EXPIRATION_TIME)
-            {
-                Container[i] = fo;
-                Traffic_Update(i);
-                break;
-            }
-        }
-        // detect and delete double IDs - Caz Yokoyama fix
-        while (++i < MAX_TRACKING_OBJECTS) {
-            if (Container[i].addr == fo.addr)
-                Container[i] = EmptyFO;
-        }
+        i = Traffic_Insert(&fo);
+        if (i != TRAFFIC_NONE)
+            Traffic_Update(i);
+        return i;
     }
+    return TRAFFIC_NONE;
 }
 
 void Traffic_setup()
@@ -216,22 +455,36 @@ void Traffic_setup()
             Alarm_Level = &Alarm_Distance;
             break;
     }
+
+    /* worst case the index is 4 buckets per slot (power of 2 rounding) */
+    uint32_t budget   = SoC->getFreeHeap() / TRAFFIC_HEAP_SHARE;
+    uint32_t capacity = budget / (sizeof(ufo_t) + sizeof(pvalid_history_t) + sizeof(uint32_t) +
+                                  2 * sizeof(int16_t) + sizeof(uint8_t) + 4 * sizeof(int16_t));
+
+    if (capacity > TRAFFIC_MAX_OBJECTS)
+        capacity = TRAFFIC_MAX_OBJECTS;
+    if (capacity < MAX_TRACKING_OBJECTS)
+        capacity = MAX_TRACKING_OBJECTS;
+
+    if (!Traffic_Alloc(capacity) && !Traffic_Alloc(MAX_TRACKING_OBJECTS))
+    {
+        Serial.println(F("WARNING! No memory for the traffic table!"));
+        return;
+    }
+
+    Serial.print(F("Traffic table capacity: "));
+    Serial.println(Traffic_capacity);
 }
 
 void Traffic_loop()
 {
     if (isTimeToUpdateTraffic())
     {
-        for (int i=0; i < MAX_TRACKING_OBJECTS; i++) {
-            if (Container[i].addr &&
-                (ThisAircraft.timestamp - Container[i].timestamp) <= ENTRY_EXPIRATION_TIME)
-            {
-                if ((ThisAircraft.timestamp - Container[i].timestamp) >= TRAFFIC_VECTOR_UPDATE_INTERVAL)
-                    Traffic_Update(i);
-            }
-            else
-                Container[i] = EmptyFO;
-        }
+        Traffic_Expire(ThisAircraft.timestamp);
+
+        for (int i = Traffic_First(); i != TRAFFIC_NONE; i = Traffic_Next(i))
+            if ((ThisAircraft.timestamp - Container[i].timestamp) >= TRAFFIC_VECTOR_UPDATE_INTERVAL)
+                Traffic_Update(i);
 
         UpdateTrafficTimeMarker = millis();
     }
@@ -239,7 +492,5 @@ void Traffic_loop()
 
 void ClearExpired()
 {
-    for (int i=0; i < MAX_TRACKING_OBJECTS; i++)
-        if (Container[i].addr && (ThisAircraft.timestamp - Container[i].timestamp) > ENTRY_EXPIRATION_TIME)
-            Container[i] = EmptyFO;
+    Traffic_Expire(ThisAircraft.timestamp);
 }
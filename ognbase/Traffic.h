@@ -20,6 +20,7 @@
 #define TRAFFICHELPER_H
 
 #include "SoC.h"
+#include "PVALID.h"
 
 #define ALARM_ZONE_NONE       100000 /* zone range is 1000m <-> 10000m */
 #define ALARM_ZONE_LOW        1000   /* zone range is  700m <->  1000m */
@@ -34,6 +35,15 @@
 #define isTimeToUpdateTraffic() (millis() - UpdateTrafficTimeMarker > \
                                  TRAFFIC_UPDATE_INTERVAL_MS)
 
+/*
+ * Tracking table capacity is sized from the free heap in Traffic_setup(),
+ * never below MAX_TRACKING_OBJECTS, which is also tried if that fails.
+ */
+#define TRAFFIC_MAX_OBJECTS         512
+#define TRAFFIC_HEAP_SHARE          8   /* use at most 1/8 of the free heap */
+
+#define TRAFFIC_NONE                (-1)
+
 enum
 {
     TRAFFIC_ALARM_NONE,
@@ -42,7 +52,8 @@ enum
     TRAFFIC_ALARM_LEGACY
 };
 
-void ParseData(void);
+/* container slot of the accepted fix, TRAFFIC_NONE if none */
+int ParseData(void);
 
 void Traffic_setup(void);
 
@@ -52,6 +63,35 @@ void ClearExpired(void);
 
 void Traffic_Update(int);
 
-extern ufo_t fo, Container[MAX_TRACKING_OBJECTS], EmptyFO;
+int Traffic_Find(uint32_t);
+
+int Traffic_Insert(ufo_t *);
+
+void Traffic_Remove(int);
+
+void Traffic_Clear(void);
+
+/* received since the last export cycle */
+bool Traffic_Fresh(int);
+
+void Traffic_Exported(void);
+
+/* not forwarded to APRS-IS since it was last received */
+bool Traffic_Pending(int);
+
+void Traffic_Sent(int);
+
+/* ms since Traffic_Sent(), 0xFFFFFFFF if never */
+uint32_t Traffic_Since_Sent(int);
+
+/* most recently updated first, TRAFFIC_NONE at the end */
+int Traffic_First(void);
+
+int Traffic_Next(int);
+
+extern ufo_t  fo, *Container, EmptyFO;
+extern pvalid_history_t* Traffic_history;
+extern uint16_t Traffic_capacity;
+extern uint16_t Traffic_count;
 
 #endif /* TRAFFICHELPER_H */
@@ -22,6 +22,10 @@
 #include "SoC.h"
 #include "EEPROM.h"
 #include "RF.h"
+#include "RFSCHED.h"
+#include "DEDUP.h"
+#include "RXSTATS.h"
+#include "LOOPSTATS.h"
 #include "global.h"
 #include "Battery.h"
 #include "Log.h"
@@ -192,7 +196,7 @@ void Web_setup(ufo_t* this_aircraft)
     file.read((uint8_t *)index_html, filesize);
     index_html[filesize] = '\0';
 
-    size_t size = 8700;
+    size_t size = 9216;
     char*  offset;
     char*  Settings_temp = (char *) malloc(size);
 
@@ -453,5 +457,25 @@ void Web_loop(void)
         values += "_";
         values += largest_range;
         globalClient->text(values);
+
+        /* receiver schedule and yield per protocol/window/channel */
+        static char sched[RFSCHED_REPORT_SIZE];
+        if (RFSCHED_Report(sched, sizeof(sched)))
+            globalClient->text(sched);
+
+        /* frames dropped before decoding, per source */
+        static char dedup[DEDUP_REPORT_SIZE];
+        if (DEDUP_Report(dedup, sizeof(dedup)))
+            globalClient->text(dedup);
+
+        /* frames, errors and RSSI per protocol/channel/window, coverage by bearing */
+        static char rx[RXSTATS_REPORT_SIZE];
+        if (RXSTATS_Report(rx, sizeof(rx)))
+            globalClient->text(rx);
+
+        /* how long loop() iterations take */
+        static char loop[LOOPSTATS_REPORT_SIZE];
+        if (LOOPSTATS_Report(loop, sizeof(loop)))
+            globalClient->text(loop);
     }
 }
@@ -104,7 +104,7 @@ size_t Raw_Receive_UDP(uint8_t* buf)
 
 void Raw_Transmit_UDP()
 {
-    size_t rx_size = RF_Payload_Size(ogn_protocol_1);
+    size_t rx_size = RF_Payload_Size(RF_last_protocol);
     rx_size = rx_size > sizeof(fo.raw) ? sizeof(fo.raw) : rx_size;
     String str = Bin2Hex(fo.raw, rx_size);
     size_t len = str.length();
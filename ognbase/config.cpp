@@ -27,12 +27,6 @@
 #include <SD.h>
 #include <FS.h>
 #include "OLED.h"
-
-// SD card
-#define SD_SCK  14
-#define SD_MISO 2
-#define SD_MOSI 15
-#define SD_CS   13
 //END SD
 
 #define ARDUINOJSON_USE_DOUBLE 0
@@ -57,6 +51,8 @@ uint16_t ogn_debugport   = 12000;
 bool     ogn_itrackbit   = false;
 bool     ogn_istealthbit = false;
 uint16_t  ogn_range       = 100;
+bool     ogn_aprs_stream   = false; // forward every fix as it comes in
+uint16_t ogn_aprs_interval = 1000;  // ms, per aircraft when streaming
 
 //sleep mode
 bool     ogn_sleepmode   = false;
@@ -100,11 +96,20 @@ bool  private_network = false;
 bool new_protocol_enable;
 String new_protocol_server;
 uint32_t new_protocol_port;
+bool new_protocol_stream;
 
 //relay
 bool ognrelay_enable = false;
 bool ognrelay_base = false;
 
+//raw frame capture
+bool capture_enable = false;
+#ifdef TTGO
+bool capture_sd = true;
+#else
+bool capture_sd = false;    /* no SD card slot, SPIFFS */
+#endif
+
 
 #ifdef TTGO
 
@@ -225,6 +230,8 @@ bool OGN_read_config(void)
       else {
          Serial.println("No firmware found");
       }
+      /* CAPTURE_Open() mounts it again on its own bus */
+      SD.end();
     }
     SPI.end();
 #endif    
@@ -311,6 +318,8 @@ bool OGN_read_config(void)
             ogn_rxidle      = obj["aprs"]["rxidle"];
             ogn_wakeuptimer = obj["aprs"]["wakeuptimer"];
             ogn_range       = obj["aprs"]["range"];
+            ogn_aprs_stream   = obj["aprs"]["stream"] | false;
+            ogn_aprs_interval = obj["aprs"]["stream_interval"] | 1000;
         }
     }
 
@@ -405,8 +414,16 @@ bool OGN_read_config(void)
             new_protocol_enable = obj["newprot"]["enable"];
             new_protocol_server = obj["newprot"]["server"].as<String>();
             new_protocol_port = obj["newprot"]["port"];
+            new_protocol_stream = obj["newprot"]["stream"];
     }        
 
+    /*raw frame capture, SD card or SPIFFS*/
+    if (obj.containsKey(F("capture")))
+    {
+        capture_enable = obj["capture"]["enable"];
+        capture_sd     = obj["capture"]["sd"] | capture_sd;
+    }
+
     if (obj.containsKey(F("beers")))
         beers_show = obj["beers"]["show"];
 
@@ -477,6 +494,8 @@ bool OGN_save_config(void)
     obj["aprs"]["rxidle"]      = ogn_rxidle;
     obj["aprs"]["wakeuptimer"] = ogn_wakeuptimer;
     obj["aprs"]["range"]       = ogn_range;
+    obj["aprs"]["stream"]          = ogn_aprs_stream;
+    obj["aprs"]["stream_interval"] = ogn_aprs_interval;
 
     //wifi config
     obj["wifi"]["ssid"][0] =  ogn_ssid[0];
@@ -23,6 +23,12 @@
 #ifndef CONFIGHELPER_H
 #define CONFIGHELPER_H
 
+// SD card (TTGO)
+#define SD_SCK  14
+#define SD_MISO 2
+#define SD_MOSI 15
+#define SD_CS   13
+
 bool OGN_save_config(void);
 
 bool OGN_read_config(void);
@@ -25,6 +25,8 @@ extern bool     ogn_sleepmode;
 extern uint16_t ogn_rxidle;
 extern uint16_t ogn_wakeuptimer;
 extern uint16_t ogn_range;
+extern bool     ogn_aprs_stream;
+extern uint16_t ogn_aprs_interval;
 
 extern bool     fanet_enable;
 extern bool     zabbix_enable;
@@ -45,6 +47,10 @@ extern bool  private_network;
 extern bool  new_protocol_enable;
 extern String new_protocol_server;
 extern uint32_t new_protocol_port;
+extern bool new_protocol_stream;
 
 extern bool ognrelay_enable;
 extern bool ognrelay_base;
+
+extern bool capture_enable;
+extern bool capture_sd;
@@ -0,0 +1,381 @@
+/*
+ * APRS_check.cpp
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * Host checks for the APRS aircraft beacon formatter:
+ *
+ *   aprs-check   OGN_APRS_Position() against the former String based
+ *                formatter (kept below, verbatim) for edge cases and
+ *                pseudo random fixes, and against a golden file
+ *   aprs-golden  writes that golden file from the reference formatter
+ *   aprs-bench   ns per beacon, reference vs. OGN_APRS_Position()
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <chrono>
+
+#include <TimeLib.h>
+
+#include "../SoC.h"
+#include "../Traffic.h"
+#include "../APRS.h"
+
+#include "Checks.h"
+
+#define CHECK_APRS_RANDOM   1000000
+#define CHECK_APRS_GOLDEN   256
+#define CHECK_APRS_BENCH    200000
+
+static uint32_t check_seed;
+
+static uint32_t Check_rand()
+{
+    /* Numerical Recipes LCG, same sequence on every host */
+    check_seed = check_seed * 1664525UL + 1013904223UL;
+    return check_seed;
+}
+
+static float Check_uniform(float lo, float hi)
+{
+    return lo + (hi - lo) * (Check_rand() >> 8) / 16777216.0f;
+}
+
+/* ---- reference: OGN_APRS_Export() as it was before OGN_APRS_Position() ---- */
+
+static String zeroPadding(String data, int len)
+{
+    if (data.charAt(2) == '.')
+        data.remove(len, data.length());
+
+    if (data.charAt(1) == '.')
+        data.remove(len - 1, data.length());
+    String tmp = "";
+    for (int i = data.length(); i < len; i++)
+        tmp += "0";
+    tmp += data;
+    return tmp;
+}
+
+static String getWW(String data)
+{
+    String tmp = data;
+    int    len = tmp.length();
+    tmp.remove(0, len - 1);
+    return tmp;
+}
+
+static float SnrCalc(float rssi)
+{
+    float noise = -108.0;
+    return rssi - (noise);
+}
+
+static String Check_APRS_reference(ufo_t* fop, const char* rec_callsign)
+{
+    String symbol_table[16] = {"/", "/", "\\", "/", "\\", "\\", "/", "/", "\\", "J", "/", "/", "M", "/", "\\", "\\"};
+    String symbol[16]       = {"z", "^", "^", "X", "", "^", "g", "g", "^", "^", "^", "O", "^", "\'", "", "n", };
+
+    String callsign, timestamp, lat_deg, lat_min, lon_deg, lon_min, alt;
+    String heading, ground_speed, sender_details, snr, pos_precision, climbrate;
+
+    float LAT = fabs(fop->latitude);
+    float LON = fabs(fop->longitude);
+
+    callsign = zeroPadding(String(fop->addr, HEX), 6);
+    callsign.toUpperCase();
+
+    time_t receive_time = fop->timestamp;
+    timestamp = zeroPadding(String(hour(receive_time)), 2) + zeroPadding(String(minute(receive_time)), 2) + zeroPadding(String(second(receive_time)), 2) + "h";
+
+    lat_deg = String(int(LAT));
+    lat_min = zeroPadding(String((LAT - int(LAT)) * 60, 3), 5);
+
+    lon_deg = zeroPadding(String(int(LON)), 3);
+    lon_min = zeroPadding(String((LON - int(LON)) * 60, 3), 5);
+
+    alt = zeroPadding(String(int(fop->altitude * 3.28084)), 6);
+
+    heading      = zeroPadding(String(int(fop->course)), 3);
+    ground_speed = zeroPadding(String(int(fop->speed)), 3);
+
+    sender_details = zeroPadding(String(fop->aircraft_type << 2 | (fop->stealth << 7) | (fop->no_track << 6) | fop->addr_type, HEX), 2);
+
+    snr = String(SnrCalc(fop->rssi), 1);
+
+    String W_lat = String((LAT - int(LAT)) * 60, 3);
+    String W_lon = String((LON - int(LON)) * 60, 3);
+
+    pos_precision = getWW(W_lat) + getWW(W_lon);
+
+    if (fop->vs >= 0)
+        climbrate = "+" + zeroPadding(String(int(fop->vs)), 3);
+    else
+        climbrate = zeroPadding(String(int(fop->vs)), 3);
+
+    String AircraftPacket = "";
+
+    if (fop->addr_type == 1)
+        AircraftPacket = "ICA";
+    if (fop->addr_type == 2)
+        AircraftPacket += "FLR";
+    if (fop->addr_type == 3)
+        AircraftPacket += "OGN";
+    if (fop->addr_type == 4)
+        AircraftPacket += "P3I";
+    if (fop->addr_type == 5)
+        AircraftPacket += "FNT";
+    if (fop->addr_type == 0 || fop->addr_type > 5)
+        AircraftPacket += "RANDOM";
+
+    AircraftPacket += callsign;
+    sender_details.toUpperCase();
+
+    AircraftPacket += ">APRS,qAS,";
+    AircraftPacket += rec_callsign;
+    AircraftPacket += ":/";
+    AircraftPacket += timestamp;
+    AircraftPacket += lat_deg;
+    AircraftPacket += lat_min;
+    if (fop->latitude < 0)
+        AircraftPacket += "S";
+    else
+        AircraftPacket += "N";
+    AircraftPacket += symbol_table[fop->aircraft_type];
+    AircraftPacket += lon_deg;
+    AircraftPacket += lon_min;
+    if (fop->longitude < 0)
+        AircraftPacket += "W";
+    else
+        AircraftPacket += "E";
+    AircraftPacket += symbol[fop->aircraft_type];
+    AircraftPacket += heading;
+    AircraftPacket += "/";
+    AircraftPacket += ground_speed;
+    AircraftPacket += "/A=";
+    AircraftPacket += alt;
+    AircraftPacket += " !W";
+    AircraftPacket += pos_precision;
+    AircraftPacket += "! id";
+    AircraftPacket += sender_details;
+    AircraftPacket += callsign;
+    AircraftPacket += " ";
+    AircraftPacket += climbrate;
+    AircraftPacket += "fpm +0.0rot ";
+    AircraftPacket += snr;
+    AircraftPacket += "dB 0e -0.0kHz";
+    AircraftPacket += "\r\n";
+
+    return AircraftPacket;
+}
+
+/* ---- test vectors ---- */
+
+#define CHECK_APRS_EDGES    (5 * 6000)
+
+/*
+ * Cases below CHECK_APRS_EDGES walk latitude/longitude across minute
+ * rounding boundaries (x.xxx5 minutes, exact halves x + n/16 minutes)
+ * and altitude/climb across sign and truncation boundaries, the rest
+ * are pseudo random.
+ */
+static float Check_APRS_half(uint32_t deg, uint32_t n)
+{
+    float half = (n % 60) + (2 * (n / 60 % 8) + 1) / 16.0f;
+    float v    = deg + half / 60;
+
+    /* nearby float whose minutes are exactly the half, if there is one */
+    for (int i = 0; i < 16 && (v - int(v)) * 60 != half; i++)
+        v = nextafterf(v, (v - int(v)) * 60 < half ? 1000.0f : 0.0f);
+    return v;
+}
+
+static void Check_APRS_case(uint32_t n, ufo_t* fop)
+{
+    memset(fop, 0, sizeof(*fop));
+
+    fop->timestamp     = 1593600000UL + Check_rand() % 86400;
+    fop->addr          = Check_rand() & 0xFFFFFF;
+    fop->addr_type     = Check_rand() % 8;
+    fop->aircraft_type = Check_rand() % 16;
+    fop->stealth       = (Check_rand() & 0x0F) == 0;
+    fop->no_track      = (Check_rand() & 0x0F) == 0;
+    fop->rssi          = (int8_t) Check_rand();
+    fop->course        = Check_uniform(0, 360);
+    fop->speed         = Check_uniform(0, 300);
+    fop->vs            = Check_uniform(-3000, 3000);
+    fop->altitude      = Check_uniform(-500, 20000);
+    fop->latitude      = Check_uniform(-90, 90);
+    fop->longitude     = Check_uniform(-180, 180);
+
+    if (n < CHECK_APRS_EDGES)
+    {
+        uint32_t deg  = Check_rand() % 90;
+        float    step = (n % 6000) / 100.0f + 0.0005f; /* 0.0005 .. 59.9995 min */
+        float    tiny = Check_uniform(-1e-6f, 1e-6f);
+
+        switch (n / 6000)
+        {
+            case 0:
+                fop->latitude  = deg + step / 60 + tiny;
+                fop->longitude = -(deg * 2.0f + step / 60 - tiny);
+                break;
+            case 1:
+                fop->latitude  = -(deg + (n % 6000) / 6000.0f);
+                fop->longitude = deg * 2.0f + (n % 6000) / 6000.0f;
+                break;
+            case 2:
+                fop->altitude = ((int) (n % 6000) - 3000) / 3.28084f + tiny * 1000;
+                fop->vs       = ((int) (n % 6000) - 3000) / 1000.0f;
+                break;
+            case 3:
+                fop->latitude  = Check_APRS_half(deg, n % 6000);
+                fop->longitude = -Check_APRS_half(deg * 2, n % 6000 + 480);
+                break;
+            default:
+                fop->latitude  = (n & 1) ? 0.0f : -0.0f;
+                fop->longitude = (n & 2) ? 180.0f : 1e-9f * (n % 6000);
+                fop->altitude  = (n % 6000) * 1e-4f;
+                fop->vs        = (n & 4) ? -0.0f : 0.0f;
+                break;
+        }
+    }
+}
+
+int Check_APRS(const char* golden)
+{
+    ufo_t    fop;
+    char     buf[APRS_PACKET_SIZE];
+    uint32_t cases    = CHECK_APRS_EDGES + CHECK_APRS_RANDOM;
+    uint32_t failures = 0;
+
+    check_seed = 1;
+    for (uint32_t n = 0; n < cases; n++)
+    {
+        Check_APRS_case(n, &fop);
+
+        String ref = Check_APRS_reference(&fop, "OGNHOST");
+        size_t len = OGN_APRS_Position(buf, sizeof(buf), &fop, "OGNHOST");
+
+        if (len != ref.length() || strcmp(buf, ref.c_str()))
+        {
+            if (failures++ < 10)
+                fprintf(stderr, "case %u lat %.9g lon %.9g alt %.9g vs %.9g\n  ref %s  new %s",
+                        n, fop.latitude, fop.longitude, fop.altitude, fop.vs, ref.c_str(), buf);
+        }
+    }
+
+    /* the buffer must be large enough for the longest callsign and never overflow */
+    Check_APRS_case(0, &fop);
+    if (OGN_APRS_Position(buf, 16, &fop, "OGNHOST") != 0 ||
+        OGN_APRS_Position(buf, sizeof(buf), &fop, "OGN1234567") == 0)
+    {
+        fprintf(stderr, "buffer size handling\n");
+        failures++;
+    }
+
+    printf("aprs-check: %u cases, %u differ from the reference\n", cases, failures);
+
+    if (golden)
+    {
+        FILE*    fp = fopen(golden, "r");
+        char     line[APRS_PACKET_SIZE + 2];
+        uint32_t n = 0, mismatches = 0;
+
+        if (!fp)
+        {
+            perror(golden);
+            return EXIT_FAILURE;
+        }
+
+        check_seed = 1;
+        while (fgets(line, sizeof(line), fp))
+        {
+            line[strcspn(line, "\r\n")] = 0;
+            Check_APRS_case(n++ * (cases / CHECK_APRS_GOLDEN), &fop);
+            OGN_APRS_Position(buf, sizeof(buf), &fop, "OGNHOST");
+            buf[strcspn(buf, "\r\n")] = 0;
+            if (strcmp(line, buf))
+            {
+                if (mismatches++ < 10)
+                    fprintf(stderr, "golden %u\n  want %s\n  got  %s\n", n, line, buf);
+            }
+        }
+        fclose(fp);
+
+        printf("aprs-check: %u golden lines, %u mismatches\n", n, mismatches);
+        if (n != CHECK_APRS_GOLDEN)
+            mismatches++;
+        failures += mismatches;
+    }
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/* one beacon per line, without CR LF, cases spread over the check set */
+int Check_APRS_golden()
+{
+    ufo_t    fop;
+    uint32_t cases = CHECK_APRS_EDGES + CHECK_APRS_RANDOM;
+
+    check_seed = 1;
+    for (uint32_t n = 0; n < CHECK_APRS_GOLDEN; n++)
+    {
+        Check_APRS_case(n * (cases / CHECK_APRS_GOLDEN), &fop);
+
+        String ref = Check_APRS_reference(&fop, "OGNHOST");
+        ref.trim();
+        printf("%s\n", ref.c_str());
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int Bench_APRS(int count)
+{
+    static ufo_t fop[64];
+    char         buf[APRS_PACKET_SIZE];
+    size_t       sink = 0;
+
+    if (count <= 0)
+        count = CHECK_APRS_BENCH;
+
+    check_seed = 1;
+    for (int n = 0; n < 64; n++)
+        Check_APRS_case(CHECK_APRS_EDGES + n, &fop[n]);
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (int n = 0; n < count; n++)
+        sink += Check_APRS_reference(&fop[n & 63], "OGNHOST").length();
+
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    for (int n = 0; n < count; n++)
+        sink += OGN_APRS_Position(buf, sizeof(buf), &fop[n & 63], "OGNHOST");
+
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+    double ref_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / count;
+    double new_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / count;
+
+    printf("aprs-bench: %d beacons (%zu bytes)\n", count, sink / 2);
+    printf("  %-24s %10.1f ns/beacon\n", "String (reference)", ref_ns);
+    printf("  %-24s %10.1f ns/beacon\n", "OGN_APRS_Position", new_ns);
+    printf("  %-24s %10.1fx\n", "speedup", ref_ns / new_ns);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+/*
+ * Arduino.h
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * Minimal Arduino core stand-in for the host (Linux) build of ognbase.
+ * Only what the receive pipeline (RF, Traffic, PVALID, APRS and the
+ * protocol decoders) actually needs is provided here.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+/* String class is shared with the Raspberry Pi port of LMIC */
+#define RASPBERRY_PI
+#include <raspi/WString.h>
+#undef  RASPBERRY_PI
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define PI          3.1415926535897932384626433832795
+#define HALF_PI     1.5707963267948966192313216916398
+#define TWO_PI      6.283185307179586476925286766559
+#define DEG_TO_RAD  0.017453292519943295769236907684886
+#define RAD_TO_DEG  57.295779513082320876798154814105
+
+#define radians(deg) ((deg) * DEG_TO_RAD)
+#define degrees(rad) ((rad) * RAD_TO_DEG)
+#define sq(x)        ((x) * (x))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define PROGMEM
+#define IRAM_ATTR
+#define F(s)                 (s)
+#define PSTR(s)              (s)
+#define pgm_read_byte(addr)  (*(const uint8_t *) (addr))
+#define pgm_read_word(addr)  (*(const uint16_t *) (addr))
+#define pgm_read_dword(addr) (*(const uint32_t *) (addr))
+#define memcpy_P             memcpy
+
+#define LOW           0
+#define HIGH          1
+#define INPUT         0
+#define OUTPUT        1
+#define INPUT_PULLUP  2
+#define INPUT_PULLDOWN 3
+
+#define SERIAL_8N1    0x800001c
+
+#define pinMode(pin, mode)       do { } while (0)
+#define digitalWrite(pin, value) do { } while (0)
+#define digitalRead(pin)         (HIGH)
+
+/*
+ * Time base of the host build is virtual: it only moves when the replay
+ * harness (or delay()) advances it, so that all millis()/now() based
+ * logic of the firmware stays deterministic while replaying a recording.
+ */
+unsigned long millis(void);
+unsigned long micros(void);
+void          delay(unsigned long);
+void          yield(void);
+void          Host_set_millis(unsigned long);
+
+long random(long);
+long random(long, long);
+void randomSeed(unsigned long);
+
+class HostSerial
+{
+  public:
+    void   begin(unsigned long, uint32_t config = SERIAL_8N1) { }
+    void   flush(void) { }
+    size_t print(const String &s)                  { return emit("%s", s.c_str()); }
+    size_t print(const char *s)                    { return emit("%s", s); }
+    size_t print(char c)                           { return emit("%c", c); }
+    size_t print(int n, int base = DEC)            { return print((long) n, base); }
+    size_t print(unsigned int n, int base = DEC)   { return print((unsigned long) n, base); }
+    size_t print(unsigned char n, int base = DEC)  { return print((unsigned long) n, base); }
+    size_t print(long n, int base = DEC)           { return base == HEX ? emit("%lX", n) : emit("%ld", n); }
+    size_t print(unsigned long n, int base = DEC)  { return base == HEX ? emit("%lX", n) : emit("%lu", n); }
+    size_t print(double n, int digits = 2)         { return emit("%.*f", digits, n); }
+    size_t println(void)                           { return emit("\r\n"); }
+    template <typename T> size_t println(T v)             { return print(v) + println(); }
+    template <typename T> size_t println(T v, int format) { return print(v, format) + println(); }
+    size_t printf(const char *fmt, ...);
+
+    bool enabled;
+
+  private:
+    size_t emit(const char *fmt, ...);
+};
+
+extern HostSerial Serial;
+
+#endif /* HOST_ARDUINO_H */
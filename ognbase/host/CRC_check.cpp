@@ -0,0 +1,162 @@
+/*
+ * CRC_check.cpp
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * Host checks for CRC.cpp:
+ *
+ *   crc-check    CRC_ccitt() against update_crc_ccitt() of lib_crc for
+ *                every length up to 4 slices plus random seeds and buffers,
+ *                and the precomputed legacy address seeds
+ *   crc-bench    ns per legacy frame and MB/s, lib_crc vs. CRC_ccitt()
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include <lib_crc.h>
+
+#include "../CRC.h"
+#include "../RF.h"
+
+#include "Checks.h"
+
+#define CHECK_CRC_RANDOM    200000
+#define CHECK_CRC_MAXLEN    (4 * CRC_CCITT_SLICES + 7)
+#define BENCH_CRC_FRAMES    2000000
+#define BENCH_CRC_BLOCK     4096
+
+static uint32_t check_seed;
+
+static uint32_t Check_rand()
+{
+    check_seed = check_seed * 1664525UL + 1013904223UL;
+    return check_seed;
+}
+
+static uint16_t Check_CRC_reference(uint16_t crc, const uint8_t* buf, size_t len)
+{
+    while (len--)
+        crc = update_crc_ccitt(crc, *buf++);
+    return crc;
+}
+
+/* the per frame work of sx12xx_rx_func() before CRC.cpp */
+static uint16_t Check_CRC_legacy_reference(const uint8_t* buf, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    crc = update_crc_ccitt(crc, 0x31);
+    crc = update_crc_ccitt(crc, 0xFA);
+    crc = update_crc_ccitt(crc, 0xB6);
+    return Check_CRC_reference(crc, buf, len);
+}
+
+int Check_CRC()
+{
+    static const uint8_t legacy_addr[] = { 0x31, 0xFA, 0xB6 };
+    uint8_t  buf[CHECK_CRC_MAXLEN];
+    uint32_t cases = 0, failed = 0;
+
+    CRC_setup();
+    check_seed = 1;
+
+    if (Check_CRC_reference(0xFFFF, legacy_addr, 3) != CRC_CCITT_LEGACY_FFFF ||
+        Check_CRC_reference(0x0000, legacy_addr, 3) != CRC_CCITT_LEGACY_0000)
+    {
+        printf("crc-check: legacy seeds %04X %04X, lib_crc says %04X %04X\n",
+               CRC_CCITT_LEGACY_FFFF, CRC_CCITT_LEGACY_0000,
+               Check_CRC_reference(0xFFFF, legacy_addr, 3),
+               Check_CRC_reference(0x0000, legacy_addr, 3));
+        failed++;
+    }
+    cases += 2;
+
+    for (int n = 0; n < CHECK_CRC_RANDOM; n++)
+    {
+        size_t   len  = n < CHECK_CRC_MAXLEN * 256 ? n / 256 : Check_rand() % (CHECK_CRC_MAXLEN + 1);
+        uint16_t seed = n & 1 ? 0xFFFF : Check_rand() >> 16;
+
+        for (size_t i = 0; i < len; i++)
+            buf[i] = Check_rand() >> 24;
+
+        uint16_t ref = Check_CRC_reference(seed, buf, len);
+        uint16_t crc = CRC_ccitt(seed, buf, len);
+
+        if (crc != ref)
+        {
+            if (failed < 10)
+                printf("crc-check: seed %04X len %zu: %04X, lib_crc %04X\n", seed, len, crc, ref);
+            failed++;
+        }
+        cases++;
+    }
+
+    printf("crc-check: %u cases, %u differ from lib_crc\n", cases, failed);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int Bench_CRC(int frames)
+{
+    static uint8_t block[BENCH_CRC_BLOCK];
+    uint8_t        frame[64][LEGACY_PAYLOAD_SIZE];
+    uint32_t       sink = 0;
+
+    if (frames <= 0)
+        frames = BENCH_CRC_FRAMES;
+
+    CRC_setup();
+    check_seed = 1;
+    for (int n = 0; n < 64; n++)
+        for (int i = 0; i < LEGACY_PAYLOAD_SIZE; i++)
+            frame[n][i] = Check_rand() >> 24;
+    for (int i = 0; i < BENCH_CRC_BLOCK; i++)
+        block[i] = Check_rand() >> 24;
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (int n = 0; n < frames; n++)
+        sink += Check_CRC_legacy_reference(frame[n & 63], LEGACY_PAYLOAD_SIZE);
+
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    for (int n = 0; n < frames; n++)
+        sink += CRC_ccitt(CRC_CCITT_LEGACY_FFFF, frame[n & 63], LEGACY_PAYLOAD_SIZE);
+
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+    int blocks = frames / 64 + 1;
+    for (int n = 0; n < blocks; n++)
+        sink += Check_CRC_reference(n, block, BENCH_CRC_BLOCK);
+
+    std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+    for (int n = 0; n < blocks; n++)
+        sink += CRC_ccitt(n, block, BENCH_CRC_BLOCK);
+
+    std::chrono::steady_clock::time_point t4 = std::chrono::steady_clock::now();
+
+    double ref_ns  = std::chrono::duration<double, std::nano>(t1 - t0).count() / frames;
+    double new_ns  = std::chrono::duration<double, std::nano>(t2 - t1).count() / frames;
+    double ref_mbs = (double) blocks * BENCH_CRC_BLOCK / std::chrono::duration<double, std::micro>(t3 - t2).count();
+    double new_mbs = (double) blocks * BENCH_CRC_BLOCK / std::chrono::duration<double, std::micro>(t4 - t3).count();
+
+    printf("crc-bench: %d legacy frames, %d blocks of %d bytes (%04X)\n",
+           frames, blocks, BENCH_CRC_BLOCK, sink & 0xFFFF);
+    printf("  %-24s %10.1f ns/frame %10.1f MB/s\n", "update_crc_ccitt", ref_ns, ref_mbs);
+    printf("  %-24s %10.1f ns/frame %10.1f MB/s\n", "CRC_ccitt", new_ns, new_mbs);
+    printf("  %-24s %10.1fx %19.1fx\n", "speedup", ref_ns / new_ns, new_mbs / ref_mbs);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,58 @@
+/*
+ * Checks.h
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * Self checks and micro benchmarks of the host build, run as
+ * subcommands of ognbase-host (see Replay.cpp).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_CHECKS_H
+#define HOST_CHECKS_H
+
+/* APRS_check.cpp */
+int Check_APRS(const char* golden);
+int Check_APRS_golden();
+int Bench_APRS(int count);
+
+/* CRC_check.cpp */
+int Check_CRC();
+int Bench_CRC(int frames);
+
+/* DEDUP_check.cpp */
+int Check_DEDUP();
+
+/* FEC_bench.cpp */
+int Bench_FEC(int frames);
+
+/* Legacy_bench.cpp */
+int Bench_Legacy(int aircraft);
+
+/* NBP_check.cpp */
+int Check_NBP();
+
+/* NBP_bench.cpp */
+int Bench_NBP(int aircraft, int seconds);
+
+/* RELAY_check.cpp */
+int Check_RELAY();
+
+/* Traffic_check.cpp */
+int Check_Traffic();
+
+/* TIMER_check.cpp */
+int Check_TIMER();
+
+#endif /* HOST_CHECKS_H */
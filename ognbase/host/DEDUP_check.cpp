@@ -0,0 +1,224 @@
+/*
+ * DEDUP_check.cpp
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * dedup-check: Legacy traffic around a base with an ognrelay. Every
+ * aircraft sends its frame in both slots of a second, every third one is
+ * also heard via the relay DEDUP_CHECK_RELAY_MS later, every seventh only
+ * via the relay. The frames go through DEDUP_Check() and, unless they
+ * are dropped, through legacy_decode() as in ParseData().
+ *
+ * Every frame sent has to be decoded exactly once, each copy has to be
+ * counted against the source it came on and the one it duplicates, and
+ * with more aircraft than DEDUP_SLOTS holds in a window the cache may
+ * miss duplicates, but never drop a frame it has not seen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "../SoftRF.h"
+#include "../RF.h"
+#include "../DEDUP.h"
+#include "../Protocol_Legacy.h"
+
+#include "Checks.h"
+
+#define DEDUP_CHECK_AIRCRAFT    60
+#define DEDUP_CHECK_SECONDS     120
+#define DEDUP_CHECK_CROWD       1500    /* aircraft, more than DEDUP_SLOTS in a window */
+#define DEDUP_CHECK_SLOT_MS     400     /* slot 1 to slot 2 */
+#define DEDUP_CHECK_RELAY_MS    150     /* relay hop */
+#define DEDUP_CHECK_START       1593600000UL
+#define DEDUP_CHECK_LAT         47.1234
+#define DEDUP_CHECK_LON         8.5678
+
+typedef struct
+{
+    uint32_t        ms;
+    uint32_t        timestamp;
+    uint8_t         source;
+    uint32_t        id;         /* frame sent, copies share it */
+    legacy_packet_t pkt;
+} check_frame_t;
+
+static void Check_DEDUP_traffic(std::vector<check_frame_t>& frames, int aircraft, int seconds,
+                                uint32_t* unique)
+{
+    ufo_t fo;
+
+    *unique = 0;
+    for (int t = 0; t < seconds; t++)
+        for (int i = 0; i < aircraft; i++)
+        {
+            check_frame_t f;
+            bool          direct = i % 7 != 0;
+            bool          relay  = i % 3 == 0 || !direct;
+
+            memset(&fo, 0, sizeof(fo));
+            fo.addr          = 0xDD0000 + i * 0x0101;
+            fo.addr_type     = ADDR_TYPE_FLARM;
+            fo.timestamp     = DEDUP_CHECK_START + t;
+            fo.latitude      = DEDUP_CHECK_LAT + 0.0001 * i + 0.0001 * t;
+            fo.longitude     = DEDUP_CHECK_LON - 0.0001 * i;
+            fo.altitude      = 1000 + i;
+            fo.course        = (i * 37 + t) % 360;
+            fo.speed         = 50;
+            fo.aircraft_type = AIRCRAFT_TYPE_GLIDER;
+
+            f.timestamp = fo.timestamp;
+            f.id        = (*unique)++;
+            legacy_encode(&f.pkt, &fo);
+
+            for (int slot = 0; slot < 2; slot++)
+            {
+                f.ms = t * 1000 + 400 + (i * 13) % 400 + slot * DEDUP_CHECK_SLOT_MS;
+                if (direct)
+                {
+                    f.source = DEDUP_DIRECT;
+                    frames.push_back(f);
+                }
+                if (relay)
+                {
+                    f.ms    += DEDUP_CHECK_RELAY_MS;
+                    f.source = DEDUP_RELAY;
+                    frames.push_back(f);
+                }
+            }
+        }
+
+    std::stable_sort(frames.begin(), frames.end(), [](const check_frame_t& a, const check_frame_t& b) {
+        return a.ms < b.ms;
+    });
+}
+
+/* the ParseData() path, with or without the cache in front */
+static double Check_DEDUP_run(const std::vector<check_frame_t>& frames, bool dedup,
+                              std::vector<uint32_t>& decoded)
+{
+    ufo_t           this_aircraft, fo;
+    legacy_packet_t pkt;
+
+    memset(&this_aircraft, 0, sizeof(this_aircraft));
+    this_aircraft.latitude  = DEDUP_CHECK_LAT;
+    this_aircraft.longitude = DEDUP_CHECK_LON;
+    DEDUP_Reset();
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (size_t n = 0; n < frames.size(); n++)
+    {
+        const check_frame_t* f = &frames[n];
+
+        if (dedup && DEDUP_Check(RF_PROTOCOL_LEGACY, (const uint8_t *) &f->pkt, sizeof(f->pkt),
+                                 f->source, f->ms))
+            continue;
+
+        pkt                     = f->pkt;
+        this_aircraft.timestamp = f->timestamp;
+        if (legacy_decode(&pkt, &this_aircraft, &fo))
+            decoded[f->id]++;
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / frames.size();
+}
+
+int Check_DEDUP()
+{
+    std::vector<check_frame_t> frames, crowd;
+    uint32_t                   unique, crowd_unique, failed = 0;
+    uint32_t                   expect[DEDUP_SOURCES][DEDUP_SOURCES];
+
+    Check_DEDUP_traffic(frames, DEDUP_CHECK_AIRCRAFT, DEDUP_CHECK_SECONDS, &unique);
+
+    std::vector<uint32_t> plain(unique, 0), dedup(unique, 0);
+    double                ns_plain = Check_DEDUP_run(frames, false, plain);
+    double                ns_dedup = Check_DEDUP_run(frames, true, dedup);
+
+    /* the first copy is slot 1 direct, or slot 1 relay for relay only aircraft */
+    memset(expect, 0, sizeof(expect));
+    for (int i = 0; i < DEDUP_CHECK_AIRCRAFT; i++)
+    {
+        bool direct = i % 7 != 0;
+        bool relay  = i % 3 == 0 || !direct;
+
+        if (direct && relay)
+        {
+            expect[DEDUP_DIRECT][DEDUP_DIRECT] += DEDUP_CHECK_SECONDS;
+            expect[DEDUP_RELAY][DEDUP_DIRECT]  += 2 * DEDUP_CHECK_SECONDS;
+        }
+        else if (direct)
+            expect[DEDUP_DIRECT][DEDUP_DIRECT] += DEDUP_CHECK_SECONDS;
+        else
+            expect[DEDUP_RELAY][DEDUP_RELAY] += DEDUP_CHECK_SECONDS;
+    }
+
+    for (uint32_t id = 0; id < unique; id++)
+        if (dedup[id] != 1 || !plain[id])
+        {
+            if (failed < 10)
+                printf("dedup-check: frame %u decoded %u times\n", id, dedup[id]);
+            failed++;
+        }
+
+    printf("dedup-check: %d aircraft, %d s, %zu frames of %u sent\n",
+           DEDUP_CHECK_AIRCRAFT, DEDUP_CHECK_SECONDS, frames.size(), unique);
+    for (int s = 0; s < DEDUP_SOURCES; s++)
+    {
+        uint32_t dup = DEDUP_stats.duplicates[s][DEDUP_DIRECT] + DEDUP_stats.duplicates[s][DEDUP_RELAY];
+
+        printf("  %-6s %6u frames  %6u duplicates (%.1f%%), first heard direct %u, via relay %u\n",
+               s == DEDUP_DIRECT ? "direct" : "relay", DEDUP_stats.frames[s], dup,
+               DEDUP_stats.frames[s] ? 100.0 * dup / DEDUP_stats.frames[s] : 0,
+               DEDUP_stats.duplicates[s][DEDUP_DIRECT], DEDUP_stats.duplicates[s][DEDUP_RELAY]);
+
+        for (int f = 0; f < DEDUP_SOURCES; f++)
+            if (DEDUP_stats.duplicates[s][f] != expect[s][f])
+            {
+                printf("dedup-check: %u duplicates [%d][%d], %u expected\n",
+                       DEDUP_stats.duplicates[s][f], s, f, expect[s][f]);
+                failed++;
+            }
+    }
+    printf("  decode all %.1f ns/frame, dedup first %.1f ns/frame, %u evicted\n",
+           ns_plain, ns_dedup, DEDUP_stats.evicted);
+
+    /* more live fingerprints than slots: duplicates may slip, nothing new is lost */
+    Check_DEDUP_traffic(crowd, DEDUP_CHECK_CROWD, 10, &crowd_unique);
+
+    std::vector<uint32_t> crowd_decoded(crowd_unique, 0);
+    Check_DEDUP_run(crowd, true, crowd_decoded);
+
+    uint32_t missed = 0;
+    for (uint32_t id = 0; id < crowd_unique; id++)
+    {
+        if (!crowd_decoded[id])
+            failed++;
+        missed += crowd_decoded[id] > 1 ? crowd_decoded[id] - 1 : 0;
+    }
+    printf("  %d aircraft: %zu frames, %u evicted, %u duplicates decoded again\n",
+           DEDUP_CHECK_CROWD, crowd.size(), DEDUP_stats.evicted, missed);
+    if (!DEDUP_stats.evicted)
+        failed++;
+
+    printf("dedup-check: %u failed\n", failed);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,223 @@
+/*
+ * FEC_bench.cpp
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * fec-bench: OGNTP frames through a noisy channel, plain LDPC_Check()
+ * against RF_FEC_Correct(), with and without Manchester erasures.
+ *
+ * The channel flips every Manchester chip with probability q. The radio
+ * decodes Manchester in hardware and has to guess on a broken chip pair,
+ * so a bit ends up wrong with probability q. A software demodulator sees
+ * the broken pair instead: the bit is erased with probability 2q(1-q)
+ * and silently wrong only with q^2.
+ *
+ * The chip error rate where half of the frames get through is turned
+ * into Eb/N0 for non-coherent FSK, q = exp(-Eb/N0 / 2) / 2, and the
+ * difference into range under free space loss.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <chrono>
+
+#include <ldpc.h>
+
+#include "../RF.h"
+
+#include "Checks.h"
+
+#define BENCH_FEC_FRAMES    4000
+#define BENCH_FEC_BYTES     LDPC_Decoder::CodeBytes
+
+static const double bench_fec_q[] = {
+    0.0005, 0.001, 0.0015, 0.002, 0.003, 0.004, 0.005, 0.0075,
+    0.01, 0.015, 0.02, 0.025, 0.03, 0.04, 0.05, 0.06, 0.08, 0.1
+};
+
+#define BENCH_FEC_POINTS    (int) (sizeof(bench_fec_q) / sizeof(bench_fec_q[0]))
+
+typedef enum
+{
+    FEC_CHECK,                      /* LDPC_Check() only, as before */
+    FEC_HARD,                       /* RF_FEC_Correct(), hard bits */
+    FEC_ERASURE,                    /* RF_FEC_Correct(), Manchester erasures */
+    FEC_MODES
+} fec_mode_t;
+
+static const char* fec_mode_name[FEC_MODES] = { "LDPC_Check", "FEC hard bits", "FEC erasures" };
+
+static uint32_t bench_seed;
+
+static uint32_t Bench_rand()
+{
+    bench_seed = bench_seed * 1664525UL + 1013904223UL;
+    return bench_seed;
+}
+
+static double Bench_uniform()
+{
+    return (Bench_rand() >> 8) / 16777216.0;
+}
+
+/* q at which the success rate falls through `level`, linear in between */
+static double Bench_FEC_threshold(const double* q, const double* ok, int points, double level)
+{
+    for (int n = 1; n < points; n++)
+        if (ok[n - 1] >= level && ok[n] < level)
+            return q[n - 1] + (q[n] - q[n - 1]) * (ok[n - 1] - level) / (ok[n - 1] - ok[n]);
+    return 0;
+}
+
+static double Bench_FEC_EbN0(double q)
+{
+    return 10 * log10(-2 * log(2 * q));
+}
+
+int Bench_FEC(int frames)
+{
+    uint8_t  sent[BENCH_FEC_BYTES];
+    uint8_t  rx[BENCH_FEC_BYTES];
+    uint8_t  err[BENCH_FEC_BYTES];
+    const double* q = bench_fec_q;
+    double   ok[FEC_MODES][BENCH_FEC_POINTS];
+    uint32_t wrong[FEC_MODES] = { 0 };
+    uint32_t good_calls = 0, bad_calls = 0;
+    double   good_us    = 0, bad_us = 0;
+
+    if (frames <= 0)
+        frames = BENCH_FEC_FRAMES;
+
+    bench_seed = 1;
+    memset(&RF_fec_stats, 0, sizeof(RF_fec_stats));
+
+    printf("fec-bench: %d OGNTP frames per point, %d iterations, at most %d flips\n",
+           frames, RF_FEC_ITERATIONS, RF_FEC_MAX_FLIPS);
+    printf("  %8s", "chip err");
+    for (int m = 0; m < FEC_MODES; m++)
+        printf(" %14s", fec_mode_name[m]);
+    printf("\n");
+
+    for (int p = 0; p < BENCH_FEC_POINTS; p++)
+    {
+        uint32_t pass[FEC_MODES] = { 0 };
+
+        for (int f = 0; f < frames; f++)
+        {
+            for (int i = 0; i < OGNTP_PAYLOAD_SIZE; i++)
+                sent[i] = Bench_rand() >> 24;
+            LDPC_Encode(sent);
+
+            for (int m = 0; m < FEC_MODES; m++)
+            {
+                memcpy(rx, sent, sizeof(rx));
+                memset(err, 0, sizeof(err));
+
+                /* the same noise for every mode */
+                uint32_t seed = bench_seed;
+                for (int bit = 0; bit < LDPC_Decoder::CodeBits; bit++)
+                {
+                    double  r    = Bench_uniform();
+                    uint8_t mask = 1 << (bit & 7);
+
+                    if (m != FEC_ERASURE)
+                    {
+                        if (r < q[p])
+                            rx[bit >> 3] ^= mask;
+                    }
+                    else if (r < q[p] * q[p])
+                        rx[bit >> 3] ^= mask;
+                    else if (r < q[p] * q[p] + 2 * q[p] * (1 - q[p]))
+                        err[bit >> 3] |= mask;
+                }
+                if (m != FEC_MODES - 1)
+                    bench_seed = seed;
+
+                bool accepted = LDPC_Check(rx) == 0;
+                if (!accepted && m != FEC_CHECK)
+                {
+                    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+                    accepted = RF_FEC_Correct(rx, m == FEC_ERASURE ? err : NULL);
+                    double us = std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - t0).count();
+
+                    if (accepted)
+                    {
+                        good_calls++;
+                        good_us += us;
+                    }
+                    else
+                    {
+                        bad_calls++;
+                        bad_us += us;
+                    }
+                }
+
+                if (!accepted)
+                    continue;
+                if (memcmp(rx, sent, OGNTP_PAYLOAD_SIZE))
+                    wrong[m]++;
+                else
+                    pass[m]++;
+            }
+        }
+
+        printf("  %7.2f%%", 100 * q[p]);
+        for (int m = 0; m < FEC_MODES; m++)
+        {
+            ok[m][p] = (double) pass[m] / frames;
+            printf(" %13.1f%%", 100 * ok[m][p]);
+        }
+        printf("\n");
+    }
+
+    printf("  %8s", "wrong");
+    for (int m = 0; m < FEC_MODES; m++)
+        printf(" %14u", wrong[m]);
+    printf("\n");
+    printf("  corrected %u frames (%u bits), rejected %u (no convergence or flip limit)\n",
+           RF_fec_stats.corrected, RF_fec_stats.bits, RF_fec_stats.rejected);
+    printf("  %.1f us per corrected frame (%.0f frames/s), %.1f us per lost one\n",
+           good_calls ? good_us / good_calls : 0, good_us > 0 ? good_calls * 1e6 / good_us : 0,
+           bad_calls ? bad_us / bad_calls : 0);
+
+    static const double levels[] = { 0.9, 0.5 };
+
+    for (unsigned l = 0; l < sizeof(levels) / sizeof(levels[0]); l++)
+    {
+        double base = Bench_FEC_threshold(q, ok[FEC_CHECK], BENCH_FEC_POINTS, levels[l]);
+
+        printf("  %.0f%% of frames through:\n", 100 * levels[l]);
+        for (int m = 0; m < FEC_MODES; m++)
+        {
+            double t = Bench_FEC_threshold(q, ok[m], BENCH_FEC_POINTS, levels[l]);
+
+            if (t <= 0 || base <= 0)
+            {
+                printf("    %-14s beyond the measured range\n", fec_mode_name[m]);
+                continue;
+            }
+
+            double gain = Bench_FEC_EbN0(base) - Bench_FEC_EbN0(t);
+            printf("    %-14s chip err %5.2f%%  Eb/N0 %5.2f dB  gain %4.2f dB  range %+5.1f%%\n",
+                   fec_mode_name[m], 100 * t, Bench_FEC_EbN0(t), gain,
+                   100 * (pow(10, gain / 20) - 1));
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+/*
+ * Legacy_bench.cpp
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * legacy-bench: ns per legacy_decode() with the XXTEA key cache warm
+ * (every aircraft sends once a second, a new key every 64 s) and cold
+ * (a new key epoch for every frame, as before the cache), and what
+ * make_key(), btea() and the packet parity cost on their own. The
+ * parity used to be summed bit by bit over the 24 bytes, that loop is
+ * kept below for comparison.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <chrono>
+#include <vector>
+
+#include "../SoftRF.h"
+#include "../RF.h"
+#include "../Protocol_Legacy.h"
+
+#include "Checks.h"
+
+#define BENCH_LEGACY_AIRCRAFT   50
+#define BENCH_LEGACY_SECONDS    600
+#define BENCH_LEGACY_START      1593600000UL
+#define BENCH_LEGACY_LAT        47.1234
+#define BENCH_LEGACY_LON        8.5678
+
+/* Protocol_Legacy.cpp */
+void make_key(uint32_t key[4], uint32_t timestamp, uint32_t address);
+void btea(uint32_t* v, int8_t n, const uint32_t key[4]);
+
+/* legacy_decode() parity before legacy_parity(), verbatim */
+static uint8_t Bench_parity_reference(uint32_t x)
+{
+    uint8_t parity=0;
+    while (x > 0) {
+        if (x & 0x1)
+            parity++;
+        x >>= 1;
+    }
+    return parity % 2;
+}
+
+static uint8_t Bench_packet_parity_reference(const legacy_packet_t* pkt)
+{
+    uint8_t pkt_parity=0;
+
+    for (size_t ndx = 0; ndx < sizeof (legacy_packet_t); ndx++)
+        pkt_parity += Bench_parity_reference(*(((unsigned char *) pkt) + ndx));
+    return pkt_parity % 2;
+}
+
+static uint8_t Bench_packet_parity(const legacy_packet_t* pkt)
+{
+    const uint32_t* w = (const uint32_t *) pkt;
+
+    return parity(w[0] ^ w[1] ^ w[2] ^ w[3] ^ w[4] ^ w[5]);
+}
+
+typedef struct
+{
+    uint32_t        timestamp;
+    legacy_packet_t pkt;
+} bench_frame_t;
+
+static void Bench_legacy_frames(std::vector<bench_frame_t>& frames, int aircraft, bool cold)
+{
+    ufo_t fo;
+
+    for (int t = 0; t < BENCH_LEGACY_SECONDS; t++)
+        for (int i = 0; i < aircraft; i++)
+        {
+            bench_frame_t f;
+
+            memset(&fo, 0, sizeof(fo));
+            fo.addr          = 0xDD0000 + i * 0x0101;
+            fo.timestamp     = BENCH_LEGACY_START + (cold ? 64 * (t * aircraft + i) : t);
+            fo.latitude      = BENCH_LEGACY_LAT + 0.001 * i + 0.0001 * t;
+            fo.longitude     = BENCH_LEGACY_LON - 0.001 * i;
+            fo.altitude      = 1000 + i;
+            fo.course        = (i * 37 + t) % 360;
+            fo.speed         = 50;
+            fo.aircraft_type = AIRCRAFT_TYPE_GLIDER;
+
+            f.timestamp = fo.timestamp;
+            legacy_encode(&f.pkt, &fo);
+            frames.push_back(f);
+        }
+}
+
+static double Bench_legacy_decode(const std::vector<bench_frame_t>& frames, ufo_t* out, uint32_t* failed)
+{
+    ufo_t           this_aircraft;
+    legacy_packet_t pkt;
+
+    memset(&this_aircraft, 0, sizeof(this_aircraft));
+    this_aircraft.latitude  = BENCH_LEGACY_LAT;
+    this_aircraft.longitude = BENCH_LEGACY_LON;
+
+    *failed = 0;
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (size_t n = 0; n < frames.size(); n++)
+    {
+        pkt                     = frames[n].pkt;
+        this_aircraft.timestamp = frames[n].timestamp;
+        if (!legacy_decode(&pkt, &this_aircraft, out))
+            (*failed)++;
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / frames.size();
+}
+
+int Bench_Legacy(int aircraft)
+{
+    std::vector<bench_frame_t> warm, cold;
+    ufo_t                      fo_warm, fo_cold;
+    uint32_t                   failed_warm, failed_cold;
+    uint32_t                   key[4];
+    uint32_t                   sink = 0;
+    uint32_t                   parity_differ = 0;
+
+    if (aircraft <= 0)
+        aircraft = BENCH_LEGACY_AIRCRAFT;
+
+    Bench_legacy_frames(warm, aircraft, false);
+    Bench_legacy_frames(cold, aircraft, true);
+
+    /* twice, the first round only warms up caches and the branch predictor */
+    double cold_ns = Bench_legacy_decode(cold, &fo_cold, &failed_cold);
+    double warm_ns = Bench_legacy_decode(warm, &fo_warm, &failed_warm);
+    cold_ns = Bench_legacy_decode(cold, &fo_cold, &failed_cold);
+    warm_ns = Bench_legacy_decode(warm, &fo_warm, &failed_warm);
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (size_t n = 0; n < cold.size(); n++)
+    {
+        make_key(key, cold[n].timestamp, (cold[n].pkt.addr << 8) & 0xffffff);
+        sink += key[n & 3];
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    for (size_t n = 0; n < warm.size(); n++)
+    {
+        legacy_packet_t pkt = warm[n].pkt;
+        btea((uint32_t *) &pkt + 1, -5, key);
+        sink += pkt.lat;
+    }
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+    for (size_t n = 0; n < warm.size(); n++)
+        sink += Bench_packet_parity_reference(&warm[n].pkt);
+    std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+    for (size_t n = 0; n < warm.size(); n++)
+        sink += Bench_packet_parity(&warm[n].pkt);
+    std::chrono::steady_clock::time_point t4 = std::chrono::steady_clock::now();
+
+    for (size_t n = 0; n < cold.size(); n++)
+        if (Bench_packet_parity(&cold[n].pkt) != Bench_packet_parity_reference(&cold[n].pkt))
+            parity_differ++;
+
+    double key_ns     = std::chrono::duration<double, std::nano>(t1 - t0).count() / cold.size();
+    double btea_ns    = std::chrono::duration<double, std::nano>(t2 - t1).count() / warm.size();
+    double par_ref_ns = std::chrono::duration<double, std::nano>(t3 - t2).count() / warm.size();
+    double par_ns     = std::chrono::duration<double, std::nano>(t4 - t3).count() / warm.size();
+
+    printf("legacy-bench: %d aircraft, %zu frames, %d key cache slots (%u)\n",
+           aircraft, warm.size(), LEGACY_KEY_CACHE, sink & 0xFF);
+    printf("  %-26s %8.1f ns/frame %10.0f frames/s  %u failed\n",
+           "legacy_decode, new key", cold_ns, 1e9 / cold_ns, failed_cold);
+    printf("  %-26s %8.1f ns/frame %10.0f frames/s  %u failed\n",
+           "legacy_decode, cached key", warm_ns, 1e9 / warm_ns, failed_warm);
+    printf("  %-26s %8.1f ns\n", "make_key", key_ns);
+    printf("  %-26s %8.1f ns\n", "btea (decrypt)", btea_ns);
+    printf("  %-26s %8.1f ns\n", "parity, bit by bit", par_ref_ns);
+    printf("  %-26s %8.1f ns  %u of %zu differ\n", "parity, folded words", par_ns,
+           parity_differ, cold.size());
+    printf("  %-26s %8.1f ns/frame %10.0f frames/s  (estimate)\n", "legacy_decode before",
+           cold_ns - par_ns + par_ref_ns, 1e9 / (cold_ns - par_ns + par_ref_ns));
+
+    return failed_cold || failed_warm || parity_differ ? EXIT_FAILURE : EXIT_SUCCESS;
+}
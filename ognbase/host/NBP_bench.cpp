@@ -0,0 +1,266 @@
+/*
+ * NBP_bench.cpp
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * nbp-bench: bytes per aircraft-hour on the uplink for the three NBP
+ * layouts, UDP/IP headers included. Synthetic traffic around the
+ * station, a quarter of it on the ground, the rest cruising or
+ * thermalling, every aircraft exported every NBP_BENCH_EXPORT seconds
+ * like APRS_EXPORT_AIRCRAFT in ognbase.ino.
+ *
+ *   single   one OneMessage with airc_pos per aircraft, before batching
+ *   batch    airc_list, one datagram per export cycle
+ *   stream   airc_stream, keyframes and deltas
+ *
+ * The stream is decoded again with NBP_Parse(): every report has to come
+ * back within the stream resolution, and with every NBP_BENCH_LOSS-th
+ * datagram dropped it prints how many reports the receiver has to skip
+ * until the next keyframe.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <chrono>
+#include <vector>
+
+#include "../SoftRF.h"
+#include "../RF.h"
+#include "../NBP.h"
+#include "../Protocol_Legacy.h"
+#include "../ogn_service_generated.h"
+
+#include "Checks.h"
+
+#define BENCH_NBP_AIRCRAFT  50
+#define BENCH_NBP_SECONDS   3600
+#define BENCH_NBP_EXPORT    5       /* s between export cycles */
+#define BENCH_NBP_LOSS      50      /* every n-th datagram lost */
+#define BENCH_NBP_UDP_IP    28
+#define BENCH_NBP_START     1593600000UL
+#define BENCH_NBP_LAT       47.1234f
+#define BENCH_NBP_LON       8.5678f
+#define BENCH_NBP_CALLSIGN  "OGNBENCH"
+
+typedef struct
+{
+    uint32_t datagrams;
+    uint64_t bytes;
+    uint32_t reports;
+    uint32_t decoded;
+    uint32_t differ;
+    double   ns;
+} bench_nbp_t;
+
+static void Bench_NBP_aircraft(ufo_t* fop, int i, int t)
+{
+    double heading, dist, turn;
+
+    memset(fop, 0, sizeof(*fop));
+    fop->addr          = 0xDD1000 + i * 0x0107;
+    fop->addr_type     = 1 + i % 3;
+    fop->aircraft_type = i % 4 ? AIRCRAFT_TYPE_GLIDER : AIRCRAFT_TYPE_TOWPLANE;
+    fop->timestamp     = BENCH_NBP_START + t - i % 3;
+    fop->no_track      = i % 17 == 0;
+
+    /* on the ground */
+    if (i % 4 == 3)
+    {
+        fop->latitude  = BENCH_NBP_LAT + 0.0003 * (i % 7);
+        fop->longitude = BENCH_NBP_LON - 0.0002 * (i % 5);
+        fop->altitude  = 480;
+        fop->course    = (i * 37) % 360;
+        return;
+    }
+
+    /* thermalling, 25 s a turn, or cruising, both slowly drifting away */
+    turn    = i % 4 == 1 ? 360.0 / 25 : 0.3;
+    heading = fmod(i * 53 + turn * t, 360.0);
+    dist    = 2000.0 + 300.0 * i + (i % 4 == 1 ? 0.5 : 25.0) * t;
+
+    fop->latitude  = BENCH_NBP_LAT + (dist * cos(i * 0.7) + 150.0 * cos(heading * M_PI / 180)) / 111320.0;
+    fop->longitude = BENCH_NBP_LON + (dist * sin(i * 0.7) + 150.0 * sin(heading * M_PI / 180)) / 75900.0;
+    fop->altitude  = 1200 + 3 * i + 400 * sin(t / 600.0 + i) + (i % 4 == 1 ? 1.5 * (t % 300) : 0);
+    fop->course    = fmod(heading + 90, 360.0);
+    fop->speed     = i % 4 == 1 ? 45 + i % 7 : 80 + i % 11;
+}
+
+static void Bench_NBP_single(int aircraft, int seconds, bench_nbp_t* r)
+{
+    flatbuffers::FlatBufferBuilder builder(64);
+    std::vector<ufo_t>             sent(aircraft);
+    double                         ns = 0;
+
+    memset(r, 0, sizeof(*r));
+
+    for (int t = 0; t < seconds; t += BENCH_NBP_EXPORT)
+    {
+        for (int i = 0; i < aircraft; i++)
+            Bench_NBP_aircraft(&sent[i], i, t);
+
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < aircraft; i++)
+        {
+            const ufo_t*     fop = &sent[i];
+            ogn::AircraftPos pos(fop->addr, fop->timestamp, fop->aircraft_type, fop->stealth, fop->no_track,
+                                 fop->course, fop->speed, fop->latitude, fop->longitude, fop->altitude);
+
+            builder.Clear();
+            builder.Finish(ogn::CreateOneMessage(builder, &pos));
+            r->bytes += builder.GetSize() + BENCH_NBP_UDP_IP;
+            r->datagrams++;
+            r->reports++;
+        }
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+        ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+    }
+
+    r->decoded = r->reports;
+    r->ns      = ns / r->reports;
+}
+
+/* a decoded report against what went in, at the stream resolution */
+static bool Bench_NBP_same(const ufo_t* a, const ufo_t* b, uint8_t mode)
+{
+    if (a->addr != b->addr || a->timestamp != b->timestamp ||
+        (int32_t) a->altitude != (int32_t) b->altitude || (int32_t) a->speed != (int32_t) b->speed ||
+        (int32_t) a->course % 360 != (int32_t) b->course % 360 || a->aircraft_type != b->aircraft_type ||
+        a->no_track != b->no_track || a->stealth != b->stealth)
+        return false;
+
+    if (mode == NBP_MODE_BATCH)
+        return a->latitude == b->latitude && a->longitude == b->longitude;
+
+    return a->addr_type == b->addr_type &&
+           NBP_Units(a->latitude) == NBP_Units(b->latitude) && NBP_Units(a->longitude) == NBP_Units(b->longitude);
+}
+
+static void Bench_NBP_run(int aircraft, int seconds, uint8_t mode, int loss, bench_nbp_t* r)
+{
+    static nbp_receiver_t rx;
+    std::vector<ufo_t>    sent, out(NBP_STREAM_SIZE);
+    const uint8_t*        buf;
+    size_t                size;
+    double                ns = 0;
+
+    memset(r, 0, sizeof(*r));
+    NBP_Reset();
+    NBP_Receiver_Reset(&rx);
+
+    for (int t = 0; t < seconds; t += BENCH_NBP_EXPORT)
+    {
+        std::vector<std::vector<uint8_t> > cycle;
+        std::vector<int>                   first;
+
+        sent.resize(aircraft);
+        for (int i = 0; i < aircraft; i++)
+            Bench_NBP_aircraft(&sent[i], i, t);
+
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        NBP_Begin(BENCH_NBP_CALLSIGN, BENCH_NBP_START + t, BENCH_NBP_LAT, BENCH_NBP_LON, 480, mode);
+        first.push_back(0);
+        for (int i = 0; i < aircraft; i++)
+            if (!NBP_Add(&sent[i]))
+            {
+                size = NBP_Finish(&buf);
+                cycle.push_back(std::vector<uint8_t>(buf, buf + size));
+                first.push_back(i);
+                NBP_Add(&sent[i]);
+            }
+        if (NBP_Count())
+        {
+            size = NBP_Finish(&buf);
+            cycle.push_back(std::vector<uint8_t>(buf, buf + size));
+        }
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+        ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+
+        for (size_t d = 0; d < cycle.size(); d++)
+        {
+            size_t end = d + 1 < first.size() ? first[d + 1] : sent.size();
+
+            r->datagrams++;
+            r->bytes   += cycle[d].size() + BENCH_NBP_UDP_IP;
+            r->reports += end - first[d];
+
+            if (loss && r->datagrams % loss == 0)
+                continue;
+
+            int n = NBP_Parse(&rx, cycle[d].data(), cycle[d].size(), out.data(), out.size(), NULL, 0);
+
+            /* deltas after a loss are skipped, find what went in by address */
+            for (int k = 0; k < n; k++)
+            {
+                size_t j = first[d];
+
+                while (j < end && sent[j].addr != out[k].addr)
+                    j++;
+                if (j == end || !Bench_NBP_same(&out[k], &sent[j], mode))
+                    r->differ++;
+            }
+            r->decoded += n > 0 ? n : 0;
+        }
+    }
+
+    r->ns = ns / r->reports;
+}
+
+static void Bench_NBP_print(const char* name, const bench_nbp_t* r, int aircraft, int seconds)
+{
+    double hours = aircraft * (double) seconds / 3600;
+
+    printf("  %-18s %7u datagrams %9llu bytes %8.0f bytes/aircraft-hour %6.1f bytes/report %7.1f ns/report"
+           "  %u of %u reports decoded, %u differ\n",
+           name, r->datagrams, (unsigned long long) r->bytes, r->bytes / hours, (double) r->bytes / r->reports,
+           r->ns, r->decoded, r->reports, r->differ);
+}
+
+int Bench_NBP(int aircraft, int seconds)
+{
+    bench_nbp_t single, batch, stream, lossy;
+    uint32_t    keyframes, evicted;
+
+    if (aircraft <= 0)
+        aircraft = BENCH_NBP_AIRCRAFT;
+    if (seconds <= 0)
+        seconds = BENCH_NBP_SECONDS;
+
+    Bench_NBP_single(aircraft, seconds, &single);
+    Bench_NBP_run(aircraft, seconds, NBP_MODE_BATCH, 0, &batch);
+    Bench_NBP_run(aircraft, seconds, NBP_MODE_STREAM, 0, &stream);
+    keyframes = NBP_stats.keyframes;
+    evicted   = NBP_stats.evicted;
+    Bench_NBP_run(aircraft, seconds, NBP_MODE_STREAM, BENCH_NBP_LOSS, &lossy);
+
+    printf("nbp-bench: %d aircraft, %d s, export every %d s, UDP/IP headers included\n",
+           aircraft, seconds, BENCH_NBP_EXPORT);
+    Bench_NBP_print("single", &single, aircraft, seconds);
+    Bench_NBP_print("batch", &batch, aircraft, seconds);
+    Bench_NBP_print("stream", &stream, aircraft, seconds);
+    printf("  %-18s %u keyframes (%.1f%%), %u slots evicted\n", "", keyframes,
+           100.0 * keyframes / stream.reports, evicted);
+
+    char name[32];
+    snprintf(name, sizeof(name), "stream, 1/%d lost", BENCH_NBP_LOSS);
+    Bench_NBP_print(name, &lossy, aircraft, seconds);
+    printf("  %-18s single/stream %.1fx, batch/stream %.1fx\n", "",
+           (double) single.bytes / stream.bytes, (double) batch.bytes / stream.bytes);
+
+    return batch.differ || stream.differ || lossy.differ || stream.decoded != stream.reports ||
+           batch.decoded != batch.reports ? EXIT_FAILURE : EXIT_SUCCESS;
+}
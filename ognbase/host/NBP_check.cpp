@@ -0,0 +1,277 @@
+/*
+ * NBP_check.cpp
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * nbp-check: batches of 0 .. 3 * NBP_BATCH_MAX aircraft through NBP.cpp
+ * the way RSM_ExportAircraftPosition() does it. Every datagram has to
+ * pass the flatbuffers verifier, fit into NBP_DATAGRAM_SIZE and carry
+ * the next sequence number, and every aircraft has to come back as it
+ * went in. Prints datagrams and bytes against one OneMessage per
+ * aircraft, UDP/IP headers included.
+ *
+ * Stream mode: export cycles of keyframes and deltas through NBP_Parse(),
+ * positions have to come back in 1/1000 arc minute, and after a lost
+ * datagram the receiver has to drop deltas instead of decoding them
+ * against the wrong reference.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../SoftRF.h"
+#include "../NBP.h"
+#include "../ogn_service_generated.h"
+
+#include "Checks.h"
+
+#define CHECK_NBP_UDP_IP    28      /* IPv4 and UDP header per datagram */
+#define CHECK_NBP_CALLSIGN  "OGNCHECK1"
+#define CHECK_NBP_START     1593600000UL
+
+using namespace ogn;
+
+static uint32_t check_sequence;
+
+static void Check_NBP_aircraft(ufo_t* fop, int i)
+{
+    memset(fop, 0, sizeof(*fop));
+    fop->addr          = 0xDD0000 + i * 0x0101;
+    fop->timestamp     = CHECK_NBP_START + i;
+    fop->latitude      = 47.1234 + 0.001 * i;
+    fop->longitude     = 8.5678 - 0.001 * i;
+    fop->altitude      = 1000 + i;
+    fop->course        = (i * 37) % 360;
+    fop->speed         = 50 + i;
+    fop->aircraft_type = i % 16;
+    fop->stealth       = i % 5 == 0;
+    fop->no_track      = i % 7 == 0;
+}
+
+static uint32_t Check_NBP_datagram(const uint8_t* buf, size_t size, int first, int* next)
+{
+    flatbuffers::Verifier verifier(buf, size);
+    uint32_t              failed = 0;
+
+    if (size > NBP_DATAGRAM_SIZE || !VerifyOneMessageBuffer(verifier))
+    {
+        printf("nbp-check: datagram %u, %zu bytes, does not verify\n", check_sequence, size);
+        return 1;
+    }
+
+    const OneMessage*    msg     = GetOneMessage(buf);
+    const StationHeader* station = msg->station();
+
+    if (!station || !msg->airc_list() || msg->airc_pos() ||
+        strcmp(station->callsign()->c_str(), CHECK_NBP_CALLSIGN) ||
+        station->sequence() != check_sequence++ || station->timestamp() != (int32_t) CHECK_NBP_START ||
+        station->alt() != 480)
+    {
+        printf("nbp-check: datagram %u, bad station header\n", check_sequence - 1);
+        return 1;
+    }
+
+    for (flatbuffers::uoffset_t n = 0; n < msg->airc_list()->size(); n++)
+    {
+        const AircraftPos* pos = msg->airc_list()->Get(n);
+        ufo_t              fo;
+
+        Check_NBP_aircraft(&fo, first + n);
+        if (pos->callsign() != (int32_t) fo.addr || pos->timestamp() != (int32_t) fo.timestamp ||
+            pos->lat() != fo.latitude || pos->lon() != fo.longitude || pos->alt() != (int32_t) fo.altitude ||
+            pos->heading() != (int32_t) fo.course || pos->speed() != (int32_t) fo.speed ||
+            pos->type() != fo.aircraft_type || pos->stealth() != fo.stealth || pos->notrack() != fo.no_track)
+        {
+            if (failed < 10)
+                printf("nbp-check: aircraft %d differs\n", first + n);
+            failed++;
+        }
+    }
+
+    *next = first + msg->airc_list()->size();
+    return failed;
+}
+
+/* the old export, one OneMessage with airc_pos per aircraft */
+static size_t Check_NBP_single(int aircraft)
+{
+    flatbuffers::FlatBufferBuilder builder;
+    size_t                         bytes = 0;
+
+    for (int i = 0; i < aircraft; i++)
+    {
+        ufo_t fo;
+
+        Check_NBP_aircraft(&fo, i);
+        AircraftPos pos(fo.addr, fo.timestamp, fo.aircraft_type, fo.stealth, fo.no_track,
+                        fo.course, fo.speed, fo.latitude, fo.longitude, fo.altitude);
+
+        builder.Clear();
+        builder.Finish(CreateOneMessage(builder, &pos));
+        bytes += builder.GetSize() + CHECK_NBP_UDP_IP;
+    }
+
+    return bytes;
+}
+
+static void Check_NBP_moving(ufo_t* fop, int i, int t)
+{
+    Check_NBP_aircraft(fop, i);
+    fop->addr_type  = i % 6;
+    fop->timestamp  = CHECK_NBP_START + t;
+    fop->latitude  += 0.0002 * t * (i % 3 - 1);
+    fop->longitude -= 0.0003 * t * (i % 5 - 2);
+    fop->altitude  += 2 * t * (i % 3) - 1000 * (i % 4 == 0);
+    fop->course     = (i * 37 + 7 * t) % 360;
+    fop->speed      = i % 4 ? 50 + t % 9 : 0;
+}
+
+/* cycle by cycle, datagram number lose never arrives */
+static uint32_t Check_NBP_stream(int aircraft, int cycles, int lose, uint32_t* decoded, uint32_t* dropped)
+{
+    static nbp_receiver_t rx;
+    static ufo_t          out[NBP_STREAM_SIZE];
+    uint32_t              failed = 0;
+    int                   datagram = 0;
+
+    NBP_Reset();
+    NBP_Receiver_Reset(&rx);
+    *decoded = 0;
+
+    for (int c = 0; c < cycles; c++)
+    {
+        const uint8_t* buf;
+        size_t         size;
+        int            t = c * 5;
+        ufo_t          fo;
+
+        NBP_Begin(CHECK_NBP_CALLSIGN, CHECK_NBP_START + t, 47.1f, 8.5f, 480, NBP_MODE_STREAM);
+        for (int i = 0; i <= aircraft; i++)
+        {
+            if (i < aircraft)
+                Check_NBP_moving(&fo, i, t);
+            if (i < aircraft && NBP_Add(&fo))
+                continue;
+            if (!NBP_Count())
+                break;
+
+            size = NBP_Finish(&buf);
+            if (size > NBP_DATAGRAM_SIZE)
+                failed++;
+            if (datagram++ != lose)
+            {
+                int n = NBP_Parse(&rx, buf, size, out, NBP_STREAM_SIZE, NULL, 0);
+
+                for (int k = 0; k < n; k++)
+                {
+                    ufo_t in;
+                    int   a = 0;
+
+                    while (a < aircraft && (Check_NBP_moving(&in, a, t), in.addr != out[k].addr))
+                        a++;
+                    if (a == aircraft || in.timestamp != out[k].timestamp || in.addr_type != out[k].addr_type ||
+                        NBP_Units(in.latitude) != NBP_Units(out[k].latitude) ||
+                        NBP_Units(in.longitude) != NBP_Units(out[k].longitude) ||
+                        (int32_t) in.altitude != (int32_t) out[k].altitude || (int32_t) in.course != out[k].course ||
+                        (int32_t) in.speed != out[k].speed || in.aircraft_type != out[k].aircraft_type ||
+                        in.stealth != out[k].stealth || in.no_track != out[k].no_track)
+                    {
+                        if (failed < 10)
+                            printf("nbp-check: stream, cycle %d, aircraft %06X differs\n", c, out[k].addr);
+                        failed++;
+                    }
+                }
+                *decoded += n > 0 ? n : 0;
+            }
+            if (i < aircraft)
+                NBP_Add(&fo);
+        }
+    }
+
+    *dropped = rx.dropped;
+    return failed;
+}
+
+int Check_NBP()
+{
+    static const int counts[] = { 0, 1, 2, 10, NBP_BATCH_MAX - 1, NBP_BATCH_MAX, NBP_BATCH_MAX + 1,
+                                  2 * NBP_BATCH_MAX, 3 * NBP_BATCH_MAX };
+    uint32_t failed = 0;
+
+    printf("nbp-check: %d aircraft per datagram of at most %d bytes\n", NBP_BATCH_MAX, NBP_DATAGRAM_SIZE);
+
+    check_sequence = 0;
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        const uint8_t* buf;
+        size_t         size;
+        int            aircraft = counts[c];
+        int            next = 0, first = 0;
+        uint32_t       datagrams = 0, bytes = 0;
+
+        NBP_Begin(CHECK_NBP_CALLSIGN, CHECK_NBP_START, 47.1f, 8.5f, 480, NBP_MODE_BATCH);
+        for (int i = 0; i < aircraft; i++)
+        {
+            ufo_t fo;
+
+            Check_NBP_aircraft(&fo, i);
+            if (!NBP_Add(&fo))
+            {
+                size = NBP_Finish(&buf);
+                failed += Check_NBP_datagram(buf, size, first, &next);
+                first   = next;
+                datagrams++;
+                bytes  += size + CHECK_NBP_UDP_IP;
+                NBP_Add(&fo);
+            }
+        }
+        if (NBP_Count())
+        {
+            size = NBP_Finish(&buf);
+            failed += Check_NBP_datagram(buf, size, first, &next);
+            datagrams++;
+            bytes += size + CHECK_NBP_UDP_IP;
+        }
+
+        if (next != aircraft)
+        {
+            printf("nbp-check: %d aircraft in, %d out\n", aircraft, next);
+            failed++;
+        }
+
+        printf("  %3d aircraft: %2u datagrams %6u bytes, one per aircraft %3d datagrams %6zu bytes\n",
+               aircraft, datagrams, bytes, aircraft, Check_NBP_single(aircraft));
+    }
+
+    uint32_t datagrams = NBP_stats.datagrams, decoded, dropped;
+    int      aircraft  = 3 * NBP_BATCH_MAX, cycles = 2 * NBP_STREAM_KEYFRAME / 5;
+
+    failed += Check_NBP_stream(aircraft, cycles, -1, &decoded, &dropped);
+    printf("  stream, %d aircraft, %d cycles: %u datagrams %u bytes, %u keyframes, %u decoded\n",
+           aircraft, cycles, NBP_stats.datagrams, NBP_stats.bytes, NBP_stats.keyframes, decoded);
+    if (decoded != (uint32_t) aircraft * cycles || dropped)
+        failed++;
+    datagrams += NBP_stats.datagrams;
+
+    failed += Check_NBP_stream(aircraft, cycles, 2, &decoded, &dropped);
+    printf("  stream, datagram 2 lost: %u decoded, %u deltas dropped\n", decoded, dropped);
+    if (!dropped || decoded + dropped >= (uint32_t) aircraft * cycles)
+        failed++;
+    datagrams += NBP_stats.datagrams;
+
+    printf("nbp-check: %u datagrams, %u failed\n", datagrams, failed);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
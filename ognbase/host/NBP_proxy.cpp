@@ -0,0 +1,733 @@
+/*
+ * NBP_proxy.cpp
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * nbp-proxy: NBP from many ground stations in, APRS out, for Linux.
+ *
+ * Datagrams are fetched PROXY_BATCH at a time with recvmmsg() and
+ * decoded with NBP_Parse(), any of the three layouts. Every station
+ * (source address and StationHeader callsign) has its own stream state.
+ * An aircraft heard by several stations is forwarded once per report
+ * timestamp, by the station that delivered it first. The lines come
+ * from OGN_APRS_Position(), the formatter of the firmware, and go out
+ * over one persistent APRS-IS connection, one send() per batch. The
+ * connection is opened again when it breaks and the queued lines go out
+ * over the new one. Dropped and counted are only lines that do not fit
+ * into the output buffer meanwhile, and the rest of a line the break
+ * cut in two.
+ *
+ *   nbp-proxy <udp port> [aprs-is host:port] [login]
+ *   nbp-proxy load <stations> <aircraft> <seconds> [batch|stream] [breaks]
+ *
+ * load replays synthetic station traffic through the proxy on loopback,
+ * as fast as it takes it, into a local stand-in for APRS-IS: each
+ * aircraft heard by PROXY_LOAD_OVERLAP stations, exported every
+ * PROXY_LOAD_EXPORT seconds. Every report has to come out exactly once.
+ * With breaks the stand-in hangs up that many times along the way, the
+ * sender waiting each time until the proxy has closed its end. The lines
+ * of the datagrams after that have to reach APRS-IS over a new
+ * connection, the proxy may lose no more than a cut line per break.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <signal.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+
+#include "../SoftRF.h"
+#include "../APRS.h"
+#include "../NBP.h"
+#include "../ogn_service_generated.h"
+
+#define PROXY_BATCH         64      /* datagrams per recvmmsg() */
+#define PROXY_DATAGRAM      2048
+#define PROXY_RCVBUF        (4 << 20)
+#define PROXY_OUT_SIZE      65536   /* APRS lines waiting for send() */
+#define PROXY_DEDUP_AGE     600     /* s an aircraft is remembered */
+#define PROXY_RECONNECT     10      /* s between connection attempts, none in load */
+#define PROXY_KEEPALIVE     240     /* s without a line until a comment goes out */
+#define PROXY_REPORT        60      /* s between statistics on stderr */
+#define PROXY_LOGIN         "NBPPROXY"
+
+#define PROXY_LOAD_OVERLAP  3       /* stations hearing each aircraft */
+#define PROXY_LOAD_EXPORT   5       /* s, APRS_EXPORT_AIRCRAFT */
+#define PROXY_LOAD_WINDOW   256     /* datagrams in flight to the proxy */
+#define PROXY_LOAD_START    1593600000UL
+
+typedef struct proxy_station
+{
+    char           callsign[NBP_CALLSIGN_SIZE];
+    nbp_receiver_t rx;
+    uint32_t       reports;
+    uint32_t       forwarded;
+} proxy_station_t;
+
+typedef struct proxy_stats
+{
+    uint32_t datagrams;
+    uint32_t batches;           /* recvmmsg() calls that returned datagrams */
+    uint32_t invalid;           /* not a OneMessage */
+    uint32_t reports;
+    uint32_t duplicates;        /* heard by another station first */
+    uint32_t lines;
+    uint32_t dropped;           /* no room while APRS-IS was away, or cut by a break */
+    uint64_t bytes;
+    uint32_t connects;
+} proxy_stats_t;
+
+static proxy_stats_t                                     proxy_stats;
+static std::unordered_map<std::string, proxy_station_t*> proxy_stations;
+static std::unordered_map<uint32_t, int32_t>             proxy_seen;     /* addr -> last timestamp forwarded */
+static int32_t                                           proxy_latest = 0;
+static ufo_t                                             proxy_out[NBP_STREAM_SIZE];
+
+static struct
+{
+    std::string host;
+    std::string port;
+    std::string login;
+    int         fd;
+    char        out[PROXY_OUT_SIZE];
+    size_t      len;
+    bool        cut;            /* out starts with the rest of a line partly sent */
+    int         reconnect;
+    time_t      retry;
+    time_t      last;
+} aprsis;
+
+static int Proxy_nonblock(int fd)
+{
+    return fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+static void Proxy_APRS_close()
+{
+    if (aprsis.fd >= 0)
+        close(aprsis.fd);
+    aprsis.fd    = -1;
+    aprsis.retry = time(NULL) + aprsis.reconnect;
+
+    /* the next connection starts with the login, not with half a line */
+    if (aprsis.cut)
+    {
+        char*  eol = (char *) memchr(aprsis.out, '\n', aprsis.len);
+        size_t n   = eol ? eol - aprsis.out + 1 : aprsis.len;
+
+        memmove(aprsis.out, aprsis.out + n, aprsis.len - n);
+        aprsis.len -= n;
+        aprsis.cut  = false;
+        proxy_stats.dropped++;
+    }
+}
+
+static bool Proxy_APRS_connect()
+{
+    struct addrinfo  hints, *res, *ai;
+    char             login[128];
+    int              len;
+
+    if (aprsis.fd >= 0)
+        return true;
+    if (aprsis.host.empty() || time(NULL) < aprsis.retry)
+        return false;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(aprsis.host.c_str(), aprsis.port.c_str(), &hints, &res))
+    {
+        aprsis.retry = time(NULL) + aprsis.reconnect;
+        return false;
+    }
+
+    for (ai = res; ai; ai = ai->ai_next)
+    {
+        aprsis.fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (aprsis.fd < 0)
+            continue;
+        if (!connect(aprsis.fd, ai->ai_addr, ai->ai_addrlen))
+            break;
+        close(aprsis.fd);
+        aprsis.fd = -1;
+    }
+    freeaddrinfo(res);
+
+    if (aprsis.fd < 0)
+    {
+        fprintf(stderr, "nbp-proxy: no connection to %s:%s\n", aprsis.host.c_str(), aprsis.port.c_str());
+        aprsis.retry = time(NULL) + aprsis.reconnect;
+        return false;
+    }
+
+    len = snprintf(login, sizeof(login), "user %s pass %d vers ognbase-proxy %s\r\n",
+                   aprsis.login.c_str(), AprsPasscode(aprsis.login.c_str()), SOFTRF_FIRMWARE_VERSION);
+    if (send(aprsis.fd, login, len, MSG_NOSIGNAL) != len)
+    {
+        Proxy_APRS_close();
+        return false;
+    }
+
+    Proxy_nonblock(aprsis.fd);
+    aprsis.last = time(NULL);
+    proxy_stats.connects++;
+    return true;
+}
+
+static void Proxy_APRS_flush()
+{
+    size_t done = 0;
+
+    if (!aprsis.len || !Proxy_APRS_connect())
+        return;
+
+    while (done < aprsis.len)
+    {
+        ssize_t n = send(aprsis.fd, aprsis.out + done, aprsis.len - done, MSG_NOSIGNAL);
+
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n <= 0)
+        {
+            fprintf(stderr, "nbp-proxy: APRS-IS connection lost\n");
+            Proxy_APRS_close();
+            return;
+        }
+        done += n;
+    }
+
+    if (done)
+        aprsis.cut = aprsis.out[done - 1] != '\n';
+    memmove(aprsis.out, aprsis.out + done, aprsis.len - done);
+    aprsis.len        -= done;
+    proxy_stats.bytes += done;
+    aprsis.last        = time(NULL);
+}
+
+static void Proxy_APRS_line(const char* line, size_t len)
+{
+    if (aprsis.len + len > sizeof(aprsis.out))
+        Proxy_APRS_flush();
+    if (aprsis.len + len > sizeof(aprsis.out))
+    {
+        proxy_stats.dropped++;
+        return;
+    }
+
+    memcpy(aprsis.out + aprsis.len, line, len);
+    aprsis.len += len;
+    proxy_stats.lines++;
+}
+
+/* the server talks too, logresp and keepalives, nobody listens */
+static void Proxy_APRS_read()
+{
+    char    buf[1024];
+    ssize_t n;
+
+    while ((n = recv(aprsis.fd, buf, sizeof(buf), 0)) > 0)
+        ;
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+    {
+        fprintf(stderr, "nbp-proxy: APRS-IS closed the connection\n");
+        Proxy_APRS_close();
+    }
+}
+
+static proxy_station_t* Proxy_station(const struct sockaddr_in* from, const char* callsign)
+{
+    char  key[64];
+    auto  it = proxy_stations.end();
+
+    snprintf(key, sizeof(key), "%s/%s", inet_ntoa(from->sin_addr), callsign);
+    it = proxy_stations.find(key);
+    if (it != proxy_stations.end())
+        return it->second;
+
+    proxy_station_t* st = new proxy_station_t;
+
+    memset(st, 0, sizeof(*st));
+    strncpy(st->callsign, callsign[0] ? callsign : PROXY_LOGIN, sizeof(st->callsign) - 1);
+    NBP_Receiver_Reset(&st->rx);
+    proxy_stations[key] = st;
+    return st;
+}
+
+static void Proxy_datagram(const uint8_t* buf, size_t size, const struct sockaddr_in* from)
+{
+    flatbuffers::Verifier verifier(buf, size);
+    const char*           callsign = "";
+    char                  line[APRS_PACKET_SIZE];
+
+    proxy_stats.datagrams++;
+
+    if (!ogn::VerifyOneMessageBuffer(verifier))
+    {
+        proxy_stats.invalid++;
+        return;
+    }
+
+    const ogn::StationHeader* header = ogn::GetOneMessage(buf)->station();
+
+    if (header && header->callsign())
+        callsign = header->callsign()->c_str();
+
+    proxy_station_t* st = Proxy_station(from, callsign);
+    int              n  = NBP_Parse(&st->rx, buf, size, proxy_out, NBP_STREAM_SIZE, NULL, 0);
+
+    for (int i = 0; i < n; i++)
+    {
+        ufo_t*   fop = &proxy_out[i];
+        int32_t& last = proxy_seen[fop->addr];
+
+        st->reports++;
+        proxy_stats.reports++;
+
+        if (last && (int32_t) fop->timestamp <= last)
+        {
+            proxy_stats.duplicates++;
+            continue;
+        }
+        last = fop->timestamp;
+        if (last > proxy_latest)
+            proxy_latest = last;
+
+        fop->rssi = -108;   /* not in NBP, 0.0dB */
+
+        size_t len = OGN_APRS_Position(line, sizeof(line), fop, st->callsign);
+        if (len)
+        {
+            Proxy_APRS_line(line, len);
+            st->forwarded++;
+        }
+    }
+}
+
+static void Proxy_expire()
+{
+    for (auto it = proxy_seen.begin(); it != proxy_seen.end(); )
+        if (proxy_latest - it->second > PROXY_DEDUP_AGE)
+            it = proxy_seen.erase(it);
+        else
+            ++it;
+}
+
+static void Proxy_report(FILE* fp)
+{
+    uint32_t lost = 0, dropped = 0;
+
+    for (auto it = proxy_stations.begin(); it != proxy_stations.end(); ++it)
+    {
+        lost    += it->second->rx.lost;
+        dropped += it->second->rx.dropped;
+    }
+
+    fprintf(fp, "nbp-proxy: %zu stations, %u datagrams in %u batches (%.1f each), %u invalid, %u lost, "
+                "%u reports, %u duplicates, %u deltas dropped, %u lines, %u not sent, %zu aircraft, %u connects\n",
+            proxy_stations.size(), proxy_stats.datagrams, proxy_stats.batches,
+            proxy_stats.batches ? (double) proxy_stats.datagrams / proxy_stats.batches : 0.0,
+            proxy_stats.invalid, lost, proxy_stats.reports, proxy_stats.duplicates, dropped,
+            proxy_stats.lines, proxy_stats.dropped, proxy_seen.size(), proxy_stats.connects);
+}
+
+static int Proxy_socket(const char* addr, int port)
+{
+    struct sockaddr_in sin;
+    int                fd  = socket(AF_INET, SOCK_DGRAM, 0);
+    int                buf = PROXY_RCVBUF;
+
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family      = AF_INET;
+    sin.sin_port        = htons(port);
+    sin.sin_addr.s_addr = inet_addr(addr);
+
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buf, sizeof(buf));
+    if (fd < 0 || bind(fd, (struct sockaddr *) &sin, sizeof(sin)))
+    {
+        perror("nbp-proxy: bind");
+        return -1;
+    }
+
+    Proxy_nonblock(fd);
+    return fd;
+}
+
+/* until *stop, or for ever */
+static void Proxy_loop(int fd, std::atomic<bool>* stop, std::atomic<uint32_t>* received)
+{
+    static uint8_t     buf[PROXY_BATCH][PROXY_DATAGRAM];
+    struct mmsghdr     msgs[PROXY_BATCH];
+    struct iovec       iov[PROXY_BATCH];
+    struct sockaddr_in from[PROXY_BATCH];
+    time_t             report = time(NULL) + PROXY_REPORT;
+    time_t             expire = time(NULL) + PROXY_DEDUP_AGE / 10;
+
+    while (!stop || !*stop)
+    {
+        struct pollfd pfd[2];
+        int           nfds = 1;
+
+        pfd[0].fd     = fd;
+        pfd[0].events = POLLIN;
+        if (aprsis.fd >= 0)
+        {
+            pfd[1].fd     = aprsis.fd;
+            pfd[1].events = POLLIN | (aprsis.len ? POLLOUT : 0);
+            nfds++;
+        }
+
+        if (poll(pfd, nfds, stop ? 10 : 1000) < 0 && errno != EINTR)
+            break;
+
+        for (;;)
+        {
+            for (int i = 0; i < PROXY_BATCH; i++)
+            {
+                iov[i].iov_base                = buf[i];
+                iov[i].iov_len                 = PROXY_DATAGRAM;
+                msgs[i].msg_hdr.msg_name       = &from[i];
+                msgs[i].msg_hdr.msg_namelen    = sizeof(from[i]);
+                msgs[i].msg_hdr.msg_iov        = &iov[i];
+                msgs[i].msg_hdr.msg_iovlen     = 1;
+                msgs[i].msg_hdr.msg_control    = NULL;
+                msgs[i].msg_hdr.msg_controllen = 0;
+                msgs[i].msg_hdr.msg_flags      = 0;
+            }
+
+            int n = recvmmsg(fd, msgs, PROXY_BATCH, MSG_DONTWAIT, NULL);
+            if (n <= 0)
+                break;
+
+            proxy_stats.batches++;
+            for (int i = 0; i < n; i++)
+                Proxy_datagram(buf[i], msgs[i].msg_len, &from[i]);
+            if (received)
+                *received += n;
+
+            Proxy_APRS_flush();
+            if (n < PROXY_BATCH)
+                break;
+        }
+
+        if (aprsis.fd >= 0 && nfds > 1 && pfd[1].revents & (POLLIN | POLLHUP | POLLERR))
+            Proxy_APRS_read();
+        Proxy_APRS_flush();
+
+        if (aprsis.fd >= 0 && !aprsis.len && time(NULL) - aprsis.last >= PROXY_KEEPALIVE)
+        {
+            static const char keepalive[] = "# ognbase-proxy\r\n";
+            memcpy(aprsis.out, keepalive, sizeof(keepalive) - 1);
+            aprsis.len = sizeof(keepalive) - 1;
+            Proxy_APRS_flush();
+        }
+
+        if (time(NULL) >= expire)
+        {
+            Proxy_expire();
+            expire = time(NULL) + PROXY_DEDUP_AGE / 10;
+        }
+        if (!stop && time(NULL) >= report)
+        {
+            Proxy_report(stderr);
+            report = time(NULL) + PROXY_REPORT;
+        }
+    }
+}
+
+/* load test */
+
+static void Proxy_load_aircraft(ufo_t* fop, int i, int t)
+{
+    memset(fop, 0, sizeof(*fop));
+    fop->addr          = 0x3E0000 + i * 0x0101;
+    fop->addr_type     = 1 + i % 2;
+    fop->aircraft_type = 1;
+    fop->timestamp     = PROXY_LOAD_START + t;
+    fop->latitude      = 47.0 + 0.004 * i + 0.0001 * t * cos(i);
+    fop->longitude     = 8.0 + 0.002 * i + 0.0001 * t * sin(i);
+    fop->altitude      = 800 + 5 * i + (t * (i % 5)) % 700;
+    fop->course        = (i * 29 + t) % 360;
+    fop->speed         = 40 + i % 60;
+}
+
+typedef struct proxy_load_link
+{
+    std::atomic<int>      fd;       /* connection the stand-in has accepted, -1 between */
+    std::atomic<uint32_t> closed;   /* connections the proxy has closed */
+    std::atomic<uint32_t> hangups;
+    std::atomic<uint64_t> lines;
+} proxy_load_link_t;
+
+/* the stand-in for APRS-IS, it reads every connection until the proxy closes it */
+static void Proxy_load_sink(int lfd, proxy_load_link_t* link)
+{
+    char    buf[16384];
+    ssize_t n;
+    int     fd;
+
+    while ((fd = accept(lfd, NULL, NULL)) >= 0)
+    {
+        link->fd = fd;
+        while ((n = recv(fd, buf, sizeof(buf), 0)) > 0)
+            for (ssize_t i = 0; i < n; i++)
+                if (buf[i] == '\n')
+                    link->lines++;
+        link->fd = -1;
+        close(fd);
+        link->closed++;
+    }
+}
+
+static void Proxy_load_send(int port, const std::vector<std::vector<uint8_t> >* datagrams,
+                            std::atomic<uint32_t>* received, int breaks, proxy_load_link_t* link)
+{
+    struct sockaddr_in to;
+    struct mmsghdr     msgs[PROXY_BATCH];
+    struct iovec       iov[PROXY_BATCH];
+    int                fd = socket(AF_INET, SOCK_DGRAM, 0);
+    size_t             sent = 0;
+    size_t             next = breaks ? datagrams->size() / (breaks + 1) : datagrams->size();
+
+    memset(&to, 0, sizeof(to));
+    to.sin_family      = AF_INET;
+    to.sin_port        = htons(port);
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    connect(fd, (struct sockaddr *) &to, sizeof(to));
+
+    while (sent < datagrams->size())
+    {
+        int n = 0;
+
+        /* APRS-IS hangs up once the proxy has taken all so far, the rest waits until it has noticed */
+        if (sent == next)
+        {
+            uint32_t closed = link->closed;
+
+            while (*received < sent)
+                std::this_thread::yield();
+            if (link->fd < 0)
+            {
+                next++;         /* no lines since the last one, no connection to break */
+                continue;
+            }
+            shutdown(link->fd, SHUT_WR);
+            while (link->closed == closed)
+                std::this_thread::yield();
+            link->hangups++;
+            next = (int) link->hangups < breaks ?
+                   std::max(next + 1, datagrams->size() * (link->hangups + 1) / (breaks + 1)) : datagrams->size();
+        }
+
+        /* no more in flight than the socket buffer takes, nothing gets lost on the way */
+        if (sent - *received >= PROXY_LOAD_WINDOW)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        for ( ; n < PROXY_BATCH && sent + n < next && sent + n - *received < PROXY_LOAD_WINDOW; n++)
+        {
+            iov[n].iov_base = (void *) (*datagrams)[sent + n].data();
+            iov[n].iov_len  = (*datagrams)[sent + n].size();
+            memset(&msgs[n].msg_hdr, 0, sizeof(msgs[n].msg_hdr));
+            msgs[n].msg_hdr.msg_iov    = &iov[n];
+            msgs[n].msg_hdr.msg_iovlen = 1;
+        }
+
+        n = sendmmsg(fd, msgs, n, 0);
+        if (n > 0)
+            sent += n;
+    }
+
+    close(fd);
+}
+
+static int Proxy_load(int stations, int aircraft, int seconds, uint8_t mode, int breaks)
+{
+    std::vector<std::vector<std::vector<uint8_t> > > per_cycle(seconds / PROXY_LOAD_EXPORT);
+    std::vector<std::vector<uint8_t> >               datagrams;
+    std::atomic<bool>                                stop(false);
+    std::atomic<uint32_t>                            received(0);
+    proxy_load_link_t                                link;
+    struct sockaddr_in                               sin;
+    socklen_t                                        len = sizeof(sin);
+    int                                              cycles = seconds / PROXY_LOAD_EXPORT;
+    uint64_t                                         bytes = 0;
+
+    /* every station encodes its own stream, one after the other */
+    for (int s = 0; s < stations; s++)
+    {
+        char callsign[NBP_CALLSIGN_SIZE];
+
+        snprintf(callsign, sizeof(callsign), "LOAD%03d", s);
+        NBP_Reset();
+
+        for (int c = 0; c < cycles; c++)
+        {
+            const uint8_t* buf;
+            size_t         size;
+            int            t = c * PROXY_LOAD_EXPORT;
+            ufo_t          fo;
+
+            NBP_Begin(callsign, PROXY_LOAD_START + t, 47.0f + 0.05f * s, 8.0f, 400, mode);
+            for (int i = 0; i < aircraft; i++)
+            {
+                if ((i - s + stations) % stations >= PROXY_LOAD_OVERLAP)
+                    continue;
+
+                Proxy_load_aircraft(&fo, i, t);
+                if (!NBP_Add(&fo))
+                {
+                    size = NBP_Finish(&buf);
+                    per_cycle[c].push_back(std::vector<uint8_t>(buf, buf + size));
+                    NBP_Add(&fo);
+                }
+            }
+            size = NBP_Finish(&buf);
+            per_cycle[c].push_back(std::vector<uint8_t>(buf, buf + size));
+        }
+    }
+
+    /* cycle after cycle, the way they would arrive */
+    for (int c = 0; c < cycles; c++)
+        for (size_t d = 0; d < per_cycle[c].size(); d++)
+        {
+            bytes += per_cycle[c][d].size();
+            datagrams.push_back(per_cycle[c][d]);
+        }
+
+    int fd = Proxy_socket("127.0.0.1", 0);
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family      = AF_INET;
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || bind(lfd, (struct sockaddr *) &sin, sizeof(sin)) || listen(lfd, 4) ||
+        getsockname(lfd, (struct sockaddr *) &sin, &len))
+        return EXIT_FAILURE;
+
+    char port[8];
+    snprintf(port, sizeof(port), "%u", ntohs(sin.sin_port));
+    aprsis.host  = "127.0.0.1";
+    aprsis.port  = port;
+    aprsis.login     = PROXY_LOGIN;
+    aprsis.reconnect = 0;
+
+    link.fd      = -1;
+    link.closed  = 0;
+    link.hangups = 0;
+    link.lines   = 0;
+    std::thread sink(Proxy_load_sink, lfd, &link);
+    Proxy_APRS_connect();
+
+    len = sizeof(sin);
+    getsockname(fd, (struct sockaddr *) &sin, &len);
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    std::thread sender(Proxy_load_send, ntohs(sin.sin_port), &datagrams, &received, breaks, &link);
+    std::thread watch([&]() {
+        while (received < datagrams.size())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        stop = true;
+    });
+
+    Proxy_loop(fd, &stop, &received);
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+    sender.join();
+    watch.join();
+    Proxy_APRS_flush();
+    Proxy_APRS_close();
+    shutdown(lfd, SHUT_RDWR);
+    sink.join();
+    close(lfd);
+    close(fd);
+
+    double   s        = std::chrono::duration<double>(t1 - t0).count();
+    uint32_t expected = (uint32_t) aircraft * cycles;
+    uint64_t arrived  = link.lines - proxy_stats.connects;   /* less the logins */
+
+    printf("nbp-proxy load: %d stations, %d aircraft each heard by %d, %d cycles, %s\n",
+           stations, aircraft, PROXY_LOAD_OVERLAP, cycles, mode == NBP_MODE_STREAM ? "stream" : "batch");
+    printf("  %zu datagrams, %llu bytes in %.3f s: %.0f datagrams/s, %.0f reports/s, %.1f MB/s\n",
+           datagrams.size(), (unsigned long long) bytes, s, datagrams.size() / s, proxy_stats.reports / s,
+           bytes / s / 1e6);
+    printf("  %u reports, %u duplicates, %u lines forwarded (%u expected), %llu received by APRS-IS\n",
+           proxy_stats.reports, proxy_stats.duplicates, proxy_stats.lines, expected,
+           (unsigned long long) arrived);
+    printf("  %u hangups, %u connects, %u lines cut\n", (uint32_t) link.hangups, proxy_stats.connects,
+           proxy_stats.dropped);
+    Proxy_report(stdout);
+
+    return proxy_stats.lines == expected && arrived + proxy_stats.dropped == expected &&
+           proxy_stats.dropped <= link.hangups && !proxy_stats.invalid ?
+           EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char* argv[])
+{
+    signal(SIGPIPE, SIG_IGN);
+    aprsis.fd        = -1;
+    aprsis.reconnect = PROXY_RECONNECT;
+
+    if (argc >= 5 && !strcmp(argv[1], "load"))
+        return Proxy_load(atoi(argv[2]), atoi(argv[3]), atoi(argv[4]),
+                          argc > 5 && !strcmp(argv[5], "batch") ? NBP_MODE_BATCH : NBP_MODE_STREAM,
+                          argc > 6 ? std::max(0, atoi(argv[6])) : 0);
+
+    if (argc >= 2 && atoi(argv[1]) > 0)
+    {
+        int fd = Proxy_socket("0.0.0.0", atoi(argv[1]));
+
+        if (fd < 0)
+            return EXIT_FAILURE;
+
+        if (argc > 2)
+        {
+            const char* colon = strrchr(argv[2], ':');
+
+            aprsis.host  = colon ? std::string(argv[2], colon - argv[2]) : argv[2];
+            aprsis.port  = colon ? colon + 1 : "14580";
+            aprsis.login = argc > 3 ? argv[3] : PROXY_LOGIN;
+        }
+
+        Proxy_loop(fd, NULL, NULL);
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stderr,
+            "usage: %s <udp port> [aprs-is host:port] [login]\n"
+            "       %s load <stations> <aircraft> <seconds> [batch|stream] [breaks]\n",
+            argv[0], argv[0]);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,497 @@
+/*
+ * Platform_Host.cpp
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * SoC_ops_t table and firmware globals for the host (Linux) build.
+ * Everything that would touch Wi-Fi, the display or flash is a no-op,
+ * APRS-IS and UDP traffic is only counted (and optionally written out).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#if defined(HOST_BUILD)
+
+#include <stdarg.h>
+#include <time.h>
+#include <SPI.h>
+
+#include "../SoC.h"
+#include "../EEPROM.h"
+#include "../RF.h"
+#include "../GNSS.h"
+#include "../Traffic.h"
+#include "../OLED.h"
+#include "../Battery.h"
+#include "../PNET.h"
+#include "../global.h"
+
+host_net_stats_t Host_net_stats;
+FILE*            Host_aprs_out = NULL;
+uint32_t         Host_tcp_rate = 0;
+
+HostSerial Serial;
+SPIClass   SPI;
+HostWiFi   WiFi;
+
+static unsigned long host_millis = 0;
+
+unsigned long millis(void)
+{
+    return host_millis;
+}
+
+unsigned long micros(void)
+{
+    return host_millis * 1000UL;
+}
+
+void delay(unsigned long ms)
+{
+    host_millis += ms;
+}
+
+void yield(void)
+{ }
+
+void Host_set_millis(unsigned long ms)
+{
+    host_millis = ms;
+}
+
+uint32_t Host_cycles(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) (ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+long random(long howbig)
+{
+    return howbig > 0 ? ::random() % howbig : 0;
+}
+
+long random(long howsmall, long howbig)
+{
+    return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed)
+{
+    srandom(seed);
+}
+
+size_t HostSerial::emit(const char* fmt, ...)
+{
+    va_list args;
+    int     rval = 0;
+
+    if (enabled)
+    {
+        va_start(args, fmt);
+        rval = vfprintf(stderr, fmt, args);
+        va_end(args);
+    }
+    return rval > 0 ? rval : 0;
+}
+
+size_t HostSerial::printf(const char* fmt, ...)
+{
+    va_list args;
+    int     rval = 0;
+
+    if (enabled)
+    {
+        va_start(args, fmt);
+        rval = vfprintf(stderr, fmt, args);
+        va_end(args);
+    }
+    return rval > 0 ? rval : 0;
+}
+
+/* ognbase.ino */
+ufo_t           ThisAircraft;
+hardware_info_t hw_info = {
+    .model    = DEFAULT_SOFTRF_MODEL,
+    .revision = 0,
+    .soc      = SOC_NONE,
+    .rf       = RF_IC_NONE,
+    .gnss     = GNSS_MODULE_NONE,
+    .baro     = 0,
+    .display  = 0,
+#if defined(ENABLE_AHRS)
+    .ahrs     = 0,
+#endif /* ENABLE_AHRS */
+};
+
+/* EEPROM.cpp */
+static settings_t host_settings = {
+    .mode          = SOFTRF_MODE_GROUND,
+    .aircraft_type = AIRCRAFT_TYPE_GLIDER,
+    .txpower       = RF_TX_POWER_FULL,
+    .volume        = 0,
+    .led_num       = 0,
+    .pointer       = 0,
+    .nmea_g        = false,
+    .nmea_p        = false,
+    .nmea_l        = false,
+    .nmea_s        = false,
+    .resvd1        = false,
+    .nmea_out      = 0,
+    .bluetooth     = 0,
+    .alarm         = TRAFFIC_ALARM_DISTANCE,
+    .stealth       = false,
+    .no_track      = false,
+    .gdl90         = 0,
+    .d1090         = 0,
+    .json          = 0,
+    .power_save    = 0,
+    .freq_corr     = 0,
+};
+settings_t* settings = &host_settings;
+
+/* GNSS.cpp */
+TinyGPSPlus            gnss;
+volatile unsigned long PPS_TimeMarker = 0;
+
+/* config.cpp */
+String   ogn_ssid[5];
+String   ogn_wpass[5];
+int      ssid_index           = 0;
+String   ogn_callsign         = "OGNHOST";
+String   ogn_server           = "aprs.glidernet.org";
+uint16_t ogn_port             = 14580;
+uint8_t  ogn_band             = RF_BAND_EU;
+uint8_t  ogn_protocol_1       = RF_PROTOCOL_LEGACY;
+uint8_t  ogn_protocol_2       = RF_PROTOCOL_OGNTP;
+bool     ogn_debug            = false;
+uint16_t ogn_debugport        = 12000;
+bool     ogn_itrackbit        = false;
+bool     ogn_istealthbit      = false;
+uint16_t ogn_range            = 100;
+bool     ogn_aprs_stream      = false;
+uint16_t ogn_aprs_interval    = 1000;
+bool     ogn_sleepmode        = false;
+uint16_t ogn_rxidle           = 3600;
+uint16_t ogn_wakeuptimer      = 3600;
+float    ogn_lat              = 0;
+float    ogn_lon              = 0;
+int      ogn_alt              = 0;
+int16_t  ogn_geoid_separation = 0;
+uint8_t  largest_range        = 0;
+bool     fanet_enable         = false;
+bool     zabbix_enable        = false;
+String   zabbix_server        = "127.0.0.1";
+uint16_t zabbix_port          = 10051;
+String   zabbix_key           = "ogn_base";
+bool     beers_show           = false;
+bool     remotelogs_enable    = false;
+String   remotelogs_server    = "127.0.0.1";
+uint16_t remotelogs_port      = 12000;
+unsigned long oled_disable    = 0;
+bool     testmode_enable      = false;
+bool     private_network      = false;
+bool     new_protocol_enable  = false;
+String   new_protocol_server  = "127.0.0.1";
+uint32_t new_protocol_port    = 12002;
+bool     new_protocol_stream  = false;
+bool     ognrelay_enable      = false;
+bool     ognrelay_base        = false;
+
+/* OLED.cpp */
+byte OLED_setup(void)
+{
+    return 0;
+}
+
+void OLED_write(char* text, short x, short y, bool clear)
+{ }
+
+void OLED_clear(void)
+{ }
+
+void OLED_bar(uint8_t bar, uint8_t val)
+{ }
+
+void OLED_info(bool ntp)
+{ }
+
+void OLED_update(void)
+{ }
+
+void OLED_disable(void)
+{ }
+
+void OLED_enable(void)
+{ }
+
+void OLED_draw_Bitmap(int16_t x, int16_t y, uint8_t bm, bool clear)
+{ }
+
+/* Battery.cpp */
+float Battery_voltage(void)
+{
+    return 4.2;
+}
+
+/* PNET.cpp */
+void aes_init()
+{ }
+
+void PNETencrypt(unsigned char msg[], size_t msgLen, char** arr, size_t* arr_len)
+{
+    *arr     = NULL;
+    *arr_len = 0;
+}
+
+void PNETdecrypt(unsigned char msg[], size_t msgLen, char** arr, size_t* arr_len)
+{
+    *arr     = NULL;
+    *arr_len = 0;
+}
+
+static void Host_setup()
+{
+    randomSeed(0x4F474E);
+}
+
+static void Host_loop()
+{ }
+
+static void Host_fini()
+{ }
+
+static void Host_reset()
+{
+    exit(EXIT_FAILURE);
+}
+
+static uint32_t Host_getChipId()
+{
+    return 0x00DDEEFF;
+}
+
+static void* Host_getResetInfoPtr()
+{
+    return NULL;
+}
+
+static String Host_getResetInfo()
+{
+    return String("Host");
+}
+
+static String Host_getResetReason()
+{
+    return String("Power on");
+}
+
+static uint32_t Host_getFreeHeap()
+{
+    return 200 * 1024;
+}
+
+static long Host_random(long howsmall, long howBig)
+{
+    return random(howsmall, howBig);
+}
+
+static uint32_t Host_maxSketchSpace()
+{
+    return 0;
+}
+
+static void Host_WiFi_setOutputPower(int dB)
+{ }
+
+static void Host_WiFi_transmit_UDP(const char* host, int port, byte* buf, size_t size)
+{
+    Host_net_stats.udp_datagrams++;
+    Host_net_stats.udp_bytes += size;
+}
+
+static void Host_WiFi_transmit_UDP_debug(int port, byte* buf, size_t size)
+{ }
+
+static int Host_WiFi_connect_TCP(const char* host, int port)
+{
+    return 1;
+}
+
+static int Host_WiFi_disconnect_TCP()
+{
+    return 0;
+}
+
+static int Host_WiFi_transmit_TCP(String message)
+{
+    Host_net_stats.tcp_writes++;
+    Host_net_stats.tcp_bytes += message.length();
+
+    if (Host_aprs_out)
+        fputs(message.c_str(), Host_aprs_out);
+    return 0;
+}
+
+/* a socket draining Host_tcp_rate bytes per (virtual) second, 0 = as fast as asked */
+static int Host_WiFi_send_TCP(const char* buf, size_t size)
+{
+    static unsigned long last_ms = 0;
+    static uint32_t      credit  = 0;
+
+    if (Host_tcp_rate)
+    {
+        credit += (millis() - last_ms) * Host_tcp_rate / 1000;
+        if (credit > HOST_TCP_SNDBUF)
+            credit = HOST_TCP_SNDBUF;
+        last_ms = millis();
+
+        if (size > credit)
+            size = credit;
+        credit -= size;
+    }
+
+    if (size == 0)
+        return 0;
+
+    Host_net_stats.tcp_writes++;
+    Host_net_stats.tcp_bytes += size;
+
+    if (Host_aprs_out)
+        fwrite(buf, 1, size, Host_aprs_out);
+    return size;
+}
+
+static int Host_WiFi_receive_TCP(char* RXbuffer, int RXbuffer_size)
+{
+    return 0;
+}
+
+static int Host_WiFi_isconnected_TCP()
+{
+    return 1;
+}
+
+static void Host_WiFiUDP_stopAll()
+{ }
+
+static bool Host_WiFi_hostname(String aHostname)
+{
+    return true;
+}
+
+static int Host_WiFi_clients_count()
+{
+    return -1;
+}
+
+static bool Host_EEPROM_begin(size_t size)
+{
+    return true;
+}
+
+static void Host_SPI_begin()
+{ }
+
+static void Host_swSer_begin(unsigned long baud)
+{ }
+
+static void Host_swSer_enableRx(boolean arg)
+{ }
+
+static void Host_Battery_setup()
+{ }
+
+static float Host_Battery_voltage()
+{
+    return Battery_voltage();
+}
+
+static void Host_GNSS_PPS_handler()
+{ }
+
+static unsigned long Host_get_PPS_TimeMarker()
+{
+    return PPS_TimeMarker;
+}
+
+static void Host_UATSerial_begin(unsigned long baud)
+{ }
+
+static void Host_UATModule_restart()
+{ }
+
+static void Host_WDT_setup()
+{ }
+
+static void Host_WDT_fini()
+{ }
+
+static void Host_Button_setup()
+{ }
+
+static void Host_Button_loop()
+{ }
+
+static void Host_Button_fini()
+{ }
+
+const SoC_ops_t Host_ops = {
+    SOC_NONE,
+    "Host",
+    Host_setup,
+    Host_loop,
+    Host_fini,
+    Host_reset,
+    Host_getChipId,
+    Host_getResetInfoPtr,
+    Host_getResetInfo,
+    Host_getResetReason,
+    Host_getFreeHeap,
+    Host_random,
+    Host_maxSketchSpace,
+    Host_WiFi_setOutputPower,
+    Host_WiFi_transmit_UDP,
+    Host_WiFi_transmit_UDP_debug,
+    Host_WiFi_connect_TCP,
+    Host_WiFi_disconnect_TCP,
+    Host_WiFi_transmit_TCP,
+    Host_WiFi_send_TCP,
+    Host_WiFi_receive_TCP,
+    Host_WiFi_isconnected_TCP,
+    Host_WiFi_connect_TCP,
+    Host_WiFi_disconnect_TCP,
+    Host_WiFi_transmit_TCP,
+    Host_WiFi_receive_TCP,
+    Host_WiFi_isconnected_TCP,
+    Host_WiFiUDP_stopAll,
+    Host_WiFi_hostname,
+    Host_WiFi_clients_count,
+    Host_EEPROM_begin,
+    Host_SPI_begin,
+    Host_swSer_begin,
+    Host_swSer_enableRx,
+    Host_Battery_setup,
+    Host_Battery_voltage,
+    Host_GNSS_PPS_handler,
+    Host_get_PPS_TimeMarker,
+    Host_UATSerial_begin,
+    Host_UATModule_restart,
+    Host_WDT_setup,
+    Host_WDT_fini,
+    Host_Button_setup,
+    Host_Button_loop,
+    Host_Button_fini
+};
+
+#endif /* HOST_BUILD */
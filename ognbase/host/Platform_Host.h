@@ -0,0 +1,85 @@
+/*
+ * Platform_Host.h
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#if defined(HOST_BUILD)
+
+#ifndef PLATFORM_HOST_H
+#define PLATFORM_HOST_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* Same limit as on the ESP32 so that replays reflect the device */
+#define MAX_TRACKING_OBJECTS    15
+
+#define DEFAULT_SOFTRF_MODEL    SOFTRF_MODEL_STANDALONE
+
+#define SerialOutput            Serial
+#define EEPROM_commit()         do { } while (0)
+
+#define isValidFix()            isValidGNSSFix()
+
+/* unlike millis() real time, Host_cycles() counts ns */
+#define CycleCount()            Host_cycles()
+#define CyclesPerMicro()        1000
+
+uint32_t Host_cycles(void);
+
+/* station mode, always connected */
+typedef enum
+{
+    WL_CONNECTED = 3,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum
+{
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP  = 2
+} wifi_mode_t;
+
+class HostWiFi
+{
+  public:
+    wl_status_t status(void) { return WL_CONNECTED; }
+    wifi_mode_t getMode(void) { return WIFI_STA; }
+    bool mode(wifi_mode_t m) { return true; }
+    bool disconnect(bool wifioff = false) { return true; }
+};
+
+extern HostWiFi WiFi;
+
+/* what the stand-in WiFi_* SoC ops have been asked to send */
+typedef struct host_net_stats_struct
+{
+    uint32_t tcp_writes;
+    uint32_t tcp_bytes;
+    uint32_t udp_datagrams;
+    uint32_t udp_bytes;
+} host_net_stats_t;
+
+/* lwIP TCP_SND_BUF on the ESP32 */
+#define HOST_TCP_SNDBUF         5744
+
+extern host_net_stats_t Host_net_stats;
+extern FILE*            Host_aprs_out;
+extern uint32_t         Host_tcp_rate;  /* APRS-IS socket bytes/s, 0 = unlimited */
+
+#endif /* PLATFORM_HOST_H */
+
+#endif /* HOST_BUILD */
@@ -0,0 +1,255 @@
+/*
+ * RELAY_check.cpp
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * relay-check: an ognrelay in the EU band hears RELAY_CHECK_AIRCRAFT
+ * Legacy aircraft for RELAY_CHECK_SECONDS, some directly, some from an
+ * upstream relay with a hop count already set. Every frame goes through
+ * RELAY_Enqueue() as in ParseData(), RELAY_Loop() runs every
+ * RELAY_CHECK_LOOP_MS as in loop().
+ *
+ * What the radio sends has to decode, carry one hop more than it came
+ * with, never more than RELAY_MAX_HOPS, be no older than
+ * RELAY_MAX_AGE_MS, and all of it has to fit the duty cycle. Weak frames
+ * have to go out more often than strong ones. The hop count of OGNTP has
+ * to leave a valid FEC, and DEDUP has to take copies that differ in the
+ * hop count only for duplicates.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+
+#include "../SoftRF.h"
+#include "../RF.h"
+#include "../RELAY.h"
+#include "../DEDUP.h"
+#include "../Protocol_Legacy.h"
+#include "../global.h"
+
+#include <ldpc.h>
+
+#include "Checks.h"
+
+#define RELAY_CHECK_AIRCRAFT    40
+#define RELAY_CHECK_SECONDS     3600
+#define RELAY_CHECK_LOOP_MS     20
+#define RELAY_CHECK_START       1593600000UL
+#define RELAY_CHECK_LAT         47.1234
+#define RELAY_CHECK_LON         8.5678
+
+typedef struct
+{
+    uint32_t timestamp;         /* of the frame queued last */
+    int8_t   rssi;
+    uint8_t  hops;              /* after this relay */
+    uint32_t heard;
+    uint32_t sent;
+} check_aircraft_t;
+
+static uint32_t Check_RELAY_fec()
+{
+    uint8_t  pkt[MAX_PKT_SIZE];
+    uint32_t failed = 0;
+
+    for (int n = 0; n < 1000; n++)
+    {
+        size_t size = OGNTP_PAYLOAD_SIZE;
+
+        for (size_t i = 0; i < size; i++)
+            pkt[i] = random(256);
+        pkt[3] &= ~0x30;
+
+        uint8_t hops = 1 + n % 3;
+        if (!RELAY_SetHops(RF_PROTOCOL_OGNTP, pkt, &size, hops) ||
+            size != OGNTP_PAYLOAD_SIZE + 6 || LDPC_Check(pkt) != 0 ||
+            RELAY_Hops(RF_PROTOCOL_OGNTP, pkt) != hops)
+            failed++;
+    }
+    if (failed)
+        printf("relay-check: %u OGNTP frames with a bad FEC or hop count\n", failed);
+    return failed;
+}
+
+static uint32_t Check_RELAY_dedup()
+{
+    ufo_t           fo;
+    legacy_packet_t pkt;
+    size_t          size = sizeof(pkt);
+    uint32_t        failed = 0;
+
+    memset(&fo, 0, sizeof(fo));
+    fo.addr      = 0xDD1234;
+    fo.timestamp = RELAY_CHECK_START;
+    fo.latitude  = RELAY_CHECK_LAT;
+    fo.longitude = RELAY_CHECK_LON;
+    legacy_encode(&pkt, &fo);
+
+    DEDUP_Reset();
+    if (DEDUP_Check(RF_PROTOCOL_LEGACY, (uint8_t *) &pkt, size, DEDUP_DIRECT, 1000))
+        failed++;
+    RELAY_SetHops(RF_PROTOCOL_LEGACY, (uint8_t *) &pkt, &size, 2);
+    if (!DEDUP_Check(RF_PROTOCOL_LEGACY, (uint8_t *) &pkt, size, DEDUP_RELAY, 1100))
+        failed++;
+    if (failed)
+        printf("relay-check: relayed copy not taken for a duplicate\n");
+    return failed;
+}
+
+int Check_RELAY()
+{
+    std::map<uint32_t, check_aircraft_t> aircraft;
+    uint8_t                              frame[MAX_LEN_FRAME];
+    uint32_t                             failed = 0, too_many_hops = 0;
+    ufo_t                                this_aircraft, fo;
+    uint64_t                             airtime_us = 0;
+
+    ogn_protocol_1 = RF_PROTOCOL_LEGACY;
+    ogn_protocol_2 = RF_PROTOCOL_LEGACY;
+    if (RF_setup() == RF_IC_NONE)
+    {
+        printf("relay-check: no radio\n");
+        return EXIT_FAILURE;
+    }
+    RF_loop();
+    RF_FreqPlan.setPlan(RF_BAND_EU);
+    RELAY_Reset();
+
+    memset(&this_aircraft, 0, sizeof(this_aircraft));
+    this_aircraft.latitude  = RELAY_CHECK_LAT;
+    this_aircraft.longitude = RELAY_CHECK_LON;
+
+    for (uint32_t ms = 0; ms < RELAY_CHECK_SECONDS * 1000UL; ms += RELAY_CHECK_LOOP_MS)
+    {
+        Host_set_millis(ms);
+
+        /* loop(): the radio finishes the last TX and listens again */
+        RF_Receive();
+
+        /* every aircraft once a second, at its own time */
+        for (int i = 0; i < RELAY_CHECK_AIRCRAFT; i++)
+        {
+            if ((ms + i * 97) % 1000 >= RELAY_CHECK_LOOP_MS)
+                continue;
+
+            uint32_t        addr     = 0xDD0000 + i;
+            bool            upstream = i % 4 == 0;
+            uint8_t         hops     = upstream ? i / 4 % 3 : 0;
+            legacy_packet_t pkt;
+            ufo_t           tx;
+            size_t          size = sizeof(pkt);
+
+            memset(&tx, 0, sizeof(tx));
+            tx.addr          = addr;
+            tx.addr_type     = ADDR_TYPE_FLARM;
+            tx.timestamp     = RELAY_CHECK_START + ms / 1000;
+            tx.latitude      = RELAY_CHECK_LAT + 0.001 * i;
+            tx.longitude     = RELAY_CHECK_LON;
+            tx.altitude      = 1000 + i;
+            tx.aircraft_type = AIRCRAFT_TYPE_GLIDER;
+            legacy_encode(&pkt, &tx);
+            if (upstream)
+                RELAY_SetHops(RF_PROTOCOL_LEGACY, (uint8_t *) &pkt, &size, hops);
+
+            check_aircraft_t* a = &aircraft[addr];
+            a->rssi = i % 2 ? -100 : -60;
+            if (RELAY_Enqueue(RF_PROTOCOL_LEGACY, (uint8_t *) &pkt, size, a->rssi,
+                              upstream ? RF_RELAY_CHANNEL : 0, ms))
+            {
+                a->timestamp = tx.timestamp;
+                a->hops      = hops + 1;
+                a->heard++;
+            }
+            else if (hops < RELAY_MAX_HOPS)
+                failed++;
+        }
+
+        if (!RELAY_Loop(ms))
+            continue;
+
+        size_t len = Host_radio_drain_tx(frame, sizeof(frame));
+        if (len < sizeof(legacy_packet_t))
+        {
+            failed++;
+            continue;
+        }
+        airtime_us += RF_Airtime(RF_PROTOCOL_LEGACY, sizeof(legacy_packet_t));
+
+        uint32_t          addr = DEDUP_Address(RF_PROTOCOL_LEGACY, frame);
+        check_aircraft_t* a    = &aircraft[addr];
+        uint8_t           hops = RELAY_Hops(RF_PROTOCOL_LEGACY, frame);
+
+        this_aircraft.timestamp = a->timestamp;
+        if (!a->heard || hops != a->hops || !legacy_decode(frame, &this_aircraft, &fo) ||
+            RELAY_CHECK_START + ms / 1000 - a->timestamp > RELAY_MAX_AGE_MS / 1000 + 1)
+        {
+            if (failed < 10)
+                printf("relay-check: frame of %06X with %u hops at %u ms\n", addr, hops, ms);
+            failed++;
+        }
+        if (hops > RELAY_MAX_HOPS)
+            too_many_hops++;
+        a->sent++;
+    }
+
+    /* what a 1% duty cycle allows, plus the burst the budget starts with */
+    uint64_t allowed_us = RELAY_CHECK_SECONDS * 1000ULL * RELAY_stats.duty + RELAY_BURST_MS * 1000ULL;
+    uint32_t weak_heard = 0, weak_sent = 0, strong_heard = 0, strong_sent = 0;
+
+    for (std::map<uint32_t, check_aircraft_t>::iterator it = aircraft.begin(); it != aircraft.end(); it++)
+        if (it->second.hops == 1)
+        {
+            if (it->second.rssi < RELAY_RSSI_WEAK)
+            {
+                weak_heard += it->second.heard;
+                weak_sent  += it->second.sent;
+            }
+            else
+            {
+                strong_heard += it->second.heard;
+                strong_sent  += it->second.sent;
+            }
+        }
+
+    printf("relay-check: %d aircraft, %d s, %u permille duty\n",
+           RELAY_CHECK_AIRCRAFT, RELAY_CHECK_SECONDS, RELAY_stats.duty);
+    printf("  queued %u, superseded %u, dropped %u, expired %u, hop limit %u, deferred %u\n",
+           RELAY_stats.queued, RELAY_stats.superseded, RELAY_stats.dropped, RELAY_stats.expired,
+           RELAY_stats.hop_limit, RELAY_stats.deferred);
+    printf("  sent %u, %.1f s on air of %.1f s allowed\n", RELAY_stats.sent,
+           airtime_us / 1e6, allowed_us / 1e6);
+    printf("  direct frames sent: weak %.1f%%, strong %.1f%%\n",
+           weak_heard ? 100.0 * weak_sent / weak_heard : 0,
+           strong_heard ? 100.0 * strong_sent / strong_heard : 0);
+
+    printf("  radio: %u frames, %u refused on air, %.1f s airtime\n",
+           RF_tx_stats.frames, RF_tx_stats.busy, RF_tx_stats.airtime_ms / 1000.0);
+
+    if (airtime_us > allowed_us || !RELAY_stats.sent || too_many_hops)
+        failed++;
+    if (RF_tx_stats.frames != RELAY_stats.sent || RF_tx_stats.busy)
+        failed++;
+    if (weak_sent * (uint64_t) strong_heard <= strong_sent * (uint64_t) weak_heard)
+        failed++;
+
+    failed += Check_RELAY_fec();
+    failed += Check_RELAY_dedup();
+
+    printf("relay-check: %u failed\n", failed);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,235 @@
+/*
+ * Radio_Host.cpp
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * Host (Linux) stand-in for the LMIC radio: a one frame "air" for the
+ * receiver, a capture buffer for the transmitter and a tiny job queue
+ * that os_runstep() drains the same way the LMIC scheduler does.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+#include <hal/hal.h>
+
+struct lmic_t      LMIC;
+struct lmic_pinmap lmic_pins = {
+    .nss  = 18,
+    .txe  = LMIC_UNUSED_PIN,
+    .rxe  = LMIC_UNUSED_PIN,
+    .rst  = 14,
+    .dio  = {26, LMIC_UNUSED_PIN, LMIC_UNUSED_PIN},
+    .busy = LMIC_UNUSED_PIN,
+    .tcxo = LMIC_UNUSED_PIN,
+};
+
+const SX12XX_ops_t  sx127x_ll_ops = { 0x12 };
+const SX12XX_ops_t  sx126x_ll_ops = { 0x26 };
+const SX12XX_ops_t* SX12XX_LL     = NULL;
+
+#define HOST_JOBS 4
+
+static struct osjob_t* jobs[HOST_JOBS];
+static uint8_t         jobs_cnt = 0;
+
+static bool   rx_armed = false;
+static bool   rx_ready = false;
+static u1_t   rx_frame[MAX_LEN_FRAME];
+static size_t rx_len  = 0;
+static s1_t   rx_rssi = 0;
+
+static u1_t   tx_frame[MAX_LEN_FRAME];
+static size_t tx_len = 0;
+
+static u1_t spi_addr = 0;
+
+/*
+ * rxfsk() in radio-sx127x.c: a full start writes 31 registers, with the
+ * modem setup of the protocol still in place 7 (op mode twice, frequency,
+ * DIO mapping, RX). About 4 us each at the 8 MHz SPI clock of the ESP32
+ * builds, chip select and call overhead included.
+ */
+#define HOST_RADIO_REG_US       4
+#define HOST_RADIO_FULL_REGS    31
+#define HOST_RADIO_FAST_REGS    7
+
+host_radio_stats_t Host_radio_stats;
+
+static const rf_proto_desc_t* rx_config = NULL;   /* modem setup in the registers */
+
+rps_t LMIC_updr2rps(u1_t dr)
+{
+    /* BW125 for all of DR_SF12..DR_SF7, BW250 for DR_SF7B, FSK otherwise */
+    static const rps_t dr2rps[] = { 6, 5, 4, 3, 2, 1, 1 | (1 << 2), 0 };
+    return dr < sizeof(dr2rps) / sizeof(dr2rps[0]) ? dr2rps[dr] : 0;
+}
+
+void LMIC_reset(void)
+{
+    const rf_proto_desc_t* protocol = LMIC.protocol;
+
+    memset(&LMIC, 0, sizeof(LMIC));
+    LMIC.protocol = protocol;
+}
+
+void LMIC_shutdown(void)
+{
+    rx_armed = false;
+    jobs_cnt = 0;
+}
+
+void os_init(void* unused)
+{
+    rx_config = NULL;
+    memset(&LMIC, 0, sizeof(LMIC));
+    jobs_cnt = 0;
+    rx_armed = rx_ready = false;
+}
+
+ostime_t os_getTime(void)
+{
+    return ms2osticks(millis());
+}
+
+void os_setCallback(struct osjob_t* job, osjobcb_t cb)
+{
+    os_clearCallback(job);
+    job->func = cb;
+    if (jobs_cnt < HOST_JOBS)
+        jobs[jobs_cnt++] = job;
+}
+
+void os_clearCallback(struct osjob_t* job)
+{
+    for (uint8_t i = 0; i < jobs_cnt; i++)
+        if (jobs[i] == job)
+        {
+            memmove(&jobs[i], &jobs[i + 1], (jobs_cnt - i - 1) * sizeof(jobs[0]));
+            jobs_cnt--;
+            break;
+        }
+}
+
+void os_radio(u1_t mode)
+{
+    switch (mode)
+    {
+        case RADIO_RST:
+            rx_armed = false;
+            break;
+        case RADIO_TX:
+            rx_config = NULL;
+            tx_len = LMIC.dataLen;
+            memcpy(tx_frame, LMIC.frame, tx_len);
+            /* TX completes "instantly", completion is reported from os_runstep() */
+            os_setCallback(&LMIC.osjob, LMIC.osjob.func);
+            break;
+        case RADIO_RX:
+        case RADIO_RXON:
+            rx_armed = true;
+            Host_radio_stats.rx_starts++;
+            if (rx_config != LMIC.protocol)
+            {
+                rx_config = LMIC.protocol;
+                Host_radio_stats.rx_configs++;
+                Host_radio_stats.spi_us += HOST_RADIO_FULL_REGS * HOST_RADIO_REG_US;
+            }
+            else
+                Host_radio_stats.spi_us += HOST_RADIO_FAST_REGS * HOST_RADIO_REG_US;
+            break;
+        default:
+            break;
+    }
+}
+
+void os_runstep(void)
+{
+    if (jobs_cnt > 0)
+    {
+        struct osjob_t* job = jobs[0];
+
+        memmove(&jobs[0], &jobs[1], (jobs_cnt - 1) * sizeof(jobs[0]));
+        jobs_cnt--;
+
+        if (job->func)
+            job->func(job);
+        return;
+    }
+
+    if (rx_armed && rx_ready)
+    {
+        /* radio goes to SLEEP after RxDone, like the SX1276 IRQ handler */
+        rx_armed = rx_ready = false;
+
+        memcpy(LMIC.frame, rx_frame, rx_len);
+        LMIC.dataLen = rx_len;
+        LMIC.rssi    = rx_rssi;
+
+        if (LMIC.osjob.func)
+            LMIC.osjob.func(&LMIC.osjob);
+    }
+}
+
+void Host_radio_inject(const u1_t* frame, size_t len, s1_t rssi)
+{
+    if (len > sizeof(rx_frame))
+        len = sizeof(rx_frame);
+
+    memcpy(rx_frame, frame, len);
+    rx_len   = len;
+    rx_rssi  = rssi;
+    rx_ready = true;
+}
+
+bool Host_radio_pending(void)
+{
+    return rx_ready;
+}
+
+size_t Host_radio_drain_tx(u1_t* buf, size_t size)
+{
+    size_t len = tx_len < size ? tx_len : size;
+
+    memcpy(buf, tx_frame, len);
+    tx_len = 0;
+    return len;
+}
+
+void hal_init(void* unused)
+{ }
+
+void hal_pin_rst(u1_t val)
+{ }
+
+void hal_pin_nss(u1_t val)
+{ }
+
+void hal_spi_select(int on)
+{ }
+
+void hal_pin_busy_wait(void)
+{ }
+
+void hal_waitUntil(u4_t time)
+{ }
+
+u1_t hal_spi(u1_t out)
+{
+    u1_t addr = spi_addr;
+
+    spi_addr = out;
+
+    /* SX1276 RegVersion */
+    return addr == 0x42 ? 0x12 : 0x00;
+}
@@ -0,0 +1,716 @@
+/*
+ * Replay.cpp
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * Replay harness for the host (Linux) build. Feeds recorded (or
+ * synthesized) raw frames through the unmodified receive pipeline
+ *
+ *   RF_Receive() -> ParseData() -> OGN_APRS_Export()
+ *
+ * on a virtual millis() clock and reports packets/s, per stage latency
+ * and the number of bytes the station would have sent to APRS-IS.
+ * An APRS-IS rate (bytes/s) emulates a slow server, -s switches to the
+ * streaming export (OGN_APRS_Forward() on every accepted fix). -2 adds
+ * a second protocol: the receiver is time sliced between the two and
+ * frames sent while it listens to the other protocol are missed.
+ *
+ * Replay file format, one record per line:
+ *
+ *   # comment
+ *   ref <lat> <lon> <alt> <geoid separation>
+ *   rx <millis> <unix time> <protocol> <rssi> <frame as hex, incl. CRC>
+ *
+ * or a capture file of the station (CAPTURE.h), which starts with
+ * CAPTURE_MAGIC. -c <file> writes the frames the radio hands over in
+ * that format while replaying. -d turns the debug log (aprs.debug) on,
+ * its datagrams are counted, not sent.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+#include "../SoC.h"
+#include "../RF.h"
+#include "../Traffic.h"
+#include "../APRS.h"
+#include "../APRSQ.h"
+#include "../RFSCHED.h"
+#include "../DEDUP.h"
+#include "../CAPTURE.h"
+#include "../RXSTATS.h"
+#include "../GNSS.h"
+#include "../Log.h"
+#include "../global.h"
+
+#include "Checks.h"
+
+#define REPLAY_EXPORT_INTERVAL  5       /* APRS_EXPORT_AIRCRAFT in ognbase.ino */
+#define REPLAY_LINE_SIZE        1024
+#define REPLAY_RX_STEPS         8
+#define REPLAY_HOP_MS           10      /* RF_loop() period between frames in dual protocol mode */
+
+#define SYNTH_REF_LAT           47.1234
+#define SYNTH_REF_LON           8.5678
+#define SYNTH_REF_ALT           450
+#define SYNTH_REF_GEOID         48
+#define SYNTH_START_TIME        1593600000UL /* 2020-07-01 10:40:00 UTC */
+#define SYNTH_LOSS_PERCENT      20
+#define SYNTH_CORRUPT_PERCENT   2
+
+typedef std::chrono::steady_clock replay_clock;
+
+struct replay_stage
+{
+    const char*         name;
+    std::vector<double> us;
+};
+
+static replay_stage stage_rx     = { "rf_receive", {} };
+static replay_stage stage_parse  = { "parse_data", {} };
+static replay_stage stage_export = { "aprs_export", {} };
+static replay_stage aprs_latency = { "rx_to_aprs", {} };   /* ms of replay time */
+
+static int replay_protocol_2 = -1;              /* -2 <protocol>, dual protocol receiver */
+
+static std::vector<unsigned long> slot_rx_ms;    /* newest fix of the slot */
+static std::vector<unsigned long> slot_sent_ms;
+
+static const char* replay_capture_path = NULL;  /* -c <file> */
+static FILE*       replay_capture      = NULL;
+
+struct replay_input
+{
+    FILE*         fp;
+    bool          capture;                      /* CAPTURE.h format */
+    bool          pending;                      /* line holds the first line of a text file */
+    unsigned long offset;                       /* capture file, bytes read */
+    char          line[REPLAY_LINE_SIZE];
+    char          hex[REPLAY_LINE_SIZE];
+};
+
+static double Replay_elapsed_us(replay_clock::time_point from)
+{
+    return std::chrono::duration<double, std::micro>(replay_clock::now() - from).count();
+}
+
+static void Replay_stage_report(replay_stage* stage)
+{
+    std::vector<double>& s = stage->us;
+    double               sum = 0;
+
+    if (s.empty())
+    {
+        printf("%-12s %8u\n", stage->name, 0);
+        return;
+    }
+
+    std::sort(s.begin(), s.end());
+    for (size_t i = 0; i < s.size(); i++)
+        sum += s[i];
+
+    printf("%-12s %8u %9.2f %9.2f %9.2f %9.2f\n", stage->name, (unsigned) s.size(),
+           sum / s.size(), s[s.size() / 2], s[(s.size() * 99) / 100], s.back());
+}
+
+static void Replay_set_reference(float lat, float lon, int alt, int16_t geoid)
+{
+    ogn_lat              = lat;
+    ogn_lon              = lon;
+    ogn_alt              = alt;
+    ogn_geoid_separation = geoid;
+
+    /* same as the "position_is_set" branch of ground() */
+    ThisAircraft.latitude         = ogn_lat;
+    ThisAircraft.longitude        = ogn_lon;
+    ThisAircraft.altitude         = ogn_alt;
+    ThisAircraft.course           = 0;
+    ThisAircraft.speed            = 0;
+    ThisAircraft.hdop             = 0;
+    ThisAircraft.geoid_separation = ogn_geoid_separation;
+}
+
+/* picks up slots OGN_APRS_Send() has just queued */
+static void Replay_sent(int i)
+{
+    if (Traffic_Since_Sent(i) == 0 && slot_sent_ms[i] != millis())
+    {
+        slot_sent_ms[i] = millis();
+        aprs_latency.us.push_back(millis() - slot_rx_ms[i]);
+    }
+}
+
+static bool Replay_select_protocol(uint8_t protocol)
+{
+    if (rf_chip && (protocol == ogn_protocol_1 || (RF_Dual() && protocol == ogn_protocol_2)))
+        return true;
+
+    ogn_protocol_1 = protocol;
+    ogn_protocol_2 = replay_protocol_2 >= 0 ? replay_protocol_2 : protocol;
+    if (RF_setup() == RF_IC_NONE)
+        return false;
+
+    /* RF_ready is latched by the first RF_loop() */
+    RF_loop();
+    return ogn_protocol_1 == protocol;
+}
+
+static size_t Replay_hex2bin(const char* hex, uint8_t* buf, size_t size)
+{
+    size_t len = 0;
+
+    while (len < size && isxdigit(hex[0]) && isxdigit(hex[1]))
+    {
+        char byte[3] = { hex[0], hex[1], 0 };
+
+        buf[len++] = (uint8_t) strtoul(byte, NULL, 16);
+        hex       += 2;
+    }
+    return len;
+}
+
+/* next ref or rx record of either format, false at the end */
+static bool Replay_next(replay_input* in, capture_record_t* rec)
+{
+    uint8_t record[256];
+
+    while (in->capture)
+    {
+        int len = fgetc(in->fp);
+
+        if (len == EOF)
+            return false;
+        in->offset++;
+
+        /* padding up to the next sector */
+        if (len == 0)
+        {
+            while (in->offset % CAPTURE_SECTOR && fgetc(in->fp) != EOF)
+                in->offset++;
+            continue;
+        }
+
+        if (fread(record, 1, len, in->fp) != (size_t) len)
+            return false;
+        in->offset += len;
+        if (CAPTURE_Decode(record, len, rec))
+            return true;
+    }
+
+    while (in->pending || fgets(in->line, sizeof(in->line), in->fp))
+    {
+        unsigned long ms, unix_time;
+        unsigned int  protocol;
+        int           rssi;
+        float         lat, lon;
+        int           alt, geoid;
+
+        in->pending = false;
+        if (sscanf(in->line, "ref %f %f %d %d", &lat, &lon, &alt, &geoid) == 4)
+        {
+            rec->type  = CAPTURE_REF;
+            rec->lat   = lat;
+            rec->lon   = lon;
+            rec->alt   = alt;
+            rec->geoid = geoid;
+            return true;
+        }
+
+        if (sscanf(in->line, "rx %lu %lu %u %d %s", &ms, &unix_time, &protocol, &rssi, in->hex) != 5)
+            continue;
+
+        rec->type     = CAPTURE_RX;
+        rec->ms       = ms;
+        rec->time     = unix_time;
+        rec->protocol = protocol;
+        rec->channel  = 0;
+        rec->rssi     = rssi;
+        rec->size     = Replay_hex2bin(in->hex, rec->frame, MAX_LEN_FRAME);
+        return true;
+    }
+    return false;
+}
+
+static size_t Replay_capture_write(const uint8_t* buf, size_t size)
+{
+    return fwrite(buf, 1, size, replay_capture);
+}
+
+static int Replay_run(const char* path, const char* aprs_path, uint32_t tcp_rate)
+{
+    FILE*            fp;
+    replay_input     in;
+    capture_record_t rec;
+    unsigned long    first_ms = 0, last_ms = 0, ExportTimeOGN = 0;
+    uint32_t      frames = 0, frames_ok = 0, frames_bad = 0, frames_missed = 0;
+    bool          started = false;
+
+    fp = strcmp(path, "-") ? fopen(path, "r") : stdin;
+    if (fp == NULL)
+    {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+
+    if (aprs_path)
+    {
+        Host_aprs_out = fopen(aprs_path, "w");
+        if (Host_aprs_out == NULL)
+        {
+            perror(aprs_path);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (replay_capture_path)
+    {
+        replay_capture = fopen(replay_capture_path, "wb");
+        if (replay_capture == NULL || !CAPTURE_Start(Replay_capture_write, true))
+        {
+            perror(replay_capture_path);
+            return EXIT_FAILURE;
+        }
+    }
+
+    in.fp      = fp;
+    in.pending = fgets(in.line, sizeof(in.line), fp) != NULL;
+    in.capture = in.pending && !strcmp(in.line, CAPTURE_MAGIC);
+    in.offset  = CAPTURE_MAGIC_SIZE;
+    if (in.capture)
+        in.pending = false;
+
+    Host_tcp_rate = tcp_rate;
+    slot_rx_ms.assign(Traffic_capacity, 0);
+    slot_sent_ms.assign(Traffic_capacity, ~0UL);
+
+    replay_clock::time_point wall = replay_clock::now();
+
+    while (Replay_next(&in, &rec))
+    {
+        unsigned long ms        = rec.ms;
+        unsigned long unix_time = rec.time;
+        unsigned int  protocol  = rec.protocol;
+
+        if (rec.type == CAPTURE_REF)
+        {
+            Replay_set_reference(rec.lat, rec.lon, rec.alt, rec.geoid);
+            CAPTURE_Ref(rec.lat, rec.lon, rec.alt, rec.geoid);
+            continue;
+        }
+
+        /* between frames the RF task keeps hopping */
+        for (unsigned long t = last_ms + REPLAY_HOP_MS; started && RF_Dual() && t < ms; t += REPLAY_HOP_MS)
+        {
+            Host_set_millis(t);
+            RF_loop();
+        }
+
+        Host_set_millis(ms);
+        if (!started)
+        {
+            first_ms      = ms;
+            ExportTimeOGN = ms / 1000;
+            started       = true;
+        }
+        if (now() != (time_t) unix_time)
+            setTime(unix_time);
+        last_ms = ms;
+
+        if (!Replay_select_protocol(protocol))
+            continue;
+
+        size_t len = rec.size;
+        if (len == 0)
+            continue;
+
+        frames++;
+
+        if (RF_Dual())
+        {
+            /* the scheduler picks the protocol for this millis() */
+            RF_loop();
+            if (LMIC.protocol == NULL || LMIC.protocol->type != protocol)
+            {
+                frames_missed++;
+                continue;
+            }
+        }
+
+        ThisAircraft.timestamp = now();
+        Host_radio_inject(rec.frame, len, rec.rssi);
+
+        replay_clock::time_point t0 = replay_clock::now();
+        bool                     success = false;
+        for (int step = 0; step < REPLAY_RX_STEPS && !success; step++)
+        {
+            success = RF_Receive();
+            if (!Host_radio_pending())
+                break;
+        }
+        stage_rx.us.push_back(Replay_elapsed_us(t0));
+
+        if (success)
+        {
+            frames_ok++;
+
+            t0 = replay_clock::now();
+            int slot = ParseData();
+            if (ogn_aprs_stream)
+                OGN_APRS_Forward(slot);
+            stage_parse.us.push_back(Replay_elapsed_us(t0));
+
+            if (slot != TRAFFIC_NONE)
+            {
+                slot_rx_ms[slot] = ms;
+                Replay_sent(slot);
+            }
+        }
+        else
+            frames_bad++;
+
+        APRSQ_Flush(); /* once per loop() */
+        CAPTURE_Loop(millis());
+        Log_loop(millis());
+
+        if (millis() / 1000 - ExportTimeOGN >= REPLAY_EXPORT_INTERVAL)
+        {
+            t0 = replay_clock::now();
+            OGN_APRS_Export();
+            stage_export.us.push_back(Replay_elapsed_us(t0));
+
+            for (int i = Traffic_First(); i != TRAFFIC_NONE; i = Traffic_Next(i))
+                Replay_sent(i);
+            ExportTimeOGN = millis() / 1000;
+        }
+    }
+
+    double wall_us = Replay_elapsed_us(wall);
+
+    Log_flush();
+    if (fp != stdin)
+        fclose(fp);
+    if (Host_aprs_out)
+        fclose(Host_aprs_out);
+    Host_aprs_out = NULL;
+    if (replay_capture)
+    {
+        CAPTURE_Stop();
+        fclose(replay_capture);
+        replay_capture = NULL;
+    }
+
+    double replay_s = (last_ms - first_ms) / 1000.0;
+
+    printf("frames       %8u  ok %u  bad %u", frames, frames_ok, frames_bad);
+    if (RF_Dual())
+        printf("  missed %u", frames_missed);
+    printf("\n");
+    printf("replay time  %8.1f s  wall %.3f s  %.0f pkts/s\n",
+           replay_s, wall_us / 1e6, wall_us > 0 ? frames * 1e6 / wall_us : 0);
+    printf("%-12s %8s %9s %9s %9s %9s  (us)\n", "stage", "count", "mean", "p50", "p99", "max");
+    Replay_stage_report(&stage_rx);
+    Replay_stage_report(&stage_parse);
+    Replay_stage_report(&stage_export);
+    printf("%-12s %8s %9s %9s %9s %9s  (ms)\n", ogn_aprs_stream ? "streaming" : "batch", "count", "mean", "p50", "p99", "max");
+    Replay_stage_report(&aprs_latency);
+    printf("rf queue     %8u frames  dropped %u  max depth %u\n",
+           RF_queue_stats.frames, RF_queue_stats.dropped, RF_queue_stats.max_depth);
+    printf("rx re-arm    %8u frames  %u hops  blind mean %.1f us  max %u us\n",
+           RF_rearm_stats.frames, RF_rearm_stats.hops,
+           RF_rearm_stats.frames + RF_rearm_stats.hops ?
+           (double) RF_rearm_stats.blind_us / (RF_rearm_stats.frames + RF_rearm_stats.hops) : 0,
+           RF_rearm_stats.blind_max_us);
+    printf("radio model  %8u RX starts  %u with modem setup  %.1f us SPI per start\n",
+           Host_radio_stats.rx_starts, Host_radio_stats.rx_configs,
+           Host_radio_stats.rx_starts ? (double) Host_radio_stats.spi_us / Host_radio_stats.rx_starts : 0);
+    if (RF_fec_stats.frames)
+        printf("ldpc         %8u frames  errored %u  corrected %u (%u bits)  rejected %u\n",
+               RF_fec_stats.frames, RF_fec_stats.errored, RF_fec_stats.corrected,
+               RF_fec_stats.bits, RF_fec_stats.rejected);
+    for (int i = 0; RF_Dual() && i < RF_DUAL_PROTOCOLS; i++)
+    {
+        const rf_proto_stats_t* ps = &RF_proto_stats[i];
+
+        printf("protocol %u   %8u frames  decoded %u  listen %.1f s (%.0f%%) in %u windows  %.1f fixes/min\n",
+               ps->protocol, ps->frames, ps->decoded, ps->listen_ms / 1000.0,
+               replay_s > 0 ? ps->listen_ms / (10 * replay_s) : 0, ps->windows,
+               ps->listen_ms ? ps->decoded * 60000.0 / ps->listen_ms : 0);
+    }
+    if (RF_Dual())
+    {
+        printf("rfsched      %8u epochs  share %u/%u%%  aircraft/epoch %.1f/%.1f  windows %u/%u\n",
+               RFSCHED_stats.epochs, RFSCHED_stats.share[0], RFSCHED_stats.share[1],
+               RFSCHED_stats.aircraft[0] / 16.0, RFSCHED_stats.aircraft[1] / 16.0,
+               RFSCHED_stats.windows[0], RFSCHED_stats.windows[1]);
+        for (int n = 0; n < RFSCHED_BUCKETS; n++)
+        {
+            const rfsched_bucket_t* b = &RFSCHED_buckets[n];
+
+            if (b->window > RFSCHED_FREE)
+                continue;
+            printf("  protocol %u %-6s ch %-3u %8.1f s  frames %6u  fixes %6u  aircraft %5u  %.1f fixes/min\n",
+                   RF_proto_stats[b->index].protocol,
+                   b->window == RFSCHED_FREE ? "free" : b->window ? "slot 1" : "slot 0", b->channel,
+                   b->listen_ms / 1000.0, b->frames, b->fixes, b->aircraft,
+                   b->listen_ms ? b->fixes * 60000.0 / b->listen_ms : 0);
+        }
+    }
+    printf("dedup        %8u frames  duplicates %u (direct %u/%u, relay %u/%u)  evicted %u\n",
+           DEDUP_stats.frames[DEDUP_DIRECT] + DEDUP_stats.frames[DEDUP_RELAY],
+           DEDUP_stats.duplicates[DEDUP_DIRECT][DEDUP_DIRECT] + DEDUP_stats.duplicates[DEDUP_DIRECT][DEDUP_RELAY] +
+           DEDUP_stats.duplicates[DEDUP_RELAY][DEDUP_DIRECT] + DEDUP_stats.duplicates[DEDUP_RELAY][DEDUP_RELAY],
+           DEDUP_stats.duplicates[DEDUP_DIRECT][DEDUP_DIRECT] + DEDUP_stats.duplicates[DEDUP_DIRECT][DEDUP_RELAY],
+           DEDUP_stats.frames[DEDUP_DIRECT],
+           DEDUP_stats.duplicates[DEDUP_RELAY][DEDUP_DIRECT] + DEDUP_stats.duplicates[DEDUP_RELAY][DEDUP_RELAY],
+           DEDUP_stats.frames[DEDUP_RELAY], DEDUP_stats.evicted);
+
+    uint32_t rx_frames = 0, rx_errors = 0, rx_range = 0;
+    char     rx_report[RXSTATS_REPORT_SIZE];
+
+    for (int p = 0; p < RXSTATS_PROTOCOLS; p++)
+        for (int c = 0; c < RXSTATS_CHANNELS; c++)
+            for (int w = 0; w < RXSTATS_WINDOWS; w++)
+            {
+                rx_frames += RXSTATS_stats.frames[p][c][w];
+                rx_errors += RXSTATS_stats.errors[p][c][w];
+            }
+    for (int s = 0; s < RXSTATS_SECTORS; s++)
+        if (RXSTATS_stats.range_m[s] > rx_range)
+            rx_range = RXSTATS_stats.range_m[s];
+    printf("rxstats      %8u frames  errors %u  undecoded %u  implausible %u  farthest %.1f km  report %zu bytes\n",
+           rx_frames, rx_errors, RXSTATS_stats.undecoded[0] + RXSTATS_stats.undecoded[1],
+           RXSTATS_stats.implausible[0] + RXSTATS_stats.implausible[1], rx_range / 1000.0,
+           RXSTATS_Report(rx_report, sizeof(rx_report)));
+    if (replay_capture_path)
+        printf("capture      %8u frames  dropped %u  %u bytes  errors %u\n", CAPTURE_stats.frames,
+               CAPTURE_stats.dropped, CAPTURE_stats.bytes, CAPTURE_stats.errors);
+    if (ogn_debug)
+        printf("log          %8u records  dropped %u  truncated %u  %u datagrams  %u bytes\n",
+               Log_stats.records, Log_stats.dropped, Log_stats.truncated, Log_stats.datagrams,
+               Log_stats.bytes);
+    printf("aprs-is      %8u writes  %u bytes", Host_net_stats.tcp_writes, Host_net_stats.tcp_bytes);
+    if (replay_s > 0)
+        printf("  %.1f bytes/s", Host_net_stats.tcp_bytes / replay_s);
+    printf("\n");
+    printf("udp          %8u datagrams  %u bytes\n", Host_net_stats.udp_datagrams, Host_net_stats.udp_bytes);
+    printf("aprs queue   %8u lines  sent %u  depth %u max %u  blocked %u  superseded %u  dropped %u/%u\n",
+           APRSQ_stats.queued, APRSQ_stats.sent, APRSQ_stats.depth, APRSQ_stats.max_depth,
+           APRSQ_stats.blocked, APRSQ_stats.superseded, APRSQ_stats.dropped, APRSQ_stats.dropped_control);
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * Every aircraft flies a circle somewhere within ~20 km of the station
+ * and sends one position per second; some frames are lost on the way,
+ * a few arrive with bit errors to exercise the CRC/FEC reject path.
+ */
+static int Replay_synth(int aircraft, int duration, uint8_t protocol)
+{
+    uint8_t frame[MAX_LEN_FRAME];
+
+    if (aircraft < 1)
+        aircraft = 1;
+
+    Replay_set_reference(SYNTH_REF_LAT, SYNTH_REF_LON, SYNTH_REF_ALT, SYNTH_REF_GEOID);
+    if (!Replay_select_protocol(protocol))
+    {
+        fprintf(stderr, "protocol %u is not supported\n", protocol);
+        return EXIT_FAILURE;
+    }
+
+    printf("# ognbase replay, %d aircraft, %d s, protocol %u\n", aircraft, duration, protocol);
+    printf("ref %.6f %.6f %d %d\n", SYNTH_REF_LAT, SYNTH_REF_LON, SYNTH_REF_ALT, SYNTH_REF_GEOID);
+
+    std::vector<int> order(aircraft);
+
+    for (int t = 0; t < duration; t++)
+    {
+        unsigned long unix_time = SYNTH_START_TIME + t;
+
+        for (int i = 0; i < aircraft; i++)
+            order[i] = i;
+        /* slot 1 and slot 2 are 400..1200 ms after the PPS */
+        std::sort(order.begin(), order.end(), [t](int a, int b) {
+            return (a * 797 + t * 131) % 800 < (b * 797 + t * 131) % 800;
+        });
+
+        for (int n = 0; n < aircraft; n++)
+        {
+            int   i      = order[n];
+            float radius = 500 + (i * 137) % 1500;                       /* m */
+            float speed  = 40 + (i * 7) % 30;                            /* kts */
+            float omega  = speed * _GPS_MPS_PER_KNOT / radius;           /* rad/s */
+            float phase  = omega * t + i;
+            float cx     = ((i * 7919) % 40000 - 20000) / 1.4142f;       /* m east */
+            float cy     = ((i * 104729) % 40000 - 20000) / 1.4142f;     /* m north */
+            float x      = cx + radius * cosf(phase);
+            float y      = cy + radius * sinf(phase);
+
+            if (random(100) < SYNTH_LOSS_PERCENT)
+                continue;
+
+            ufo_t fo_tx;
+            memset(&fo_tx, 0, sizeof(fo_tx));
+            fo_tx.addr             = 0xDD0000 + i;
+            fo_tx.timestamp        = unix_time;
+            fo_tx.aircraft_type    = AIRCRAFT_TYPE_GLIDER;
+            fo_tx.latitude         = SYNTH_REF_LAT + y / 111320.0;
+            fo_tx.longitude        = SYNTH_REF_LON + x / (111320.0 * cos(radians(SYNTH_REF_LAT)));
+            fo_tx.altitude         = 1000 + (i * 211) % 1500 + 50 * sinf(phase / 4);
+            fo_tx.geoid_separation = SYNTH_REF_GEOID;
+            fo_tx.course           = fmodf(degrees(phase) + 90 + 720, 360);
+            fo_tx.speed            = speed;
+            fo_tx.vs               = 200 * cosf(phase / 4);
+
+            unsigned long ms = t * 1000UL + 400 + (i * 797 + t * 131) % 800;
+            Host_set_millis(ms);
+
+            size_t size = protocol_encode ? (*protocol_encode)((void *) &TxBuffer[0], &fo_tx) : 0;
+            if (size == 0 || !RF_Transmit(size, false))
+                continue;
+
+            size_t len = Host_radio_drain_tx(frame, sizeof(frame));
+
+            /* TX done, as the RF task would pick it up */
+            while (RF_Transmit_busy())
+                RF_Receive();
+            if (random(100) < SYNTH_CORRUPT_PERCENT)
+                frame[random(len)] ^= 1 << random(8);
+
+            printf("rx %lu %lu %u %d ", ms, unix_time, protocol, (int) (-60 - random(50)));
+            for (size_t k = 0; k < len; k++)
+                printf("%02x", frame[k]);
+            printf("\n");
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static void Replay_usage(const char* prog)
+{
+    fprintf(stderr,
+            "usage: %s synth <aircraft> <seconds> [protocol]\n"
+            "       %s replay [-s] [-d] [-2 protocol] [-c capture file] <file|-> [aprs output file] [aprs-is bytes/s]\n"
+            "       %s aprs-check [golden file]\n"
+            "       %s aprs-golden\n"
+            "       %s aprs-bench [count]\n"
+            "       %s crc-check\n"
+            "       %s crc-bench [frames]\n"
+            "       %s dedup-check\n"
+            "       %s fec-bench [frames per point]\n"
+            "       %s legacy-bench [aircraft]\n"
+            "       %s nbp-check\n"
+            "       %s nbp-bench [aircraft] [seconds]\n"
+            "       %s relay-check\n"
+            "       %s timer-check\n"
+            "       %s traffic-check\n",
+            prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog);
+}
+
+int main(int argc, char* argv[])
+{
+    SoC_setup();
+    Serial.enabled = false;
+    Traffic_setup();
+
+    if (argc >= 4 && !strcmp(argv[1], "synth"))
+        return Replay_synth(atoi(argv[2]), atoi(argv[3]),
+                            argc > 4 ? atoi(argv[4]) : RF_PROTOCOL_LEGACY);
+
+    if (argc >= 4 && !strcmp(argv[1], "replay") && !strcmp(argv[2], "-s"))
+    {
+        ogn_aprs_stream = true;
+        argv[2]         = argv[1];
+        argv++;
+        argc--;
+    }
+
+    if (argc >= 4 && !strcmp(argv[1], "replay") && !strcmp(argv[2], "-d"))
+    {
+        ogn_debug = true;
+        argv[2]   = argv[1];
+        argv++;
+        argc--;
+    }
+
+    if (argc >= 5 && !strcmp(argv[1], "replay") && !strcmp(argv[2], "-2"))
+    {
+        replay_protocol_2 = atoi(argv[3]);
+        argv[3]           = argv[1];
+        argv += 2;
+        argc -= 2;
+    }
+
+    if (argc >= 5 && !strcmp(argv[1], "replay") && !strcmp(argv[2], "-c"))
+    {
+        replay_capture_path = argv[3];
+        argv[3]             = argv[1];
+        argv += 2;
+        argc -= 2;
+    }
+
+    if (argc >= 3 && !strcmp(argv[1], "replay"))
+        return Replay_run(argv[2], argc > 3 && strcmp(argv[3], "-") ? argv[3] : NULL,
+                          argc > 4 ? atoi(argv[4]) : 0);
+
+    if (argc >= 2 && !strcmp(argv[1], "aprs-check"))
+        return Check_APRS(argc > 2 ? argv[2] : NULL);
+
+    if (argc >= 2 && !strcmp(argv[1], "aprs-golden"))
+        return Check_APRS_golden();
+
+    if (argc >= 2 && !strcmp(argv[1], "aprs-bench"))
+        return Bench_APRS(argc > 2 ? atoi(argv[2]) : 0);
+
+    if (argc >= 2 && !strcmp(argv[1], "crc-check"))
+        return Check_CRC();
+
+    if (argc >= 2 && !strcmp(argv[1], "crc-bench"))
+        return Bench_CRC(argc > 2 ? atoi(argv[2]) : 0);
+
+    if (argc >= 2 && !strcmp(argv[1], "dedup-check"))
+        return Check_DEDUP();
+
+    if (argc >= 2 && !strcmp(argv[1], "fec-bench"))
+        return Bench_FEC(argc > 2 ? atoi(argv[2]) : 0);
+
+    if (argc >= 2 && !strcmp(argv[1], "legacy-bench"))
+        return Bench_Legacy(argc > 2 ? atoi(argv[2]) : 0);
+
+    if (argc >= 2 && !strcmp(argv[1], "nbp-check"))
+        return Check_NBP();
+
+    if (argc >= 2 && !strcmp(argv[1], "nbp-bench"))
+        return Bench_NBP(argc > 2 ? atoi(argv[2]) : 0, argc > 3 ? atoi(argv[3]) : 0);
+
+    if (argc >= 2 && !strcmp(argv[1], "relay-check"))
+        return Check_RELAY();
+
+    if (argc >= 2 && !strcmp(argv[1], "timer-check"))
+        return Check_TIMER();
+
+    if (argc >= 2 && !strcmp(argv[1], "traffic-check"))
+        return Check_Traffic();
+
+    Replay_usage(argv[0]);
+    return EXIT_FAILURE;
+}
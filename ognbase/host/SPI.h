@@ -0,0 +1,33 @@
+/*
+ * SPI.h
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * Host (Linux) stand-in, the radio is emulated in basicmac.h.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+class SPIClass
+{
+  public:
+    void begin(int sck = -1, int miso = -1, int mosi = -1, int ss = -1) { }
+    void end(void) { }
+};
+
+extern SPIClass SPI;
+
+#endif /* HOST_SPI_H */
@@ -0,0 +1,24 @@
+/*
+ * SSD1306Wire.h
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * Host (Linux) stand-in, there is no display on the host build.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_SSD1306WIRE_H
+#define HOST_SSD1306WIRE_H
+
+#endif /* HOST_SSD1306WIRE_H */
@@ -0,0 +1,209 @@
+/*
+ * TIMER_check.cpp
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * timer-check: TIMER_CHECK_EVENTS events on the wheel for
+ * TIMER_CHECK_HOURS, starting just before millis() wraps. loop() comes
+ * round every 1 to TIMER_CHECK_LOOP_MS ms. The events are scheduled
+ * from a few ms to more than the wheel spans, some periodic with
+ * jitter, and from their own functions they cancel and reschedule each
+ * other.
+ *
+ * No event may run before it is due, or more than a tick after the
+ * loop() that could have run it. A cancelled one must not run at all,
+ * and TIMER_Idle() must never sleep past a due event.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../TIMER.h"
+
+#include "Checks.h"
+
+#define TIMER_CHECK_EVENTS      64
+#define TIMER_CHECK_HOURS       50      /* beyond what the wheel spans */
+#define TIMER_CHECK_LOOP_MS     7
+#define TIMER_CHECK_START       0xFFFF0000UL
+
+typedef struct
+{
+    uint32_t due;                       /* millis() it may run from */
+    uint32_t period_ms;
+    uint32_t jitter_ms;
+    uint32_t fired;
+    bool     pending;
+} check_event_t;
+
+static timer_event_t check_timers[TIMER_CHECK_EVENTS];
+static check_event_t check_events[TIMER_CHECK_EVENTS];
+static uint32_t      check_ms;          /* of the TIMER_Loop() running */
+static uint32_t      check_prev_ms;     /* of the one before */
+static uint32_t      check_failed;
+
+static uint32_t Check_TIMER_delay()
+{
+    static const uint32_t delays[] = {
+        1, 10, 15, 640, 650, 5000, 41000, 300000, 2700000, 7200000, 172800000UL
+    };
+
+    return delays[random() % (sizeof(delays) / sizeof(delays[0]))] + random() % 1000;
+}
+
+static void Check_TIMER_schedule(int i, uint32_t ms, uint32_t delay_ms)
+{
+    TIMER_Schedule(&check_timers[i], ms, delay_ms);
+    check_events[i].due     = ms + delay_ms;
+    check_events[i].pending = true;
+}
+
+static void Check_TIMER_fired(int i)
+{
+    check_event_t* e = &check_events[i];
+
+    /* the loop() before could not have run it yet */
+    if (!e->pending || (int32_t) (check_ms - e->due) < 0 ||
+        (int32_t) (check_prev_ms - e->due) >= TIMER_TICK_MS + (int32_t) e->jitter_ms)
+    {
+        if (check_failed < 10)
+            printf("timer-check: event %d due at %u ran at %u (loop before %u, pending %d)\n",
+                   i, e->due, check_ms, check_prev_ms, e->pending);
+        check_failed++;
+    }
+    e->fired++;
+    e->pending = false;
+
+    /* as TIMER_Run() did: a period after it was due, skipping what was missed */
+    if (e->period_ms)
+    {
+        e->due += e->period_ms;
+        if ((int32_t) (check_ms - e->due) > 0)
+            e->due += ((check_ms - e->due) / e->period_ms + 1) * e->period_ms;
+        e->pending = true;
+    }
+
+    /* every fifth reschedules itself, every seventh cancels its neighbour */
+    if (i % 5 == 0)
+        Check_TIMER_schedule(i, check_ms, Check_TIMER_delay());
+    if (i % 7 == 0)
+    {
+        int n = (i + 1) % TIMER_CHECK_EVENTS;
+
+        TIMER_Cancel(&check_timers[n]);
+        check_events[n].pending = false;
+    }
+}
+
+template <int N> static void Check_TIMER_fn()
+{
+    Check_TIMER_fired(N);
+}
+
+template <int N> struct Check_TIMER_fns
+{
+    static void fill(timer_fn_t* fns)
+    {
+        fns[N - 1] = &Check_TIMER_fn<N - 1>;
+        Check_TIMER_fns<N - 1>::fill(fns);
+    }
+};
+
+template <> struct Check_TIMER_fns<0>
+{
+    static void fill(timer_fn_t* fns)
+    { }
+};
+
+int Check_TIMER()
+{
+    timer_fn_t fns[TIMER_CHECK_EVENTS];
+    uint32_t   idle_early = 0, loops = 0, fired = 0;
+    uint64_t   slept = 0;
+
+    Check_TIMER_fns<TIMER_CHECK_EVENTS>::fill(fns);
+    srandom(1);
+
+    check_ms = check_prev_ms = TIMER_CHECK_START;
+    TIMER_Setup(check_ms, 12345);
+
+    for (int i = 0; i < TIMER_CHECK_EVENTS; i++)
+    {
+        timer_event_t event = TIMER_EVENT(fns[i], 0, 0);
+
+        memset(&check_events[i], 0, sizeof(check_events[i]));
+        check_timers[i] = event;
+        if (i % 3 == 0)
+        {
+            /* periodic, from 20 ms to 30 min */
+            check_timers[i].period_ms = 20 + random() % 1800000;
+            check_timers[i].jitter_ms = i % 2 ? random() % 5000 : 0;
+            check_events[i].period_ms = check_timers[i].period_ms;
+            check_events[i].jitter_ms = check_timers[i].jitter_ms;
+        }
+        Check_TIMER_schedule(i, check_ms, Check_TIMER_delay());
+    }
+
+    for (uint64_t t = 0; t < TIMER_CHECK_HOURS * 3600000ULL; loops++)
+    {
+        /* now and then loop() sleeps as long as TIMER_Idle() allows */
+        uint32_t step = 1 + random() % TIMER_CHECK_LOOP_MS;
+
+        if (loops % 4 == 0)
+        {
+            uint32_t idle = TIMER_Idle(check_ms, 1000);
+
+            for (int i = 0; i < TIMER_CHECK_EVENTS; i++)
+                if (check_events[i].pending &&
+                    (int32_t) (check_events[i].due + check_events[i].jitter_ms + TIMER_TICK_MS -
+                               (check_ms + idle)) < 0)
+                    idle_early++;
+            step = idle ? idle : step;
+            slept += step;
+        }
+
+        t             += step;
+        check_prev_ms  = check_ms;
+        check_ms      += step;
+        TIMER_Loop(check_ms);
+    }
+
+    /* the once-only events that are still pending have to be on the wheel */
+    for (int i = 0; i < TIMER_CHECK_EVENTS; i++)
+    {
+        fired += check_events[i].fired;
+        if (check_events[i].pending != TIMER_Pending(&check_timers[i]))
+        {
+            printf("timer-check: event %d pending %d, on the wheel %d\n", i,
+                   check_events[i].pending, TIMER_Pending(&check_timers[i]));
+            check_failed++;
+        }
+    }
+
+    if (idle_early)
+        printf("timer-check: %u times TIMER_Idle() slept past an event\n", idle_early);
+    check_failed += idle_early;
+
+    printf("timer-check: %d events, %d h, %u loop() rounds, %.1f%% of the time asleep\n",
+           TIMER_CHECK_EVENTS, TIMER_CHECK_HOURS, loops, 100.0 * slept / (TIMER_CHECK_HOURS * 3600000.0));
+    printf("  fired %u (wheel %u), late max %u ms\n", fired, TIMER_stats.fired, TIMER_stats.late_max_ms);
+
+    if (fired != TIMER_stats.fired || !fired)
+        check_failed++;
+
+    printf("timer-check: %u failed\n", check_failed);
+    return check_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
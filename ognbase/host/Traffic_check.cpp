@@ -0,0 +1,231 @@
+/*
+ * Traffic_check.cpp
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * traffic-check: the tracking table against a plain model of it. First
+ * a probe chain that wraps from the last bucket of the index to the
+ * first ones is built and taken apart from the front and the middle,
+ * then TRAFFIC_CHECK_OPS random inserts, updates and removals run over
+ * twice as many addresses as the table holds, so it keeps filling up.
+ *
+ * After every step each aircraft of the model has to be found in its
+ * slot, none of the others at all, and Traffic_First()/Traffic_Next()
+ * have to list them most recently updated first. A new aircraft in a
+ * full table has to take the slot of the least recently updated one,
+ * and once they are all older than ENTRY_EXPIRATION_TIME the next
+ * insert has to clear them.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <TimeLib.h>
+
+#include "../SoftRF.h"
+#include "../Traffic.h"
+
+#include "Checks.h"
+
+#define TRAFFIC_CHECK_OPS       20000
+#define TRAFFIC_CHECK_CHAIN     4       /* entries homed at the last bucket */
+
+static std::vector<uint32_t>  check_lru;    /* model, most recently updated first */
+static std::map<uint32_t, int> check_slot;
+static std::vector<uint32_t>  check_absent; /* addresses that must not be found */
+static uint32_t               check_failed;
+
+/* Traffic_Hash() of an index with 2^bits buckets */
+static uint16_t Check_Traffic_home(uint32_t addr, uint8_t bits)
+{
+    return (uint16_t) ((uint32_t) (addr * 2654435761U) >> (32 - bits));
+}
+
+/* next address after *addr with home bucket home */
+static uint32_t Check_Traffic_addr(uint32_t* addr, uint16_t home, uint8_t bits)
+{
+    do {
+        (*addr)++;
+    } while (Check_Traffic_home(*addr, bits) != home);
+    return *addr;
+}
+
+static void Check_Traffic_fail(const char* what, uint32_t addr, int got, int want)
+{
+    if (check_failed < 10)
+        printf("traffic-check: %s %06X: slot %d, expected %d\n", what, addr, got, want);
+    check_failed++;
+}
+
+static void Check_Traffic_insert(uint32_t addr)
+{
+    ufo_t fo;
+    int   evicted = TRAFFIC_NONE;
+    int   ndx;
+
+    memset(&fo, 0, sizeof(fo));
+    fo.addr      = addr;
+    fo.timestamp = now();
+    fo.latitude  = 47.0 + (addr & 0xFF) * 0.001;
+    fo.longitude = 8.0;
+
+    std::map<uint32_t, int>::iterator it = check_slot.find(addr);
+
+    if (it == check_slot.end() && check_slot.size() == Traffic_capacity)
+    {
+        uint32_t oldest = check_lru.back();
+
+        evicted = check_slot[oldest];
+        check_slot.erase(oldest);
+        check_lru.pop_back();
+        check_absent.push_back(oldest);
+    }
+
+    ndx = Traffic_Insert(&fo);
+
+    if (it != check_slot.end())
+    {
+        if (ndx != it->second)
+            Check_Traffic_fail("update moved", addr, ndx, it->second);
+        check_lru.erase(std::find(check_lru.begin(), check_lru.end(), addr));
+    }
+    else if (evicted != TRAFFIC_NONE && ndx != evicted)
+        Check_Traffic_fail("did not evict the oldest for", addr, ndx, evicted);
+
+    check_slot[addr] = ndx;
+    check_lru.insert(check_lru.begin(), addr);
+    check_absent.erase(std::remove(check_absent.begin(), check_absent.end(), addr), check_absent.end());
+}
+
+static void Check_Traffic_remove(uint32_t addr)
+{
+    Traffic_Remove(check_slot[addr]);
+    check_slot.erase(addr);
+    check_lru.erase(std::find(check_lru.begin(), check_lru.end(), addr));
+    check_absent.push_back(addr);
+}
+
+static void Check_Traffic_verify()
+{
+    size_t n = 0;
+
+    if (Traffic_count != check_slot.size())
+        Check_Traffic_fail("count, no aircraft", 0, Traffic_count, check_slot.size());
+
+    for (std::map<uint32_t, int>::iterator it = check_slot.begin(); it != check_slot.end(); ++it)
+    {
+        int ndx = Traffic_Find(it->first);
+
+        if (ndx != it->second || Container[ndx].addr != it->first)
+            Check_Traffic_fail("find", it->first, ndx, it->second);
+    }
+
+    for (size_t i = 0; i < check_absent.size(); i++)
+        if (Traffic_Find(check_absent[i]) != TRAFFIC_NONE)
+            Check_Traffic_fail("removed but found", check_absent[i], Traffic_Find(check_absent[i]),
+                               TRAFFIC_NONE);
+
+    for (int i = Traffic_First(); i != TRAFFIC_NONE && n <= Traffic_capacity; i = Traffic_Next(i), n++)
+        if (n >= check_lru.size() || Container[i].addr != check_lru[n])
+        {
+            Check_Traffic_fail("LRU order at", Container[i].addr, i,
+                               n < check_lru.size() ? check_slot[check_lru[n]] : TRAFFIC_NONE);
+            return;
+        }
+
+    if (n != check_lru.size())
+        Check_Traffic_fail("LRU length, no aircraft", 0, n, check_lru.size());
+}
+
+int Check_Traffic()
+{
+    uint8_t  bits = 1;
+    uint32_t addr = 0, evictions = 0;
+    uint32_t chain[TRAFFIC_CHECK_CHAIN + 3];
+    std::vector<uint32_t> pool;
+
+    while ((1U << bits) < 2U * Traffic_capacity)
+        bits++;
+
+    srandom(1);
+    Traffic_Clear();
+
+    /* a chain from the last bucket across the wraparound, displacing entries homed at 0 and 1 */
+    for (int i = 0; i < TRAFFIC_CHECK_CHAIN; i++)
+        chain[i] = Check_Traffic_addr(&addr, (1U << bits) - 1, bits);
+    chain[TRAFFIC_CHECK_CHAIN]     = Check_Traffic_addr(&addr, 0, bits);
+    chain[TRAFFIC_CHECK_CHAIN + 1] = Check_Traffic_addr(&addr, 0, bits);
+    chain[TRAFFIC_CHECK_CHAIN + 2] = Check_Traffic_addr(&addr, 1, bits);
+
+    for (int i = 0; i < TRAFFIC_CHECK_CHAIN + 3; i++)
+        Check_Traffic_insert(chain[i]);
+    Check_Traffic_verify();
+
+    static const int order[] = { 0, TRAFFIC_CHECK_CHAIN, 2, TRAFFIC_CHECK_CHAIN + 2, 1 };
+
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); i++)
+    {
+        Check_Traffic_remove(chain[order[i]]);
+        Check_Traffic_verify();
+    }
+    for (int i = 0; i < TRAFFIC_CHECK_CHAIN + 3; i++)
+    {
+        Check_Traffic_insert(chain[i]);
+        Check_Traffic_verify();
+    }
+
+    /* random traffic, twice as many aircraft as fit */
+    for (uint32_t i = 0; i < 2U * Traffic_capacity; i++)
+        pool.push_back(0x100000 + i * 0x0101);
+
+    for (int op = 0; op < TRAFFIC_CHECK_OPS; op++)
+    {
+        uint32_t a = pool[random() % pool.size()];
+
+        if (check_slot.count(a) && random() % 4 == 0)
+            Check_Traffic_remove(a);
+        else
+        {
+            evictions += !check_slot.count(a) && check_slot.size() == Traffic_capacity;
+            Check_Traffic_insert(a);
+        }
+        Check_Traffic_verify();
+    }
+
+    /* everything expired, the next new aircraft finds the table empty */
+    Host_set_millis(millis() + (ENTRY_EXPIRATION_TIME + 1) * 1000UL);
+    for (std::map<uint32_t, int>::iterator it = check_slot.begin(); it != check_slot.end(); ++it)
+        check_absent.push_back(it->first);
+    check_slot.clear();
+    check_lru.clear();
+    Check_Traffic_insert(0xFFFFFF);
+    Check_Traffic_verify();
+
+    Traffic_Clear();
+
+    printf("traffic-check: %u slots, %u buckets, %d operations, %u evictions\n",
+           Traffic_capacity, 1U << bits, TRAFFIC_CHECK_OPS, evictions);
+
+    if (!evictions)
+        check_failed++;
+
+    printf("traffic-check: %u failed\n", check_failed);
+    return check_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
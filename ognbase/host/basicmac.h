@@ -0,0 +1,130 @@
+/*
+ * basicmac.h
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * Host (Linux) stand-in for the Basic MAC / LMIC radio layer.
+ *
+ * There is no SX1276 on the host. Received frames are injected by the
+ * replay harness with Host_radio_inject() and handed to the RF.cpp rx job
+ * from os_runstep(), exactly as the IRQ handler of the real LMIC does.
+ * Frames passed to os_radio(RADIO_TX) are captured for Host_radio_drain_tx().
+ * Starts of the receiver are counted against a model of the SPI traffic
+ * radio-sx127x.c would cause, see Host_radio_stats.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_BASICMAC_H
+#define HOST_BASICMAC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <protocol.h>
+
+typedef uint8_t  u1_t;
+typedef int8_t   s1_t;
+typedef uint16_t u2_t;
+typedef int16_t  s2_t;
+typedef uint32_t u4_t;
+typedef int32_t  s4_t;
+typedef s4_t     ostime_t;
+typedef u1_t     cr_t;
+typedef u1_t     dr_t;
+typedef u2_t     rps_t;
+
+#define OSTICKS_PER_SEC 32768
+#define ms2osticks(ms)  ((ostime_t) (((int64_t) (ms) * OSTICKS_PER_SEC) / 1000))
+#define osticks2ms(os)  ((s4_t) (((int64_t) (os) * 1000) / OSTICKS_PER_SEC))
+
+enum { MAX_LEN_FRAME = 255 };
+enum { RADIO_RST=0, RADIO_TX=1, RADIO_RX=2, RADIO_RXON=3, RADIO_TXCW, RADIO_CCA };
+enum _cr_t { CR_4_5=0, CR_4_6, CR_4_7, CR_4_8 };
+enum _dr_eu868_t { DR_SF12=0, DR_SF11, DR_SF10, DR_SF9, DR_SF8, DR_SF7, DR_SF7B, DR_FSK, DR_NONE };
+enum { REGCODE_EU868 = 1 };
+
+struct osjob_t;
+typedef void (*osjobcb_t)(struct osjob_t *);
+
+struct osjob_t
+{
+    struct osjob_t* next;
+    ostime_t        deadline;
+    osjobcb_t       func;
+};
+
+struct lmic_t
+{
+    const rf_proto_desc_t* protocol;
+
+    u1_t     frame[MAX_LEN_FRAME];
+    u1_t     dataLen;
+    s1_t     rssi;
+    s1_t     snr;
+    u4_t     freq;
+    s1_t     txpow;
+    u1_t     datarate;
+    u1_t     syncword;
+    rps_t    rps;
+    s1_t     agcref;
+    u1_t     noRXIQinversion;
+    u2_t     rxsyms;
+    ostime_t rxtime;
+    ostime_t txend;
+
+    struct osjob_t osjob;
+};
+
+extern struct lmic_t LMIC;
+
+inline rps_t setCr(rps_t params, cr_t cr)
+{
+    return (rps_t) ((params & ~0x60) | (cr << 5));
+}
+
+rps_t    LMIC_updr2rps(u1_t dr);
+void     LMIC_reset(void);
+void     LMIC_shutdown(void);
+
+void     os_init(void *);
+void     os_runstep(void);
+void     os_radio(u1_t);
+void     os_setCallback(struct osjob_t *, osjobcb_t);
+void     os_clearCallback(struct osjob_t *);
+ostime_t os_getTime(void);
+
+typedef struct SX12XX_ops_struct
+{
+    u1_t type;
+} SX12XX_ops_t;
+
+extern const SX12XX_ops_t* SX12XX_LL;
+extern const SX12XX_ops_t  sx127x_ll_ops;
+extern const SX12XX_ops_t  sx126x_ll_ops;
+
+/* replay harness side of the radio */
+void   Host_radio_inject(const u1_t *, size_t, s1_t);
+bool   Host_radio_pending(void);
+size_t Host_radio_drain_tx(u1_t *, size_t);
+
+typedef struct host_radio_stats_struct
+{
+    uint32_t rx_starts;
+    uint32_t rx_configs;    /* with the full modem setup, not just the frequency */
+    uint32_t spi_us;        /* modeled register writes of all starts */
+} host_radio_stats_t;
+
+extern host_radio_stats_t Host_radio_stats;
+
+#endif /* HOST_BASICMAC_H */
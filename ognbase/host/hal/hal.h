@@ -0,0 +1,53 @@
+/*
+ * hal/hal.h
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * Host (Linux) stand-in for the LMIC hardware abstraction layer.
+ * SPI reads return a SX1276 RegVersion so that RF_setup() probes
+ * the same code path as on a T-Beam.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+#include <basicmac.h>
+
+#define NUM_DIO 3
+
+struct lmic_pinmap
+{
+    u1_t nss;
+    u1_t txe;
+    u1_t rxe;
+    u1_t rst;
+    u1_t dio[NUM_DIO];
+    u1_t busy;
+    u1_t tcxo;
+};
+
+const u1_t LMIC_UNUSED_PIN = 0xff;
+
+extern struct lmic_pinmap lmic_pins;
+
+void hal_init(void *);
+void hal_pin_rst(u1_t);
+void hal_pin_nss(u1_t);
+void hal_spi_select(int);
+void hal_pin_busy_wait(void);
+u1_t hal_spi(u1_t);
+void hal_waitUntil(u4_t);
+
+#endif /* HOST_HAL_H */
@@ -0,0 +1,24 @@
+/*
+ * nRF905.h
+ * Copyright (C) 2020 Manuel Roesel
+ *
+ * Host (Linux) stand-in, the nRF905 radio is not used by the ground station.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_NRF905_H
+#define HOST_NRF905_H
+
+#endif /* HOST_NRF905_H */
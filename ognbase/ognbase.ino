@@ -77,6 +77,11 @@
 #include "Traffic.h"
 
 #include "APRS.h"
+#include "APRSQ.h"
+#include "RELAY.h"
+#include "CAPTURE.h"
+#include "LOOPSTATS.h"
+#include "TIMER.h"
 #include "RSM.h"
 #include "PNET.h"
 #include "MONIT.h"
@@ -106,56 +111,47 @@
 
 #define seconds() (millis()/1000)
 
-#define isTimeToExport() (millis() - ExportTimeMarker > 1000)
-
+/* periods of the timer events, in seconds */
 #define APRS_EXPORT_AIRCRAFT 5
-#define TimeToExportOGN() (seconds() - ExportTimeOGN >= APRS_EXPORT_AIRCRAFT)
-
 #define APRS_REGISTER_REC 300
-#define TimeToRegisterOGN() (seconds() - ExportTimeRegisterOGN >= APRS_REGISTER_REC)
-
 #define APRS_KEEPALIVE_TIME 240
-#define TimeToKeepAliveOGN() (seconds() - ExportTimeKeepAliveOGN >= APRS_KEEPALIVE_TIME)
-
 #define APRS_CHECK_KEEPALIVE_TIME 20
-#define TimeToCheckKeepAliveOGN() (seconds() - ExportTimeCheckKeepAliveOGN >= APRS_CHECK_KEEPALIVE_TIME)
-
 #define APRS_CHECK_WIFI_TIME 600
-#define TimeToCheckWifi() (seconds() - ExportTimeCheckWifi >= APRS_CHECK_WIFI_TIME)
-
 #define APRS_STATUS_REC 1800
-#define TimeToStatusOGN() (seconds() - ExportTimeStatusOGN >= APRS_STATUS_REC)
-
-#define APRS_PROTO_SWITCH 2
-#define TimeToswitchProto() (seconds() - ExportTimeSwitch >= APRS_PROTO_SWITCH)
-
 #define TIME_TO_REFRESH_WEB 30
-#define TimeToRefreshWeb() (seconds() - ExportTimeWebRefresh >= TIME_TO_REFRESH_WEB)
-
-//testing
-#define TimeToSleep() (seconds() - ExportTimeSleep >= ogn_rxidle)
-
-//testing
 #define TIME_TO_DIS_WIFI  60
-#define TimeToDisWifi() (seconds() - ExportTimeDisWifi >= TIME_TO_DIS_WIFI)
-
-//testing
-#define TimeToDisableOled() (seconds() - ExportTimeOledDisable >= oled_disable)
 
 //time reregister if failed
 #define TIME_TO_REREG 30
-#define TimeToReRegisterOGN() (seconds() - ExportTimeReRegister >= TIME_TO_REREG)
+
+/* a restarted WiFi interface has that long to connect again before the board is reset */
+#define APRS_WIFI_GRACE 10
 
 /*Testing FANET service messages*/
 #define TIME_TO_EXPORT_FANET_SERVICE 40 /*every 40 sec 10 for testing*/
-#define TimeToExportFanetService() (seconds() - ExportTimeFanetService >= TIME_TO_EXPORT_FANET_SERVICE)
+
+/* keepalive and status up to that much later, stations started together drift apart */
+#define APRS_JITTER_MS 5000
+
+/* loop() sleeps at most that long for the next event or frame, the button and OTA are polled */
+#define LOOP_IDLE_MS 20
 
 #define BUTTON 38
 
 
+/* APRS-IS connection of the base station, ground() and the timer events move it on */
+enum
+{
+  GROUND_NO_POSITION,   /* nothing to register with yet */
+  GROUND_REGISTER,      /* connect and log in */
+  GROUND_ONLINE,        /* export, keepalive, status, server messages */
+  GROUND_RETRY          /* login failed, next try after TIME_TO_REREG */
+};
+
 ufo_t ThisAircraft;
 bool groundstation = false;
-int ground_registred = 0;
+uint8_t ground_state = GROUND_NO_POSITION;
+bool wifi_recheck = false;
 bool fanet_transmitter = false;
 bool time_synced = false;
 int proto_in_use = 0;
@@ -168,22 +164,32 @@ hardware_info_t hw_info = {
   .gnss     = GNSS_MODULE_NONE,
 };
 
-unsigned long LEDTimeMarker = 0;
-unsigned long ExportTimeMarker = 0;
-
-unsigned long ExportTimeOGN = 0;
-unsigned long ExportTimeRegisterOGN = 0;
-unsigned long ExportTimeKeepAliveOGN = 0;
-unsigned long ExportTimeStatusOGN = 0;
-unsigned long ExportTimeSwitch = 0;
-unsigned long ExportTimeSleep = 0;
-unsigned long ExportTimeDisWifi = 0;
-unsigned long ExportTimeWebRefresh = 0;
-unsigned long ExportTimeFanetService = 0;
-unsigned long ExportTimeCheckKeepAliveOGN = 0;
-unsigned long ExportTimeCheckWifi = 0;
-unsigned long ExportTimeOledDisable = 0;
-unsigned long ExportTimeReRegister = 0;
+/* what happens now and then, TIMER_Loop() runs it from loop() */
+void ground_screen();
+void ground_export();
+void ground_keepalive();
+void ground_status();
+void ground_messages();
+void ground_check_wifi();
+void ground_login();
+void ground_reregister();
+void ground_fanet_service();
+void ground_sleep();
+void ground_disable_wifi();
+
+timer_event_t screen_event     = TIMER_EVENT(ground_screen, 1000, 0);
+timer_event_t export_event     = TIMER_EVENT(ground_export, APRS_EXPORT_AIRCRAFT * 1000UL, 0);
+timer_event_t keepalive_event  = TIMER_EVENT(ground_keepalive, APRS_KEEPALIVE_TIME * 1000UL, APRS_JITTER_MS);
+timer_event_t status_event     = TIMER_EVENT(ground_status, APRS_STATUS_REC * 1000UL, APRS_JITTER_MS);
+timer_event_t messages_event   = TIMER_EVENT(ground_messages, APRS_CHECK_KEEPALIVE_TIME * 1000UL, 0);
+timer_event_t wifi_event       = TIMER_EVENT(ground_check_wifi, APRS_CHECK_WIFI_TIME * 1000UL, 0);
+timer_event_t login_event      = TIMER_EVENT(ground_login, 0, 0);
+timer_event_t reregister_event = TIMER_EVENT(ground_reregister, 0, 0);
+timer_event_t fanet_event      = TIMER_EVENT(ground_fanet_service, TIME_TO_EXPORT_FANET_SERVICE * 1000UL, 0);
+timer_event_t web_event        = TIMER_EVENT(Web_loop, TIME_TO_REFRESH_WEB * 1000UL, 0);
+timer_event_t sleep_event      = TIMER_EVENT(ground_sleep, 0, 0);
+timer_event_t dis_wifi_event   = TIMER_EVENT(ground_disable_wifi, TIME_TO_DIS_WIFI * 1000UL, 0);
+timer_event_t oled_event       = TIMER_EVENT(OLED_disable, 0, 0);
 
 /*set ground position only once*/
 bool position_is_set = false;
@@ -239,6 +245,7 @@ void setup()
   ThisAircraft.addr = SoC->getChipId() & 0x00FFFFFF;
 
   hw_info.rf = RF_setup();
+  RELAY_Reset();
 
   if (hw_info.model    == SOFTRF_MODEL_PRIME_MK2 &&
       hw_info.revision == 2                      &&
@@ -273,25 +280,45 @@ void setup()
 #if defined(TBEAM)
   pinMode(BUTTON, INPUT);
 #endif  
+
+  /* raw frames of the RF task, written by loop() */
+  if (capture_enable && CAPTURE_Open(capture_sd) && ogn_lat != 0 && ogn_lon != 0)
+    CAPTURE_Ref(ogn_lat, ogn_lon, ogn_alt, ogn_geoid_separation);
+
+  /* from here on the radio is serviced on core 0, loop() drains the frame queue */
+  RF_Task_start();
+
+  TIMER_Setup(millis(), ThisAircraft.addr);
+  TIMER_Start(&screen_event, millis());
+  TIMER_Start(&export_event, millis());
+  TIMER_Start(&keepalive_event, millis());
+  TIMER_Start(&status_event, millis());
+  TIMER_Start(&messages_event, millis());
+  TIMER_Start(&fanet_event, millis());
+  TIMER_Start(&web_event, millis());
+  TIMER_Start(ognrelay_enable ? &dis_wifi_event : &wifi_event, millis());
+  if (ogn_sleepmode)
+    TIMER_Schedule(&sleep_event, millis(), ogn_rxidle * 1000UL);
+  if (oled_disable > 0)
+    TIMER_Schedule(&oled_event, millis(), oled_disable * 1000UL);
 }
 
 void loop()
 {
+  LOOPSTATS_Start(micros());
+
   // Do common RF stuff first
   RF_loop();
 
   ground();
+
+  CAPTURE_Loop(millis());
+
+  Log_loop(millis());
   
   // Handle DNS
   WiFi_loop();
 
-  // Handle Web
-  /*MANU add timer to refresh values*/
-  if(TimeToRefreshWeb()){
-    Web_loop();
-    ExportTimeWebRefresh = seconds();
-  }
-
   // Handle OTA update.
   OTA_loop();
 
@@ -301,6 +328,17 @@ void loop()
 
   SoC->Button_loop();
 
+  TIMER_Loop(millis());
+
+  LOOPSTATS_Iteration(micros());
+
+  /*
+   * nothing due: sleep until the next event or a frame from the RF task,
+   * not while the setup page serves DNS or the APRS-IS socket is full
+   */
+  if (WiFi.getMode() != WIFI_AP && APRSQ_stats.depth == 0 && RELAY_Depth() == 0)
+    RF_Wait(TIMER_Idle(millis(), LOOP_IDLE_MS));
+
   yield();
 }
 
@@ -319,8 +357,13 @@ void shutdown(const char *msg)
   GNSS_fini();
 #endif
 
+  /* the RF task is gone before the capture buffers are */
   RF_Shutdown();
 
+  CAPTURE_Stop();
+
+  Log_flush();
+
   SoC->Button_fini();
 
   SoC_fini();
@@ -329,10 +372,9 @@ void shutdown(const char *msg)
 void ground()
 {
 
-   char *disp;
-   bool success;
    String msg;
    char buf[32];
+   int login;
 
    if (!groundstation) {
 
@@ -353,32 +395,24 @@ void ground()
     Logger_send_udp(&msg);
   }
 
-  if((WiFi.getMode() == WIFI_AP) && !ognrelay_enable){
-    OLED_write("Setup mode..", 0, 9, true);
-    snprintf (buf, sizeof(buf), "SSID: %s", host_name.c_str());
-    OLED_write(buf, 0, 18, false);
-    snprintf (buf, sizeof(buf), "ip: %s", "192.168.1.1");
-    OLED_write(buf, 0, 27, false);
-    snprintf (buf, sizeof(buf), "reboot in %d seconds", 300 - seconds());
-    OLED_write(buf, 0, 36, false);
-    snprintf (buf, sizeof(buf), "Version: %s ", _VERSION);
-    OLED_write(buf, 0, 45, false);    
-    delay(1000);
-    if(300 < seconds()){
-      SoC->reset();
-      }
-    }
+  while (RF_Receive()){
+    if (!isValidFix() && !position_is_set)
+      continue;
 
-  
-  success = RF_Receive();
-  if (success && isValidFix() || success && position_is_set){
-    Logger_send_udp(&msg);    
-    
-    ParseData();
-    
-    ExportTimeSleep = seconds();
+    int slot = ParseData();
+
+    if (ogn_aprs_stream && ground_state == GROUND_ONLINE)
+      OGN_APRS_Forward(slot);
+
+    /* ogn_rxidle without a frame sends the station to sleep */
+    if (ogn_sleepmode)
+      TIMER_Schedule(&sleep_event, millis(), ogn_rxidle * 1000UL);
   }
 
+  /* queued by ParseData(), sent between the slots */
+  if (ognrelay_enable)
+    RELAY_Loop(millis());
+
   if (ogn_lat != 0 && ogn_lon != 0 && !position_is_set) {
     ThisAircraft.latitude = ogn_lat;
     ThisAircraft.longitude = ogn_lon;
@@ -430,13 +464,6 @@ void ground()
 
   }
 
-  if(!position_is_set){
-    OLED_write("no position data found", 0, 18, true);
-    delay(1000);
-    OLED_write("waiting for GPS fix", 0, 18, true);
-    delay(1000);
-  }
-
 #if defined(TBEAM)
   GNSS_loop();
 #endif
@@ -447,159 +474,229 @@ void ground()
 
   if (!ognrelay_enable){
 
-    if ((TimeToRegisterOGN() && (position_is_set) && WiFi.getMode() != WIFI_AP ) || (ground_registred == 0  && (position_is_set) && WiFi.getMode() != WIFI_AP))
-    {  
-      ground_registred = OGN_APRS_Register(&ThisAircraft);
-      ExportTimeRegisterOGN = seconds();
-    }
-  
-    if(ground_registred ==  -1){
-      OLED_write("server registration failed!", 0, 18, true);
-      OLED_write("please check json file!", 0, 27, false);
-      snprintf (buf, sizeof(buf), "%s : %d", ogn_server.c_str(), ogn_port);
-      OLED_write(buf, 0, 36, false);
-      ground_registred = -2; 
-    }
-  
-    if(ground_registred == -2){
-      OGN_APRS_check_Wifi();
-      ExportTimeReRegister = seconds();
-      while(TimeToReRegisterOGN()){
-        os_runstep();
-      }
-      ground_registred = 0;
-    }
-  
-    if (TimeToExportOGN() && ground_registred == 1)
-    {
-      if(new_protocol_enable && testmode_enable){
-        RSM_ExportAircraftPosition();
-      }
-      OGN_APRS_Export();
-      OLED_info(position_is_set);
-      ExportTimeOGN = seconds();
-    }
-  
-    if (TimeToKeepAliveOGN() && ground_registred == 1)
+    switch (ground_state)
     {
-      disp = "keepalive OGN...";
-      OLED_write(disp, 0, 24, true);
-      
-      OGN_APRS_KeepAlive();
-      ExportTimeKeepAliveOGN = seconds();
+      case GROUND_NO_POSITION:
+        if (position_is_set && WiFi.getMode() != WIFI_AP)
+          ground_state = GROUND_REGISTER;
+        break;
+
+      case GROUND_REGISTER:
+        login = OGN_APRS_Register(&ThisAircraft);
+        if (login == 0)
+          break;    /* still connecting, asked again next round */
+        if (login == 1){
+          ground_state = GROUND_ONLINE;
+          /* a new login every APRS_REGISTER_REC */
+          TIMER_Schedule(&login_event, millis(), APRS_REGISTER_REC * 1000UL);
+          break;
+        }
+        OLED_write("server registration failed!", 0, 18, true);
+        OLED_write("please check json file!", 0, 27, false);
+        snprintf (buf, sizeof(buf), "%s : %d", ogn_server.c_str(), ogn_port);
+        OLED_write(buf, 0, 36, false);
+        OGN_APRS_check_Wifi(false);
+        TIMER_Schedule(&reregister_event, millis(), TIME_TO_REREG * 1000UL);
+        ground_state = GROUND_RETRY;
+        break;
+
+      case GROUND_RETRY:
+      case GROUND_ONLINE:
+        /* login_event and reregister_event */
+        break;
     }
-  
-    if (TimeToStatusOGN() && ground_registred == 1 && (position_is_set ))
-    {
-  
-      disp = "status OGN...";
-      OLED_write(disp, 0, 24, true);
-      
-      OGN_APRS_Status(&ThisAircraft);
-  
-      msg = "Version: ";
-      msg += String(_VERSION);
-      msg += " Power: ";
-      msg += String(SoC->Battery_voltage());
-      msg += String(" Uptime: ");
-      msg += String(millis() / 3600000);
-      msg += String(" GNSS: ");
-      msg += String(gnss.satellites.value());
-      Logger_send_udp(&msg);
-      ExportTimeStatusOGN = seconds();
-    }  
-  
-    if(TimeToCheckKeepAliveOGN() && ground_registred == 1){
-      ground_registred = OGN_APRS_check_messages();
-      ExportTimeCheckKeepAliveOGN = seconds();
-      MONIT_send_trap();
+
+    /* whatever the socket did not take in the last round */
+    if (ground_state == GROUND_ONLINE)
+      APRSQ_Flush();
+  }
+
+  // Handle Air Connect
+#if defined(TBEAM) 
+  ClearExpired();
+#endif   
+
+#if defined(TBEAM) 
+  /* the button switches the display on again, for another oled_disable */
+  static bool pressed = false;
+
+  if (!digitalRead(BUTTON) != pressed){
+    pressed = !pressed;
+    if (pressed){
+      OLED_enable();
+      if (oled_disable > 0)
+        TIMER_Schedule(&oled_event, millis(), oled_disable * 1000UL);
     }
-    
-    if( TimeToCheckWifi() && !ognrelay_enable){
-      OLED_draw_Bitmap(39, 5, 3 , true);
-      OLED_write("check connections..", 15, 45, false);
-      if(OGN_APRS_check_Wifi()){
-        OLED_write("success", 35, 54, false);
-      }
-      else{
-        OLED_write("error", 35, 54, false);
+  }
+#endif 
+}
+
+void ground_screen()
+{
+  char buf[32];
+
+  if((WiFi.getMode() == WIFI_AP) && !ognrelay_enable){
+    OLED_write("Setup mode..", 0, 9, true);
+    snprintf (buf, sizeof(buf), "SSID: %s", host_name.c_str());
+    OLED_write(buf, 0, 18, false);
+    snprintf (buf, sizeof(buf), "ip: %s", "192.168.1.1");
+    OLED_write(buf, 0, 27, false);
+    snprintf (buf, sizeof(buf), "reboot in %d seconds", 300 - seconds());
+    OLED_write(buf, 0, 36, false);
+    snprintf (buf, sizeof(buf), "Version: %s ", _VERSION);
+    OLED_write(buf, 0, 45, false);    
+    if(300 < seconds()){
+      SoC->reset();
       }
-      ExportTimeCheckWifi = seconds();
-    }  
+    }
 
+  if(!position_is_set){
+    OLED_write(seconds() % 2 ? "waiting for GPS fix" : "no position data found", 0, 18, true);
   }
-  
+}
 
-  if (TimeToExportOGN() && ognrelay_enable){
+void ground_export()
+{
+  if (ognrelay_enable){
     OLED_info(position_is_set);
-    ExportTimeOGN = seconds();
+    return;
   }
+  if (ground_state != GROUND_ONLINE)
+    return;
 
-  
-  if ( TimeToSleep() && ogn_sleepmode )
-  {
-    msg = "entering sleep mode for ";
-    msg += String(ogn_wakeuptimer); 
-    msg += " seconds - good night";
-    Logger_send_udp(&msg);
-    
-    esp_sleep_enable_timer_wakeup(ogn_wakeuptimer*1000000LL);
-    esp_sleep_enable_ext0_wakeup(GPIO_NUM_26,1);
-    OLED_disable();
-    
-    if (ogn_sleepmode == 1){
-      
-#if defined(TBEAM)      
-      GNSS_sleep();
-#endif 
-    }
-    
-    ground_registred = 0;
-    if(!ognrelay_enable)
-      SoC->WiFi_disconnect_TCP();
-    esp_deep_sleep_start();
+  if(new_protocol_enable && testmode_enable){
+    RSM_ExportAircraftPosition();
   }
+  OGN_APRS_Export();
+  OLED_info(position_is_set);
+}
 
-  if(ground_registred == 1 && TimeToExportFanetService()){
+void ground_keepalive()
+{
+  if (ognrelay_enable || ground_state != GROUND_ONLINE)
+    return;
 
-    
-    OLED_draw_Bitmap(14, 0, 2 , true);
-      
-    if( fanet_transmitter ){
-      RSM_receiver();
-    }
-    else{
-      fanet_transmitter = RSM_Setup(ogn_debugport+1);
-    }
-    ExportTimeFanetService = seconds();
-    msg = "current system time  ";
-    msg += String(now());
-    Logger_send_udp(&msg);
-  }
+  OLED_write("keepalive OGN...", 0, 24, true);
+  OGN_APRS_KeepAlive();
+}
 
-  // Handle Air Connect
-#if defined(TBEAM) 
-  ClearExpired();
-#endif   
+void ground_status()
+{
+  char msg[LOG_LINE];
+  int len;
+
+  if (ognrelay_enable || ground_state != GROUND_ONLINE)
+    return;
+
+  OLED_write("status OGN...", 0, 24, true);
+
+  OGN_APRS_Status(&ThisAircraft);
+
+  len = snprintf(msg, sizeof(msg),
+                 "Version: %s Power: %.2f Uptime: %lu GNSS: %lu APRS queue: %u/%u dropped: %lu/%lu"
+                 " TX: %lu airtime: %lums latency max: %luus RX blind max: %luus log dropped: %lu"
+                 " loop max: %luus timer late max: %lums",
+                 _VERSION, SoC->Battery_voltage(), (unsigned long) (millis() / 3600000),
+                 (unsigned long) gnss.satellites.value(), APRSQ_stats.depth, APRSQ_stats.max_depth,
+                 (unsigned long) APRSQ_stats.superseded, (unsigned long) APRSQ_stats.dropped,
+                 (unsigned long) RF_tx_stats.frames, (unsigned long) RF_tx_stats.airtime_ms,
+                 (unsigned long) RF_tx_stats.latency_max_us, (unsigned long) RF_rearm_stats.blind_max_us,
+                 (unsigned long) Log_stats.dropped, (unsigned long) LOOPSTATS_stats.max_us,
+                 (unsigned long) TIMER_stats.late_max_ms);
+  if (len > 0)
+    Log_write(msg, len < (int) sizeof(msg) ? len : sizeof(msg) - 1);
+}
 
+/* server messages, and the Zabbix trap */
+void ground_messages()
+{
+  if (ognrelay_enable || ground_state != GROUND_ONLINE)
+    return;
+
+  if (OGN_APRS_check_messages() != 1)
+    ground_state = GROUND_REGISTER;
+  MONIT_send_trap();
+}
 
-  if( TimeToDisWifi() && ognrelay_enable ){
-    WiFi.mode(WIFI_OFF);
-    ExportTimeDisWifi = seconds();
-    //Serial.print("disabling Wifi");
+void ground_check_wifi()
+{
+  OLED_draw_Bitmap(39, 5, 3 , true);
+  OLED_write("check connections..", 15, 45, false);
+  if(OGN_APRS_check_Wifi(wifi_recheck)){
+    OLED_write("success", 35, 54, false);
+    wifi_recheck = false;
+  }
+  else{
+    OLED_write("error", 35, 54, false);
+    /* restarted, look again in APRS_WIFI_GRACE */
+    TIMER_Schedule(&wifi_event, millis(), APRS_WIFI_GRACE * 1000UL);
+    wifi_recheck = true;
   }
+}
 
-  if( TimeToDisableOled() ){
-    if (oled_disable > 0){
-     OLED_disable(); 
-    }
+void ground_login()
+{
+  if (ground_state == GROUND_ONLINE)
+    ground_state = GROUND_REGISTER;
+}
+
+void ground_reregister()
+{
+  if (ground_state != GROUND_RETRY)
+    return;
+
+  OGN_APRS_check_Wifi(true);
+  ground_state = GROUND_REGISTER;
+}
+
+void ground_fanet_service()
+{
+  String msg;
+
+  if (ground_state != GROUND_ONLINE)
+    return;
+
+  OLED_draw_Bitmap(14, 0, 2 , true);
+
+  if( fanet_transmitter ){
+    RSM_receiver();
   }
-  
-#if defined(TBEAM) 
-  if (!digitalRead(BUTTON)){
-    while(!digitalRead(BUTTON)){delay(100);}
-    OLED_enable();
-    ExportTimeOledDisable = seconds();
+  else{
+    fanet_transmitter = RSM_Setup(ogn_debugport+1);
   }
+  msg = "current system time  ";
+  msg += String(now());
+  Logger_send_udp(&msg);
+}
+
+void ground_sleep()
+{
+  String msg;
+
+  msg = "entering sleep mode for ";
+  msg += String(ogn_wakeuptimer); 
+  msg += " seconds - good night";
+  Logger_send_udp(&msg);
+  
+  esp_sleep_enable_timer_wakeup(ogn_wakeuptimer*1000000LL);
+  esp_sleep_enable_ext0_wakeup(GPIO_NUM_26,1);
+  OLED_disable();
+  
+  if (ogn_sleepmode == 1){
+    
+#if defined(TBEAM)      
+    GNSS_sleep();
 #endif 
+  }
+  
+  ground_state = GROUND_NO_POSITION;
+  if(!ognrelay_enable)
+    SoC->WiFi_disconnect_TCP();
+  esp_deep_sleep_start();
+}
+
+void ground_disable_wifi()
+{
+  WiFi.mode(WIFI_OFF);
+  //Serial.print("disabling Wifi");
 }
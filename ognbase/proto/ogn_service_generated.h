@@ -14,6 +14,9 @@ struct GroundPos;
 
 struct GroundStat;
 
+struct StationHeader;
+struct StationHeaderBuilder;
+
 struct OneMessage;
 struct OneMessageBuilder;
 
@@ -175,12 +178,126 @@ FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(4) GroundStat FLATBUFFERS_FINAL_CLASS {
 };
 FLATBUFFERS_STRUCT_END(GroundStat, 20);
 
+struct StationHeader FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  typedef StationHeaderBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_CALLSIGN = 4,
+    VT_TIMESTAMP = 6,
+    VT_SEQUENCE = 8,
+    VT_LAT = 10,
+    VT_LON = 12,
+    VT_ALT = 14
+  };
+  const flatbuffers::String *callsign() const {
+    return GetPointer<const flatbuffers::String *>(VT_CALLSIGN);
+  }
+  int32_t timestamp() const {
+    return GetField<int32_t>(VT_TIMESTAMP, 0);
+  }
+  uint32_t sequence() const {
+    return GetField<uint32_t>(VT_SEQUENCE, 0);
+  }
+  float lat() const {
+    return GetField<float>(VT_LAT, 0.0f);
+  }
+  float lon() const {
+    return GetField<float>(VT_LON, 0.0f);
+  }
+  int32_t alt() const {
+    return GetField<int32_t>(VT_ALT, 0);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyOffset(verifier, VT_CALLSIGN) &&
+           verifier.VerifyString(callsign()) &&
+           VerifyField<int32_t>(verifier, VT_TIMESTAMP) &&
+           VerifyField<uint32_t>(verifier, VT_SEQUENCE) &&
+           VerifyField<float>(verifier, VT_LAT) &&
+           VerifyField<float>(verifier, VT_LON) &&
+           VerifyField<int32_t>(verifier, VT_ALT) &&
+           verifier.EndTable();
+  }
+};
+
+struct StationHeaderBuilder {
+  typedef StationHeader Table;
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_callsign(flatbuffers::Offset<flatbuffers::String> callsign) {
+    fbb_.AddOffset(StationHeader::VT_CALLSIGN, callsign);
+  }
+  void add_timestamp(int32_t timestamp) {
+    fbb_.AddElement<int32_t>(StationHeader::VT_TIMESTAMP, timestamp, 0);
+  }
+  void add_sequence(uint32_t sequence) {
+    fbb_.AddElement<uint32_t>(StationHeader::VT_SEQUENCE, sequence, 0);
+  }
+  void add_lat(float lat) {
+    fbb_.AddElement<float>(StationHeader::VT_LAT, lat, 0.0f);
+  }
+  void add_lon(float lon) {
+    fbb_.AddElement<float>(StationHeader::VT_LON, lon, 0.0f);
+  }
+  void add_alt(int32_t alt) {
+    fbb_.AddElement<int32_t>(StationHeader::VT_ALT, alt, 0);
+  }
+  explicit StationHeaderBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  flatbuffers::Offset<StationHeader> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<StationHeader>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<StationHeader> CreateStationHeader(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    flatbuffers::Offset<flatbuffers::String> callsign = 0,
+    int32_t timestamp = 0,
+    uint32_t sequence = 0,
+    float lat = 0.0f,
+    float lon = 0.0f,
+    int32_t alt = 0) {
+  StationHeaderBuilder builder_(_fbb);
+  builder_.add_alt(alt);
+  builder_.add_lon(lon);
+  builder_.add_lat(lat);
+  builder_.add_sequence(sequence);
+  builder_.add_timestamp(timestamp);
+  builder_.add_callsign(callsign);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<StationHeader> CreateStationHeaderDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    const char *callsign = nullptr,
+    int32_t timestamp = 0,
+    uint32_t sequence = 0,
+    float lat = 0.0f,
+    float lon = 0.0f,
+    int32_t alt = 0) {
+  auto callsign__ = callsign ? _fbb.CreateString(callsign) : 0;
+  return ogn::CreateStationHeader(
+      _fbb,
+      callsign__,
+      timestamp,
+      sequence,
+      lat,
+      lon,
+      alt);
+}
+
 struct OneMessage FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   typedef OneMessageBuilder Builder;
   enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
     VT_AIRC_POS = 4,
     VT_GROU_POS = 6,
-    VT_GROU_STA = 8
+    VT_GROU_STA = 8,
+    VT_STATION = 10,
+    VT_AIRC_LIST = 12,
+    VT_AIRC_STREAM = 14
   };
   const ogn::AircraftPos *airc_pos() const {
     return GetStruct<const ogn::AircraftPos *>(VT_AIRC_POS);
@@ -191,11 +308,26 @@ struct OneMessage FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   const ogn::GroundStat *grou_sta() const {
     return GetStruct<const ogn::GroundStat *>(VT_GROU_STA);
   }
+  const ogn::StationHeader *station() const {
+    return GetPointer<const ogn::StationHeader *>(VT_STATION);
+  }
+  const flatbuffers::Vector<const ogn::AircraftPos *> *airc_list() const {
+    return GetPointer<const flatbuffers::Vector<const ogn::AircraftPos *> *>(VT_AIRC_LIST);
+  }
+  const flatbuffers::Vector<uint8_t> *airc_stream() const {
+    return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_AIRC_STREAM);
+  }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<ogn::AircraftPos>(verifier, VT_AIRC_POS) &&
            VerifyField<ogn::GroundPos>(verifier, VT_GROU_POS) &&
            VerifyField<ogn::GroundStat>(verifier, VT_GROU_STA) &&
+           VerifyOffset(verifier, VT_STATION) &&
+           verifier.VerifyTable(station()) &&
+           VerifyOffset(verifier, VT_AIRC_LIST) &&
+           verifier.VerifyVector(airc_list()) &&
+           VerifyOffset(verifier, VT_AIRC_STREAM) &&
+           verifier.VerifyVector(airc_stream()) &&
            verifier.EndTable();
   }
 };
@@ -213,6 +345,15 @@ struct OneMessageBuilder {
   void add_grou_sta(const ogn::GroundStat *grou_sta) {
     fbb_.AddStruct(OneMessage::VT_GROU_STA, grou_sta);
   }
+  void add_station(flatbuffers::Offset<ogn::StationHeader> station) {
+    fbb_.AddOffset(OneMessage::VT_STATION, station);
+  }
+  void add_airc_list(flatbuffers::Offset<flatbuffers::Vector<const ogn::AircraftPos *>> airc_list) {
+    fbb_.AddOffset(OneMessage::VT_AIRC_LIST, airc_list);
+  }
+  void add_airc_stream(flatbuffers::Offset<flatbuffers::Vector<uint8_t>> airc_stream) {
+    fbb_.AddOffset(OneMessage::VT_AIRC_STREAM, airc_stream);
+  }
   explicit OneMessageBuilder(flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -228,14 +369,40 @@ inline flatbuffers::Offset<OneMessage> CreateOneMessage(
     flatbuffers::FlatBufferBuilder &_fbb,
     const ogn::AircraftPos *airc_pos = 0,
     const ogn::GroundPos *grou_pos = 0,
-    const ogn::GroundStat *grou_sta = 0) {
+    const ogn::GroundStat *grou_sta = 0,
+    flatbuffers::Offset<ogn::StationHeader> station = 0,
+    flatbuffers::Offset<flatbuffers::Vector<const ogn::AircraftPos *>> airc_list = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint8_t>> airc_stream = 0) {
   OneMessageBuilder builder_(_fbb);
+  builder_.add_airc_stream(airc_stream);
+  builder_.add_airc_list(airc_list);
+  builder_.add_station(station);
   builder_.add_grou_sta(grou_sta);
   builder_.add_grou_pos(grou_pos);
   builder_.add_airc_pos(airc_pos);
   return builder_.Finish();
 }
 
+inline flatbuffers::Offset<OneMessage> CreateOneMessageDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    const ogn::AircraftPos *airc_pos = 0,
+    const ogn::GroundPos *grou_pos = 0,
+    const ogn::GroundStat *grou_sta = 0,
+    flatbuffers::Offset<ogn::StationHeader> station = 0,
+    const std::vector<ogn::AircraftPos> *airc_list = nullptr,
+    const std::vector<uint8_t> *airc_stream = nullptr) {
+  auto airc_list__ = airc_list ? _fbb.CreateVectorOfStructs<ogn::AircraftPos>(*airc_list) : 0;
+  auto airc_stream__ = airc_stream ? _fbb.CreateVector<uint8_t>(*airc_stream) : 0;
+  return ogn::CreateOneMessage(
+      _fbb,
+      airc_pos,
+      grou_pos,
+      grou_sta,
+      station,
+      airc_list__,
+      airc_stream__);
+}
+
 inline const ogn::OneMessage *GetOneMessage(const void *buf) {
   return flatbuffers::GetRoot<ogn::OneMessage>(buf);
 }
@@ -0,0 +1,237 @@
+
+# NBP -> APRS proxy
+#
+# Receives NBP datagrams of ground stations (single airc_pos, airc_list
+# batches or the airc_stream keyframe/delta stream) and turns every
+# aircraft report into the APRS position line the station would have
+# sent itself. The lines are printed and, with --aprs, forwarded to an
+# APRS-IS server.
+#
+# Stream records (see NBP.cpp):
+#   keyframe  0x80 | slot, address (3 bytes LE), info, then time, lat and
+#             lon relative to the StationHeader, altitude, course, speed
+#   delta     slot, then time, lat, lon, altitude, course and speed
+#             relative to the previous record of the slot
+# varints are LEB128, signed ones zigzag, lat/lon in 1/1000 arc minute.
+
+import socket
+import sys
+import math
+import argparse
+from datetime import datetime, timezone
+
+import flatbuffers
+from ogn.OneMessage import OneMessage
+
+STREAM_KEY   = 0x80
+STREAM_UNITS = 60000
+
+prefixes     = {1: 'ICA', 2: 'FLR', 3: 'OGN', 4: 'P3I', 5: 'FNT'}
+symbol_table = ["/", "/", "\\", "/", "\\", "\\", "/", "/", "\\", "J", "/", "/", "M", "/", "\\", "\\"]
+symbol       = ["z", "^", "^", "X", "", "^", "g", "g", "^", "^", "^", "O", "^", "'", "", "n"]
+
+
+def units(deg):
+    return int(math.floor(deg * STREAM_UNITS + 0.5))
+
+
+def unzigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+
+def varint(buf, pos):
+    v = 0
+    shift = 0
+    while True:
+        b = buf[pos]
+        pos += 1
+        v |= (b & 0x7F) << shift
+        if not b & 0x80:
+            return v, pos
+        shift += 7
+
+
+class Station(object):
+    """receiver state of one ground station"""
+
+    def __init__(self):
+        self.sequence = None
+        self.slots = {}
+        self.lost = 0
+        self.dropped = 0
+
+    def check_sequence(self, sequence):
+        # a gap, a restart or a reordered datagram: the deltas are off
+        if self.sequence is None or sequence != self.sequence:
+            if self.sequence is not None and 0 < sequence - self.sequence < 0x10000:
+                self.lost += sequence - self.sequence
+            self.slots = {}
+        self.sequence = (sequence + 1) & 0xFFFFFFFF
+
+    def stream(self, buf, timestamp, lat, lon):
+        reports = []
+        pos = 0
+        try:
+            while pos < len(buf):
+                tag = buf[pos]
+                pos += 1
+                slot = tag & ~STREAM_KEY
+                prev = self.slots.get(slot)
+                if tag & STREAM_KEY:
+                    addr = buf[pos] | buf[pos + 1] << 8 | buf[pos + 2] << 16
+                    pos += 3
+                    v = []
+                    for i in range(7):
+                        x, pos = varint(buf, pos)
+                        v.append(x)
+                    now = dict(addr=addr, info=v[0], timestamp=timestamp + unzigzag(v[1]),
+                               lat=lat + unzigzag(v[2]), lon=lon + unzigzag(v[3]),
+                               alt=unzigzag(v[4]), course=v[5], speed=v[6])
+                    if prev is not None and prev['addr'] != addr:
+                        prev = None
+                else:
+                    v = []
+                    for i in range(6):
+                        x, pos = varint(buf, pos)
+                        v.append(unzigzag(x))
+                    if prev is None:
+                        self.dropped += 1
+                        continue
+                    now = dict(prev)
+                    now['timestamp'] += v[0]
+                    now['lat'] += v[1]
+                    now['lon'] += v[2]
+                    now['alt'] += v[3]
+                    now['course'] = (now['course'] + v[4] + 360) % 360
+                    now['speed'] += v[5]
+                vs = 0
+                if prev is not None and now['timestamp'] > prev['timestamp']:
+                    vs = int((now['alt'] - prev['alt']) * 3.28084 * 60 / (now['timestamp'] - prev['timestamp']))
+                now['vs'] = vs
+                self.slots[slot] = now
+                reports.append(now)
+        except IndexError:
+            print("truncated stream record")
+        return reports
+
+
+def from_struct(position):
+    return dict(addr=position.Callsign() & 0xFFFFFF, info=(position.Type() & 0x0F) << 5 |
+                position.Stealth() << 4 | position.Notrack() << 3, timestamp=position.Timestamp(),
+                lat=units(position.Lat()), lon=units(position.Lon()), alt=position.Alt(),
+                course=position.Heading(), speed=position.Speed(), vs=0)
+
+
+def put_int(val, width):
+    s = str(abs(val))
+    if val < 0:
+        s = '-' + s
+    return s.rjust(width, '0')
+
+
+def aprs_position(r, callsign):
+    """the line of OGN_APRS_Position() in APRS.cpp"""
+    addr_type = r['info'] & 0x07
+    no_track = r['info'] >> 3 & 1
+    stealth = r['info'] >> 4 & 1
+    aircraft_type = r['info'] >> 5 & 0x0F
+    lat = abs(r['lat'])
+    lon = abs(r['lon'])
+    lat_deg, lat_min = lat // STREAM_UNITS, lat % STREAM_UNITS
+    lon_deg, lon_min = lon // STREAM_UNITS, lon % STREAM_UNITS
+    t = datetime.fromtimestamp(r['timestamp'], timezone.utc)
+
+    line = "%s%06X>APRS,qAS,%s:/" % (prefixes.get(addr_type, 'RANDOM'), r['addr'], callsign)
+    line += put_int(t.hour, 2) + put_int(t.minute, 2) + put_int(t.second, 2) + 'h'
+    line += put_int(lat_deg, 0) + put_int(lat_min // 1000, 2) + '.' + put_int(lat_min % 1000 // 10, 2)
+    line += ('S' if r['lat'] < 0 else 'N') + symbol_table[aircraft_type]
+    line += put_int(lon_deg, 3) + put_int(lon_min // 1000, 2) + '.' + put_int(lon_min % 1000 // 10, 2)
+    line += ('W' if r['lon'] < 0 else 'E') + symbol[aircraft_type]
+    line += put_int(r['course'], 3) + '/' + put_int(r['speed'], 3)
+    line += "/A=" + put_int(int(r['alt'] * 3.28084), 6)
+    line += " !W%d%d! id%02X%06X " % (lat_min % 10, lon_min % 10,
+                                      aircraft_type << 2 | stealth << 7 | no_track << 6 | addr_type, r['addr'])
+    line += ('+' if r['vs'] >= 0 else '') + put_int(r['vs'], 3)
+    line += "fpm +0.0rot 0.0dB 0e -0.0kHz\r\n"
+    return line
+
+
+def aprs_passcode(callsign):
+    root = callsign.split('-')[0].upper()[:9]
+    h = 0x73e2
+    for i in range(0, len(root), 2):
+        h ^= ord(root[i]) << 8
+        if i + 1 < len(root):
+            h ^= ord(root[i + 1])
+    return h & 0x7fff
+
+
+class AprsIs(object):
+    """one TCP connection to APRS-IS, opened again when it breaks"""
+
+    def __init__(self, server, login):
+        host, port = server.rsplit(':', 1)
+        self.server = (host, int(port))
+        self.login = login
+        self.sock = None
+
+    def send(self, line):
+        try:
+            if self.sock is None:
+                self.sock = socket.create_connection(self.server, 10)
+                self.sock.sendall(("user %s pass %d vers nbp-proxy 0.1\r\n" %
+                                   (self.login, aprs_passcode(self.login))).encode())
+            self.sock.sendall(line.encode())
+        except OSError as e:
+            print("APRS-IS: %s" % e)
+            self.sock = None
+
+
+def main():
+    parser = argparse.ArgumentParser(description="NBP to APRS proxy")
+    parser.add_argument("port", type=int)
+    parser.add_argument("--bind", default="0.0.0.0")
+    parser.add_argument("--aprs", help="APRS-IS server host:port")
+    parser.add_argument("--login", default="NBPPROXY", help="APRS-IS login callsign")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind((args.bind, args.port))
+
+    aprs = AprsIs(args.aprs, args.login) if args.aprs else None
+    stations = {}
+
+    while True:
+        data, addr = sock.recvfrom(2048)
+
+        try:
+            message = OneMessage.GetRootAsOneMessage(data, 0)
+            header = message.Station()
+            callsign = header.Callsign().decode() if header is not None else addr[0]
+            station = stations.setdefault((addr[0], callsign), Station())
+            reports = []
+
+            if header is not None:
+                lost, dropped = station.lost, station.dropped
+                station.check_sequence(header.Sequence())
+                if not message.AircStreamIsNone():
+                    buf = bytes(message.AircStream(j) for j in range(message.AircStreamLength()))
+                    reports += station.stream(buf, header.Timestamp(), units(header.Lat()), units(header.Lon()))
+                if station.lost != lost or station.dropped != dropped:
+                    print("%s: %d datagrams lost, %d deltas dropped" % (callsign, station.lost, station.dropped))
+            for i in range(message.AircListLength()):
+                reports.append(from_struct(message.AircList(i)))
+            if message.AircPos() is not None:
+                reports.append(from_struct(message.AircPos()))
+
+            for r in reports:
+                line = aprs_position(r, callsign)
+                sys.stdout.write(line.replace("\r\n", "\n"))
+                if aprs is not None:
+                    aprs.send(line)
+        except Exception as e:
+            print(e)
+
+
+if __name__ == "__main__":
+    main()
@@ -57,7 +57,69 @@ class OneMessage(object):
             return obj
         return None
 
-def Start(builder): builder.StartObject(3)
+    # OneMessage
+    def Station(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(10))
+        if o != 0:
+            x = self._tab.Indirect(o + self._tab.Pos)
+            from ogn.StationHeader import StationHeader
+            obj = StationHeader()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+    # OneMessage
+    def AircList(self, j):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(12))
+        if o != 0:
+            x = self._tab.Vector(o)
+            x += flatbuffers.number_types.UOffsetTFlags.py_type(j) * 32
+            from ogn.AircraftPos import AircraftPos
+            obj = AircraftPos()
+            obj.Init(self._tab.Bytes, x)
+            return obj
+        return None
+
+    # OneMessage
+    def AircListLength(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(12))
+        if o != 0:
+            return self._tab.VectorLen(o)
+        return 0
+
+    # OneMessage
+    def AircListIsNone(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(12))
+        return o == 0
+
+    # OneMessage
+    def AircStream(self, j):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(14))
+        if o != 0:
+            a = self._tab.Vector(o)
+            return self._tab.Get(flatbuffers.number_types.Uint8Flags, a + flatbuffers.number_types.UOffsetTFlags.py_type(j * 1))
+        return 0
+
+    # OneMessage
+    def AircStreamAsNumpy(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(14))
+        if o != 0:
+            return self._tab.GetVectorAsNumpy(flatbuffers.number_types.Uint8Flags, o)
+        return 0
+
+    # OneMessage
+    def AircStreamLength(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(14))
+        if o != 0:
+            return self._tab.VectorLen(o)
+        return 0
+
+    # OneMessage
+    def AircStreamIsNone(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(14))
+        return o == 0
+
+def Start(builder): builder.StartObject(6)
 def OneMessageStart(builder):
     """This method is deprecated. Please switch to Start."""
     return Start(builder)
@@ -73,6 +135,26 @@ def AddGrouSta(builder, grouSta): builder.PrependStructSlot(2, flatbuffers.numbe
 def OneMessageAddGrouSta(builder, grouSta):
     """This method is deprecated. Please switch to AddGrouSta."""
     return AddGrouSta(builder, grouSta)
+def AddStation(builder, station): builder.PrependUOffsetTRelativeSlot(3, flatbuffers.number_types.UOffsetTFlags.py_type(station), 0)
+def OneMessageAddStation(builder, station):
+    """This method is deprecated. Please switch to AddStation."""
+    return AddStation(builder, station)
+def AddAircList(builder, aircList): builder.PrependUOffsetTRelativeSlot(4, flatbuffers.number_types.UOffsetTFlags.py_type(aircList), 0)
+def OneMessageAddAircList(builder, aircList):
+    """This method is deprecated. Please switch to AddAircList."""
+    return AddAircList(builder, aircList)
+def StartAircListVector(builder, numElems): return builder.StartVector(32, numElems, 4)
+def OneMessageStartAircListVector(builder, numElems):
+    """This method is deprecated. Please switch to Start."""
+    return StartAircListVector(builder, numElems)
+def AddAircStream(builder, aircStream): builder.PrependUOffsetTRelativeSlot(5, flatbuffers.number_types.UOffsetTFlags.py_type(aircStream), 0)
+def OneMessageAddAircStream(builder, aircStream):
+    """This method is deprecated. Please switch to AddAircStream."""
+    return AddAircStream(builder, aircStream)
+def StartAircStreamVector(builder, numElems): return builder.StartVector(1, numElems, 1)
+def OneMessageStartAircStreamVector(builder, numElems):
+    """This method is deprecated. Please switch to Start."""
+    return StartAircStreamVector(builder, numElems)
 def End(builder): return builder.EndObject()
 def OneMessageEnd(builder):
     """This method is deprecated. Please switch to End."""
@@ -0,0 +1,100 @@
+# automatically generated by the FlatBuffers compiler, do not modify
+
+# namespace: ogn
+
+import flatbuffers
+from flatbuffers.compat import import_numpy
+np = import_numpy()
+
+class StationHeader(object):
+    __slots__ = ['_tab']
+
+    @classmethod
+    def GetRootAs(cls, buf, offset=0):
+        n = flatbuffers.encode.Get(flatbuffers.packer.uoffset, buf, offset)
+        x = StationHeader()
+        x.Init(buf, n + offset)
+        return x
+
+    @classmethod
+    def GetRootAsStationHeader(cls, buf, offset=0):
+        """This method is deprecated. Please switch to GetRootAs."""
+        return cls.GetRootAs(buf, offset)
+    # StationHeader
+    def Init(self, buf, pos):
+        self._tab = flatbuffers.table.Table(buf, pos)
+
+    # StationHeader
+    def Callsign(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(4))
+        if o != 0:
+            return self._tab.String(o + self._tab.Pos)
+        return None
+
+    # StationHeader
+    def Timestamp(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(6))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Int32Flags, o + self._tab.Pos)
+        return 0
+
+    # StationHeader
+    def Sequence(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(8))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Uint32Flags, o + self._tab.Pos)
+        return 0
+
+    # StationHeader
+    def Lat(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(10))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Float32Flags, o + self._tab.Pos)
+        return 0.0
+
+    # StationHeader
+    def Lon(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(12))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Float32Flags, o + self._tab.Pos)
+        return 0.0
+
+    # StationHeader
+    def Alt(self):
+        o = flatbuffers.number_types.UOffsetTFlags.py_type(self._tab.Offset(14))
+        if o != 0:
+            return self._tab.Get(flatbuffers.number_types.Int32Flags, o + self._tab.Pos)
+        return 0
+
+def Start(builder): builder.StartObject(6)
+def StationHeaderStart(builder):
+    """This method is deprecated. Please switch to Start."""
+    return Start(builder)
+def AddCallsign(builder, callsign): builder.PrependUOffsetTRelativeSlot(0, flatbuffers.number_types.UOffsetTFlags.py_type(callsign), 0)
+def StationHeaderAddCallsign(builder, callsign):
+    """This method is deprecated. Please switch to AddCallsign."""
+    return AddCallsign(builder, callsign)
+def AddTimestamp(builder, timestamp): builder.PrependInt32Slot(1, timestamp, 0)
+def StationHeaderAddTimestamp(builder, timestamp):
+    """This method is deprecated. Please switch to AddTimestamp."""
+    return AddTimestamp(builder, timestamp)
+def AddSequence(builder, sequence): builder.PrependUint32Slot(2, sequence, 0)
+def StationHeaderAddSequence(builder, sequence):
+    """This method is deprecated. Please switch to AddSequence."""
+    return AddSequence(builder, sequence)
+def AddLat(builder, lat): builder.PrependFloat32Slot(3, lat, 0.0)
+def StationHeaderAddLat(builder, lat):
+    """This method is deprecated. Please switch to AddLat."""
+    return AddLat(builder, lat)
+def AddLon(builder, lon): builder.PrependFloat32Slot(4, lon, 0.0)
+def StationHeaderAddLon(builder, lon):
+    """This method is deprecated. Please switch to AddLon."""
+    return AddLon(builder, lon)
+def AddAlt(builder, alt): builder.PrependInt32Slot(5, alt, 0)
+def StationHeaderAddAlt(builder, alt):
+    """This method is deprecated. Please switch to AddAlt."""
+    return AddAlt(builder, alt)
+def End(builder): return builder.EndObject()
+def StationHeaderEnd(builder):
+    """This method is deprecated. Please switch to End."""
+    return End(builder)
\ No newline at end of file
@@ -25,7 +25,7 @@ serverSock.bind((UDP_IP_ADDRESS, UDP_PORT_NO))
 stations = []
 
 while True:
-    data, addr = serverSock.recvfrom(512)
+    data, addr = serverSock.recvfrom(2048)
 
     if addr[0] not in stations:
         stations.append(addr[0]);
@@ -38,8 +38,15 @@ while True:
     print_c("%s RAW Message: %s from %s"%(current_time, data.hex(), addr[0]))
 
     try:
-        aircraft = OneMessage.GetRootAsOneMessage(data, 0)
-        position = aircraft.AircPos()
-        print("Aircraft: %s Lat: %.4f Lon: %.4f Alt: %.4f Timestamp: %d"%(position.Callsign(), position.Lat(), position.Lon(), position.Alt(), position.Timestamp()))
+        message = OneMessage.GetRootAsOneMessage(data, 0)
+        station = message.Station()
+        if station is not None:
+            # one datagram per export cycle, all aircraft of the station
+            print_c("Station: %s Seq: %d Aircraft: %d Lat: %.4f Lon: %.4f Alt: %d Timestamp: %d"%(station.Callsign().decode(), station.Sequence(), message.AircListLength(), station.Lat(), station.Lon(), station.Alt(), station.Timestamp()))
+            positions = [message.AircList(i) for i in range(message.AircListLength())]
+        else:
+            positions = [message.AircPos()]
+        for position in positions:
+            print("Aircraft: %X Lat: %.4f Lon: %.4f Alt: %d Timestamp: %d"%(position.Callsign(), position.Lat(), position.Lon(), position.Alt(), position.Timestamp()))
     except Exception as e:
         print(e)